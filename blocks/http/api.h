@@ -80,6 +80,7 @@ using current::http::HTTP;
 using current::http::Request;
 using current::http::Response;
 using current::http::ReRegisterRoute;
+using current::http::StreamRequestBody;
 using HTTPRoutesScope = typename HTTP_IMPL::server_impl_t::HTTPRoutesScope;
 using HTTPRoutesScopeEntry = current::http::HTTPServerPOSIX::HTTPRoutesScopeEntry;
 
@@ -179,7 +179,7 @@ int main() {
                     try {
                       auto response = r.connection.SendChunkedHTTPResponse(
                           HTTPResponseCode.OK,
-                          {{"Connection", "keep-alive"}, {"Access-Control-Allow-Origin", "*"}},
+                          {{"Access-Control-Allow-Origin", "*"}},
                           "application/json; charset=utf-8");
                       std::string data;
                       const double begin = static_cast<double>(Now().count());
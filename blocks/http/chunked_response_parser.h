@@ -27,7 +27,12 @@ SOFTWARE.
 
 #include "../../port.h"
 
+#include <memory>
+
+#include "../../bricks/net/http/constants.h"
 #include "../../bricks/net/http/headers/headers.h"
+#include "../../bricks/strings/util.h"
+#include "../../bricks/util/gzip.h"
 
 class ChunkByChunkHTTPResponseReceiver {
  public:
@@ -55,9 +60,27 @@ class ChunkByChunkHTTPResponseReceiver {
   const current::net::http::Headers& headers() const { return headers_; }
 
  protected:
-  inline void OnHeader(const char* key, const char* value) { params.header_callback(key, value); }
+  // A compressed response is decompressed on the fly, so that `chunk_callback` gets the original data.
+  inline void OnHeader(const char* key, const char* value) {
+    if (current::strings::ToLower(key) == current::strings::ToLower(current::net::constants::kContentEncodingHeaderKey)) {
+      const std::string encoding = current::strings::ToLower(value);
+      if (encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate") {
+        decompressor_ = std::make_unique<current::gzip::Decompressor>();
+      }
+    }
+    params.header_callback(key, value);
+  }
 
-  inline void OnChunk(const char* chunk, size_t length) { params.chunk_callback(std::string(chunk, length)); }
+  inline void OnChunk(const char* chunk, size_t length) {
+    if (decompressor_) {
+      const std::string data = decompressor_->Decompress(chunk, length);
+      if (!data.empty()) {
+        params.chunk_callback(data);
+      }
+    } else {
+      params.chunk_callback(std::string(chunk, length));
+    }
+  }
 
   inline void OnChunkedBodyDone(const char*& begin, const char*& end) {
     params.done_callback();
@@ -67,6 +90,7 @@ class ChunkByChunkHTTPResponseReceiver {
 
  private:
   current::net::http::Headers headers_;
+  std::unique_ptr<current::gzip::Decompressor> decompressor_;
 };
 
 #endif  // BLOCKS_HTTP_CHUNKED_RESPONSE_PARSER_H
@@ -65,6 +65,10 @@ EXPECT_EQ(".....\n", HTTP(GET(Printf("http://localhost:%d/chunked?n=5&delay_ms=2
    
   // NOTE: For most legitimate practical usecases of returning unlimited
   // amounts of data, consider Stream's stream data replication mechanisms.
+  
+  // NOTE: If the client sends `Accept-Encoding: gzip`, both regular and chunked
+  // responses are compressed on the fly, and each chunk sent still reaches the
+  // client right away. `ChunkedGET(...).AcceptGZip()` asks for it and decompresses.
 }
 
 #endif  // BLOCKS_HTTP_DOCU_SERVER_05_TEST_CC
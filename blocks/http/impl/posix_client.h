@@ -30,10 +30,18 @@ SOFTWARE.
 
 #include "../types.h"
 
+#include "posix_client_pool.h"
+
+#include <cerrno>
 #include <memory>
 #include <string>
 #include <set>
 
+#ifndef CURRENT_WINDOWS
+#include <poll.h>
+#include <sys/socket.h>
+#endif  // CURRENT_WINDOWS
+
 #include "../../url/url.h"
 
 #include "../../../bricks/net/http/http.h"
@@ -94,47 +102,32 @@ class GenericHTTPClientPOSIX final {
           port = 80;
         }
       }
-      current::net::Connection connection(
-          current::net::Connection(current::net::ClientSocket(parsed_url.host, port)));
-      connection.BlockingWrite(
-          request_method_ + ' ' + parsed_url.path + parsed_url.ComposeParameters() + " HTTP/1.1\r\n", true);
-      connection.BlockingWrite("Host: " + parsed_url.host + "\r\n", true);
-      if (!request_user_agent_.empty()) {
-        connection.BlockingWrite("User-Agent: " + request_user_agent_ + "\r\n", true);
-      }
-      for (const auto& h : request_headers_) {
-        connection.BlockingWrite(h.header + ": " + h.value + "\r\n", true);
-      }
-      if (!request_headers_.cookies.empty()) {
-        connection.BlockingWrite("Cookie: " + request_headers_.CookiesAsString() + "\r\n", true);
-      }
-      if (!request_body_content_type_.empty()) {
-        connection.BlockingWrite("Content-Type: " + request_body_content_type_ + "\r\n", true);
-      }
-      if (!request_body_contents_.empty() || current::net::NeedContentLengthHeader(request_method_)) {
-        // NOTE(dkorolev): The `try/catch/throw` combo here is a hack for the unit test for HTTP 413 to pass.
-        // It swallows the `SocketWriteException` exception for huge payloads, as Current's HTTP server logic
-        // does intentionally close the HTTP connection prematurely if `Content-Length` exceeds a reasonable limit.
+      auto& pool = DefaultHTTPClientConnectionPool();
+      std::unique_ptr<current::net::Connection> connection = pool.Acquire(parsed_url.host, port);
+      if (connection) {
+        // The server may have closed the pooled connection by the time the request was sent over it. Then the request,
+        // whatever its method, is sent once again over a new connection, as it would have been with no pool: the server
+        // closes the idle connection without reading from it, so the request has not been acted upon.
+        bool closed_by_server;
         try {
-#ifndef CURRENT_WINDOWS
-          connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n", true);
-          connection.BlockingWrite("\r\n", true);
-          connection.BlockingWrite(request_body_contents_, false);
-#else
-          // TODO(grixa): this fix for the PayloadTooLarge test on Windows is temporary, need to revisit it.
-          connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n\r\n" +
-                                       request_body_contents_,
-                                   false);
-#endif
-        } catch (const net::SocketWriteException&) {
-          if (request_body_contents_.length() <= net::constants::kMaxHTTPPayloadSizeInBytes) {
-            throw;
-          }
+          SendRequest(*connection, parsed_url);
+          closed_by_server = !ResponseArrived(*connection);
+        } catch (const current::net::SocketWriteException&) {
+          closed_by_server = true;
+        }
+        if (closed_by_server) {
+          connection = nullptr;
         }
-      } else {
-        connection.BlockingWrite("\r\n", false);
       }
-      http_request_.reset(new CustomHTTPRequestData(connection, request_data_construction_params_));
+      if (!connection) {
+        connection = std::make_unique<current::net::Connection>(current::net::ClientSocket(parsed_url.host, port));
+        SendRequest(*connection, parsed_url);
+      }
+      http_request_.reset(new CustomHTTPRequestData(*connection, request_data_construction_params_));
+      if (http_request_->KeepAliveAnnounced() && http_request_->HasDelimitedBody() && request_method_ != "HEAD" &&
+          connection->ExtractReadBuffer().empty()) {
+        pool.Release(parsed_url.host, port, std::move(connection));
+      }
       // TODO(dkorolev): Rename `Path()`, it's only called so now because of HTTP request/response format.
       // Elaboration:
       // HTTP request  message is: `GET /path HTTP/1.1`, "/path" is the second component of it.
@@ -159,6 +152,76 @@ class GenericHTTPClientPOSIX final {
 
   const CustomHTTPRequestData& HTTPRequest() const { return *http_request_.get(); }
 
+ private:
+  // The server closes the stale pooled connection as soon as the request arrives, if not before.
+  // Past this timeout, it is taken to be busy with the request, and the response is waited for as usual.
+  constexpr static int kPooledConnectionCloseTimeoutMS = 1000;
+
+  // Waits for the first byte of the response, without consuming it. False if the server closes the connection instead.
+  static bool ResponseArrived(current::net::Connection& connection) {
+    pollfd fd;
+    fd.fd = static_cast<SOCKET>(connection.socket);
+    fd.events = POLLIN;
+    fd.revents = 0;
+    int retval;
+    do {
+#ifndef CURRENT_WINDOWS
+      retval = ::poll(&fd, 1, kPooledConnectionCloseTimeoutMS);
+#else
+      retval = ::WSAPoll(&fd, 1, kPooledConnectionCloseTimeoutMS);
+#endif  // CURRENT_WINDOWS
+    } while (retval < 0 && errno == EINTR);
+    if (retval == 0) {
+      return true;
+    }
+    char c;
+    do {
+      retval = static_cast<int>(::recv(static_cast<SOCKET>(connection.socket), &c, 1, MSG_PEEK));
+    } while (retval < 0 && errno == EINTR);
+    return retval > 0;
+  }
+
+  void SendRequest(current::net::Connection& connection, const URL& parsed_url) {
+    connection.BlockingWrite(
+        request_method_ + ' ' + parsed_url.path + parsed_url.ComposeParameters() + " HTTP/1.1\r\n", true);
+    connection.BlockingWrite("Host: " + parsed_url.host + "\r\n", true);
+    if (!request_user_agent_.empty()) {
+      connection.BlockingWrite("User-Agent: " + request_user_agent_ + "\r\n", true);
+    }
+    for (const auto& h : request_headers_) {
+      connection.BlockingWrite(h.header + ": " + h.value + "\r\n", true);
+    }
+    if (!request_headers_.cookies.empty()) {
+      connection.BlockingWrite("Cookie: " + request_headers_.CookiesAsString() + "\r\n", true);
+    }
+    if (!request_body_content_type_.empty()) {
+      connection.BlockingWrite("Content-Type: " + request_body_content_type_ + "\r\n", true);
+    }
+    if (!request_body_contents_.empty() || current::net::NeedContentLengthHeader(request_method_)) {
+      // NOTE(dkorolev): The `try/catch/throw` combo here is a hack for the unit test for HTTP 413 to pass.
+      // It swallows the `SocketWriteException` exception for huge payloads, as Current's HTTP server logic
+      // does intentionally close the HTTP connection prematurely if `Content-Length` exceeds a reasonable limit.
+      try {
+#ifndef CURRENT_WINDOWS
+        connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n", true);
+        connection.BlockingWrite("\r\n", true);
+        connection.BlockingWrite(request_body_contents_, false);
+#else
+        // TODO(grixa): this fix for the PayloadTooLarge test on Windows is temporary, need to revisit it.
+        connection.BlockingWrite("Content-Length: " + std::to_string(request_body_contents_.length()) + "\r\n\r\n" +
+                                     request_body_contents_,
+                                 false);
+#endif
+      } catch (const net::SocketWriteException&) {
+        if (request_body_contents_.length() <= net::constants::kMaxHTTPPayloadSizeInBytes) {
+          throw;
+        }
+      }
+    } else {
+      connection.BlockingWrite("\r\n", false);
+    }
+  }
+
  public:
   // Request parameters.
   std::string request_method_ = "";
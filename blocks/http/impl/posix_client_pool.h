@@ -0,0 +1,169 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2014 Dmitry "Dima" Korolev, <dmitry.korolev@gmail.com>.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The pool of idle keep-alive connections, used by `HTTPClientPOSIX` by default.
+//
+// After a response with `Connection: keep-alive`, the connection is returned into the pool, and the next request
+// to the same host and port reuses it instead of connecting again. The pool is bounded per host, and the connections
+// that have been idle for too long, or that have been closed by the server, are evicted.
+
+#ifndef BLOCKS_HTTP_IMPL_POSIX_CLIENT_POOL_H
+#define BLOCKS_HTTP_IMPL_POSIX_CLIENT_POOL_H
+
+#include "../../../port.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#ifndef CURRENT_WINDOWS
+#include <sys/socket.h>
+#endif  // CURRENT_WINDOWS
+
+#include "../../../bricks/net/tcp/tcp.h"
+#include "../../../bricks/util/singleton.h"
+
+namespace current {
+namespace http {
+
+struct HTTPClientConnectionPoolStats {
+  uint64_t hits = 0u;     // Requests sent over a pooled connection.
+  uint64_t misses = 0u;   // Requests that had to connect.
+  uint64_t evicted = 0u;  // Idle connections closed as stale, expired, or over the limit.
+  uint64_t idle = 0u;     // Idle connections in the pool now.
+};
+
+class HTTPClientConnectionPool final {
+ public:
+  constexpr static size_t kDefaultMaxIdleConnectionsPerHost = 8u;
+  // Below the server-side default of five seconds, not to reuse the connections the server is about to close.
+  constexpr static int64_t kDefaultIdleTimeoutMS = 4000;
+
+  // Zero `max_idle_connections_per_host` disables the pool.
+  void Configure(size_t max_idle_connections_per_host, std::chrono::milliseconds idle_timeout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_idle_connections_per_host_ = max_idle_connections_per_host;
+    idle_timeout_ = idle_timeout;
+    for (auto& host : idle_) {
+      EvictFromLockedSection(host.second, std::chrono::steady_clock::now());
+    }
+  }
+
+  // Returns an idle connection to `host:port`, or `nullptr` if there is none.
+  std::unique_ptr<current::net::Connection> Acquire(const std::string& host, int port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = idle_.find(Key(host, port));
+    if (it != idle_.end()) {
+      EvictFromLockedSection(it->second, std::chrono::steady_clock::now());
+      while (!it->second.empty()) {
+        std::unique_ptr<current::net::Connection> connection = std::move(it->second.back().connection);
+        it->second.pop_back();
+        if (IsOpen(*connection)) {
+          ++stats_.hits;
+          return connection;
+        } else {
+          ++stats_.evicted;
+        }
+      }
+    }
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  // Keeps the connection for the next request to `host:port`.
+  void Release(const std::string& host, int port, std::unique_ptr<current::net::Connection> connection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& connections = idle_[Key(host, port)];
+    connections.push_back(IdleConnection{std::move(connection), std::chrono::steady_clock::now()});
+    EvictFromLockedSection(connections, std::chrono::steady_clock::now());
+  }
+
+  HTTPClientConnectionPoolStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    HTTPClientConnectionPoolStats result = stats_;
+    result.idle = 0u;
+    for (const auto& host : idle_) {
+      result.idle += host.second.size();
+    }
+    return result;
+  }
+
+  // Closes all the idle connections, for the tests. Keeps the counters.
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.clear();
+  }
+
+ private:
+  struct IdleConnection final {
+    std::unique_ptr<current::net::Connection> connection;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  static std::string Key(const std::string& host, int port) { return host + ':' + std::to_string(port); }
+
+  // An idle connection should have nothing to read: the end of stream means the server has closed it,
+  // and any data would be out of place.
+  static bool IsOpen(current::net::Connection& connection) {
+#ifndef CURRENT_WINDOWS
+    char c;
+    const ssize_t retval = ::recv(static_cast<SOCKET>(connection.socket), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return retval < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#else
+    // No cheap check here, the client will retry over a new connection if this one turns out to be closed.
+    static_cast<void>(connection);
+    return true;
+#endif  // CURRENT_WINDOWS
+  }
+
+  // The oldest connections are at the front.
+  void EvictFromLockedSection(std::deque<IdleConnection>& connections, std::chrono::steady_clock::time_point now) {
+    while (!connections.empty() &&
+           (connections.size() > max_idle_connections_per_host_ || now - connections.front().since >= idle_timeout_)) {
+      connections.pop_front();
+      ++stats_.evicted;
+    }
+  }
+
+  mutable std::mutex mutex_;
+  size_t max_idle_connections_per_host_ = kDefaultMaxIdleConnectionsPerHost;
+  std::chrono::milliseconds idle_timeout_ = std::chrono::milliseconds(kDefaultIdleTimeoutMS);
+  std::map<std::string, std::deque<IdleConnection>> idle_;
+  HTTPClientConnectionPoolStats stats_;
+};
+
+inline HTTPClientConnectionPool& DefaultHTTPClientConnectionPool() {
+  return current::Singleton<HTTPClientConnectionPool>();
+}
+
+}  // namespace http
+}  // namespace current
+
+#endif  // BLOCKS_HTTP_IMPL_POSIX_CLIENT_POOL_H
@@ -25,16 +25,33 @@ SOFTWARE.
 #ifndef BLOCKS_HTTP_IMPL_POSIX_SERVER_H
 #define BLOCKS_HTTP_IMPL_POSIX_SERVER_H
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
+#include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 #include <iostream>  // TODO(dkorolev): More robust logging here.
 
+#ifndef CURRENT_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // CURRENT_WINDOWS
+
+#include <sys/stat.h>
+
 #include "../types.h"
 #include "../request.h"
 
+#include "posix_server_epoll.h"
+#include "posix_server_router.h"
+
 #include "../../url/url.h"
 
 #include "../../../typesystem/optional.h"
@@ -45,6 +62,7 @@ SOFTWARE.
 #include "../../../bricks/sync/owned_borrowed.h"
 #include "../../../bricks/time/chrono.h"
 #include "../../../bricks/util/accumulative_scoped_deleter.h"
+#include "../../../bricks/util/make_scope_guard.h"
 
 namespace current {
 namespace http {
@@ -97,12 +115,89 @@ struct ServeStaticFilesFromOptions {
   // Names of files to serve if a directory URL is requested, in the priority order (first found will be served).
   std::vector<std::string> index_filenames;
 
+  // Whether the files are read from disk for each request and sent with `sendfile()`, see `SendFiles()`,
+  // instead of being read into memory once, when the routes are registered.
+  bool send_files = false;
+  size_t cache_size_in_bytes = 0u;
+  size_t max_cached_file_size_in_bytes = 0u;
+
   explicit ServeStaticFilesFromOptions(std::string route_prefix_in = "/",
                                        std::string public_url_prefix_in = "",
                                        std::vector<std::string> index_filenames_in = {"index.html", "index.htm"})
       : route_prefix(std::move(route_prefix_in)),
         public_url_prefix(public_url_prefix_in.empty() ? route_prefix : std::move(public_url_prefix_in)),
         index_filenames(std::move(index_filenames_in)) {}
+
+  // Use as `ServeStaticFilesFromOptions("/static").SendFiles()`. The files are served with `ETag` and
+  // `Last-Modified`, and with "304 Not Modified" to the requests that already have the current version.
+  // The files of up to `max_cached_file_size` bytes are kept in memory, up to `cache_size` bytes in total,
+  // evicting the least recently used ones first. Unlike the files sent from disk, they may be compressed.
+  ServeStaticFilesFromOptions SendFiles(size_t cache_size = 0u, size_t max_cached_file_size = 64 * 1024) const {
+    ServeStaticFilesFromOptions result = *this;
+    result.send_files = true;
+    result.cache_size_in_bytes = cache_size;
+    result.max_cached_file_size_in_bytes = max_cached_file_size;
+    return result;
+  }
+};
+
+// The least recently used static files, shared by the `StaticFileServer`-s of one `ServeStaticFilesFrom()` call.
+// An entry is only used while its `etag` matches the file on disk.
+class StaticFilesCache final {
+ public:
+  struct File final {
+    std::string etag;
+    std::string content;
+  };
+
+  StaticFilesCache(size_t capacity_in_bytes, size_t max_file_size_in_bytes)
+      : capacity_in_bytes_(capacity_in_bytes), max_file_size_in_bytes_(max_file_size_in_bytes) {}
+
+  bool ShouldCache(size_t file_size) const {
+    return file_size <= max_file_size_in_bytes_ && file_size <= capacity_in_bytes_;
+  }
+
+  std::shared_ptr<const File> Get(const std::string& pathname, const std::string& etag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto cit = index_.find(pathname);
+    if (cit == index_.end() || cit->second->second->etag != etag) {
+      return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, cit->second);
+    return cit->second->second;
+  }
+
+  void Add(const std::string& pathname, std::shared_ptr<const File> file) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto cit = index_.find(pathname);
+    if (cit != index_.end()) {
+      size_in_bytes_ -= cit->second->second->content.length();
+      lru_.erase(cit->second);
+      index_.erase(cit);
+    }
+    size_in_bytes_ += file->content.length();
+    lru_.emplace_front(pathname, std::move(file));
+    index_[pathname] = lru_.begin();
+    while (size_in_bytes_ > capacity_in_bytes_) {
+      size_in_bytes_ -= lru_.back().second->content.length();
+      index_.erase(lru_.back().first);
+      lru_.pop_back();
+    }
+  }
+
+  size_t SizeInBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_in_bytes_;
+  }
+
+ private:
+  using lru_t = std::list<std::pair<std::string, std::shared_ptr<const File>>>;
+  const size_t capacity_in_bytes_;
+  const size_t max_file_size_in_bytes_;
+  mutable std::mutex mutex_;
+  lru_t lru_;  // The most recently used first.
+  std::unordered_map<std::string, lru_t::iterator> index_;
+  size_t size_in_bytes_ = 0u;
 };
 
 // Helper to serve a static file.
@@ -112,15 +207,22 @@ struct StaticFileServer {
   std::string content_type;
   bool serves_directory;
   std::string trailing_slash_redirect_url;
+  // If set, the file is served from disk, not from `content`. See `ServeStaticFilesFromOptions::SendFiles()`.
+  std::string pathname;
+  std::shared_ptr<StaticFilesCache> cache;
 
   StaticFileServer(std::string content,
                    std::string content_type,
                    bool serves_directory,
-                   std::string trailing_slash_redirect_url = "")
+                   std::string trailing_slash_redirect_url = "",
+                   std::string pathname = "",
+                   std::shared_ptr<StaticFilesCache> cache = nullptr)
       : content(std::move(content)),
         content_type(content_type),
         serves_directory(serves_directory),
-        trailing_slash_redirect_url(trailing_slash_redirect_url) {}
+        trailing_slash_redirect_url(trailing_slash_redirect_url),
+        pathname(std::move(pathname)),
+        cache(std::move(cache)) {}
 
   void operator()(Request r) {
     if (r.method == "GET") {
@@ -129,7 +231,11 @@ struct StaticFileServer {
         // (`static` is a directory, not a file).
         // 2) Respond with the content if we're serving a file and don't have a trailing slash. Example:
         // `/static/index.html`, `/static/file.png`.
-        r.connection.SendHTTPResponse(content, HTTPResponseCode.OK, net::http::Headers(), content_type);
+        if (pathname.empty()) {
+          r.connection.SendHTTPResponse(content, HTTPResponseCode.OK, net::http::Headers(), content_type);
+        } else {
+          SendFile(r);
+        }
       } else if (!serves_directory && r.url_path_had_trailing_slash) {
         // Respond with HTTP 404 Not Found if we're serving a file and have a trailing slash. Example:
         // `/static/index.html/`.
@@ -154,39 +260,235 @@ struct StaticFileServer {
                                     current::net::constants::kDefaultHTMLContentType);
     }
   }
+
+ private:
+  void SendFile(Request& r) const {
+    struct stat info;
+#ifndef CURRENT_WINDOWS
+    const int fd = ::open(pathname.c_str(), O_RDONLY);
+    if (fd < 0 || ::fstat(fd, &info)) {
+      if (fd >= 0) {
+        ::close(fd);  // LCOV_EXCL_LINE
+      }
+#else
+    // No `sendfile()` on Windows, so the file is read into memory by its name, see below.
+    if (::stat(pathname.c_str(), &info)) {
+#endif  // CURRENT_WINDOWS
+      r.connection.SendHTTPResponse(current::net::DefaultNotFoundMessage(),
+                                    HTTPResponseCode.NotFound,
+                                    current::net::http::Headers(),
+                                    current::net::constants::kDefaultHTMLContentType);
+      return;
+    }
+#ifndef CURRENT_WINDOWS
+    const auto fd_closer = current::MakeScopeGuard([fd]() { ::close(fd); });
+#endif  // CURRENT_WINDOWS
+
+    const size_t size = static_cast<size_t>(info.st_size);
+    const std::chrono::microseconds modified(static_cast<int64_t>(info.st_mtime) * 1000000);
+    // The version of the file is its size and modification time, the way most web servers tell it.
+    const std::string etag = current::strings::Printf("\"%llx-%llx\"",
+                                                      static_cast<unsigned long long>(size),
+                                                      static_cast<unsigned long long>(info.st_mtime));
+    net::http::Headers headers;
+    headers.Set("ETag", etag);
+    headers.Set("Last-Modified", current::FormatDateTimeAsIMFFix(modified));
+
+    if (IsNotModified(r.headers, etag, modified)) {
+      r.connection.SendHTTPResponse("", HTTPResponseCode.NotModified, headers, content_type);
+    } else if (cache && cache->ShouldCache(size)) {
+      std::shared_ptr<const StaticFilesCache::File> file = cache->Get(pathname, etag);
+      if (!file) {
+        auto new_file = std::make_shared<StaticFilesCache::File>();
+        new_file->etag = etag;
+#ifndef CURRENT_WINDOWS
+        new_file->content.resize(size);
+        size_t offset = 0u;
+        while (offset < size) {
+          const auto bytes_read = ::read(fd, &new_file->content[offset], size - offset);
+          if (bytes_read <= 0) {
+            break;  // LCOV_EXCL_LINE
+          }
+          offset += static_cast<size_t>(bytes_read);
+        }
+        new_file->content.resize(offset);
+#else
+        new_file->content = current::FileSystem::ReadFileAsString(pathname);
+#endif  // CURRENT_WINDOWS
+        cache->Add(pathname, new_file);
+        file = std::move(new_file);
+      }
+      r.connection.SendHTTPResponse(file->content, HTTPResponseCode.OK, headers, content_type);
+    } else {
+#ifndef CURRENT_WINDOWS
+      r.connection.SendHTTPResponseFromFile(fd, 0u, size, HTTPResponseCode.OK, headers, content_type);
+#else
+      r.connection.SendHTTPResponse(
+          current::FileSystem::ReadFileAsString(pathname), HTTPResponseCode.OK, headers, content_type);
+#endif  // CURRENT_WINDOWS
+    }
+  }
+
+  // `If-None-Match` takes precedence over `If-Modified-Since`, as per RFC 7232.
+  static bool IsNotModified(const net::http::Headers& headers,
+                            const std::string& etag,
+                            std::chrono::microseconds modified) {
+    if (headers.Has("If-None-Match")) {
+      for (const std::string& tag : current::strings::Split(headers.Get("If-None-Match"), ',')) {
+        const std::string trimmed = current::strings::Trim(tag);
+        if (trimmed == "*" || trimmed == etag || trimmed == "W/" + etag) {
+          return true;
+        }
+      }
+      return false;
+    } else if (headers.Has("If-Modified-Since")) {
+      try {
+        return modified <= net::http::ParseHTTPDate(headers.Get("If-Modified-Since"));
+      } catch (const net::http::InvalidHTTPDateException&) {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+};
+
+// What is registered for a route: the handler, and whether it reads the body itself, see `StreamRequestBody`.
+struct HTTPRouteHandler final {
+  std::function<void(Request)> handler;
+  bool stream_body;
+  size_t max_body_length;
+
+  explicit HTTPRouteHandler(std::function<void(Request)> handler)
+      : handler(std::move(handler)),
+        stream_body(false),
+        max_body_length(net::constants::kMaxHTTPPayloadSizeInBytes) {}
+  HTTPRouteHandler(std::function<void(Request)> handler, const StreamRequestBody& options)
+      : handler(std::move(handler)), stream_body(true), max_body_length(options.max_body_length) {}
+};
+
+// The ways `HTTPServerPOSIX` can accept connections and read requests.
+enum class HTTPServerEngine : int {
+  AcceptLoop = 0,  // One thread per port accepts, reads, and handles the requests one by one.
+  EPoll = 1        // Reads the requests with non-blocking calls, and handles them in a pool of worker threads.
+};
+
+// Passed as `HTTP(port, options)` on the first access to the port, before the server on it is started.
+struct HTTPServerOptions {
+  HTTPServerEngine engine = HTTPServerEngine::AcceptLoop;
+  size_t worker_threads = 0u;  // For the `EPoll` engine, zero for the number of cores.
+
+  // Persistent connections, zero `max_requests_per_connection` to close each connection after one response.
+  // Only the `EPoll` engine keeps the connections alive, as the `AcceptLoop` one serves one connection at a time.
+  size_t max_requests_per_connection = 0u;
+  std::chrono::milliseconds keep_alive_idle_timeout = std::chrono::milliseconds(5000);
+
+  // For the `EPoll` engine, the longest a client may take to send its request, headers and all, before the connection
+  // is closed, counting from the connection being accepted, or from the first byte of the next request on a kept
+  // alive one. Guards against the clients holding the connections open by sending their requests byte by byte.
+  std::chrono::milliseconds request_read_timeout = std::chrono::milliseconds(10000);
+
+  // The number of listening sockets, each with its own thread accepting the connections, see `Listeners()`.
+  size_t listeners = 1u;
+
+  static HTTPServerOptions AcceptLoop() { return HTTPServerOptions(); }
+
+  // Falls back to `AcceptLoop` on the systems with no `epoll`.
+  static HTTPServerOptions EPoll(size_t worker_threads = 0u) {
+    HTTPServerOptions result;
+    result.engine = HTTPServerEngine::EPoll;
+    result.worker_threads = worker_threads;
+    return result;
+  }
+
+  // Use as `HTTPServerOptions::EPoll().KeepAlive()`. The connections that have not sent the next request
+  // within `idle_timeout` are closed, and so are the ones that have been used for `max_requests` requests.
+  HTTPServerOptions KeepAlive(std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(5000),
+                              size_t max_requests = 1000u) const {
+    HTTPServerOptions result = *this;
+    result.max_requests_per_connection = max_requests;
+    result.keep_alive_idle_timeout = idle_timeout;
+    return result;
+  }
+
+  // Use as `HTTPServerOptions::EPoll().RequestReadTimeout(std::chrono::seconds(1))`.
+  HTTPServerOptions RequestReadTimeout(std::chrono::milliseconds timeout) const {
+    HTTPServerOptions result = *this;
+    result.request_read_timeout = timeout;
+    return result;
+  }
+
+  // Use as `HTTPServerOptions().Listeners(4)`, zero for the number of cores. Each listener has its own
+  // `SO_REUSEPORT` socket on the port, and the kernel balances the connections among them. With the `EPoll`
+  // engine, each listener runs its own reactor, and the worker threads are split among them.
+  // The routes are shared by all the listeners.
+  HTTPServerOptions Listeners(size_t count = 0u) const {
+    HTTPServerOptions result = *this;
+    result.listeners =
+        count ? count : std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1u));
+    return result;
+  }
 };
 
 // HTTP server bound to a specific port.
 class HTTPServerPOSIX final {
  public:
+  using options_t = HTTPServerOptions;
+
   // The constructor starts listening on the specified port.
   // Since instances of `HTTPServerPOSIX` are created via a singleton,
-  // a listening thread will only be created once per port, on the first access to that port.
-  explicit HTTPServerPOSIX(uint16_t port)
-      : terminating_(false), port_(port), thread_(&HTTPServerPOSIX::Thread, this, current::net::Socket(port)) {}
+  // the listening threads will only be created once per port, on the first access to that port.
+  explicit HTTPServerPOSIX(uint16_t port, const HTTPServerOptions& options = HTTPServerOptions())
+      : terminating_(false), port_(port), options_(options), active_listeners_(0u) {
+    // All the sockets are bound before any thread is started, for the constructor to throw if the port is taken.
+    std::vector<current::net::Socket> sockets;
+    if (options_.listeners > 1u) {
+      for (size_t i = 0; i < options_.listeners; ++i) {
+        sockets.emplace_back(port,
+                             current::net::kMaxServerQueuedConnections,
+                             current::net::kDisableNagleAlgorithmByDefault,
+                             true);
+      }
+    } else {
+      sockets.emplace_back(port);
+    }
+    active_listeners_ = sockets.size();
+    for (auto& socket : sockets) {
+      threads_.emplace_back(&HTTPServerPOSIX::Thread, this, std::move(socket));
+    }
+  }
 
   // The destructor closes the socket.
   // Note that the destructor will only be run on the shutdown of the binary,
   // unregistering all handlers will still keep the listening thread up, and it will serve 404-s.
   ~HTTPServerPOSIX() {
     terminating_ = true;
-    // Notify the server thread that it should terminate.
+    // Notify the server threads that they should terminate.
     // Effectively, call `HTTP(GET("/healthz"))`, but in a way that avoids client <=> server dependency.
-    // LCOV_EXCL_START
-    try {
-      // TODO(dkorolev): This should always use the POSIX implemenation of the client, nothing fancier.
-      // It is a safe call, since the server itself is POSIX, so the architecture we are on is POSIX-friendly.
-      current::net::Connection(current::net::ClientSocket("localhost", port_))
-          .BlockingWrite("GET /healthz HTTP/1.1\r\n\r\n", true);
-    } catch (const current::Exception&) {
-      // It is guaranteed that after `terminated_` is set the server will be terminated on the next request,
-      // but it might so happen that that terminating request will happen between `terminating_ = true`
-      // and the consecutive request. Which is perfectly fine, since it implies that the server has terminated.
+    // With several listeners, each connection goes to one of them, picked by the kernel, so keep connecting
+    // until they all are done.
+    while (active_listeners_) {
+      // LCOV_EXCL_START
+      try {
+        // TODO(dkorolev): This should always use the POSIX implemenation of the client, nothing fancier.
+        // It is a safe call, since the server itself is POSIX, so the architecture we are on is POSIX-friendly.
+        current::net::Connection(current::net::ClientSocket("localhost", port_))
+            .BlockingWrite("GET /healthz HTTP/1.1\r\n\r\n", true);
+      } catch (const current::Exception&) {
+        // It is guaranteed that after `terminated_` is set the server will be terminated on the next request,
+        // but it might so happen that that terminating request will happen between `terminating_ = true`
+        // and the consecutive request. Which is perfectly fine, since it implies that the server has terminated.
+      }
+      // LCOV_EXCL_STOP
+      for (int i = 0; i < 100 && active_listeners_; ++i) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
     }
-    // LCOV_EXCL_STOP
-    // Wait for the thread to terminate.
-    if (thread_.joinable()) {
-      thread_.join();
+    // Wait for the threads to terminate.
+    for (auto& thread : threads_) {
+      if (thread.joinable()) {
+        thread.join();
+      }
     }
   }
 
@@ -194,7 +496,9 @@ class HTTPServerPOSIX final {
   // instead of `while(true)`
   // LCOV_EXCL_START
   void Join() {
-    thread_.join();  // May throw.
+    for (auto& thread : threads_) {
+      thread.join();  // May throw.
+    }
   }
   // LCOV_EXCL_STOP
 
@@ -217,7 +521,10 @@ class HTTPServerPOSIX final {
                                 const URLPathArgs::CountMask path_args_count_mask,
                                 F& handler) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return DoRegisterHandler(path, [&handler](Request r) { handler(std::move(r)); }, path_args_count_mask, POLICY);
+    return DoRegisterHandler(path,
+                             HTTPRouteHandler([&handler](Request r) { handler(std::move(r)); }),
+                             path_args_count_mask,
+                             POLICY);
   }
 
   template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt>
@@ -225,44 +532,79 @@ class HTTPServerPOSIX final {
                                 const URLPathArgs::CountMask path_args_count_mask,
                                 std::function<void(Request)> handler) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return DoRegisterHandler(path, handler, path_args_count_mask, POLICY);
+    return DoRegisterHandler(path, HTTPRouteHandler(std::move(handler)), path_args_count_mask, POLICY);
   }
 
   // Two argument version registers handler with no URL path arguments.
   template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt, typename F>
   HTTPRoutesScopeEntry Register(const std::string& path, F& handler) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return DoRegisterHandler(
-        path, [&handler](Request r) { handler(std::move(r)); }, URLPathArgs::CountMask::None, POLICY);
+    return DoRegisterHandler(path,
+                             HTTPRouteHandler([&handler](Request r) { handler(std::move(r)); }),
+                             URLPathArgs::CountMask::None,
+                             POLICY);
   }
   template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt>
   HTTPRoutesScopeEntry Register(const std::string& path, std::function<void(Request)> handler) {
     std::lock_guard<std::mutex> lock(mutex_);
-    return DoRegisterHandler(path, handler, URLPathArgs::CountMask::None, POLICY);
+    return DoRegisterHandler(path, HTTPRouteHandler(std::move(handler)), URLPathArgs::CountMask::None, POLICY);
+  }
+
+  // The handlers that read the body of the request themselves, as it arrives, see `StreamRequestBody`.
+  template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt, typename F>
+  HTTPRoutesScopeEntry Register(const std::string& path,
+                                const URLPathArgs::CountMask path_args_count_mask,
+                                const StreamRequestBody& stream_body,
+                                F& handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DoRegisterHandler(path,
+                             HTTPRouteHandler([&handler](Request r) { handler(std::move(r)); }, stream_body),
+                             path_args_count_mask,
+                             POLICY);
+  }
+  template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt>
+  HTTPRoutesScopeEntry Register(const std::string& path,
+                                const URLPathArgs::CountMask path_args_count_mask,
+                                const StreamRequestBody& stream_body,
+                                std::function<void(Request)> handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DoRegisterHandler(path, HTTPRouteHandler(std::move(handler), stream_body), path_args_count_mask, POLICY);
+  }
+  template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt, typename F>
+  HTTPRoutesScopeEntry Register(const std::string& path, const StreamRequestBody& stream_body, F& handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DoRegisterHandler(path,
+                             HTTPRouteHandler([&handler](Request r) { handler(std::move(r)); }, stream_body),
+                             URLPathArgs::CountMask::None,
+                             POLICY);
+  }
+  template <ReRegisterRoute POLICY = ReRegisterRoute::ThrowOnAttempt>
+  HTTPRoutesScopeEntry Register(const std::string& path,
+                                const StreamRequestBody& stream_body,
+                                std::function<void(Request)> handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return DoRegisterHandler(
+        path, HTTPRouteHandler(std::move(handler), stream_body), URLPathArgs::CountMask::None, POLICY);
   }
 
+  // Returns once the handler is not in use by any request.
   void UnRegister(const std::string& path,
                   const URLPathArgs::CountMask path_args_count_mask = URLPathArgs::CountMask::None) {
     std::lock_guard<std::mutex> lock(mutex_);
     URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
     for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask <<= 1) {
-      if ((path_args_count_mask & mask) == mask) {
-        auto it1 = handlers_.find(path);
-        if (it1 == handlers_.end()) {
-          CURRENT_THROW(HandlerDoesNotExistException(path));
-        }
-        auto& map = it1->second;
-        auto it2 = map.find(i);
-        if (it2 == map.end()) {
-          CURRENT_THROW(HandlerDoesNotExistException(path));
-        }
-        map.erase(it2);
-        if (map.empty()) {
-          // Maintain the value of `PathHandlersCount()` invariant.
-          handlers_.erase(it1);
-        }
+      if ((path_args_count_mask & mask) == mask && !router_.HasHandler(path, i)) {
+        CURRENT_THROW(HandlerDoesNotExistException(path));
       }
     }
+    router_.Update(path, [path_args_count_mask](router_t::handlers_t& handlers) {
+      URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;
+      for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask <<= 1) {
+        if ((path_args_count_mask & mask) == mask) {
+          handlers[i] = nullptr;
+        }
+      }
+    });
   }
 
   HTTPRoutesScope ServeStaticFilesFrom(const std::string& dir,
@@ -270,9 +612,13 @@ class HTTPServerPOSIX final {
     ValidateRoute(options.route_prefix);
 
     HTTPRoutesScope scope;
+    const std::shared_ptr<StaticFilesCache> cache =
+        (options.send_files && options.cache_size_in_bytes)
+            ? std::make_shared<StaticFilesCache>(options.cache_size_in_bytes, options.max_cached_file_size_in_bytes)
+            : nullptr;
     current::FileSystem::ScanDir(
         dir,
-        [this, &options, &scope](const current::FileSystem::ScanDirItemInfo& item_info) {
+        [this, &options, &scope, &cache](const current::FileSystem::ScanDirItemInfo& item_info) {
           // Ignore files named with a leading dot (means hidden in POSIX) before checking MIME type.
           if (item_info.basename.front() == '.') {
             return;
@@ -306,12 +652,14 @@ class HTTPServerPOSIX final {
 
             // TODO(dkorolev): Wrap keeping file contents into a singleton
             // that keeps a map from a (SHA256) hash to the contents.
-            std::string content = current::FileSystem::ReadFileAsString(item_info.pathname);
+            std::string content =
+                options.send_files ? "" : current::FileSystem::ReadFileAsString(item_info.pathname);
+            const std::string pathname = options.send_files ? item_info.pathname : "";
 
             // If it's an index file, serve it additionally at the route without the filename (i.e. the directory
             // route).
             if (is_index_file) {
-              if (handlers_.find(route_for_directory) != handlers_.end()) {
+              if (router_.HasPath(route_for_directory)) {
                 CURRENT_THROW(ServeStaticFilesFromCannotServeMoreThanOneIndexFile(route_for_directory + ' ' +
                                                                                   item_info.basename));
               }
@@ -322,13 +670,14 @@ class HTTPServerPOSIX final {
                                                         (path_components_empty ? "" : path_components_joined + "/");
               CURRENT_ASSERT(trailing_slash_redirect_url.length() > 0 && trailing_slash_redirect_url.back() == '/');
 
-              auto static_file_server =
-                  std::make_unique<StaticFileServer>(content, content_type, true, trailing_slash_redirect_url);
+              auto static_file_server = std::make_unique<StaticFileServer>(
+                  content, content_type, true, trailing_slash_redirect_url, pathname, cache);
               scope += Register(route_for_directory, *static_file_server);
               static_file_servers_.push_back(std::move(static_file_server));
             }
 
-            auto static_file_server = std::make_unique<StaticFileServer>(std::move(content), content_type, false);
+            auto static_file_server =
+                std::make_unique<StaticFileServer>(std::move(content), content_type, false, "", pathname, cache);
             scope += Register(route_for_file, *static_file_server);
             static_file_servers_.push_back(std::move(static_file_server));
           } else {
@@ -344,7 +693,7 @@ class HTTPServerPOSIX final {
     // NOTE: The total number of handlers is no longer an interesting measure.
     //       Just return the number of distinct paths, which may be path prefixes.
     std::lock_guard<std::mutex> lock(mutex_);
-    return handlers_.size();
+    return router_.PathsCount();
   }
 
  private:
@@ -353,10 +702,9 @@ class HTTPServerPOSIX final {
   // Note: If the user code handles the request synchronously, the scoped HTTP registerers will do the job.
   // If the user handles the request from another thread, it's the responsibility of the user to make sure
   // the very object ("this") does not get destroyed while the request is being handled.
-  Optional<Borrowed<std::function<void(Request)>>> FindHandler(const std::string& path,
+  // No mutex is locked here, see `HTTPServerRouter`.
+  Optional<Borrowed<HTTPRouteHandler>> FindHandler(const std::string& path,
                                                                URLPathArgs& output_url_args) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     // LCOV_EXCL_START
     if (path.empty()) {
       std::cerr << "HTTP: path is empty.\n";
@@ -368,97 +716,118 @@ class HTTPServerPOSIX final {
     }
     // LCOV_EXCL_STOP
 
-    // Work with the path by trying to match the full one, then the one with the last component removed,
-    // then the one with two last components removed, etc.
-    // As a component is removed, it's removed from `base_path` and is added to `url_args`.
-    std::string& remaining_path = output_url_args.base_path;
-    remaining_path = path;
-
-    // Friendly reminder: `remaining_path[0]` is guaranteed to be '/'.
-    while (true) {
-      while (remaining_path.length() > 1 && remaining_path.back() == '/') {
-        remaining_path.resize(remaining_path.length() - 1);
-      }
-
-      const auto cit = handlers_.find(remaining_path);
-      if (cit != handlers_.end()) {
-        const auto cit2 = cit->second.find(output_url_args.size());
-        if (cit2 != cit->second.end()) {
-          return Borrowed<std::function<void(Request)>>(cit2->second);
-        }
-      }
-
-      if (remaining_path == "/") {
-        break;
-      }
-
-      const size_t arg_begin_index = remaining_path.rfind('/') + 1;
-      output_url_args.add(URL::DecodeURIComponent(remaining_path.substr(arg_begin_index)));
-      remaining_path.resize(arg_begin_index);
-    }
-
-    return nullptr;
+    // The handler registered for the longest prefix of the path, with the number of URL path arguments
+    // matching the number of the remaining path components, if any.
+    return router_.Find(path, output_url_args);
   }
 
   void Thread(current::net::Socket socket) {
-    // TODO(dkorolev): Benchmark QPS.
+    const auto listener_done = current::MakeScopeGuard([this]() { --active_listeners_; });
+#ifdef CURRENT_HTTP_SERVER_EPOLL_SUPPORTED
+    if (options_.engine == HTTPServerEngine::EPoll) {
+      const size_t worker_threads =
+          options_.worker_threads
+              ? options_.worker_threads
+              : std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1u));
+      HTTPServerEPollReactor(std::max(worker_threads / options_.listeners, static_cast<size_t>(1u)),
+                             options_.max_requests_per_connection,
+                             options_.keep_alive_idle_timeout,
+                             options_.request_read_timeout,
+                             [this](current::net::Connection&& connection,
+                                    HTTPServerEPollReactor::keep_alive_t keep_alive) {
+                               ServeConnection(std::move(connection), std::move(keep_alive));
+                             }).Run(socket, [this]() -> bool { return terminating_; });
+      return;
+    }
+#endif
     while (!terminating_) {
       try {
-        std::unique_ptr<current::net::HTTPServerConnection> connection(
-            new current::net::HTTPServerConnection(socket.Accept()));
-        if (terminating_) {
-          // Already terminating. Will not send the response, and this
-          // lack of response should not result in an exception.
-          connection->DoNotSendAnyResponse();
-          break;
+        ServeConnection(socket.Accept());
+      } catch (const current::Exception& e) {  // LCOV_EXCL_LINE
+        std::cerr << "HTTP accept failed: " << e.what() << '\n';  // LCOV_EXCL_LINE
+      }
+    }
+  }
+
+  // Parses the request from the connection and runs the handler for it. Called from the accepting thread
+  // by the `AcceptLoop` engine, and from the worker threads by the `EPoll` one.
+  // A non-empty `keep_alive` is where the connection goes after the response, if the client wants it kept open.
+  void ServeConnection(current::net::Connection&& raw_connection,
+                       std::function<void(current::net::Connection&&)> keep_alive = nullptr) {
+    try {
+      // The route is looked up as soon as the headers are parsed, for its handler to read the body, if it streams it.
+      URLPathArgs url_path_args;
+      Optional<Borrowed<HTTPRouteHandler>> handler;
+      bool routed = false;
+      std::unique_ptr<current::net::HTTPServerConnection> connection(new current::net::HTTPServerConnection(
+          std::move(raw_connection), [this, &url_path_args, &handler, &routed](const net::HTTPRequestData& request) {
+            handler = FindHandler(request.URL().path, url_path_args);
+            routed = true;
+            return Exists(handler) && Value(handler)->stream_body;
+          }));
+      if (terminating_) {
+        // Already terminating. Will not send the response, and this
+        // lack of response should not result in an exception.
+        connection->DoNotSendAnyResponse();
+        return;
+      }
+      if (keep_alive) {
+        connection->KeepAlive(std::move(keep_alive));
+      }
+      if (!routed) {
+        handler = FindHandler(connection->HTTPRequest().URL().path, url_path_args);
+      }
+      if (Exists(handler)) {
+        if (Value(handler)->stream_body) {
+          connection->LimitBodyLength(Value(handler)->max_body_length);
         }
-        URLPathArgs url_path_args;
-        const auto handler = FindHandler(connection->HTTPRequest().URL().path, url_path_args);
-        if (Exists(handler)) {
-          // OK, here's the tricky part with error handling and exceptions in this multithreaded world.
-          // * On the one hand, the connection should be std::move-d into the request,
-          //   since it might end up being served in another thread, via a message queue, etc.
-          //   Thus, the user code is responsible for closing the connection.
-          //   Not to mention that the std::move-d away connection can easily outlive this scope.
-          // * On the other hand, if an exception occurs in user code, we need to return a 500,
-          //   which should obviously happen before the connection object is destructed.
-          //   This seems like a good reason to not std::move it away, or move it away with some flag,
-          //   but I thought hard of it, and don't think it's a good choice -- D.K.
-          //
-          // Solution: Do nothing here. No matter how tempting it is, it won't work across threads. Period.
-          //
-          // The implementation of HTTP connection will return an "INTERNAL SERVER ERROR"
-          // if no response was sent. That's what the user gets. In debugger, they can put a breakpoint there
-          // and see what caused the error.
-          //
-          // It is the job of the user of this library to ensure no exceptions leave their code.
-          // In practice, a top-level try-catch for `const current::Exception& e` is good enough.
-          try {
-            (*Value(handler))(Request(std::move(connection), url_path_args));
-          } catch (const current::Exception& e) {  // LCOV_EXCL_LINE
-            // WARNING: This `catch` is really not sufficient, it just logs a message
-            // if a user exception occurred in the same thread that ran the handler.
-            // DO NOT COUNT ON IT.
-            std::cerr << "HTTP route failed in user code: " << e.what() << '\n';  // LCOV_EXCL_LINE
-          }
-        } else {
-          connection->SendHTTPResponse(current::net::DefaultNotFoundMessage(),
-                                       HTTPResponseCode.NotFound,
-                                       current::net::http::Headers(),
-                                       current::net::constants::kDefaultHTMLContentType);
+        // OK, here's the tricky part with error handling and exceptions in this multithreaded world.
+        // * On the one hand, the connection should be std::move-d into the request,
+        //   since it might end up being served in another thread, via a message queue, etc.
+        //   Thus, the user code is responsible for closing the connection.
+        //   Not to mention that the std::move-d away connection can easily outlive this scope.
+        // * On the other hand, if an exception occurs in user code, we need to return a 500,
+        //   which should obviously happen before the connection object is destructed.
+        //   This seems like a good reason to not std::move it away, or move it away with some flag,
+        //   but I thought hard of it, and don't think it's a good choice -- D.K.
+        //
+        // Solution: Do nothing here. No matter how tempting it is, it won't work across threads. Period.
+        //
+        // The implementation of HTTP connection will return an "INTERNAL SERVER ERROR"
+        // if no response was sent. That's what the user gets. In debugger, they can put a breakpoint there
+        // and see what caused the error.
+        //
+        // It is the job of the user of this library to ensure no exceptions leave their code.
+        // In practice, a top-level try-catch for `const current::Exception& e` is good enough.
+        try {
+          Value(handler)->handler(Request(std::move(connection), url_path_args));
+        } catch (const current::net::HTTPPayloadTooLarge&) {
+          // Thrown by `Request::ReadBody()`, which has already responded with "413 ENTITY TOO LARGE".
+        } catch (const current::net::ChunkSizeNotAValidHEXValue&) {
+          // Thrown by `Request::ReadBody()`, which has already responded with "400 BAD REQUEST".
+        } catch (const current::Exception& e) {  // LCOV_EXCL_LINE
+          // WARNING: This `catch` is really not sufficient, it just logs a message
+          // if a user exception occurred in the same thread that ran the handler.
+          // DO NOT COUNT ON IT.
+          std::cerr << "HTTP route failed in user code: " << e.what() << '\n';  // LCOV_EXCL_LINE
         }
-      } catch (const current::net::ChunkSizeNotAValidHEXValue&) {
-        // The `ChunkSizeNotAValidHEXValue` situation, if emerged, is already handled with a "400 BAD REQUEST" response.
-      } catch (const current::net::HTTPPayloadTooLarge&) {
-        // The `HTTPPayloadTooLarge` situation, if emerged, is already handled with a "413 ENTITY TOO LARGE" response.
-      } catch (const current::net::HTTPRequestBodyLengthNotProvided&) {
-        // The `HTTPRequestBodyLengthNotProvided` situation, if emerged, is already handled with "411 LENGTH REQUIRED".
-      } catch (const current::net::EmptySocketException&) {  // LCOV_EXCL_LINE
-        // Silently discard errors if no data was sent in.
-      } catch (const current::Exception& e) {  // LCOV_EXCL_LINE
-        // TODO(dkorolev): More reliable logging.
-        std::cerr << "HTTP route failed: " << e.what() << '\n';  // LCOV_EXCL_LINE
+      } else {
+        connection->SendHTTPResponse(current::net::DefaultNotFoundMessage(),
+                                     HTTPResponseCode.NotFound,
+                                     current::net::http::Headers(),
+                                     current::net::constants::kDefaultHTMLContentType);
       }
+    } catch (const current::net::ChunkSizeNotAValidHEXValue&) {
+      // The `ChunkSizeNotAValidHEXValue` situation, if emerged, is already handled with a "400 BAD REQUEST" response.
+    } catch (const current::net::HTTPPayloadTooLarge&) {
+      // The `HTTPPayloadTooLarge` situation, if emerged, is already handled with a "413 ENTITY TOO LARGE" response.
+    } catch (const current::net::HTTPRequestBodyLengthNotProvided&) {
+      // The `HTTPRequestBodyLengthNotProvided` situation, if emerged, is already handled with "411 LENGTH REQUIRED".
+    } catch (const current::net::EmptySocketException&) {  // LCOV_EXCL_LINE
+      // Silently discard errors if no data was sent in.
+    } catch (const current::Exception& e) {  // LCOV_EXCL_LINE
+      // TODO(dkorolev): More reliable logging.
+      std::cerr << "HTTP route failed: " << e.what() << '\n';  // LCOV_EXCL_LINE
     }
   }
 
@@ -475,7 +844,7 @@ class HTTPServerPOSIX final {
   }
 
   HTTPRoutesScopeEntry DoRegisterHandler(const std::string& path,
-                                         std::function<void(Request)> handler,
+                                         const HTTPRouteHandler& handler,
                                          const URLPathArgs::CountMask path_args_count_mask,
                                          const ReRegisterRoute policy) {
     // LCOV_EXCL_START
@@ -488,12 +857,10 @@ class HTTPServerPOSIX final {
 
     {
       // Step 1: Confirm the request is valid.
-      const auto handlers_per_path_iterator = handlers_.find(path);
       URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
       for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask = mask << 1) {
         if ((path_args_count_mask & mask) == mask) {
-          if (handlers_per_path_iterator == handlers_.end() ||
-              handlers_per_path_iterator->second.find(i) == handlers_per_path_iterator->second.end()) {
+          if (!router_.HasHandler(path, i)) {
             // No such handler. Throw if trying to "Update" it.
             if (policy == ReRegisterRoute::SilentlyUpdateExisting) {
               CURRENT_THROW(HandlerDoesNotExistException(path));
@@ -508,16 +875,15 @@ class HTTPServerPOSIX final {
       }
     }
 
-    {
-      // Step 2: Update.
-      auto& handlers_per_path = handlers_[path];
-      URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
+    // Step 2: Update.
+    router_.Update(path, [&handler, path_args_count_mask](router_t::handlers_t& handlers) {
+      URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;
       for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask = mask << 1) {
         if ((path_args_count_mask & mask) == mask) {
-          handlers_per_path[i] = MakeOwned<std::function<void(Request)>>(handler);
+          handlers[i] = std::make_shared<Owned<HTTPRouteHandler>>(ConstructOwned<HTTPRouteHandler>(), handler);
         }
       }
-    }
+    });
 
     if (policy == ReRegisterRoute::SilentlyUpdateExisting) {
       return HTTPRoutesScopeEntry();
@@ -530,12 +896,15 @@ class HTTPServerPOSIX final {
 
   std::atomic_bool terminating_;
   const uint16_t port_;
-  std::thread thread_;
+  const HTTPServerOptions options_;
+  std::atomic_size_t active_listeners_;
+  std::vector<std::thread> threads_;  // One per listener.
 
-  // TODO(dkorolev): Look into read-write mutexes here.
+  // Serializes the changes to the routes. The lookups do not lock it.
   mutable std::mutex mutex_;
 
-  std::map<std::string, std::map<size_t, Owned<std::function<void(Request)>>>> handlers_;
+  using router_t = HTTPServerRouter<HTTPRouteHandler>;
+  router_t router_;
   std::vector<std::unique_ptr<StaticFileServer>> static_file_servers_;
 };
 
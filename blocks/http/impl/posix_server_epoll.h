@@ -0,0 +1,369 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2014 Dmitry "Dima" Korolev, <dmitry.korolev@gmail.com>.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The event-driven engine of `HTTPServerPOSIX`, enabled by `HTTPServerOptions::EPoll()`.
+//
+// A single thread accepts the connections and reads the requests with non-blocking calls, and only hands
+// the complete ones over to the pool of worker threads, which parse them with the regular blocking code and run
+// the handlers. Thus a client sending its request slowly does not stall the others, and a slow handler only
+// occupies one worker. The responses, including the chunked ones, are sent from the worker threads as before.
+//
+// With keep-alive, the connection is handed back to the reactor once the response has been sent, and waits there
+// for the next request. The pipelined requests already read by the parser are dispatched right away.
+//
+// The connections that take longer than the request read timeout to send the request, counting from the connection
+// being accepted, or from the first byte of the next request on a kept alive connection, are closed. Otherwise a client
+// trickling the bytes of its headers in, or not sending anything at all, would hold its connection open forever.
+
+#ifndef BLOCKS_HTTP_IMPL_POSIX_SERVER_EPOLL_H
+#define BLOCKS_HTTP_IMPL_POSIX_SERVER_EPOLL_H
+
+#include "../../../port.h"
+
+#if defined(CURRENT_POSIX) && defined(__linux__)
+#define CURRENT_HTTP_SERVER_EPOLL_SUPPORTED
+#endif
+
+#ifdef CURRENT_HTTP_SERVER_EPOLL_SUPPORTED
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../../../bricks/net/exceptions.h"
+#include "../../../bricks/net/http/http.h"
+
+namespace current {
+namespace http {
+
+class HTTPServerEPollReactor final {
+ public:
+  // The requests are dispatched as soon as they are complete, or once this many bytes have been read ahead,
+  // whichever comes first. In the latter case the worker keeps reading the request with blocking calls.
+  constexpr static size_t kMaxReadAheadBytes = 1024 * 1024;
+  constexpr static int kMaxEventsPerWait = 256;
+
+  // The `keep_alive` passed to `serve` is empty if the connection should be closed after the response.
+  using keep_alive_t = std::function<void(current::net::Connection&&)>;
+  using serve_t = std::function<void(current::net::Connection&&, keep_alive_t keep_alive)>;
+
+  // Zero `worker_threads` stands for the number of cores, zero `max_requests_per_connection` disables keep-alive.
+  HTTPServerEPollReactor(size_t worker_threads,
+                         size_t max_requests_per_connection,
+                         std::chrono::milliseconds keep_alive_idle_timeout,
+                         std::chrono::milliseconds request_read_timeout,
+                         serve_t serve)
+      : max_requests_per_connection_(max_requests_per_connection),
+        keep_alive_idle_timeout_(std::max(keep_alive_idle_timeout, std::chrono::milliseconds(1))),
+        request_read_timeout_(std::max(request_read_timeout, std::chrono::milliseconds(1))),
+        timeouts_check_interval_(
+            std::max((max_requests_per_connection_ ? std::min(keep_alive_idle_timeout_, request_read_timeout_)
+                                                   : request_read_timeout_) /
+                         2,
+                     std::chrono::milliseconds(1))),
+        serve_(std::move(serve)),
+        returned_(std::make_shared<ReturnedConnections>()) {
+    if (!worker_threads) {
+      worker_threads = std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1u));
+    }
+    for (size_t i = 0; i < worker_threads; ++i) {
+      workers_.emplace_back([this]() { WorkerThread(); });
+    }
+  }
+
+  ~HTTPServerEPollReactor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    condition_variable_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Serves the connections accepted on `socket` until `terminating()` is true, which is checked after each event.
+  void Run(current::net::Socket& socket, const std::function<bool()>& terminating) {
+    const int listening_fd = static_cast<SOCKET>(socket.socket);
+    SetNonBlocking(listening_fd, true);
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      CURRENT_THROW(current::net::SocketCreateException());  // LCOV_EXCL_LINE
+    }
+    Add(listening_fd);
+    returned_->event_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (returned_->event_fd < 0) {
+      CURRENT_THROW(current::net::SocketCreateException());  // LCOV_EXCL_LINE
+    }
+    Add(returned_->event_fd);
+
+    const int timeout_ms = static_cast<int>(timeouts_check_interval_.count());
+    std::vector<struct epoll_event> events(kMaxEventsPerWait);
+    while (!terminating()) {
+      const int n = ::epoll_wait(epoll_fd_, &events[0], kMaxEventsPerWait, timeout_ms);
+      for (int i = 0; i < n; ++i) {
+        const int fd = events[i].data.fd;
+        if (fd == listening_fd) {
+          // One `accept()` per event, as the listening socket is level-triggered.
+          try {
+            Accept(socket.Accept());
+          } catch (const current::net::SocketException&) {
+            // The client may have reset the connection before it was accepted.
+          }
+        } else if (fd == returned_->event_fd) {
+          OnConnectionsReturned();
+        } else {
+          OnReadable(fd);
+        }
+      }
+      CloseTimedOutConnections();
+    }
+
+    {
+      // The connections handed back after this point are just closed.
+      std::lock_guard<std::mutex> lock(returned_->mutex);
+      returned_->closed = true;
+      returned_->connections.clear();
+      ::close(returned_->event_fd);
+      returned_->event_fd = -1;
+    }
+    pending_.clear();
+    ::close(epoll_fd_);
+    epoll_fd_ = -1;
+    SetNonBlocking(listening_fd, false);
+  }
+
+ private:
+  // The connection with its request being read ahead.
+  struct PendingConnection final {
+    current::net::Connection connection;
+    std::string buffer;
+    size_t requests_served = 0u;
+    std::chrono::steady_clock::time_point last_activity = std::chrono::steady_clock::now();
+    // When the connection was accepted, or when the first byte of the next request arrived on a kept alive one.
+    std::chrono::steady_clock::time_point request_started = last_activity;
+    keep_alive_t keep_alive;
+    PendingConnection(current::net::Connection&& connection, size_t requests_served)
+        : connection(std::move(connection)), requests_served(requests_served) {}
+  };
+
+  // The connections handed back by the workers after the responses. Shared, as a `Request` may outlive the server.
+  struct ReturnedConnections final {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<PendingConnection>> connections;
+    int event_fd = -1;
+    bool closed = false;
+
+    void Return(current::net::Connection&& connection, size_t requests_served) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!closed) {
+        connections.push_back(std::make_unique<PendingConnection>(std::move(connection), requests_served));
+        const uint64_t one = 1u;
+        if (::write(event_fd, &one, sizeof(one)) < 0) {
+          // The counter can only overflow with the reactor not reading it, in which case it is being shut down.
+        }
+      }
+    }
+  };
+
+  static void SetNonBlocking(int fd, bool non_blocking) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, non_blocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+  }
+
+  void Add(int fd) {
+    struct epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event)) {
+      CURRENT_THROW(current::net::SocketCreateException());  // LCOV_EXCL_LINE
+    }
+  }
+
+  void Accept(current::net::Connection&& connection) {
+    const int fd = static_cast<SOCKET>(connection.socket);
+    SetNonBlocking(fd, true);
+    Add(fd);
+    pending_[fd] = std::make_unique<PendingConnection>(std::move(connection), 0u);
+  }
+
+  static bool IsComplete(const std::string& buffer) {
+    return current::net::CompleteHTTPRequestLength(buffer.data(), buffer.data() + buffer.length()) != 0u;
+  }
+
+  void OnReadable(int fd) {
+    const auto it = pending_.find(fd);
+    if (it == pending_.end()) {
+      return;  // LCOV_EXCL_LINE
+    }
+    PendingConnection& pending = *it->second;
+    const bool awaiting_next_request = pending.requests_served && pending.buffer.empty();
+    bool closed = false;
+    char buffer[16 * 1024];
+    while (true) {
+      const ssize_t retval = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (retval > 0) {
+        pending.buffer.append(buffer, static_cast<size_t>(retval));
+      } else if (retval < 0 && errno == EINTR) {
+        continue;
+      } else {
+        closed = !(retval < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+        break;
+      }
+    }
+    pending.last_activity = std::chrono::steady_clock::now();
+    if (awaiting_next_request && !pending.buffer.empty()) {
+      pending.request_started = pending.last_activity;
+    }
+    if (IsComplete(pending.buffer) || pending.buffer.length() >= kMaxReadAheadBytes) {
+      ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+      std::unique_ptr<PendingConnection> dispatched = std::move(it->second);
+      pending_.erase(it);
+      Dispatch(std::move(dispatched));
+    } else if (closed) {
+      ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+      pending_.erase(it);
+    }
+  }
+
+  // The connections come back with the bytes of the pipelined requests, if any, already read by the parser.
+  void OnConnectionsReturned() {
+    uint64_t counter;
+    if (::read(returned_->event_fd, &counter, sizeof(counter)) < 0) {
+      // Nothing to do, the connections are checked for below regardless.
+    }
+    std::vector<std::unique_ptr<PendingConnection>> connections;
+    {
+      std::lock_guard<std::mutex> lock(returned_->mutex);
+      connections.swap(returned_->connections);
+    }
+    for (auto& returned : connections) {
+      returned->buffer = returned->connection.ExtractReadBuffer();
+      const int fd = static_cast<SOCKET>(returned->connection.socket);
+      if (IsComplete(returned->buffer)) {
+        Dispatch(std::move(returned));
+      } else {
+        SetNonBlocking(fd, true);
+        Add(fd);
+        pending_[fd] = std::move(returned);
+      }
+    }
+  }
+
+  // Closes the kept alive connections idle for too long, and the ones sending their request for too long.
+  void CloseTimedOutConnections() {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_timeouts_check_) {
+      return;
+    }
+    next_timeouts_check_ = now + timeouts_check_interval_;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+      const PendingConnection& pending = *it->second;
+      const bool awaiting_next_request = pending.requests_served && pending.buffer.empty();
+      const bool idle = pending.requests_served && now - pending.last_activity >= keep_alive_idle_timeout_;
+      const bool too_slow = !awaiting_next_request && now - pending.request_started >= request_read_timeout_;
+      if (idle || too_slow) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->first, nullptr);
+        it = pending_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void Dispatch(std::unique_ptr<PendingConnection> pending) {
+    SetNonBlocking(static_cast<SOCKET>(pending->connection.socket), false);
+    pending->connection.PrependToReadBuffer(std::move(pending->buffer));
+    const size_t requests_served = pending->requests_served + 1u;
+    if (requests_served < max_requests_per_connection_) {
+      std::shared_ptr<ReturnedConnections> returned = returned_;
+      pending->keep_alive = [returned, requests_served](current::net::Connection&& connection) {
+        returned->Return(std::move(connection), requests_served);
+      };
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(pending));
+    }
+    condition_variable_.notify_one();
+  }
+
+  void WorkerThread() {
+    while (true) {
+      std::unique_ptr<PendingConnection> pending;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        pending = std::move(queue_.front());
+        queue_.pop_front();
+      }
+      try {
+        serve_(std::move(pending->connection), std::move(pending->keep_alive));
+      } catch (const std::exception& e) {  // LCOV_EXCL_LINE
+        std::cerr << "HTTP worker failed: " << e.what() << '\n';  // LCOV_EXCL_LINE
+      }
+    }
+  }
+
+  const size_t max_requests_per_connection_;
+  const std::chrono::milliseconds keep_alive_idle_timeout_;
+  const std::chrono::milliseconds request_read_timeout_;
+  const std::chrono::milliseconds timeouts_check_interval_;
+  const serve_t serve_;
+  int epoll_fd_ = -1;
+  // Only accessed from the `Run()` thread.
+  std::unordered_map<int, std::unique_ptr<PendingConnection>> pending_;
+  std::chrono::steady_clock::time_point next_timeouts_check_;
+  std::shared_ptr<ReturnedConnections> returned_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::deque<std::unique_ptr<PendingConnection>> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace http
+}  // namespace current
+
+#endif  // CURRENT_HTTP_SERVER_EPOLL_SUPPORTED
+
+#endif  // BLOCKS_HTTP_IMPL_POSIX_SERVER_EPOLL_H
@@ -0,0 +1,271 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2014 Dmitry "Dima" Korolev, <dmitry.korolev@gmail.com>.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The routing table of `HTTPServerPOSIX`: maps request paths to the handlers registered for them.
+//
+// The routes form a tree by the path components, so that a lookup walks down the request path once, without
+// copying it, and picks the deepest registered path with a handler for the number of the remaining components.
+//
+// The lookups take no locks. The tree is never modified in place: a change builds the new root, re-using
+// the unchanged subtrees, and publishes it atomically. Before the old tree, along with the handlers only it
+// referred to, is released, the writer waits for the lookups that could have seen it to complete, RCU-style.
+
+#ifndef BLOCKS_HTTP_IMPL_POSIX_SERVER_ROUTER_H
+#define BLOCKS_HTTP_IMPL_POSIX_SERVER_ROUTER_H
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../../url/url.h"
+
+#include "../../../typesystem/optional.h"
+
+#include "../../../bricks/sync/owned_borrowed.h"
+
+namespace current {
+namespace http {
+
+template <typename T>
+class HTTPServerRouter final {
+ public:
+  // The handlers of a path, by the number of URL path arguments.
+  using handlers_t = std::array<std::shared_ptr<Owned<T>>, URLPathArgs::MaxArgsCount + 1>;
+
+  HTTPServerRouter() : root_(std::make_shared<Node>()), published_root_(root_.get()), epoch_(0u) {
+    readers_[0] = 0u;
+    readers_[1] = 0u;
+  }
+
+  // Returns the handler for `path`, and fills in `output_url_args`. Thread-safe and lock-free.
+  // The `path` must start with a slash.
+  Optional<Borrowed<T>> Find(const std::string& path, URLPathArgs& output_url_args) const {
+    // The trailing slashes are ignored.
+    size_t length = path.length();
+    while (length > 1 && path[length - 1] == '/') {
+      --length;
+    }
+
+    // The non-empty path components past the matched route become the URL path arguments.
+    size_t remaining_args = 0u;
+    for (size_t i = 1; i < length; ++i) {
+      if (path[i] != '/' && path[i - 1] == '/') {
+        ++remaining_args;
+      }
+    }
+
+    const ReadSection section(*this);
+    const Node* node = section.Root();
+    Owned<T>* best = node->Handler(remaining_args);
+    size_t best_end = 1u;
+    size_t best_args = remaining_args;
+    for (size_t begin = 1u; begin < length;) {
+      const size_t end = std::min(path.find('/', begin), length);
+      const auto cit = node->children.find(std::string_view(path.data() + begin, end - begin));
+      if (cit == node->children.end()) {
+        break;
+      }
+      node = cit->second.get();
+      if (end > begin) {
+        --remaining_args;
+      }
+      Owned<T>* handler = node->Handler(remaining_args);
+      if (handler) {
+        best = handler;
+        best_end = end;
+        best_args = remaining_args;
+      }
+      begin = end + 1;
+    }
+
+    if (!best) {
+      return nullptr;
+    }
+    output_url_args.base_path.assign(path, 0u, best_end);
+    // The last argument goes first, as `URLPathArgs` expects.
+    for (size_t end = length; output_url_args.size() < best_args;) {
+      const size_t begin = path.rfind('/', end - 1) + 1;
+      if (begin < end) {
+        output_url_args.add(URL::DecodeURIComponent(path.substr(begin, end - begin)));
+      }
+      end = begin - 1;
+    }
+    // The handler is borrowed before leaving the read section, so that unregistering it waits for the request.
+    return Borrowed<T>(*best);
+  }
+
+  // Whether any handler is registered for exactly this `path`. Thread-safe and lock-free.
+  bool HasPath(const std::string& path) const {
+    const ReadSection section(*this);
+    const Node* node = FindNode(section.Root(), path);
+    return node && node->HasHandlers();
+  }
+
+  // The methods below change or inspect the routes on the writer side. The caller must serialize them.
+
+  // Calls `f` on the handlers of `path` to change them, and publishes the result. Returns once the replaced
+  // handlers can no longer be found, and have been released.
+  void Update(const std::string& path, std::function<void(handlers_t&)> f) {
+    std::vector<std::string> components;
+    if (path != "/") {
+      for (size_t begin = 1u; begin <= path.length();) {
+        const size_t end = std::min(path.find('/', begin), path.length());
+        components.emplace_back(path, begin, end - begin);
+        begin = end + 1;
+      }
+    }
+    const bool had_handlers = HasHandlers(path);
+    std::shared_ptr<const Node> root = Updated(root_, components, 0u, f);
+    if (!root) {
+      root = std::make_shared<Node>();
+    }
+    Publish(std::move(root));
+    const bool has_handlers = HasHandlers(path);
+    if (has_handlers && !had_handlers) {
+      ++paths_count_;
+    } else if (had_handlers && !has_handlers) {
+      --paths_count_;
+    }
+  }
+
+  bool HasHandler(const std::string& path, size_t args_count) const {
+    const Node* node = FindNode(root_.get(), path);
+    return node && node->handlers[args_count];
+  }
+
+  // The number of distinct paths with handlers.
+  size_t PathsCount() const { return paths_count_; }
+
+ private:
+  struct Node final {
+    std::map<std::string, std::shared_ptr<const Node>, std::less<>> children;
+    handlers_t handlers;
+
+    Owned<T>* Handler(size_t args_count) const {
+      return args_count <= URLPathArgs::MaxArgsCount ? handlers[args_count].get() : nullptr;
+    }
+    bool HasHandlers() const {
+      for (const auto& handler : handlers) {
+        if (handler) {
+          return true;
+        }
+      }
+      return false;
+    }
+  };
+
+  // Registers a lookup in progress with one of the two counters, picked by the parity of `epoch_`.
+  // The writer flips the parity after publishing the new root, and waits for the old counter to drop to zero.
+  // The parity is re-checked after the counter is incremented, so that the lookup is either waited for,
+  // or is certain to see the new root.
+  class ReadSection final {
+   public:
+    explicit ReadSection(const HTTPServerRouter& self) : self_(self) {
+      while (true) {
+        index_ = self_.epoch_ & 1u;
+        ++self_.readers_[index_];
+        if ((self_.epoch_ & 1u) == index_) {
+          break;
+        }
+        --self_.readers_[index_];
+      }
+    }
+    ~ReadSection() { --self_.readers_[index_]; }
+    const Node* Root() const { return self_.published_root_; }
+
+   private:
+    const HTTPServerRouter& self_;
+    size_t index_;
+  };
+
+  void Publish(std::shared_ptr<const Node> root) {
+    published_root_ = root.get();
+    const size_t index = (epoch_++) & 1u;
+    while (readers_[index]) {
+      std::this_thread::yield();
+    }
+    root_ = std::move(root);
+  }
+
+  static const Node* FindNode(const Node* node, const std::string& path) {
+    if (path != "/") {
+      for (size_t begin = 1u; node && begin <= path.length();) {
+        const size_t end = std::min(path.find('/', begin), path.length());
+        const auto cit = node->children.find(std::string_view(path.data() + begin, end - begin));
+        node = (cit != node->children.end()) ? cit->second.get() : nullptr;
+        begin = end + 1;
+      }
+    }
+    return node;
+  }
+
+  bool HasHandlers(const std::string& path) const {
+    const Node* node = FindNode(root_.get(), path);
+    return node && node->HasHandlers();
+  }
+
+  // Returns the copy of `node` with the handlers at `components` changed, or `nullptr` if it ends up empty.
+  static std::shared_ptr<const Node> Updated(const std::shared_ptr<const Node>& node,
+                                             const std::vector<std::string>& components,
+                                             size_t index,
+                                             std::function<void(handlers_t&)>& f) {
+    auto result = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+    if (index == components.size()) {
+      f(result->handlers);
+    } else {
+      const auto it = result->children.find(components[index]);
+      auto child = Updated(it != result->children.end() ? it->second : nullptr, components, index + 1u, f);
+      if (child) {
+        result->children[components[index]] = std::move(child);
+      } else if (it != result->children.end()) {
+        result->children.erase(it);
+      }
+    }
+    if (result->children.empty() && !result->HasHandlers()) {
+      return nullptr;
+    }
+    return result;
+  }
+
+  // The writer's reference to the current tree, which keeps it and its handlers alive.
+  std::shared_ptr<const Node> root_;
+  std::atomic<const Node*> published_root_;
+  std::atomic_size_t epoch_;
+  mutable std::atomic_size_t readers_[2];
+  size_t paths_count_ = 0u;
+
+  HTTPServerRouter(const HTTPServerRouter&) = delete;
+  void operator=(const HTTPServerRouter&) = delete;
+};
+
+}  // namespace http
+}  // namespace current
+
+#endif  // BLOCKS_HTTP_IMPL_POSIX_SERVER_ROUTER_H
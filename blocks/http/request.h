@@ -113,15 +113,25 @@ struct Request final {
     response.DoRespondViaHTTP(std::move(*this));
   }
 
+  // Reads up to `max_length` next bytes of the body, returns zero once it is over. Unlike `body`, works for the handlers
+  // registered with `StreamRequestBody`, for which the body is read from the client as this is called.
+  size_t ReadBody(char* buffer, size_t max_length) {
+    if (!unique_connection) {
+      CURRENT_THROW(net::AttemptedToReadBodyOfMovedAwayRequest());
+    }
+    return connection.ReadBody(buffer, max_length);
+  }
+
   template <uint64_t CACHE_SIZE = CURRENT_BRICKS_HTTP_DEFAULT_CHUNK_CACHE_SIZE>
   current::net::HTTPServerConnection::ChunkedResponseSender<CACHE_SIZE> SendChunkedResponse(
       net::HTTPResponseCodeValue code = HTTPResponseCode.OK,
       const net::http::Headers& headers = net::http::Headers(),
-      const std::string& content_type = net::constants::kDefaultJSONContentType) {
+      const std::string& content_type = net::constants::kDefaultJSONContentType,
+      const net::ChunkedResponseOptions& options = net::ChunkedResponseOptions()) {
     if (!unique_connection) {
       CURRENT_THROW(net::AttemptedToSendHTTPResponseMoreThanOnce());
     }
-    return connection.SendChunkedHTTPResponse<CACHE_SIZE>(code, headers, content_type);
+    return connection.SendChunkedHTTPResponse<CACHE_SIZE>(code, headers, content_type, options);
   }
 
   Request(const Request&) = delete;
@@ -33,6 +33,7 @@ SOFTWARE.
 #include "docu/server/docu_03httpserver_04_test.cc"
 #include "docu/server/docu_03httpserver_05_test.cc"
 
+#include <set>
 #include <string>
 
 #include "api.h"
@@ -82,6 +83,20 @@ DEFINE_int32(net_api_test_port_secondary,
              "different from "
              "ports in other network-based tests, since API-driven HTTP server will hold it open for the whole "
              "lifetime of the binary.");
+DEFINE_int32(net_api_test_port_epoll,
+             PickPortForUnitTest(),
+             "Local port to use for the test HTTP server running the `EPoll` engine. NOTE: This port should be "
+             "different from ports in other network-based tests, since API-driven HTTP server will hold it open for "
+             "the whole lifetime of the binary.");
+DEFINE_int32(net_api_test_port_keep_alive,
+             PickPortForUnitTest(),
+             "Local port to use for the test HTTP server running the `EPoll` engine with keep-alive.");
+DEFINE_int32(net_api_test_port_reuse_port,
+             PickPortForUnitTest(),
+             "Local port to use for the test HTTP server with several `SO_REUSEPORT` listeners.");
+DEFINE_int32(net_api_test_port_raw,
+             PickPortForUnitTest(),
+             "Local port to use for the raw TCP server closing the connections before responding.");
 DEFINE_string(net_api_test_tmpdir, ".current", "Local path for the test to create temporary files in.");
 
 CURRENT_STRUCT(HTTPAPITestObject) {
@@ -271,6 +286,55 @@ TEST(HTTPAPI, ScopeCanBeAssignedNullPtr) {
   EXPECT_EQ(404, static_cast<int>(HTTP(GET(url)).code));
 }
 
+TEST(HTTPAPI, RoutesCanBeChangedWhileServing) {
+  const auto scope = HTTP(FLAGS_net_api_test_port).Register("/stable", [](Request r) { r("Stable."); });
+  const string base_url = Printf("http://localhost:%d", FLAGS_net_api_test_port);
+  const size_t paths_count = HTTP(FLAGS_net_api_test_port).PathHandlersCount();
+  std::atomic_bool done(false);
+  std::thread churn([&done]() {
+    for (size_t i = 0u; !done; ++i) {
+      const auto churn_scope = HTTP(FLAGS_net_api_test_port)
+                                   .Register("/churn/" + current::ToString(i % 10u), [](Request r) { r("Churn."); });
+    }
+  });
+  for (size_t i = 0u; i < 100u; ++i) {
+    EXPECT_EQ("Stable.", HTTP(GET(base_url + "/stable")).body);
+  }
+  done = true;
+  churn.join();
+  EXPECT_EQ(paths_count, HTTP(FLAGS_net_api_test_port).PathHandlersCount());
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/churn/0")).code));
+}
+
+TEST(HTTPAPI, UnRegisterWaitsForTheRequestsInFlight) {
+  std::atomic_bool handler_started(false);
+  std::atomic_bool handler_may_respond(false);
+  std::atomic_bool unregistered(false);
+  auto scope = HTTP(FLAGS_net_api_test_port).Register("/slow", [&](Request r) {
+    handler_started = true;
+    while (!handler_may_respond) {
+      std::this_thread::yield();
+    }
+    r("Finally.");
+  });
+  const string url = Printf("http://localhost:%d/slow", FLAGS_net_api_test_port);
+  std::thread client([&url]() { EXPECT_EQ("Finally.", HTTP(GET(url)).body); });
+  while (!handler_started) {
+    std::this_thread::yield();
+  }
+  std::thread unregisterer([&]() {
+    scope = nullptr;
+    unregistered = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_FALSE(unregistered);
+  handler_may_respond = true;
+  unregisterer.join();
+  client.join();
+  EXPECT_TRUE(unregistered);
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(url)).code));
+}
+
 TEST(HTTPAPI, URLParameters) {
   const auto scope = HTTP(FLAGS_net_api_test_port).Register("/query", [](Request r) { r("x=" + r.url.query["x"]); });
   EXPECT_EQ("x=", HTTP(GET(Printf("http://localhost:%d/query", FLAGS_net_api_test_port))).body);
@@ -842,7 +906,7 @@ TEST(HTTPAPI, GetByChunksPrototype) {
     ASSERT_TRUE(client.Go());
     EXPECT_EQ("1\n|23\n|456\n|DONE", current::strings::Join(chunk_by_chunk_response, '|'));
     EXPECT_EQ(4u, headers.size());
-    EXPECT_EQ("Content-Type=text/plain Connection=keep-alive header=oh-well Transfer-Encoding=chunked",
+    EXPECT_EQ("Content-Type=text/plain Connection=close header=oh-well Transfer-Encoding=chunked",
               current::strings::Join(headers, ' '));
   }
   {
@@ -858,11 +922,46 @@ TEST(HTTPAPI, GetByChunksPrototype) {
     EXPECT_EQ(200, static_cast<int>(response));
     EXPECT_EQ("1\n|23\n|456\n|DONE", current::strings::Join(chunk_by_chunk_response, '|'));
     EXPECT_EQ(4u, headers.size());
-    EXPECT_EQ("Content-Type=text/plain Connection=keep-alive header=oh-well Transfer-Encoding=chunked",
+    EXPECT_EQ("Content-Type=text/plain Connection=close header=oh-well Transfer-Encoding=chunked",
               current::strings::Join(headers, ' '));
   }
 }
 
+#ifdef CURRENT_HAS_ZLIB
+TEST(HTTPAPI, ChunkedGETWithGZip) {
+  std::atomic_size_t chunks_received(0u);
+  const auto scope = HTTP(FLAGS_net_api_test_port)
+                         .Register("/gzip_chunks",
+                                   [&chunks_received](Request r) {
+                                     auto response = r.connection.SendChunkedHTTPResponse();
+                                     for (const std::string chunk : {"1\n", "23\n", "456\n"}) {
+                                       const size_t expected = chunks_received + 1u;
+                                       response.Send(chunk);
+                                       // The compressed response is still incremental: each chunk is received
+                                       // and decompressed by the client before the next one is sent.
+                                       while (chunks_received != expected) {
+                                         std::this_thread::yield();
+                                       }
+                                     }
+                                   });
+  std::vector<std::string> headers;
+  std::vector<std::string> chunks;
+  const auto response =
+      HTTP(ChunkedGET(Printf("http://localhost:%d/gzip_chunks", FLAGS_net_api_test_port),
+                      [&headers](const std::string& k, const std::string& v) { headers.push_back(k + '=' + v); },
+                      [&chunks, &chunks_received](const std::string& s) {
+                        chunks.push_back(s);
+                        ++chunks_received;
+                      }).AcceptGZip());
+  EXPECT_EQ(200, static_cast<int>(response));
+  EXPECT_EQ("1\n|23\n|456\n", current::strings::Join(chunks, '|'));
+  EXPECT_EQ(
+      "Content-Type=application/json; charset=utf-8 Connection=close Content-Encoding=gzip "
+      "Vary=Accept-Encoding Transfer-Encoding=chunked",
+      current::strings::Join(headers, ' '));
+}
+#endif  // CURRENT_HAS_ZLIB
+
 TEST(HTTPAPI, PostFromBufferToBuffer) {
   const auto scope = HTTP(FLAGS_net_api_test_port)
                          .Register("/post",
@@ -1569,6 +1668,89 @@ TEST(HTTPAPI, ServeStaticFilesFromOnlyServesFilesOfKnownMIMEType) {
                ServeStaticFilesFromCanNotServeStaticFilesOfUnknownMIMEType);
 }
 
+TEST(HTTPAPI, ServeStaticFilesFromWithSendFile) {
+  FileSystem::MkDir(FLAGS_net_api_test_tmpdir, FileSystem::MkDirParameters::Silent);
+  const std::string dir = FileSystem::JoinPath(FLAGS_net_api_test_tmpdir, "sendfile_static");
+  const auto dir_remover = current::FileSystem::ScopedRmDir(dir);
+  FileSystem::MkDir(dir, FileSystem::MkDirParameters::Silent);
+  std::string large_file;
+  for (int i = 0; i < 50000; ++i) {
+    large_file += Printf("%d\n", i);
+  }
+  FileSystem::WriteStringToFile(large_file, FileSystem::JoinPath(dir, "large.txt").c_str());
+  FileSystem::WriteStringToFile("<h1>Index</h1>", FileSystem::JoinPath(dir, "index.html").c_str());
+  FileSystem::WriteStringToFile("body { color: red; }", FileSystem::JoinPath(dir, "small.css").c_str());
+
+  // The files of up to 100 bytes are kept in memory, up to 1KB of them.
+  const auto scope =
+      HTTP(FLAGS_net_api_test_port).ServeStaticFilesFrom(dir, ServeStaticFilesFromOptions().SendFiles(1024, 100));
+  const std::string base_url = Printf("http://localhost:%d", FLAGS_net_api_test_port);
+
+  // The large file is sent from disk.
+  const auto large_response = HTTP(GET(base_url + "/large.txt"));
+  EXPECT_EQ(200, static_cast<int>(large_response.code));
+  EXPECT_EQ("text/plain", large_response.headers.Get("Content-Type"));
+  EXPECT_EQ(large_file, large_response.body);
+  ASSERT_TRUE(large_response.headers.Has("ETag"));
+  ASSERT_TRUE(large_response.headers.Has("Last-Modified"));
+  const std::string etag = large_response.headers.Get("ETag");
+
+  // The client that has the current version of the file gets "304 Not Modified".
+  {
+    const auto response = HTTP(GET(base_url + "/large.txt").SetHeader("If-None-Match", etag));
+    EXPECT_EQ(304, static_cast<int>(response.code));
+    EXPECT_EQ("", response.body);
+    EXPECT_EQ(etag, response.headers.Get("ETag"));
+    // No body, and thus no `Content-Length` or `Content-Type` either.
+    EXPECT_FALSE(response.headers.Has("Content-Length"));
+    EXPECT_FALSE(response.headers.Has("Content-Type"));
+  }
+  {
+    const auto response = HTTP(GET(base_url + "/large.txt").SetHeader("If-None-Match", "\"other\", " + etag));
+    EXPECT_EQ(304, static_cast<int>(response.code));
+  }
+  {
+    const auto response = HTTP(GET(base_url + "/large.txt").SetHeader("If-None-Match", "\"other\""));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_EQ(large_file, response.body);
+  }
+  {
+    const auto response = HTTP(
+        GET(base_url + "/large.txt").SetHeader("If-Modified-Since", large_response.headers.Get("Last-Modified")));
+    EXPECT_EQ(304, static_cast<int>(response.code));
+  }
+  {
+    const auto response =
+        HTTP(GET(base_url + "/large.txt").SetHeader("If-Modified-Since", "Thu, 01 Jan 1970 00:00:01 GMT"));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+  }
+
+  // The directory index is served from disk as well.
+  {
+    const auto response = HTTP(GET(base_url + "/"));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_EQ("<h1>Index</h1>", response.body);
+  }
+
+  // The small file is served from memory, until it changes on disk.
+  {
+    const auto response = HTTP(GET(base_url + "/small.css"));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_EQ("text/css", response.headers.Get("Content-Type"));
+    EXPECT_EQ("body { color: red; }", response.body);
+  }
+  FileSystem::WriteStringToFile("body { color: green; }", FileSystem::JoinPath(dir, "small.css").c_str());
+  {
+    const auto response = HTTP(GET(base_url + "/small.css"));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_EQ("body { color: green; }", response.body);
+  }
+
+  // The files removed from disk are no longer served.
+  FileSystem::RmFile(FileSystem::JoinPath(dir, "small.css"));
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/small.css")).code));
+}
+
 TEST(HTTPAPI, ResponseSmokeTest) {
   const auto send_response = [](const Response& response, Request request) { request(response); };
 
@@ -1710,6 +1892,471 @@ TEST(HTTPAPI, PayloadTooLarge) {
   }
 }
 
+TEST(HTTPAPI, StreamRequestBody) {
+  std::atomic_size_t bytes_read_by_handler(0u);
+  const auto handler = [&bytes_read_by_handler](Request r) {
+    EXPECT_TRUE(r.body.empty());
+    std::string body;
+    char buffer[7];
+    size_t length;
+    while ((length = r.ReadBody(buffer, sizeof(buffer))) != 0u) {
+      EXPECT_LE(length, sizeof(buffer));
+      body.append(buffer, length);
+      bytes_read_by_handler += length;
+    }
+    Request moved(std::move(r));
+    EXPECT_THROW(r.ReadBody(buffer, sizeof(buffer)), current::net::AttemptedToReadBodyOfMovedAwayRequest);
+    moved(moved.method + ' ' + body + '\n');
+  };
+  const auto scope =
+      HTTP(FLAGS_net_api_test_port).Register("/stream", StreamRequestBody(1000u), handler) +
+      HTTP(FLAGS_net_api_test_port).Register("/stream", URLPathArgs::CountMask::One, StreamRequestBody(), handler);
+  const std::string url = Printf("http://localhost:%d/stream", FLAGS_net_api_test_port);
+
+  EXPECT_EQ("GET \n", HTTP(GET(url)).body);
+  EXPECT_EQ("POST Hello, world!\n", HTTP(POST(url, "Hello, world!")).body);
+  EXPECT_EQ("POST \n", HTTP(POST(url, "")).body);
+  EXPECT_EQ("POST " + std::string(1000u, '.') + '\n', HTTP(POST(url, std::string(1000u, '.'))).body);
+  EXPECT_EQ(std::string(2000u, '.').length() + 6u, HTTP(POST(url + "/arg", std::string(2000u, '.'))).body.length());
+
+  {
+    // The limit of the length of the body is enforced before the handler is called.
+    bytes_read_by_handler = 0u;
+    const auto response = HTTP(POST(url, std::string(1001u, '.')));
+    EXPECT_EQ(413, static_cast<int>(response.code));
+    EXPECT_EQ("<h1>ENTITY TOO LARGE</h1>\n", response.body);
+    EXPECT_EQ(0u, bytes_read_by_handler);
+  }
+
+  const auto ReadResponse = [](Connection& connection, const std::string& until) {
+    char buffer[1024];
+    std::string response;
+    while (response.find(until) == std::string::npos) {
+      const size_t read = connection.BlockingRead(buffer, sizeof(buffer));
+      if (!read) {
+        break;
+      }
+      response.append(buffer, read);
+    }
+    return response;
+  };
+
+  {
+    // The handler reads the body as it arrives, before the rest of it has been sent.
+    bytes_read_by_handler = 0u;
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port));
+    connection.BlockingWrite("POST /stream HTTP/1.1\r\nContent-Length: 12\r\n\r\nfirst,", true);
+    while (bytes_read_by_handler < 6u) {
+      std::this_thread::yield();
+    }
+    connection.BlockingWrite("second", false);
+    EXPECT_NE(std::string::npos, ReadResponse(connection, "POST first,second\n").find("POST first,second\n"));
+  }
+
+  {
+    // A chunked body, sent in pieces, with a chunk extension and a trailer.
+    bytes_read_by_handler = 0u;
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port));
+    connection.BlockingWrite("POST /stream HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nHello\r\n", true);
+    while (bytes_read_by_handler < 5u) {
+      std::this_thread::yield();
+    }
+    connection.BlockingWrite("8;ext=1\r\n, world!\r\n0\r\nTrailer: yes\r\n\r\n", false);
+    EXPECT_NE(std::string::npos, ReadResponse(connection, "POST Hello, world!\n").find("POST Hello, world!\n"));
+  }
+
+  {
+    // The limit of the length of the chunked body is enforced as it is read.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port));
+    connection.BlockingWrite("POST /stream HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", true);
+    connection.BlockingWrite("200\r\n" + std::string(0x200, '.') + "\r\n", true);
+    connection.BlockingWrite("200\r\n", false);
+    const std::string response = ReadResponse(connection, "<h1>ENTITY TOO LARGE</h1>\n");
+    EXPECT_EQ(0u, response.find("HTTP/1.1 413 "));
+  }
+
+  {
+    // An invalid chunk size.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port));
+    connection.BlockingWrite("POST /stream HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nXYZ\r\n", false);
+    const std::string response = ReadResponse(connection, "</h1>\n");
+    EXPECT_EQ(0u, response.find("HTTP/1.1 400 "));
+  }
+}
+
+// The `EPoll` engine, with two worker threads.
+inline HTTPServerPOSIX& EPollTestServer() {
+  return HTTP(FLAGS_net_api_test_port_epoll, HTTPServerOptions::EPoll(2u));
+}
+
+TEST(HTTPAPI, EPollEngine) {
+  const auto scope = EPollTestServer().Register("/epoll",
+                                                [](Request r) {
+                                                  if (r.method == "GET") {
+                                                    r("GET " + r.url.query.get("x", "?") + '\n');
+                                                  } else {
+                                                    r(r.method + ' ' + r.body + '\n');
+                                                  }
+                                                }) +
+                     EPollTestServer().Register("/epoll_chunked", [](Request r) {
+                       auto response = r.SendChunkedResponse(HTTPResponseCode.OK, Headers({{"header", "yeah"}}));
+                       response.Send("A");
+                       response.Send("B");
+                       response.Send("C");
+                     });
+  const std::string base_url = Printf("http://localhost:%d", FLAGS_net_api_test_port_epoll);
+
+  EXPECT_EQ("GET 42\n", HTTP(GET(base_url + "/epoll?x=42")).body);
+  EXPECT_EQ("POST body\n", HTTP(POST(base_url + "/epoll", "body")).body);
+  EXPECT_EQ(std::string(1000000, '.').length() + 6u,
+            HTTP(POST(base_url + "/epoll", std::string(1000000, '.'))).body.length());
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/nope")).code));
+  {
+    const auto response = HTTP(GET(base_url + "/epoll_chunked"));
+    EXPECT_EQ("ABC", response.body);
+    EXPECT_EQ("yeah", response.headers.Get("header"));
+  }
+  {
+    // A request with a chunked body, sent in pieces.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_epoll));
+    connection.BlockingWrite("POST /epoll HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    connection.BlockingWrite("3\r\nabc\r\n", true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    connection.BlockingWrite("2\r\nde\r\n0\r\n\r\n", false);
+    char buffer[1024];
+    std::string response;
+    while (response.find("POST abcde\n") == std::string::npos) {
+      const size_t read = connection.BlockingRead(buffer, sizeof(buffer));
+      ASSERT_GT(read, 0u);
+      response.append(buffer, read);
+    }
+  }
+}
+
+TEST(HTTPAPI, EPollEngineIsNotStalledBySlowClientsOrHandlers) {
+  std::atomic_bool slow_handler_may_proceed(false);
+  const auto scope =
+      EPollTestServer().Register("/epoll_fast", [](Request r) { r("fast\n"); }) +
+      EPollTestServer().Register("/epoll_slow", [&slow_handler_may_proceed](Request r) {
+        while (!slow_handler_may_proceed) {
+          std::this_thread::yield();
+        }
+        r("slow\n");
+      });
+  const std::string base_url = Printf("http://localhost:%d", FLAGS_net_api_test_port_epoll);
+
+  // A client that has only sent a part of its request.
+  Connection slow_client(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_epoll));
+  slow_client.BlockingWrite("GET /epoll_fast HTTP/1.1\r\n", true);
+
+  // A handler that is busy.
+  std::string slow_response;
+  std::thread slow_request([&]() { slow_response = HTTP(GET(base_url + "/epoll_slow")).body; });
+
+  EXPECT_EQ("fast\n", HTTP(GET(base_url + "/epoll_fast")).body);
+  EXPECT_EQ("fast\n", HTTP(GET(base_url + "/epoll_fast")).body);
+
+  slow_handler_may_proceed = true;
+  slow_request.join();
+  EXPECT_EQ("slow\n", slow_response);
+
+  slow_client.BlockingWrite("\r\n", false);
+  char buffer[1024];
+  std::string response;
+  while (response.find("fast\n") == std::string::npos) {
+    const size_t read = slow_client.BlockingRead(buffer, sizeof(buffer));
+    ASSERT_GT(read, 0u);
+    response.append(buffer, read);
+  }
+  EXPECT_EQ(0u, response.find("HTTP/1.1 200 OK\r\n"));
+}
+
+// At most three requests per connection, the idle connections are closed after 100ms, and the ones taking longer
+// than 300ms to send the request are closed too.
+inline HTTPServerPOSIX& KeepAliveTestServer() {
+  return HTTP(FLAGS_net_api_test_port_keep_alive,
+              HTTPServerOptions::EPoll(2u)
+                  .KeepAlive(std::chrono::milliseconds(100), 3u)
+                  .RequestReadTimeout(std::chrono::milliseconds(300)));
+}
+
+TEST(HTTPAPI, EPollEngineKeepAlive) {
+  auto& server = KeepAliveTestServer();
+  const auto scope = server.Register("/keep_alive", [](Request r) { r("Hello, " + r.url.query.get("name", "?")); }) +
+                     server.Register("/keep_alive_chunked", [](Request r) {
+                       auto response = r.SendChunkedResponse();
+                       response("A");
+                       response("B");
+                     });
+
+  const auto is_closed = [](Connection& connection) {
+    try {
+      char c;
+      return connection.BlockingRead(&c, 1u) == 0u;
+    } catch (const current::net::SocketException&) {
+      return true;
+    }
+  };
+
+  {
+    // Sequential requests on one connection, including a chunked response, up to the limit of three.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    connection.BlockingWrite("GET /keep_alive?name=one HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("200", response.RawPath());
+      EXPECT_EQ("keep-alive", response.headers().Get("Connection"));
+      EXPECT_EQ("Hello, one", response.Body());
+    }
+    connection.BlockingWrite("GET /keep_alive_chunked HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("200", response.RawPath());
+      EXPECT_EQ("keep-alive", response.headers().Get("Connection"));
+      EXPECT_EQ("AB", response.Body());
+    }
+    connection.BlockingWrite("GET /keep_alive?name=three HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("close", response.headers().Get("Connection"));
+      EXPECT_EQ("Hello, three", response.Body());
+    }
+    EXPECT_TRUE(is_closed(connection));
+  }
+
+  {
+    // Pipelined requests, sent at once.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    connection.BlockingWrite(
+        "GET /keep_alive?name=a HTTP/1.1\r\nHost: localhost\r\n\r\n"
+        "GET /keep_alive?name=b HTTP/1.1\r\nHost: localhost\r\n\r\n",
+        false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("Hello, a", response.Body());
+    }
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("Hello, b", response.Body());
+    }
+  }
+
+  {
+    // `Connection: close` from the client.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    connection.BlockingWrite("GET /keep_alive?name=x HTTP/1.1\r\nConnection: close\r\n\r\n", false);
+    const current::net::HTTPRequestData response(connection);
+    EXPECT_EQ("close", response.headers().Get("Connection"));
+    EXPECT_EQ("Hello, x", response.Body());
+    EXPECT_TRUE(is_closed(connection));
+  }
+
+  {
+    // The idle connection is closed by the server.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    connection.BlockingWrite("GET /keep_alive?name=idle HTTP/1.1\r\n\r\n", false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("Hello, idle", response.Body());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_TRUE(is_closed(connection));
+  }
+
+  // The regular client works with the keep-alive server too.
+  EXPECT_EQ("Hello, client",
+            HTTP(GET(Printf("http://localhost:%d/keep_alive?name=client", FLAGS_net_api_test_port_keep_alive))).body);
+}
+
+TEST(HTTPAPI, EPollEngineRequestReadTimeout) {
+  const auto scope = KeepAliveTestServer().Register("/read_timeout", [](Request r) { r("OK\n"); });
+
+  const auto is_closed = [](Connection& connection) {
+    try {
+      char c;
+      return connection.BlockingRead(&c, 1u) == 0u;
+    } catch (const current::net::SocketException&) {
+      return true;
+    }
+  };
+
+  // Sends the request byte by byte, every 50ms, and returns whether the server has closed the connection.
+  const auto trickle = [&is_closed](Connection& connection) {
+    const std::string request = "GET /read_timeout HTTP/1.1\r\nHost: localhost\r\nX-Padding: 1234567890\r\n\r\n";
+    try {
+      for (char c : request) {
+        connection.BlockingWrite(&c, 1u, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }
+    } catch (const current::net::SocketException&) {
+      return true;
+    }
+    return is_closed(connection);
+  };
+
+  {
+    // The connection that sends nothing.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    EXPECT_TRUE(is_closed(connection));
+  }
+
+  {
+    // The connection that keeps sending its first request too slowly to ever be idle.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    EXPECT_TRUE(trickle(connection));
+  }
+
+  {
+    // The kept alive connection that sends its next request too slowly.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    connection.BlockingWrite("GET /read_timeout HTTP/1.1\r\nHost: localhost\r\n\r\n", false);
+    {
+      const current::net::HTTPRequestData response(connection);
+      EXPECT_EQ("OK\n", response.Body());
+    }
+    EXPECT_TRUE(trickle(connection));
+  }
+
+  {
+    // The request sent within the timeout is served.
+    Connection connection(current::net::ClientSocket("localhost", FLAGS_net_api_test_port_keep_alive));
+    for (const char* part : {"GET /read_timeout HTTP/1.1\r\n", "Host: localhost\r\n", "\r\n"}) {
+      connection.BlockingWrite(part, false);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    const current::net::HTTPRequestData response(connection);
+    EXPECT_EQ("OK\n", response.Body());
+  }
+}
+
+#ifndef CURRENT_WINDOWS
+// Four listeners, each accepting the connections on its own socket.
+inline HTTPServerPOSIX& ReusePortTestServer() {
+  return HTTP(FLAGS_net_api_test_port_reuse_port, HTTPServerOptions().Listeners(4u));
+}
+
+TEST(HTTPAPI, ReusePortListeners) {
+  // The routes registered after the listeners have started are served by all of them.
+  const auto scope = ReusePortTestServer().Register("/reuse_port", [](Request r) {
+    r(current::ToString(std::hash<std::thread::id>()(std::this_thread::get_id())));
+  });
+  const std::string url = Printf("http://localhost:%d/reuse_port", FLAGS_net_api_test_port_reuse_port);
+  std::set<std::string> threads;
+  for (int i = 0; i < 50; ++i) {
+    const auto response = HTTP(GET(url));
+    ASSERT_EQ(200, static_cast<int>(response.code));
+    threads.insert(response.body);
+  }
+  // The connections are balanced by the kernel, so more than one listener should have been hit.
+  EXPECT_GT(threads.size(), 1u);
+  EXPECT_LE(threads.size(), 4u);
+
+  // Binding the same port without `SO_REUSEPORT` fails.
+  ASSERT_THROW(current::net::Socket{static_cast<uint16_t>(FLAGS_net_api_test_port_reuse_port)},
+               current::net::SocketBindException);
+}
+#endif  // CURRENT_WINDOWS
+
+TEST(HTTPAPI, ClientConnectionPool) {
+  auto& pool = current::http::DefaultHTTPClientConnectionPool();
+  pool.Clear();
+
+  const auto scope = KeepAliveTestServer().Register("/pool", [](Request r) { r("pooled\n"); }) +
+                     HTTP(FLAGS_net_api_test_port).Register("/pool", [](Request r) { r("not pooled\n"); });
+  const std::string keep_alive_url = Printf("http://localhost:%d/pool", FLAGS_net_api_test_port_keep_alive);
+  const std::string close_url = Printf("http://localhost:%d/pool", FLAGS_net_api_test_port);
+
+  {
+    // The server closes the connection after three requests, so the fourth one connects again.
+    const auto before = pool.Stats();
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ("pooled\n", HTTP(GET(keep_alive_url)).body);
+    }
+    const auto after = pool.Stats();
+    EXPECT_EQ(2u, after.hits - before.hits);
+    EXPECT_EQ(2u, after.misses - before.misses);
+    EXPECT_EQ(1u, after.idle);
+  }
+
+  {
+    // The connection closed by the server while in the pool is not used.
+    const auto before = pool.Stats();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    EXPECT_EQ("pooled\n", HTTP(POST(keep_alive_url, "body")).body);
+    const auto after = pool.Stats();
+    EXPECT_EQ(0u, after.hits - before.hits);
+    EXPECT_EQ(1u, after.misses - before.misses);
+    EXPECT_EQ(1u, after.evicted - before.evicted);
+  }
+
+  {
+    // The connections to the servers that do not keep them alive are not pooled.
+    pool.Clear();
+    const auto before = pool.Stats();
+    EXPECT_EQ("not pooled\n", HTTP(GET(close_url)).body);
+    EXPECT_EQ("not pooled\n", HTTP(GET(close_url)).body);
+    const auto after = pool.Stats();
+    EXPECT_EQ(0u, after.hits - before.hits);
+    EXPECT_EQ(2u, after.misses - before.misses);
+    EXPECT_EQ(0u, after.idle);
+  }
+
+  {
+    // Concurrent requests use separate connections, all of which are then pooled, up to the limit.
+    pool.Clear();
+    pool.Configure(2u, std::chrono::milliseconds(4000));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&keep_alive_url]() {
+        for (int j = 0; j < 2; ++j) {
+          EXPECT_EQ("pooled\n", HTTP(GET(keep_alive_url)).body);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    EXPECT_LE(pool.Stats().idle, 2u);
+    pool.Configure(current::http::HTTPClientConnectionPool::kDefaultMaxIdleConnectionsPerHost,
+                   std::chrono::milliseconds(current::http::HTTPClientConnectionPool::kDefaultIdleTimeoutMS));
+  }
+}
+
+TEST(HTTPAPI, ClientConnectionPoolRetriesStaleConnections) {
+  auto& pool = current::http::DefaultHTTPClientConnectionPool();
+  pool.Clear();
+
+  // Responds to the first request on each connection, and closes the connection upon receiving the second one.
+  // The third connection gets closed after the response.
+  std::thread server([](current::net::Socket socket) {
+    const auto respond = [](current::net::Connection& c, const std::string& body) {
+      c.BlockingWrite("HTTP/1.1 200 OK\r\nConnection: keep-alive\r\nContent-Length: " +
+                          current::ToString(body.length()) + "\r\n\r\n" + body,
+                      false);
+    };
+    for (const std::string body : {"one", "two"}) {
+      current::net::Connection c(socket.Accept());
+      { const current::net::HTTPRequestData request(c); }
+      respond(c, body);
+      { const current::net::HTTPRequestData request(c); }
+    }
+    current::net::Connection c(socket.Accept());
+    { const current::net::HTTPRequestData request(c); }
+    respond(c, "three");
+  }, current::net::Socket(FLAGS_net_api_test_port_raw));
+
+  const std::string url = Printf("http://localhost:%d/", FLAGS_net_api_test_port_raw);
+  EXPECT_EQ("one", HTTP(GET(url)).body);
+  // Both the POST and the GET are sent again over a new connection.
+  EXPECT_EQ("two", HTTP(POST(url, "body")).body);
+  EXPECT_EQ("three", HTTP(GET(url)).body);
+
+  server.join();
+  pool.Clear();
+}
+
 CURRENT_STRUCT_T(HTTPAPITemplatedTestObject) {
   CURRENT_FIELD(text, std::string, "OK");
   CURRENT_FIELD(data, T);
@@ -47,6 +47,15 @@ namespace http {
 // TODO(dkorolev): Add another option, to throw if the handler does not exist, while it's expected to?
 enum class ReRegisterRoute { ThrowOnAttempt, SilentlyUpdateExisting };
 
+// Use as `HTTP(port).Register("/upload", StreamRequestBody(), handler)` to have the handler called as soon as
+// the headers of the request have been read, for it to read the body with `Request::ReadBody()` as it arrives.
+// The bodies longer than `max_body_length` bytes are responded to with "413 Request Entity Too Large".
+struct StreamRequestBody final {
+  size_t max_body_length;
+  explicit StreamRequestBody(size_t max_body_length = net::constants::kMaxHTTPPayloadSizeInBytes)
+      : max_body_length(max_body_length) {}
+};
+
 // Structures to define HTTP requests.
 // The syntax for creating an instance of a GET request is GET is `GET(url)`.
 // The syntax for creating an instance of a POST request is POST is `POST(url, data, content_type)`'.
@@ -93,11 +102,20 @@ struct ChunkedGET {
   std::function<void(const std::string&, const std::string&)> header_callback;
   std::function<void(const std::string&)> chunk_callback;
   std::function<void()> done_callback;
+  current::net::http::Headers custom_headers;
   explicit ChunkedGET(const std::string& url,
                       std::function<void(const std::string&, const std::string&)> header_callback,
                       std::function<void(const std::string&)> chunk_callback,
                       std::function<void()> done_callback = []() {})
       : url(url), header_callback(header_callback), chunk_callback(chunk_callback), done_callback(done_callback) {}
+
+  ChunkedGET& SetHeader(const std::string& key, const std::string& value) {
+    custom_headers.emplace_back(key, value);
+    return *this;
+  }
+
+  // Asks the server to compress the response. The chunks are decompressed before they reach `chunk_callback`.
+  ChunkedGET& AcceptGZip() { return SetHeader(net::constants::kAcceptEncodingHeaderKey, "gzip"); }
 };
 
 struct HEAD : HTTPRequestBase<HEAD> {
@@ -231,13 +249,16 @@ struct HTTPImpl {
   typedef CHUNKED_CLIENT_IMPL chunked_client_impl_t;
   typedef SERVER_IMPL server_impl_t;
 
-  server_impl_t& operator()(uint16_t port) {
+  server_impl_t& operator()(uint16_t port) { return operator()(port, typename server_impl_t::options_t()); }
+
+  // The `options` only take effect if this is the first access to the `port`, which starts the server on it.
+  server_impl_t& operator()(uint16_t port, const typename server_impl_t::options_t& options) {
     static std::mutex mutex;
     static std::map<uint16_t, std::unique_ptr<server_impl_t>> servers;
     std::lock_guard<std::mutex> lock(mutex);
     std::unique_ptr<server_impl_t>& server = servers[port];
     if (!server) {
-      server.reset(new server_impl_t(port));
+      server.reset(new server_impl_t(port, options));
     }
     return *server;
   }
@@ -247,6 +268,10 @@ struct HTTPImpl {
     CURRENT_ASSERT(port > 0 && port < 65536);
     return operator()(static_cast<uint16_t>(port));
   }
+  server_impl_t& operator()(int port, const typename server_impl_t::options_t& options) {
+    CURRENT_ASSERT(port > 0 && port < 65536);
+    return operator()(static_cast<uint16_t>(port), options);
+  }
 
   template <typename REQUEST_PARAMS, typename RESPONSE_PARAMS = KeepResponseInMemory>
   inline typename ResponseTypeFromRequestType<RESPONSE_PARAMS>::response_type_t operator()(
@@ -275,6 +300,7 @@ struct HTTPImpl {
     chunked_client_impl_t impl(impl_params);
     impl.request_method_ = "GET";
     impl.request_url_ = request_params.url;
+    impl.request_headers_ = request_params.custom_headers;
 
     if (impl.Go()) {
       return impl.response_code_;
@@ -0,0 +1,302 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef BLOCKS_MMQ_LOCK_FREE_MMQ_H
+#define BLOCKS_MMQ_LOCK_FREE_MMQ_H
+
+// `LockFreeMMQ` is a drop-in replacement for `MMQ`, with the same template arguments, the same `Publish()` interface,
+// and the same semantics, that does not lock a mutex on either the publishing or the consuming side.
+//
+// The buffer is a ring of slots, each with its own sequence number, so that the producers and the consumer only
+// synchronize on the slot they are working with:
+//   1) The producer claims the next ticket, which is the index of the message, with a single compare-and-swap of
+//      the timestamp of the slot for this ticket. The swap only succeeds if the ticket is not claimed yet, and its
+//      new timestamp is validated against the one of the previous ticket beforehand, which is where
+//      `InconsistentTimestampException` is thrown from. No producer waits for another one to complete any step:
+//      if the producer that has won the ticket is preempted before advancing `next_ticket_`, others advance it.
+//   2) The message is copied or moved into the slot outside of any critical section, and the slot is marked ready.
+// The consumer walks the ring in the order of the tickets. It spins for a while when the next slot is not ready yet,
+// then yields, and then parks on an `EventCount`. The number of spins adapts: it grows while spinning pays off,
+// and shrinks while the consumer ends up parked anyway. On a single core the consumer does not spin at all.
+//
+// With `DROP_ON_OVERFLOW`, the message is dropped if the next slot is not free yet. Otherwise, the publishing thread
+// spins and then parks until the consumer frees the slot. Same as with `MMQ`, the order of the messages published
+// from any particular thread is respected.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "../ss/ss.h"
+
+#include "../../bricks/sync/event_count.h"
+#include "../../bricks/time/chrono.h"
+
+namespace current {
+namespace mmq {
+
+template <typename MESSAGE, typename CONSUMER, size_t DEFAULT_BUFFER_SIZE = 1024, bool DROP_ON_OVERFLOW = false>
+class LockFreeMMQImpl {
+  static_assert(current::ss::IsEntrySubscriber<CONSUMER, MESSAGE>::value, "");
+
+ public:
+  // The type of messages to store and dispatch.
+  using message_t = MESSAGE;
+
+  // Consumer's `operator()` will be called from a dedicated thread, which is spawned and owned
+  // by the instance of LockFreeMMQImpl. See "blocks/ss/ss.h" and its test for possible callee signatures.
+  using consumer_t = CONSUMER;
+
+  LockFreeMMQImpl(consumer_t& consumer, size_t buffer_size = DEFAULT_BUFFER_SIZE)
+      : consumer_(consumer),
+        circular_buffer_size_(buffer_size),
+        circular_buffer_(new Slot[circular_buffer_size_]),
+        max_spins_(std::thread::hardware_concurrency() > 1u ? static_cast<size_t>(kMaxSpins) : 0u),
+        spins_(max_spins_) {
+    // The ready mark of a slot, `ticket + 1`, must differ from its free mark for the next ticket, `ticket + size`.
+    CURRENT_ASSERT(circular_buffer_size_ >= 2u);
+    for (size_t i = 0u; i < circular_buffer_size_; ++i) {
+      circular_buffer_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    consumer_thread_ = std::thread(&LockFreeMMQImpl::ConsumerThread, this);
+  }
+
+  // The destructor waits for the consumer thread to terminate, which implies committing all the queued messages.
+  ~LockFreeMMQImpl() {
+    destructing_ = true;
+    consumer_event_.NotifyAll();
+    free_slot_event_.NotifyAll();
+    consumer_thread_.join();
+  }
+
+ protected:
+  // Adds a message to the buffer.
+  // Supports both copy and move semantics.
+  // THREAD SAFE. Does not lock any mutex.
+  template <current::locks::MutexLockStatus, typename TIMESTAMP>  // `MutexLockStatus` is unused by MMQ.
+  idxts_t PublisherPublishImpl(const message_t& message, TIMESTAMP&& timestamp) {
+    uint64_t ticket;
+    std::chrono::microseconds us;
+    if (!ClaimTicket(timestamp, ticket, us) || !WaitForSlot(ticket)) {
+      return idxts_t();
+    }
+    Slot& slot = SlotForTicket(ticket);
+    slot.index_timestamp = idxts_t(ticket + 1u, us);
+    slot.message_body = message;
+    MarkReady(slot, ticket);
+    return idxts_t(ticket + 1u, us);
+  }
+
+  template <current::locks::MutexLockStatus, typename TIMESTAMP>  // `MutexLockStatus` is unused by MMQ.
+  idxts_t PublisherPublishImpl(message_t&& message, TIMESTAMP&& timestamp) {
+    uint64_t ticket;
+    std::chrono::microseconds us;
+    if (!ClaimTicket(timestamp, ticket, us) || !WaitForSlot(ticket)) {
+      return idxts_t();
+    }
+    Slot& slot = SlotForTicket(ticket);
+    slot.index_timestamp = idxts_t(ticket + 1u, us);
+    slot.message_body = std::move(message);
+    MarkReady(slot, ticket);
+    return idxts_t(ticket + 1u, us);
+  }
+
+ private:
+  LockFreeMMQImpl(const LockFreeMMQImpl&) = delete;
+  LockFreeMMQImpl(LockFreeMMQImpl&&) = delete;
+  void operator=(const LockFreeMMQImpl&) = delete;
+  void operator=(LockFreeMMQImpl&&) = delete;
+
+  // The slot is free for the ticket `t` when its `sequence` is `t`, and is ready to be consumed when it is `t + 1`.
+  // Once consumed, the slot is free for the ticket `t + circular_buffer_size_`.
+  // The `claimed_us` of the slot is the timestamp of the last ticket claimed for it, or `-1` initially. As timestamps
+  // strictly increase, the ticket `t` is claimed iff the `claimed_us` of its slot exceeds the one of the ticket `t - 1`.
+  struct Slot {
+    std::atomic<uint64_t> sequence;
+    std::atomic<int64_t> claimed_us{-1};
+    idxts_t index_timestamp;
+    message_t message_body;
+  };
+
+  enum : size_t { kMinSpins = 16u, kMaxSpins = 4096u, kYields = 16u };
+
+  Slot& SlotForTicket(uint64_t ticket) const { return circular_buffer_[ticket % circular_buffer_size_]; }
+
+  // Waits for `predicate()` to hold: spins up to `spins` times, then yields, then parks on `event`.
+  // Returns `false` if the instance is being destructed. The `spins` argument is updated to adapt to the load.
+  template <typename F>
+  bool SpinThenPark(EventCount& event, size_t& spins, F&& predicate) {
+    for (size_t i = 0u; i < spins; ++i) {
+      if (predicate()) {
+        spins = std::min(spins * 2u, max_spins_);
+        return true;
+      }
+    }
+    for (size_t i = 0u; i < kYields; ++i) {
+      std::this_thread::yield();
+      if (predicate()) {
+        return true;
+      }
+    }
+    spins = std::max(spins / 2u, std::min(static_cast<size_t>(kMinSpins), max_spins_));
+    while (true) {
+      const auto key = event.PrepareWait();
+      if (predicate()) {
+        return true;
+      }
+      if (destructing_) {
+        return false;
+      }
+      event.Wait(key);
+    }
+  }
+
+  // Claims the next ticket for the message with the timestamp `user_timestamp`, and sets `ticket` and `us`.
+  // Returns `false` if the message should be dropped. Throws `InconsistentTimestampException`.
+  template <typename TIMESTAMP>
+  bool ClaimTicket(const TIMESTAMP& user_timestamp, uint64_t& ticket, std::chrono::microseconds& us) {
+    if (!DROP_ON_OVERFLOW && destructing_) {
+      return false;  // LCOV_EXCL_LINE
+    }
+    while (true) {
+      uint64_t t = next_ticket_.load();
+      Slot& slot = SlotForTicket(t);
+      const int64_t previous_us = SlotForTicket(t + circular_buffer_size_ - 1u).claimed_us.load();
+      int64_t slot_us = slot.claimed_us.load();
+      const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (next_ticket_.load() != t) {
+        // The slots may have been claimed for later tickets meanwhile.
+        continue;
+      }
+      if (slot_us > previous_us) {
+        // The ticket is claimed, help its producer to advance `next_ticket_`.
+        next_ticket_.compare_exchange_strong(t, t + 1u);
+        continue;
+      }
+      if (DROP_ON_OVERFLOW && sequence != t) {
+        if (sequence < t) {
+          // Overflow. Discarding the message.
+          return false;
+        }
+        continue;  // LCOV_EXCL_LINE
+      }
+      // With `DefaultTimeArgument`, the time is taken anew on each attempt, as the previous timestamp has moved on.
+      us = current::time::TimestampAsMicroseconds(user_timestamp);
+      if (!(us.count() > previous_us)) {
+        CURRENT_THROW(ss::InconsistentTimestampException(std::chrono::microseconds(previous_us + 1), us));
+      }
+      if (slot.claimed_us.compare_exchange_strong(slot_us, us.count())) {
+        next_ticket_.compare_exchange_strong(t, t + 1u);
+        ticket = t;
+        return true;
+      }
+    }
+  }
+
+  // Waits for the consumer to free the slot for the claimed ticket. Never waits with `DROP_ON_OVERFLOW`.
+  bool WaitForSlot(uint64_t ticket) {
+    const std::atomic<uint64_t>& sequence = SlotForTicket(ticket).sequence;
+    if (sequence.load(std::memory_order_acquire) == ticket) {
+      return true;
+    }
+    size_t spins = max_spins_;
+    return SpinThenPark(
+        free_slot_event_, spins, [&sequence, ticket]() { return sequence.load(std::memory_order_acquire) == ticket; });
+  }
+
+  void MarkReady(Slot& slot, uint64_t ticket) {
+    slot.sequence.store(ticket + 1u, std::memory_order_release);
+    consumer_event_.NotifyAll();
+  }
+
+  // The index and the timestamp of the last claimed ticket, for the consumer to pass as the `last` argument.
+  // The timestamp is consistent with the ticket as long as `next_ticket_` has not moved while it was being read.
+  idxts_t LoadLastIdxTs() const {
+    while (true) {
+      const uint64_t next_ticket = next_ticket_.load();
+      if (!next_ticket) {
+        return idxts_t(0u, std::chrono::microseconds(-1));  // LCOV_EXCL_LINE
+      }
+      const int64_t us = SlotForTicket(next_ticket - 1u).claimed_us.load();
+      if (next_ticket_.load() == next_ticket) {
+        return idxts_t(next_ticket, std::chrono::microseconds(us));
+      }
+    }
+  }
+
+  // The thread which extracts fully populated messages from the ring and feeds them to the consumer.
+  void ConsumerThread() {
+    // The `tail` ticket is local to the procesing thread.
+    uint64_t tail = 0u;
+
+    while (true) {
+      Slot& slot = SlotForTicket(tail);
+      const auto ready = [&slot, tail]() { return slot.sequence.load(std::memory_order_acquire) == tail + 1u; };
+      if (!ready() && !SpinThenPark(consumer_event_, spins_, ready)) {
+        return;
+      }
+      consumer_(std::move(slot.message_body), slot.index_timestamp, LoadLastIdxTs());
+      slot.sequence.store(tail + circular_buffer_size_, std::memory_order_release);
+      ++tail;
+      if (!DROP_ON_OVERFLOW) {
+        // Need to notify message publishers that, in case they were waiting, a new slot is now available.
+        free_slot_event_.NotifyAll();
+      }
+    }
+  }
+
+  // The instance of the consuming side of the FIFO buffer.
+  consumer_t& consumer_;
+
+  // The capacity of the ring buffer for intermediate messages.
+  const size_t circular_buffer_size_;
+  const std::unique_ptr<Slot[]> circular_buffer_;
+
+  // The next ticket to claim. Lags behind by one while the producer that has claimed it has not advanced it yet.
+  std::atomic<uint64_t> next_ticket_{0u};
+
+  // The number of times to spin before yielding. Zero on a single core.
+  const size_t max_spins_;
+  size_t spins_;  // Adapted by the consumer thread.
+
+  EventCount consumer_event_;
+  EventCount free_slot_event_;
+
+  // For safe thread destruction.
+  std::atomic_bool destructing_{false};
+
+  // The thread in which the consuming process is running.
+  std::thread consumer_thread_;
+};
+
+template <typename MESSAGE, typename CONSUMER, size_t DEFAULT_BUFFER_SIZE = 1024, bool DROP_ON_OVERFLOW = false>
+using LockFreeMMQ =
+    ss::EntryPublisher<LockFreeMMQImpl<MESSAGE, CONSUMER, DEFAULT_BUFFER_SIZE, DROP_ON_OVERFLOW>, MESSAGE>;
+
+}  // namespace mmq
+}  // namespace current
+
+#endif  // BLOCKS_MMQ_LOCK_FREE_MMQ_H
@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include "mmq.h"
 #include "mmpq.h"
+#include "lock_free_mmq.h"
 
 #include <atomic>
 #include <chrono>
@@ -39,6 +40,7 @@ SOFTWARE.
 
 using current::mmq::MMQ;
 using current::mmq::MMPQ;
+using current::mmq::LockFreeMMQ;
 using current::ss::EntryResponse;
 
 TEST(InMemoryMQ, SmokeTest) {
@@ -413,3 +415,188 @@ TEST(InMemoryMQ, MMPQSupportsUpdateHead) {
   EXPECT_EQ("three @ 3, seven @ 7, ace @ 100, king @ 101, queen @ 102, jack @ 103, joker @ 1000",
             current::strings::Join(c.messages_by_timestamps_, ", "));
 }
+
+TEST(InMemoryMQ, LockFreeSmokeTest) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::string messages_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t current, idxts_t last) {
+      EXPECT_EQ(processed_messages_ + 1u, current.index);
+      EXPECT_GE(last.index, current.index);
+      messages_ += s + '\n';
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  LockFreeMMQ<std::string, Consumer> mmq(c);
+  static_assert(current::ss::IsPublisher<decltype(mmq)>::value, "");
+  static_assert(current::ss::IsEntryPublisher<decltype(mmq), std::string>::value, "");
+  EXPECT_EQ(1u, mmq.Publish("one").index);
+  EXPECT_EQ(2u, mmq.Publish("two").index);
+  const std::string three = "three";
+  EXPECT_EQ(3u, mmq.Publish(three).index);
+  while (c.processed_messages_ != 3) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ("one\ntwo\nthree\n", c.messages_);
+}
+
+TEST(InMemoryMQ, LockFreeDropOnOverflowTest) {
+  current::time::ResetToZero();
+
+  SuspendableConsumer c;
+
+  // Queue with 10 at most messages in the buffer.
+  LockFreeMMQ<std::string, SuspendableConsumer, 10, true> mmq(c);
+
+  // Suspend the consumer temporarily while the first 25 messages are published.
+  c.suspend_processing_ = true;
+
+  // Publish 25 messages, causing an overflow, of which 15 will be discarded.
+  size_t messages_accepted = 0u;
+  size_t messages_dropped = 0u;
+  for (size_t i = 0; i < 25; ++i) {
+    if (mmq.Publish(current::strings::Printf("M%02d", static_cast<int>(i))).index) {
+      ++messages_accepted;
+    } else {
+      ++messages_dropped;
+    }
+  }
+  EXPECT_EQ(10u, messages_accepted);
+  EXPECT_EQ(15u, messages_dropped);
+
+  c.suspend_processing_ = false;
+  while (c.processed_messages_ != 10u) {
+    std::this_thread::yield();
+  }
+
+  // The dropped messages do not consume indexes, so the next message accepted gets the index of `11`.
+  mmq.Publish("Plus one");
+  while (c.processed_messages_ != 11u) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(11u, c.total_messages_accepted_by_the_queue_);
+  EXPECT_EQ(12u, c.expected_next_message_index_);
+  EXPECT_EQ(11u, std::set<std::string>(begin(c.messages_), end(c.messages_)).size());
+}
+
+TEST(InMemoryMQ, LockFreeWaitOnOverflowTest) {
+  current::time::ResetToZero();
+
+  SuspendableConsumer c;
+  c.SetProcessingDelayMillis(1u);
+
+  // Queue with 10 events in the buffer. Don't drop events on overflow.
+  LockFreeMMQ<std::string, SuspendableConsumer, 10, false> mmq(c);
+
+  const auto producer = [&](char prefix, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      mmq.Publish(current::strings::Printf("%c%02d", prefix, static_cast<int>(i)));
+    }
+  };
+
+  std::vector<std::thread> producers;
+  for (size_t i = 0; i < 10; ++i) {
+    producers.emplace_back(producer, static_cast<char>('a' + i), 10u);
+  }
+  for (auto& p : producers) {
+    p.join();
+  }
+
+  // Since we published 100 messages and the size of the buffer is 10,
+  // we must see at least 90 messages processed by this moment.
+  EXPECT_GE(c.processed_messages_, 90u);
+
+  while (c.processed_messages_ != 100u) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(c.processed_messages_, c.total_messages_accepted_by_the_queue_);
+  EXPECT_EQ(100u, std::set<std::string>(c.messages_.begin(), c.messages_.end()).size());
+}
+
+TEST(InMemoryMQ, LockFreeTimeShouldNotGoBack) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::vector<std::string> messages_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t idxts, idxts_t) {
+      messages_.push_back("[" + current::ToString(idxts.index) + "] = " + s + " @ " + current::ToString(idxts.us));
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  LockFreeMMQ<std::string, Consumer> mmq(c);
+  mmq.Publish("one", std::chrono::microseconds(1));
+  mmq.Publish("three", std::chrono::microseconds(3));
+  ASSERT_THROW(mmq.Publish("two", std::chrono::microseconds(2)), current::ss::InconsistentTimestampException);
+  ASSERT_THROW(mmq.Publish("another three", std::chrono::microseconds(3)),
+               current::ss::InconsistentTimestampException);
+  mmq.Publish("four", std::chrono::microseconds(4));
+  while (c.processed_messages_ != 3) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ("[1] = one @ 1, [2] = three @ 3, [3] = four @ 4", current::strings::Join(c.messages_, ", "));
+}
+
+TEST(InMemoryMQ, LockFreeManyProducers) {
+  current::time::ResetToZero();
+
+  constexpr size_t kProducers = 16u;
+  constexpr size_t kMessagesPerProducer = 1000u;
+
+  struct ConsumerImpl {
+    std::atomic_size_t processed_messages_;
+    uint64_t last_index_ = 0u;
+    int64_t last_us_ = -1;
+    std::vector<size_t> next_message_per_producer_;
+    bool ok_ = true;
+    ConsumerImpl() : processed_messages_(0u), next_message_per_producer_(kProducers) {}
+    EntryResponse operator()(std::pair<size_t, size_t>&& message, idxts_t current, idxts_t last) {
+      // Indexes go one by one, timestamps strictly increase, and the order of each producer is respected.
+      ok_ = ok_ && (current.index == last_index_ + 1u) && (current.us.count() > last_us_) &&
+            (last.index >= current.index) && (next_message_per_producer_[message.first] == message.second);
+      last_index_ = current.index;
+      last_us_ = current.us.count();
+      ++next_message_per_producer_[message.first];
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::pair<size_t, size_t>>;
+
+  Consumer c;
+  {
+    // A small buffer, for the producers to wait for the consumer often.
+    LockFreeMMQ<std::pair<size_t, size_t>, Consumer, 64> mmq(c);
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < kProducers; ++i) {
+      producers.emplace_back([&mmq, i]() {
+        for (size_t j = 0; j < kMessagesPerProducer; ++j) {
+          mmq.Publish(std::make_pair(i, j));
+        }
+      });
+    }
+    for (auto& p : producers) {
+      p.join();
+    }
+    while (c.processed_messages_ != kProducers * kMessagesPerProducer) {
+      std::this_thread::yield();
+    }
+  }
+  EXPECT_TRUE(c.ok_);
+  EXPECT_EQ(kProducers * kMessagesPerProducer, c.last_index_);
+}
@@ -0,0 +1,636 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// A file-based persister storing length-prefixed, checksummed, binary records.
+//
+// The file begins with the `kFileMagic` marker, the format version, and the length-prefixed stream signature.
+// Each record then is a fixed 24-byte header followed by the payload of `length` bytes:
+//   * `uint32_t length`: the length of the payload, with the highest bit set for the head record, which has no payload,
+//   * `uint32_t crc32`:  the CRC32 of the other 20 bytes of the header followed by the payload,
+//   * `uint64_t index`:  the 0-based index of the entry, or the number of entries for the head record,
+//   * `int64_t us`:      the timestamp of the entry, or the head.
+// All integers are little-endian. The payload is the entry saved with `SaveIntoBinary()`. `IterateUnsafe()`,
+// and thus unchecked subscribers and HTTP endpoints, re-encode it as JSON, and `PublishUnsafe()` parses the JSON
+// back, to stay compatible with `File`. Unlike with `File`, neither is cheaper than its checked counterpart.
+//
+// The file is validated at startup by checking headers and checksums only, with no payload parsing involved.
+// As with `File`, the head record is rewritten in place if it is the last record in the file.
+
+#ifndef BLOCKS_PERSISTENCE_BINARY_H
+#define BLOCKS_PERSISTENCE_BINARY_H
+
+#include <fstream>
+#include <functional>
+
+#include "exceptions.h"
+#include "file.h"
+#include "idxts_prefix.h"
+
+#include "../ss/persister.h"
+#include "../ss/signature.h"
+
+#include "../../bricks/sync/locks.h"
+#include "../../bricks/sync/owned_borrowed.h"
+#include "../../bricks/time/chrono.h"
+#include "../../bricks/util/atomic_that_works.h"
+#include "../../bricks/util/crc32.h"
+#include "../../typesystem/schema/schema.h"
+#include "../../typesystem/serialization/binary.h"
+#include "../../typesystem/serialization/json.h"
+
+namespace current {
+namespace persistence {
+
+namespace impl {
+
+namespace binary {
+
+constexpr char kFileMagic[] = "CURRENTB";
+constexpr size_t kFileMagicLength = 8u;
+constexpr uint32_t kFormatVersion = 1u;
+
+constexpr uint32_t kRecordTypeEntry = 0u;
+constexpr uint32_t kRecordTypeHead = 0x80000000u;
+constexpr uint32_t kRecordLengthMask = 0x7fffffffu;
+
+constexpr size_t kRecordHeaderSize = 24u;
+
+inline void PutUInt32(char* p, uint32_t x) {
+  for (size_t i = 0u; i < 4u; ++i) {
+    p[i] = static_cast<char>((x >> (i * 8u)) & 0xff);
+  }
+}
+
+inline void PutUInt64(char* p, uint64_t x) {
+  for (size_t i = 0u; i < 8u; ++i) {
+    p[i] = static_cast<char>((x >> (i * 8u)) & 0xff);
+  }
+}
+
+inline uint32_t GetUInt32(const char* p) {
+  uint32_t x = 0u;
+  for (size_t i = 0u; i < 4u; ++i) {
+    x |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (i * 8u);
+  }
+  return x;
+}
+
+inline uint64_t GetUInt64(const char* p) {
+  uint64_t x = 0u;
+  for (size_t i = 0u; i < 8u; ++i) {
+    x |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (i * 8u);
+  }
+  return x;
+}
+
+struct RecordHeader {
+  uint32_t type = kRecordTypeEntry;
+  uint32_t length = 0u;
+  uint64_t index = 0u;
+  std::chrono::microseconds us = std::chrono::microseconds(0);
+
+  RecordHeader() = default;
+  RecordHeader(uint32_t type, uint32_t length, uint64_t index, std::chrono::microseconds us)
+      : type(type), length(length), index(index), us(us) {}
+
+  // Serializes the header, computing the checksum over it and the `payload`.
+  void Serialize(char* output, const char* payload) const {
+    PutUInt32(output, type | length);
+    PutUInt64(output + 8, index);
+    PutUInt64(output + 16, static_cast<uint64_t>(us.count()));
+    PutUInt32(output + 4, Checksum(output, payload, length));
+  }
+
+  static uint32_t Checksum(const char* header, const char* payload, size_t length) {
+    return CRC32(CRC32(CRC32(0u, header, 4u), header + 8, 16u), payload, length);
+  }
+};
+
+inline std::string FileHeader(const std::string& signature) {
+  std::string result(kFileMagic, kFileMagicLength);
+  char buffer[8];
+  PutUInt32(buffer, kFormatVersion);
+  PutUInt32(buffer + 4, static_cast<uint32_t>(signature.length()));
+  result.append(buffer, 8u);
+  result += signature;
+  return result;
+}
+
+// Reads the file header, of the `remaining` bytes of the file, which are counted down, same as by `ReadRecord()`.
+// Throws on a malformed header or on signature mismatch.
+inline void ReadAndValidateFileHeader(std::istream& fi, uint64_t& remaining, const std::string& expected_signature) {
+  char buffer[kFileMagicLength + 8u];
+  if (!fi.read(buffer, sizeof(buffer)) || std::string(buffer, kFileMagicLength) != kFileMagic) {
+    CURRENT_THROW(MalformedEntryException("Not a binary persistence file."));
+  }
+  if (GetUInt32(buffer + kFileMagicLength) != kFormatVersion) {
+    CURRENT_THROW(MalformedEntryException("Unsupported binary persistence format version."));
+  }
+  const uint32_t signature_length = GetUInt32(buffer + kFileMagicLength + 4u);
+  if (remaining < sizeof(buffer) || signature_length > remaining - sizeof(buffer)) {
+    CURRENT_THROW(MalformedEntryException("Truncated binary persistence file header."));
+  }
+  remaining -= sizeof(buffer) + signature_length;
+  std::string signature(signature_length, ' ');
+  if (!fi.read(&signature[0], signature.length())) {
+    CURRENT_THROW(MalformedEntryException("Truncated binary persistence file header."));
+  }
+  if (signature != expected_signature) {
+    CURRENT_THROW(InvalidStreamSignature(expected_signature, signature));
+  }
+}
+
+// Reads the next record, of the `remaining` bytes of the file, which are counted down.
+// Returns `false` on a clean end of file, throws on a truncated or a corrupted record.
+// The header is validated before the payload is read, so that a corrupted length is never allocated.
+inline bool ReadRecord(std::istream& fi, uint64_t& remaining, RecordHeader& header, std::string& payload) {
+  char buffer[kRecordHeaderSize];
+  fi.read(buffer, kRecordHeaderSize);
+  if (fi.gcount() == 0) {
+    return false;
+  }
+  if (fi.gcount() != static_cast<std::streamsize>(kRecordHeaderSize) || remaining < kRecordHeaderSize) {
+    CURRENT_THROW(MalformedEntryException("Truncated binary record header."));
+  }
+  remaining -= kRecordHeaderSize;
+  const uint32_t type_and_length = GetUInt32(buffer);
+  header.type = type_and_length & ~kRecordLengthMask;
+  header.length = type_and_length & kRecordLengthMask;
+  header.index = GetUInt64(buffer + 8);
+  header.us = std::chrono::microseconds(static_cast<int64_t>(GetUInt64(buffer + 16)));
+  if (header.type == kRecordTypeHead && header.length) {
+    CURRENT_THROW(MalformedEntryException("Invalid binary head record."));
+  }
+  if (header.length > remaining) {
+    CURRENT_THROW(MalformedEntryException("Truncated binary record payload."));
+  }
+  remaining -= header.length;
+  payload.resize(header.length);
+  if (header.length && !fi.read(&payload[0], header.length)) {
+    CURRENT_THROW(MalformedEntryException("Truncated binary record payload."));
+  }
+  if (RecordHeader::Checksum(buffer, payload.data(), payload.length()) != GetUInt32(buffer + 4)) {
+    CURRENT_THROW(BinaryRecordChecksumMismatchException(header.index));
+  }
+  return true;
+}
+
+}  // namespace current::persistence::impl::binary
+
+template <typename ENTRY>
+class BinaryPersister {
+ protected:
+  // { last_published_index + 1, last_published_us, current_head_us }, or { 0, -1us, -1us } for an empty persister.
+  struct end_t {
+    uint64_t next_index;
+    std::chrono::microseconds last_entry_us;
+    std::chrono::microseconds head;
+  };
+
+ private:
+  struct BinaryPersisterImpl final {
+    const std::string filename_;
+    std::ofstream file_appender_;
+    std::fstream head_rewriter_;
+
+    std::mutex& publish_mutex_ref_;  // Guards `record_offset_`, `head_offset_` and `record_timestamp_`.
+    std::vector<std::streampos> record_offset_;
+    std::vector<std::chrono::microseconds> record_timestamp_;
+    std::streampos head_offset_;  // The offset of the head record if it is the last one in the file, or zero.
+
+    current::atomic_that_works<end_t> end_;
+
+    BinaryPersisterImpl() = delete;
+    BinaryPersisterImpl(const BinaryPersisterImpl&) = delete;
+    BinaryPersisterImpl(BinaryPersisterImpl&&) = delete;
+    BinaryPersisterImpl& operator=(const BinaryPersisterImpl&) = delete;
+    BinaryPersisterImpl& operator=(BinaryPersisterImpl&&) = delete;
+
+    BinaryPersisterImpl(std::mutex& publish_mutex_ref,
+                        const ss::StreamNamespaceName& namespace_name,
+                        const std::string& filename)
+        : filename_(filename),
+          file_appender_(filename, std::ofstream::binary | std::ofstream::app | std::ofstream::ate),
+          head_rewriter_(filename, std::ofstream::binary | std::ofstream::in | std::ofstream::out),
+          publish_mutex_ref_(publish_mutex_ref),
+          head_offset_(0) {
+      if (file_appender_.bad() || head_rewriter_.bad()) {
+        CURRENT_THROW(PersistenceFileNotWritable(filename));
+      }
+      ValidateFileAndInitializeHead(namespace_name);
+    }
+
+    // Scan the record headers and verify the checksums. Used to initialize `end_` at startup.
+    void ValidateFileAndInitializeHead(const ss::StreamNamespaceName& namespace_name) {
+      reflection::StructSchema struct_schema;
+      struct_schema.AddType<ENTRY>();
+      const auto signature = JSON(ss::StreamSignature(namespace_name, struct_schema.GetSchemaInfo()));
+
+      end_t end{0ull, std::chrono::microseconds(-1), std::chrono::microseconds(-1)};
+      std::ifstream fi(filename_, std::ifstream::binary);
+      if (fi.peek() == std::ifstream::traits_type::eof()) {
+        file_appender_ << binary::FileHeader(signature) << std::flush;
+      } else {
+        fi.seekg(0, std::ios_base::end);
+        uint64_t remaining = static_cast<uint64_t>(fi.tellg());
+        fi.seekg(0, std::ios_base::beg);
+        binary::ReadAndValidateFileHeader(fi, remaining, signature);
+        binary::RecordHeader header;
+        std::string payload;
+        std::streampos offset = fi.tellg();
+        while (binary::ReadRecord(fi, remaining, header, payload)) {
+          if (!(header.us > end.head)) {
+            CURRENT_THROW(ss::InconsistentTimestampException(end.head + std::chrono::microseconds(1), header.us));
+          }
+          if (header.type == binary::kRecordTypeEntry) {
+            if (header.index != end.next_index) {
+              CURRENT_THROW(ss::InconsistentIndexException(end.next_index, header.index));
+            }
+            record_offset_.push_back(offset);
+            record_timestamp_.push_back(header.us);
+            ++end.next_index;
+            end.last_entry_us = header.us;
+            head_offset_ = 0;
+          } else {
+            head_offset_ = offset;
+          }
+          end.head = header.us;
+          offset = fi.tellg();
+        }
+      }
+      end_.store(end);
+    }
+
+    // Must be called from within the locked section.
+    void AppendRecord(const binary::RecordHeader& header, const std::string& payload) {
+      char buffer[binary::kRecordHeaderSize];
+      header.Serialize(buffer, payload.data());
+      file_appender_.write(buffer, binary::kRecordHeaderSize);
+      file_appender_.write(payload.data(), payload.length());
+      file_appender_.flush();
+    }
+  };
+
+ public:
+  BinaryPersister() = delete;
+  BinaryPersister(const BinaryPersister&) = delete;
+  BinaryPersister(BinaryPersister&&) = delete;
+  BinaryPersister& operator=(const BinaryPersister&) = delete;
+  BinaryPersister& operator=(BinaryPersister&&) = delete;
+
+  BinaryPersister(std::mutex& publish_mutex_ref,
+                  const ss::StreamNamespaceName& namespace_name,
+                  const std::string& filename)
+      : impl_(MakeOwned<BinaryPersisterImpl>(publish_mutex_ref, namespace_name, filename)) {}
+
+  // Both the safe and the unsafe iterators scan the file sequentially from the offset of the first entry.
+  // The safe one loads the payload, the unsafe one re-encodes it as JSON and prepends the index and timestamp.
+  // The head records preceding the entries being read are never rewritten, so no locking is required.
+  template <bool UNSAFE>
+  class IteratorImpl final {
+   public:
+    struct Entry {
+      idxts_t idx_ts;
+      ENTRY entry;
+    };
+    using value_t = typename std::conditional<UNSAFE, std::string, Entry>::type;
+
+    IteratorImpl() = delete;
+    IteratorImpl(const IteratorImpl&) = delete;
+    IteratorImpl& operator=(const IteratorImpl&) = delete;
+    IteratorImpl(IteratorImpl&&) = default;
+    IteratorImpl& operator=(IteratorImpl&&) = default;
+
+    IteratorImpl(Borrowed<BinaryPersisterImpl> impl, const std::string& filename, uint64_t i, std::streampos offset)
+        : impl_(std::move(impl)), i_(i) {
+      if (!filename.empty()) {
+        fi_ = std::make_unique<std::ifstream>(filename, std::ifstream::binary);
+        // The file only grows, and the entries to iterate over are all in it by now.
+        fi_->seekg(0, std::ios_base::end);
+        remaining_ = static_cast<uint64_t>(fi_->tellg()) - static_cast<uint64_t>(offset);
+        fi_->seekg(offset, std::ios_base::beg);
+      }
+    }
+
+    // `operator*` relies on the fact each entry will be requested at most once.
+    value_t operator*() const {
+      binary::RecordHeader header;
+      do {
+        if (!binary::ReadRecord(*fi_, remaining_, header, payload_)) {
+          // End of file. Should never happen as long as the user only iterates over valid ranges.
+          CURRENT_THROW(current::Exception());  // LCOV_EXCL_LINE
+        }
+      } while (header.type != binary::kRecordTypeEntry || header.index < i_);
+      if (header.index != i_) {
+        CURRENT_THROW(ss::InconsistentIndexException(i_, header.index));  // LCOV_EXCL_LINE
+      }
+      return Value(header);
+    }
+
+    IteratorImpl& operator++() {
+      ++i_;
+      return *this;
+    }
+    bool operator==(const IteratorImpl& rhs) const { return i_ == rhs.i_; }
+    bool operator!=(const IteratorImpl& rhs) const { return !operator==(rhs); }
+    operator bool() const { return impl_; }
+
+   private:
+    template <bool B = UNSAFE>
+    ENABLE_IF<!B, Entry> Value(const binary::RecordHeader& header) const {
+      return Entry{idxts_t(header.index, header.us), LoadFromBinary<ENTRY>(payload_)};
+    }
+
+    // The JSON round-trip: the payload is parsed into the entry, which is then serialized as JSON.
+    template <bool B = UNSAFE>
+    ENABLE_IF<B, std::string> Value(const binary::RecordHeader& header) const {
+      return JSON(idxts_t(header.index, header.us)) + '\t' + JSON(LoadFromBinary<ENTRY>(payload_));
+    }
+
+    Borrowed<BinaryPersisterImpl> impl_;
+    std::unique_ptr<std::ifstream> fi_;
+    uint64_t i_;
+    mutable uint64_t remaining_ = 0u;  // The bytes of the file past the position of `fi_`, as of its opening.
+    mutable std::string payload_;
+  };
+
+  using Iterator = IteratorImpl<false>;
+  using IteratorUnsafe = IteratorImpl<true>;
+
+  template <typename ITERATOR>
+  class IterableRangeImpl {
+   public:
+    IterableRangeImpl(Borrowed<BinaryPersisterImpl> impl, uint64_t begin, uint64_t end, std::streampos begin_offset)
+        : impl_(std::move(impl)), begin_(begin), end_(end), begin_offset_(begin_offset) {}
+
+    IterableRangeImpl(IterableRangeImpl&& rhs)
+        : impl_(std::move(rhs.impl_)), begin_(rhs.begin_), end_(rhs.end_), begin_offset_(rhs.begin_offset_) {}
+
+    // No need in accessing the file for null and for `end` iterators.
+    ITERATOR begin() const {
+      return ITERATOR(impl_, begin_ == end_ ? "" : impl_->filename_, begin_, begin_offset_);
+    }
+    ITERATOR end() const { return ITERATOR(impl_, "", end_, 0); }
+
+    operator bool() const { return impl_; }
+
+   private:
+    const Borrowed<BinaryPersisterImpl> impl_;
+    const uint64_t begin_;
+    const uint64_t end_;
+    const std::streampos begin_offset_;
+  };
+
+  template <current::locks::MutexLockStatus MLS, typename E, typename TIMESTAMP>
+  idxts_t PersisterPublishImpl(E&& entry, const TIMESTAMP provided_timestamp) {
+    current::locks::SmartMutexLockGuard<MLS> lock(impl_->publish_mutex_ref_);
+    const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
+    // Explicit `MakeSureTheRightTypeIsSerialized` is essential, otherwise the `Variant`'s case
+    // would be serialized in an unwrapped way when passed directly.
+    return AppendEntryFromLockedSection(
+        timestamp, SaveIntoBinary(MakeSureTheRightTypeIsSerialized<ENTRY, decay<E>>::DoIt(std::forward<E>(entry))));
+  }
+
+  // The other half of the JSON round-trip: the entry is parsed from the JSON of the line, to be saved as binary.
+  template <current::locks::MutexLockStatus MLS>
+  idxts_t PersisterPublishUnsafeImpl(const std::string& raw_log_line) {
+    current::locks::SmartMutexLockGuard<MLS> lock(impl_->publish_mutex_ref_);
+    const auto tab_pos = raw_log_line.find('\t');
+    if (tab_pos == std::string::npos) {
+      CURRENT_THROW(MalformedEntryException(raw_log_line));
+    }
+    const idxts_t idxts = ParseIndexAndTimestampPrefix(raw_log_line, tab_pos);
+    const uint64_t next_index = impl_->end_.load().next_index;
+    if (idxts.index != next_index) {
+      CURRENT_THROW(UnsafePublishBadIndexTimestampException(next_index, idxts.index));
+    }
+    return AppendEntryFromLockedSection(idxts.us, SaveIntoBinary(ParseJSON<ENTRY>(raw_log_line.substr(tab_pos + 1))));
+  }
+
+  template <current::locks::MutexLockStatus MLS, typename TIMESTAMP>
+  void PersisterUpdateHeadImpl(const TIMESTAMP provided_timestamp) {
+    current::locks::SmartMutexLockGuard<MLS> lock(impl_->publish_mutex_ref_);
+
+    end_t iterator = impl_->end_.load();
+    const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
+    if (!(timestamp > iterator.head)) {
+      CURRENT_THROW(ss::InconsistentTimestampException(iterator.head + std::chrono::microseconds(1), timestamp));
+    }
+    iterator.head = timestamp;
+    const binary::RecordHeader header(binary::kRecordTypeHead, 0u, iterator.next_index, timestamp);
+    if (impl_->head_offset_) {
+      char buffer[binary::kRecordHeaderSize];
+      header.Serialize(buffer, "");
+      auto& rewriter = impl_->head_rewriter_;
+      rewriter.seekp(impl_->head_offset_, std::ios_base::beg);
+      rewriter.write(buffer, binary::kRecordHeaderSize);
+      rewriter.flush();
+    } else {
+      impl_->head_offset_ = impl_->file_appender_.tellp();
+      impl_->AppendRecord(header, "");
+    }
+    impl_->end_.store(iterator);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  bool PersisterEmptyImpl() const {
+    return !impl_->end_.load().next_index;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  uint64_t PersisterSizeImpl() const noexcept {
+    return impl_->end_.load().next_index;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  std::chrono::microseconds PersisterCurrentHeadImpl() const noexcept {
+    return impl_->end_.load().head;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  idxts_t PersisterLastPublishedIndexAndTimestampImpl() const {
+    const auto iterator = impl_->end_.load();
+    if (iterator.next_index) {
+      return idxts_t(iterator.next_index - 1, iterator.last_entry_us);
+    } else {
+      CURRENT_THROW(NoEntriesPublishedYet());
+    }
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  head_optidxts_t PersisterHeadAndLastPublishedIndexAndTimestampImpl() const noexcept {
+    const auto iterator = impl_->end_.load();
+    if (iterator.next_index) {
+      return head_optidxts_t(iterator.head, iterator.next_index - 1, iterator.last_entry_us);
+    } else {
+      return head_optidxts_t(iterator.head);
+    }
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  std::pair<uint64_t, uint64_t> PersisterIndexRangeByTimestampRangeImpl(std::chrono::microseconds from,
+                                                                        std::chrono::microseconds till) const {
+    std::pair<uint64_t, uint64_t> result{static_cast<uint64_t>(-1), static_cast<uint64_t>(-1)};
+    current::locks::SmartMutexLockGuard<MLS> lock(impl_->publish_mutex_ref_);
+    const auto& timestamps = impl_->record_timestamp_;
+    const auto begin_it = std::lower_bound(timestamps.begin(), timestamps.end(), from);
+    if (begin_it != timestamps.end()) {
+      result.first = std::distance(timestamps.begin(), begin_it);
+    }
+    if (till.count() > 0) {
+      const auto end_it = std::upper_bound(timestamps.begin(), timestamps.end(), till);
+      if (end_it != timestamps.end()) {
+        result.second = std::distance(timestamps.begin(), end_it);
+      }
+    }
+    return result;
+  }
+
+  using IterableRange = IterableRangeImpl<Iterator>;
+  using IterableRangeUnsafe = IterableRangeImpl<IteratorUnsafe>;
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRange PersisterIterate(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRange>(begin_index, end_index);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeUnsafe PersisterIterateUnsafe(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRangeUnsafe>(begin_index, end_index);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRange PersisterIterate(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    return PersisterIterateImpl<MLS, IterableRange>(from, till);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeUnsafe PersisterIterateUnsafe(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    return PersisterIterateImpl<MLS, IterableRangeUnsafe>(from, till);
+  }
+
+ private:
+  idxts_t AppendEntryFromLockedSection(std::chrono::microseconds timestamp, const std::string& payload) {
+    end_t iterator = impl_->end_.load();
+    if (!(timestamp > iterator.head)) {
+      CURRENT_THROW(ss::InconsistentTimestampException(iterator.head + std::chrono::microseconds(1), timestamp));
+    }
+    const auto idxts = idxts_t(iterator.next_index, timestamp);
+    CURRENT_ASSERT(impl_->record_offset_.size() == iterator.next_index);
+    impl_->record_offset_.push_back(impl_->file_appender_.tellp());
+    impl_->record_timestamp_.push_back(timestamp);
+    impl_->AppendRecord(
+        binary::RecordHeader(binary::kRecordTypeEntry, static_cast<uint32_t>(payload.length()), idxts.index, idxts.us),
+        payload);
+    iterator.last_entry_us = iterator.head = timestamp;
+    ++iterator.next_index;
+    impl_->head_offset_ = 0;
+    impl_->end_.store(iterator);
+    return idxts;
+  }
+
+  template <current::locks::MutexLockStatus MLS, typename ITERABLE>
+  ITERABLE PersisterIterateImpl(uint64_t begin_index, uint64_t end_index) const {
+    const uint64_t current_size = impl_->end_.load().next_index;
+    if (end_index == static_cast<uint64_t>(-1)) {
+      end_index = current_size;
+    }
+    if (end_index > current_size) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+    if (begin_index == end_index) {
+      return ITERABLE(impl_, 0, 0, 0);
+    }
+    if (end_index < begin_index) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+    current::locks::SmartMutexLockGuard<MLS> lock(impl_->publish_mutex_ref_);
+    return ITERABLE(impl_, begin_index, end_index, impl_->record_offset_[begin_index]);
+  }
+
+  template <current::locks::MutexLockStatus MLS, typename ITERABLE>
+  ITERABLE PersisterIterateImpl(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    if (till.count() > 0 && till < from) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+    const auto index_range = PersisterIndexRangeByTimestampRangeImpl<MLS>(from, till);
+    if (index_range.first != static_cast<uint64_t>(-1)) {
+      return PersisterIterateImpl<MLS, ITERABLE>(index_range.first, index_range.second);
+    } else {  // No entries found in the requested range.
+      return ITERABLE(impl_, 0, 0, 0);
+    }
+  }
+
+ private:
+  Owned<BinaryPersisterImpl> impl_;  // `Owned`, as iterators borrow it.
+};
+
+}  // namespace current::persistence::impl
+
+template <typename ENTRY>
+using Binary = ss::EntryPersister<impl::BinaryPersister<ENTRY>, ENTRY>;
+
+// Converts a persisted stream from one persistence layer into another, i.e. `File` into `Binary` or vice versa.
+// Both persisters validate their respective files. The entries are copied as raw log lines,
+// and the current head, if it is ahead of the last entry, is carried over as well.
+// The destination must be empty. Returns the number of entries converted.
+template <typename ENTRY, template <typename> class FROM, template <typename> class TO>
+uint64_t ConvertPersistedStream(const std::string& from_filename,
+                                const std::string& to_filename,
+                                const ss::StreamNamespaceName& namespace_name) {
+  std::mutex from_mutex;
+  FROM<ENTRY> from(from_mutex, namespace_name, from_filename);
+  std::mutex to_mutex;
+  TO<ENTRY> to(to_mutex, namespace_name, to_filename);
+  if (!to.Empty()) {
+    CURRENT_THROW(PersistenceFileNotEmpty(to_filename));
+  }
+  for (const auto& raw_log_line : from.IterateUnsafe()) {
+    to.PublishUnsafe(raw_log_line);
+  }
+  const auto head = from.CurrentHead();
+  if (head > to.CurrentHead()) {
+    to.UpdateHead(head);
+  }
+  return to.Size();
+}
+
+template <typename ENTRY>
+uint64_t ConvertFileToBinary(const std::string& from_filename,
+                             const std::string& to_filename,
+                             const ss::StreamNamespaceName& namespace_name) {
+  return ConvertPersistedStream<ENTRY, File, Binary>(from_filename, to_filename, namespace_name);
+}
+
+template <typename ENTRY>
+uint64_t ConvertBinaryToFile(const std::string& from_filename,
+                             const std::string& to_filename,
+                             const ss::StreamNamespaceName& namespace_name) {
+  return ConvertPersistedStream<ENTRY, Binary, File>(from_filename, to_filename, namespace_name);
+}
+
+}  // namespace current::persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_BINARY_H
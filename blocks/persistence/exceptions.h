@@ -64,6 +64,32 @@ struct PersistenceFileNotWritable : PersistenceException {
       : PersistenceException("Persistence file not writable: `" + filename + "`.") {}
 };
 
+struct PersistenceFileCommitFailed : PersistenceException {
+  explicit PersistenceFileCommitFailed(const std::string& filename)
+      : PersistenceException("Persistence file could not be written or synced: `" + filename + "`.") {}
+};
+
+struct PersistenceFileNotMappable : PersistenceException {
+  explicit PersistenceFileNotMappable(const std::string& filename)
+      : PersistenceException("Persistence file can not be memory-mapped: `" + filename + "`.") {}
+};
+
+struct PersistenceFileNotEmpty : PersistenceException {
+  explicit PersistenceFileNotEmpty(const std::string& filename)
+      : PersistenceException("Persistence file not empty: `" + filename + "`.") {}
+};
+
+struct InvalidSegmentsManifest : PersistenceException {
+  explicit InvalidSegmentsManifest(const std::string& message)
+      : PersistenceException("Invalid segments manifest: " + message) {}
+};
+
+struct BinaryRecordChecksumMismatchException : MalformedEntryException {
+  explicit BinaryRecordChecksumMismatchException(uint64_t index)
+      : MalformedEntryException(current::strings::Printf("Checksum mismatch in the record with index %lld.",
+                                                         static_cast<long long>(index))) {}
+};
+
 struct UnsafePublishBadIndexTimestampException : PersistenceException {
   explicit UnsafePublishBadIndexTimestampException(uint64_t expected, uint64_t found)
       : PersistenceException(current::strings::Printf(
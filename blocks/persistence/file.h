@@ -27,6 +27,8 @@ SOFTWARE.
 // The file is replayed at startup to check its integriry and to extract the most recent index/timestamp.
 // Each iterator opens the same file again, to read its first N lines.
 // Iterators never outlive the persister.
+// With `FileIndex::Sparse()`, only every N-th record is indexed, in a memory-mapped sidecar file, see `file_index.h`.
+// `IterateMapped()` hands out the raw lines as `strings::Chunk`-s of the memory-mapped file, see `file_mapping.h`.
 
 #ifndef BLOCKS_PERSISTENCE_FILE_H
 #define BLOCKS_PERSISTENCE_FILE_H
@@ -35,15 +37,22 @@ SOFTWARE.
 #include <fstream>
 #include <functional>
 
-#ifdef CURRENT_BUILD_WITH_PARANOIC_RUNTIME_CHECKS
+#ifndef CURRENT_WINDOWS
+#include <unistd.h>
+#endif  // CURRENT_WINDOWS
+
 #include <iostream>
-#endif  // CURRENT_BUILD_WITH_PARANOIC_RUNTIME_CHECKS
 
 #include "exceptions.h"
+#include "file_index.h"
+#include "file_mapping.h"
+#include "group_commit.h"
+#include "idxts_prefix.h"
 
 #include "../ss/persister.h"
 #include "../ss/signature.h"
 
+#include "../../bricks/strings/chunk.h"
 #include "../../bricks/sync/locks.h"
 #include "../../bricks/sync/owned_borrowed.h"
 #include "../../bricks/time/chrono.h"
@@ -88,7 +97,7 @@ class IteratorOverFileOfPersistedEntries {
         if (tab_pos == std::string::npos) {
           CURRENT_THROW(MalformedEntryException(line_));
         }
-        const auto current = ParseJSON<idxts_t>(line_.substr(0, tab_pos));
+        const auto current = ParseIndexAndTimestampPrefix(line_, tab_pos);
         if (current.index != next_.index) {
           // Indexes must be strictly continuous.
           CURRENT_THROW(ss::InconsistentIndexException(next_.index, current.index));
@@ -152,16 +161,34 @@ class FilePersister {
 
     // `record_offset_.size() == end.next_index`,
     // and `record_offset_[i]` is the record_offset_ in bytes where the line for index `i` begins.
-    std::mutex& publish_mutex_ref_;  // Guards `record_offset_`, `head_offset_` and `record_timestamp_`.
+    // In the `Sparse` index mode both vectors stay empty, and `sparse_index_` is used instead.
+    std::mutex& publish_mutex_ref_;  // Guards `record_offset_`, `head_offset_`, `record_timestamp_`, `sparse_index_`.
     std::vector<std::streampos> record_offset_;
     std::streampos head_offset_;
     std::vector<std::chrono::microseconds> record_timestamp_;
+    std::unique_ptr<FileSparseIndex> sparse_index_;
+    // The index of the first record, with `record_offset_`, `record_timestamp_` and `sparse_index_` relative to it.
+    const uint64_t first_index_;
+
+    // Shared by all the `IteratorMapped`-s, and only mapped once the first one is dereferenced.
+    FileMapping mapping_;
 
     // Just `std::atomic<end_t> end_;` won't work in g++ until 5.1, ref.
     // http://stackoverflow.com/questions/29824570/segfault-in-stdatomic-load/29824840#29824840
     // std::atomic<end_t> end_;
     current::atomic_that_works<end_t> end_;
 
+    // The publisher-side `end_`. Guarded by `publish_mutex_ref_`.
+    // Equals `end_` in the `Strict` mode, and is ahead of it by the uncommitted entries in the `GroupCommit` mode.
+    end_t next_end_;
+
+    // The group commit machinery, only used in the `GroupCommit` mode.
+    // The offset of the next record to append is tracked manually, as the file is written to by the committer thread.
+    const FileDurability durability_;
+    std::streampos append_offset_;
+    std::streampos group_commit_begin_offset_;  // The size of the file as the committer took over.
+    std::unique_ptr<GroupCommitter<end_t>> group_committer_;  // Last, to be destructed, and thus flushed, first.
+
     FilePersisterImpl() = delete;
     FilePersisterImpl(const FilePersisterImpl&) = delete;
     FilePersisterImpl(FilePersisterImpl&&) = delete;
@@ -170,16 +197,59 @@ class FilePersister {
 
     FilePersisterImpl(std::mutex& publish_mutex_ref,
                       const ss::StreamNamespaceName& namespace_name,
-                      const std::string& filename)
+                      const std::string& filename,
+                      const FileDurability& durability,
+                      const FileIndex& index)
         : filename_(filename),
           file_appender_(filename, std::ofstream::app | std::ofstream::ate),
           head_rewriter_(filename, std::ofstream::in | std::ofstream::out),
           publish_mutex_ref_(publish_mutex_ref),
-          head_offset_(0) {
+          head_offset_(0),
+          sparse_index_(index.every_n ? std::make_unique<FileSparseIndex>(filename + ".idx", index.every_n) : nullptr),
+          first_index_(index.first_index),
+          mapping_(filename),
+          durability_(durability) {
       ValidateFileAndInitializeHead(namespace_name);
       if (file_appender_.bad() || head_rewriter_.bad()) {
         CURRENT_THROW(PersistenceFileNotWritable(filename));
       }
+      next_end_ = end_.load();
+      if (durability_.group_commit) {
+        append_offset_ = file_appender_.tellp();
+        group_commit_begin_offset_ = append_offset_;
+        group_committer_ = std::make_unique<GroupCommitter<end_t>>(
+            file_appender_, filename_, durability_, [this](const end_t& end) { end_.store(end); });
+      }
+    }
+
+    // After a failed batch, `file_appender_` may still hold its data, and would write it out as it is closed,
+    // while the publishers of the batch got `PersistenceFileCommitFailed`. So the file is cut back to what was
+    // committed, for it to be reopened with exactly the entries that were reported as published.
+    ~FilePersisterImpl() {
+      if (group_committer_ && group_committer_->Failed()) {
+        const uint64_t committed_length =
+            static_cast<uint64_t>(group_commit_begin_offset_) + group_committer_->Stats().bytes;
+        group_committer_ = nullptr;
+        file_appender_.close();
+#ifndef CURRENT_WINDOWS
+        if (::truncate(filename_.c_str(), static_cast<off_t>(committed_length))) {
+          std::cerr << "Could not cut back the file after a failed group commit: " << filename_ << std::endl;
+        }
+#endif  // CURRENT_WINDOWS
+      }
+    }
+
+    // Must be called for each record, in order, from the locked section.
+    void AddRecord(uint64_t index, std::streampos offset, std::chrono::microseconds us) {
+      index -= first_index_;
+      if (sparse_index_) {
+        sparse_index_->Add(index, offset, us);
+      } else {
+        CURRENT_ASSERT(index == record_offset_.size());
+        CURRENT_ASSERT(index == record_timestamp_.size());
+        record_offset_.push_back(offset);
+        record_timestamp_.push_back(us);
+      }
     }
 
     // Replay the file but ignore its contents. Used to initialize `end_` at startup.
@@ -188,8 +258,9 @@ class FilePersister {
       if (!fi.bad()) {
         // Read through all the lines.
         // Let `IteratorOverFileOfPersistedEntries` maintain its own `next_`, which later becomes `this->end_`.
-        // While reading the file, record the offset of each record and store it in `record_offset_`.
-        IteratorOverFileOfPersistedEntries<ENTRY> cit(fi, 0, 0);
+        // While reading the file, record the offset of each record and store it in `record_offset_`,
+        // or, in the `Sparse` index mode, of every N-th record in `sparse_index_`.
+        IteratorOverFileOfPersistedEntries<ENTRY> cit(fi, 0, first_index_);
         const std::streampos offset_zero(0);
         auto current_offset = offset_zero;
         auto head = std::chrono::microseconds(-1);
@@ -198,13 +269,10 @@ class FilePersister {
         const auto signature = JSON(ss::StreamSignature(namespace_name, struct_schema.GetSchemaInfo()));
         while (cit.ProcessNextEntry(
             [&](const idxts_t& current, const char*) {
-              CURRENT_ASSERT(current.index == record_offset_.size());
-              CURRENT_ASSERT(current.index == record_timestamp_.size());
               if (!(current.us > head)) {
                 CURRENT_THROW(ss::InconsistentTimestampException(head + std::chrono::microseconds(1), current.us));
               }
-              record_offset_.push_back(current_offset);
-              record_timestamp_.push_back(current.us);
+              AddRecord(current.index, current_offset, current.us);
               current_offset = fi.tellg();
               head = current.us;
               head_offset_ = 0;
@@ -250,7 +318,7 @@ class FilePersister {
           file_appender_ << constants::kSignatureDirective << ' ' << signature << std::endl;
         }
       } else {
-        end_.store({0ull, std::chrono::microseconds(-1), std::chrono::microseconds(-1)});
+        end_.store({first_index_, std::chrono::microseconds(-1), std::chrono::microseconds(-1)});
       }
     }
   };
@@ -264,8 +332,32 @@ class FilePersister {
 
   FilePersister(std::mutex& publish_mutex_ref,
                 const ss::StreamNamespaceName& namespace_name,
-                const std::string& filename)
-      : file_persister_impl_(MakeOwned<FilePersisterImpl>(publish_mutex_ref, namespace_name, filename)) {}
+                const std::string& filename,
+                const FileDurability& durability = FileDurability::Strict(),
+                const FileIndex& index = FileIndex::Full())
+      : file_persister_impl_(
+            MakeOwned<FilePersisterImpl>(publish_mutex_ref, namespace_name, filename, durability, index)) {}
+
+  FilePersister(std::mutex& publish_mutex_ref,
+                const ss::StreamNamespaceName& namespace_name,
+                const std::string& filename,
+                const FileIndex& index)
+      : FilePersister(publish_mutex_ref, namespace_name, filename, FileDurability::Strict(), index) {}
+
+  // The size of the file in bytes, including the entries not yet committed in the `GroupCommit` mode.
+  uint64_t FileSizeFromLockedSection() {
+    if (file_persister_impl_->group_committer_) {
+      return static_cast<uint64_t>(file_persister_impl_->append_offset_);
+    } else {
+      return static_cast<uint64_t>(file_persister_impl_->file_appender_.tellp());
+    }
+  }
+
+  // All zeroes unless in the `GroupCommit` mode.
+  FileGroupCommitStats GroupCommitStats() const {
+    return file_persister_impl_->group_committer_ ? file_persister_impl_->group_committer_->Stats()
+                                                  : FileGroupCommitStats();
+  }
 
   class Iterator final {
    public:
@@ -345,8 +437,11 @@ class FilePersister {
                    const std::string& filename,
                    uint64_t i,
                    std::streampos offset,
-                   uint64_t)
-        : file_persister_impl_(std::move(file_persister_impl)), i_(i), current_offset_(offset) {
+                   uint64_t index_at_offset)
+        : file_persister_impl_(std::move(file_persister_impl)),
+          i_(i),
+          current_offset_(offset),
+          next_index_in_file_(index_at_offset) {
       if (!filename.empty()) {
         fi_ = std::make_unique<std::ifstream>(filename);
         CURRENT_ASSERT(!fi_->bad());
@@ -360,16 +455,28 @@ class FilePersister {
     // The range-based for-loop works fine. -- D.K.
     std::string operator*() const {
       if (current_entry_.empty()) {
-        const auto offset = file_persister_impl_->record_offset_[i_];
-        if (offset != current_offset_) {
-          fi_->seekg(offset, std::ios_base::beg);
-          current_offset_ = offset;
-        }
-        if (std::getline(*fi_, current_entry_)) {
-          CURRENT_ASSERT(current_entry_[0] != constants::kDirectiveMarker);
+        if (!file_persister_impl_->sparse_index_) {
+          const auto offset = file_persister_impl_->record_offset_[i_ - file_persister_impl_->first_index_];
+          if (offset != current_offset_) {
+            fi_->seekg(offset, std::ios_base::beg);
+            current_offset_ = offset;
+          }
+          if (std::getline(*fi_, current_entry_)) {
+            CURRENT_ASSERT(current_entry_[0] != constants::kDirectiveMarker);
+          } else {
+            // End of file. Should never happen as long as the user only iterates over valid ranges.
+            CURRENT_THROW(current::Exception());  // LCOV_EXCL_LINE
+          }
         } else {
-          // End of file. Should never happen as long as the user only iterates over valid ranges.
-          CURRENT_THROW(current::Exception());  // LCOV_EXCL_LINE
+          // No per-record offsets in the `Sparse` mode: read forward from the indexed entry, skipping the directives.
+          while (true) {
+            if (!std::getline(*fi_, current_entry_)) {
+              CURRENT_THROW(current::Exception());  // LCOV_EXCL_LINE
+            }
+            if (current_entry_[0] != constants::kDirectiveMarker && next_index_in_file_++ == i_) {
+              break;
+            }
+          }
         }
       }
       return current_entry_;
@@ -391,6 +498,94 @@ class FilePersister {
     uint64_t i_;
     mutable std::string current_entry_;
     mutable std::streampos current_offset_;
+    mutable uint64_t next_index_in_file_;  // Only used in the `Sparse` index mode.
+  };
+
+  // Same as `IteratorUnsafe`, but with no copies and no per-iterator `std::ifstream`: the lines are returned as
+  // `strings::Chunk`-s of the file memory-mapped once per persister. The chunks are not null-terminated, and remain
+  // valid for as long as the persister lives, so that they can be batched, see `impl::FileMapping`.
+  class IteratorMapped final {
+   public:
+    IteratorMapped() = delete;
+    IteratorMapped(const IteratorMapped&) = delete;
+    IteratorMapped(IteratorMapped&&) = default;
+    IteratorMapped& operator=(const IteratorMapped&) = delete;
+    IteratorMapped& operator=(IteratorMapped&&) = default;
+
+    IteratorMapped(Borrowed<FilePersisterImpl> file_persister_impl,
+                   const std::string&,
+                   uint64_t i,
+                   std::streampos offset,
+                   uint64_t index_at_offset)
+        : file_persister_impl_(std::move(file_persister_impl)),
+          i_(i),
+          next_offset_(static_cast<size_t>(offset)),
+          next_index_in_file_(index_at_offset) {}
+
+    // `operator*` relies on the fact each entry will be requested at most once.
+    // The range-based for-loop works fine. -- D.K.
+    current::strings::Chunk operator*() const {
+      if (!current_entry_.first) {
+        while (true) {
+          const char* begin;
+          const char* end;
+          if (!NextLine(begin, end)) {
+            // End of file. Should never happen as long as the user only iterates over valid ranges.
+            CURRENT_THROW(current::Exception());  // LCOV_EXCL_LINE
+          }
+          if (*begin != constants::kDirectiveMarker && next_index_in_file_++ == i_) {
+            current_entry_ = std::make_pair(begin, end);
+            break;
+          }
+        }
+      }
+      return current::strings::Chunk(current_entry_.first, current_entry_.second);
+    }
+
+    IteratorMapped& operator++() {
+      ++i_;
+      current_entry_.first = nullptr;
+      return *this;
+    }
+    bool operator==(const IteratorMapped& rhs) const { return i_ == rhs.i_; }
+    bool operator!=(const IteratorMapped& rhs) const { return !operator==(rhs); }
+    operator bool() const { return file_persister_impl_; }
+
+   private:
+    // Finds the next non-empty line, remapping the file if the line is not fully within the current region.
+    bool NextLine(const char*& begin, const char*& end) const {
+      size_t scanned = next_offset_;  // There is no newline in `[next_offset_, scanned)`.
+      while (true) {
+        if (!region_ || region_->Size() <= scanned) {
+          auto region = file_persister_impl_->mapping_.AtLeast(scanned + 1u);
+          if (region->Size() <= scanned) {
+            return false;
+          }
+          region_ = std::move(region);
+        }
+        const char* data = region_->Data();
+        const size_t size = region_->Size();
+        const char* eol = static_cast<const char*>(::memchr(data + scanned, '\n', size - scanned));
+        if (!eol) {
+          scanned = size;
+        } else {
+          begin = data + next_offset_;
+          end = eol;
+          next_offset_ = static_cast<size_t>(eol - data) + 1u;
+          if (begin != end) {
+            return true;
+          }
+          scanned = next_offset_;
+        }
+      }
+    }
+
+    Borrowed<FilePersisterImpl> file_persister_impl_;
+    uint64_t i_;
+    mutable std::shared_ptr<const FileMapping::Region> region_;
+    mutable size_t next_offset_;
+    mutable uint64_t next_index_in_file_;
+    mutable std::pair<const char*, const char*> current_entry_ = std::make_pair(nullptr, nullptr);
   };
 
   template <typename ITERATOR>
@@ -399,21 +594,28 @@ class FilePersister {
     IterableRangeImpl(Borrowed<FilePersisterImpl> file_persister_impl,
                       uint64_t begin,
                       uint64_t end,
-                      std::streampos begin_offset)
-        : file_persister_impl_(std::move(file_persister_impl)), begin_(begin), end_(end), begin_offset_(begin_offset) {}
+                      std::streampos begin_offset,
+                      uint64_t begin_offset_index)
+        : file_persister_impl_(std::move(file_persister_impl)),
+          begin_(begin),
+          end_(end),
+          begin_offset_(begin_offset),
+          begin_offset_index_(begin_offset_index) {}
 
     IterableRangeImpl(IterableRangeImpl&& rhs)
         : file_persister_impl_(std::move(rhs.file_persister_impl_)),
           begin_(rhs.begin_),
           end_(rhs.end_),
-          begin_offset_(rhs.begin_offset_) {}
+          begin_offset_(rhs.begin_offset_),
+          begin_offset_index_(rhs.begin_offset_index_) {}
 
     ITERATOR begin() const {
       // By convention, iterating over data, being an immutable operation, does not throw.
       if (begin_ == end_) {
         return ITERATOR(file_persister_impl_, "", 0, 0, 0);  // No need in accessing the file for a null iterator.
       } else {
-        return ITERATOR(file_persister_impl_, file_persister_impl_->filename_, begin_, begin_offset_, begin_);
+        return ITERATOR(
+            file_persister_impl_, file_persister_impl_->filename_, begin_, begin_offset_, begin_offset_index_);
       }
     }
     ITERATOR end() const {
@@ -433,14 +635,46 @@ class FilePersister {
     const uint64_t begin_;
     const uint64_t end_;
     const std::streampos begin_offset_;
+    const uint64_t begin_offset_index_;  // The index of the entry at `begin_offset_`, `<= begin_` in `Sparse` mode.
   };
 
   // `TIMESTAMP` can be `std::chrono::microseconds` or `current::time::DefaultTimeArgument`.
   template <current::locks::MutexLockStatus MLS, typename E, typename TIMESTAMP>
   idxts_t PersisterPublishImpl(E&& entry, const TIMESTAMP provided_timestamp) {
-    current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
+    uint64_t group_commit_batch_id;
+    idxts_t idxts;
+    {
+      current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
+      idxts = PersisterPublishFromLockedSection(std::forward<E>(entry), provided_timestamp, group_commit_batch_id);
+    }
+    if (group_commit_batch_id) {
+      // Wait outside the publish mutex, so that other publishers could join the batch.
+      file_persister_impl_->group_committer_->WaitUntilCommitted(group_commit_batch_id);
+    }
+    return idxts;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  idxts_t PersisterPublishUnsafeImpl(const std::string& raw_log_line) {
+    uint64_t group_commit_batch_id;
+    idxts_t idxts;
+    {
+      current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
+      idxts = PersisterPublishUnsafeFromLockedSection(raw_log_line, group_commit_batch_id);
+    }
+    if (group_commit_batch_id) {
+      file_persister_impl_->group_committer_->WaitUntilCommitted(group_commit_batch_id);
+    }
+    return idxts;
+  }
 
-    end_t iterator = file_persister_impl_->end_.load();
+ private:
+  // Sets `group_commit_batch_id` to the batch to wait for in the `GroupCommit` mode, or to zero otherwise.
+  template <typename E, typename TIMESTAMP>
+  idxts_t PersisterPublishFromLockedSection(E&& entry,
+                                            const TIMESTAMP provided_timestamp,
+                                            uint64_t& group_commit_batch_id) {
+    end_t iterator = file_persister_impl_->next_end_;
     const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
     if (!(timestamp > iterator.head)) {
 #ifdef CURRENT_BUILD_WITH_PARANOIC_RUNTIME_CHECKS
@@ -451,33 +685,43 @@ class FilePersister {
 
     iterator.last_entry_us = iterator.head = timestamp;
     const auto idxts = idxts_t(iterator.next_index, iterator.last_entry_us);
-    CURRENT_ASSERT(file_persister_impl_->record_offset_.size() == iterator.next_index);
-    CURRENT_ASSERT(file_persister_impl_->record_timestamp_.size() == iterator.next_index);
-    file_persister_impl_->record_offset_.push_back(file_persister_impl_->file_appender_.tellp());
-    file_persister_impl_->record_timestamp_.push_back(timestamp);
+    ++iterator.next_index;
+    file_persister_impl_->head_offset_ = 0;
+    file_persister_impl_->next_end_ = iterator;
 
     // Explicit `MakeSureTheRightTypeIsSerialized` is essential, otherwise the `Variant`'s case
     // would be serialized in an unwrapped way when passed directly.
-    file_persister_impl_->file_appender_ << JSON(idxts) << '\t'
-                                         << JSON(MakeSureTheRightTypeIsSerialized<ENTRY, decay<E>>::DoIt(
-                                                std::forward<E>(entry))) << std::endl;
-    ++iterator.next_index;
-    file_persister_impl_->head_offset_ = 0;
-    file_persister_impl_->end_.store(iterator);
+    if (!file_persister_impl_->group_committer_) {
+      file_persister_impl_->AddRecord(idxts.index, file_persister_impl_->file_appender_.tellp(), timestamp);
+      file_persister_impl_->file_appender_ << JSON(idxts) << '\t'
+                                           << JSON(MakeSureTheRightTypeIsSerialized<ENTRY, decay<E>>::DoIt(
+                                                  std::forward<E>(entry))) << std::endl;
+      file_persister_impl_->end_.store(iterator);
+      group_commit_batch_id = 0u;
+    } else {
+      file_persister_impl_->AddRecord(idxts.index, file_persister_impl_->append_offset_, timestamp);
+      group_commit_batch_id = file_persister_impl_->group_committer_->Append(
+          [&](std::string& batch) {
+            const size_t length_before = batch.length();
+            batch += JSON(idxts);
+            batch += '\t';
+            batch += JSON(MakeSureTheRightTypeIsSerialized<ENTRY, decay<E>>::DoIt(std::forward<E>(entry)));
+            batch += '\n';
+            file_persister_impl_->append_offset_ += batch.length() - length_before;
+          },
+          iterator);
+    }
 
     return idxts;
   }
 
-  template <current::locks::MutexLockStatus MLS>
-  idxts_t PersisterPublishUnsafeImpl(const std::string& raw_log_line) {
-    current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
-
-    end_t iterator = file_persister_impl_->end_.load();
+  idxts_t PersisterPublishUnsafeFromLockedSection(const std::string& raw_log_line, uint64_t& group_commit_batch_id) {
+    end_t iterator = file_persister_impl_->next_end_;
     const auto tab_pos = raw_log_line.find('\t');
     if (tab_pos == std::string::npos) {
       CURRENT_THROW(MalformedEntryException(raw_log_line));
     }
-    const idxts_t idxts = ParseJSON<idxts_t>(raw_log_line.substr(0, tab_pos));
+    const idxts_t idxts = ParseIndexAndTimestampPrefix(raw_log_line, tab_pos);
     if (idxts.index != iterator.next_index) {
       CURRENT_THROW(UnsafePublishBadIndexTimestampException(iterator.next_index, idxts.index));
     }
@@ -486,24 +730,40 @@ class FilePersister {
     }
 
     iterator.last_entry_us = iterator.head = idxts.us;
-    CURRENT_ASSERT(file_persister_impl_->record_offset_.size() == idxts.index);
-    CURRENT_ASSERT(file_persister_impl_->record_timestamp_.size() == idxts.index);
-    file_persister_impl_->record_offset_.push_back(file_persister_impl_->file_appender_.tellp());
-    file_persister_impl_->record_timestamp_.push_back(idxts.us);
-
-    file_persister_impl_->file_appender_ << raw_log_line << std::endl;
     ++iterator.next_index;
     file_persister_impl_->head_offset_ = 0;
-    file_persister_impl_->end_.store(iterator);
+    file_persister_impl_->next_end_ = iterator;
+
+    if (!file_persister_impl_->group_committer_) {
+      file_persister_impl_->AddRecord(idxts.index, file_persister_impl_->file_appender_.tellp(), idxts.us);
+      file_persister_impl_->file_appender_ << raw_log_line << std::endl;
+      file_persister_impl_->end_.store(iterator);
+      group_commit_batch_id = 0u;
+    } else {
+      file_persister_impl_->AddRecord(idxts.index, file_persister_impl_->append_offset_, idxts.us);
+      group_commit_batch_id = file_persister_impl_->group_committer_->Append(
+          [&raw_log_line](std::string& batch) {
+            batch += raw_log_line;
+            batch += '\n';
+          },
+          iterator);
+      file_persister_impl_->append_offset_ += raw_log_line.length() + 1u;
+    }
 
     return idxts;
   }
 
+ public:
   template <current::locks::MutexLockStatus MLS, typename TIMESTAMP>
   void PersisterUpdateHeadImpl(const TIMESTAMP provided_timestamp) {
     current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
 
-    end_t iterator = file_persister_impl_->end_.load();
+    if (file_persister_impl_->group_committer_) {
+      // The head directive is written directly, so the pending entries must hit the file first.
+      file_persister_impl_->group_committer_->CommitAndWait();
+    }
+
+    end_t iterator = file_persister_impl_->next_end_;
     const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
     if (!(timestamp > iterator.head)) {
       CURRENT_THROW(ss::InconsistentTimestampException(iterator.head + std::chrono::microseconds(1), timestamp));
@@ -519,7 +779,9 @@ class FilePersister {
       file_appender_ << constants::kHeadDirective << ' ';
       file_persister_impl_->head_offset_ = file_appender_.tellp();
       file_appender_ << head_str << std::endl;
+      file_persister_impl_->append_offset_ = file_appender_.tellp();
     }
+    file_persister_impl_->next_end_ = iterator;
     file_persister_impl_->end_.store(iterator);
   }
 
@@ -562,30 +824,78 @@ class FilePersister {
   std::pair<uint64_t, uint64_t> PersisterIndexRangeByTimestampRangeImpl(std::chrono::microseconds from,
                                                                         std::chrono::microseconds till) const {
     std::pair<uint64_t, uint64_t> result{static_cast<uint64_t>(-1), static_cast<uint64_t>(-1)};
+    if (file_persister_impl_->sparse_index_) {
+      // `upper_bound(till)` is the first entry with the timestamp of at least `till + 1us`.
+      result.first = SparseFirstIndexWithTimestampNotBefore<MLS>(from);
+      if (till.count() > 0) {
+        result.second = SparseFirstIndexWithTimestampNotBefore<MLS>(till + std::chrono::microseconds(1));
+      }
+      return result;
+    }
     current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
+    // Only look at the committed entries, as `record_timestamp_` also holds the pending ones in `GroupCommit` mode.
+    const auto timestamps_begin = file_persister_impl_->record_timestamp_.begin();
+    const auto timestamps_end =
+        timestamps_begin + (file_persister_impl_->end_.load().next_index - file_persister_impl_->first_index_);
     const auto begin_it =
-        std::lower_bound(file_persister_impl_->record_timestamp_.begin(),
-                         file_persister_impl_->record_timestamp_.end(),
+        std::lower_bound(timestamps_begin,
+                         timestamps_end,
                          from,
                          [](std::chrono::microseconds entry_t, std::chrono::microseconds t) { return entry_t < t; });
-    if (begin_it != file_persister_impl_->record_timestamp_.end()) {
-      result.first = std::distance(file_persister_impl_->record_timestamp_.begin(), begin_it);
+    if (begin_it != timestamps_end) {
+      result.first = file_persister_impl_->first_index_ + std::distance(timestamps_begin, begin_it);
     }
     if (till.count() > 0) {
       const auto end_it =
-          std::upper_bound(file_persister_impl_->record_timestamp_.begin(),
-                           file_persister_impl_->record_timestamp_.end(),
+          std::upper_bound(timestamps_begin,
+                           timestamps_end,
                            till,
                            [](std::chrono::microseconds t, std::chrono::microseconds entry_t) { return t < entry_t; });
-      if (end_it != file_persister_impl_->record_timestamp_.end()) {
-        result.second = std::distance(file_persister_impl_->record_timestamp_.begin(), end_it);
+      if (end_it != timestamps_end) {
+        result.second = file_persister_impl_->first_index_ + std::distance(timestamps_begin, end_it);
+      }
+    }
+    return result;
+  }
+
+  // The `Sparse` index mode counterpart of the `std::lower_bound()` above: seek to the last indexed entry
+  // older than `t`, and scan forward, outside the publish mutex, at most through the next `every_n` entries.
+  template <current::locks::MutexLockStatus MLS>
+  uint64_t SparseFirstIndexWithTimestampNotBefore(std::chrono::microseconds t) const {
+    uint64_t committed_size;
+    std::pair<uint64_t, std::streampos> checkpoint;
+    {
+      current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
+      committed_size = file_persister_impl_->end_.load().next_index;
+      if (committed_size == file_persister_impl_->first_index_) {
+        return static_cast<uint64_t>(-1);
       }
+      checkpoint = file_persister_impl_->sparse_index_->SeekBefore(t);
+      checkpoint.first += file_persister_impl_->first_index_;
+    }
+    if (checkpoint.first >= committed_size) {
+      // The last indexed entry older than `t` is not even committed yet.
+      return static_cast<uint64_t>(-1);
+    }
+    std::ifstream fi(file_persister_impl_->filename_);
+    IteratorOverFileOfPersistedEntries<ENTRY> cit(fi, checkpoint.second, checkpoint.first);
+    uint64_t result = static_cast<uint64_t>(-1);
+    while (result == static_cast<uint64_t>(-1) && cit.Next().index < committed_size &&
+           cit.ProcessNextEntry(
+               [&result, t](const idxts_t& current, const char*) {
+                 if (current.us >= t) {
+                   result = current.index;
+                 }
+               },
+               [](const std::string&) {})) {
+      ;
     }
     return result;
   }
 
   using IterableRange = IterableRangeImpl<Iterator>;
   using IterableRangeUnsafe = IterableRangeImpl<IteratorUnsafe>;
+  using IterableRangeMapped = IterableRangeImpl<IteratorMapped>;
 
   template <current::locks::MutexLockStatus MLS>
   IterableRange PersisterIterate(uint64_t begin_index, uint64_t end_index) const {
@@ -607,6 +917,16 @@ class FilePersister {
     return PersisterIterateImpl<MLS, IterableRangeUnsafe>(from, till);
   }
 
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeMapped PersisterIterateMapped(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRangeMapped>(begin_index, end_index);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeMapped PersisterIterateMapped(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    return PersisterIterateImpl<MLS, IterableRangeMapped>(from, till);
+  }
+
  private:
   template <current::locks::MutexLockStatus MLS, typename ITERABLE>
   ITERABLE PersisterIterateImpl(uint64_t begin_index, uint64_t end_index) const {
@@ -619,18 +939,29 @@ class FilePersister {
       CURRENT_THROW(InvalidIterableRangeException());
     }
     if (begin_index == end_index) {
-      return ITERABLE(file_persister_impl_, 0, 0, 0);  // OK, even for an empty persister, where 0 is an invalid index.
+      // OK, even for an empty persister, where 0 is an invalid index.
+      return ITERABLE(file_persister_impl_, 0, 0, 0, 0);
     }
-    if (end_index < begin_index) {
+    if (end_index < begin_index || begin_index < file_persister_impl_->first_index_) {
       CURRENT_THROW(InvalidIterableRangeException());
     }
 
     current::locks::SmartMutexLockGuard<MLS> lock(file_persister_impl_->publish_mutex_ref_);
 
+    if (file_persister_impl_->sparse_index_) {
+      const uint64_t first_index = file_persister_impl_->first_index_;
+      const auto checkpoint = file_persister_impl_->sparse_index_->Seek(begin_index - first_index);
+      return ITERABLE(file_persister_impl_, begin_index, end_index, checkpoint.second, first_index + checkpoint.first);
+    }
+
     // ">" is OK, as this call is multithreading-friendly, and more entries could have been added during this call.
-    CURRENT_ASSERT(file_persister_impl_->record_offset_.size() >= current_size);
+    CURRENT_ASSERT(file_persister_impl_->first_index_ + file_persister_impl_->record_offset_.size() >= current_size);
 
-    return ITERABLE(file_persister_impl_, begin_index, end_index, file_persister_impl_->record_offset_[begin_index]);
+    return ITERABLE(file_persister_impl_,
+                    begin_index,
+                    end_index,
+                    file_persister_impl_->record_offset_[begin_index - file_persister_impl_->first_index_],
+                    begin_index);
   }
 
   template <current::locks::MutexLockStatus MLS, typename ITERABLE>
@@ -643,7 +974,7 @@ class FilePersister {
     if (index_range.first != static_cast<uint64_t>(-1)) {
       return PersisterIterateImpl<MLS, ITERABLE>(index_range.first, index_range.second);
     } else {  // No entries found in the requested range.
-      return ITERABLE(file_persister_impl_, 0, 0, 0);
+      return ITERABLE(file_persister_impl_, 0, 0, 0, 0);
     }
   }
 
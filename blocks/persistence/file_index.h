@@ -0,0 +1,197 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The index of the records of `current::persistence::File`, used to start iterating from an arbitrary entry.
+//
+// In the default, `Full`, mode the offset and the timestamp of each entry are kept in memory, 16 bytes per entry.
+// In the `Sparse` mode only every `every_n`-th entry is indexed, in the `<filename>.idx` sidecar file, which is
+// memory-mapped rather than loaded. Iterating from an arbitrary entry then seeks to the nearest preceding indexed
+// entry and scans forward, reading at most `every_n - 1` extra lines. The sidecar is rebuilt on startup, as the
+// whole file is scanned anyway to validate it.
+
+#ifndef BLOCKS_PERSISTENCE_FILE_INDEX_H
+#define BLOCKS_PERSISTENCE_FILE_INDEX_H
+
+#include "../../port.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifndef CURRENT_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // CURRENT_WINDOWS
+
+#include "exceptions.h"
+
+namespace current {
+namespace persistence {
+
+// The index mode of `current::persistence::File`, passed as an optional constructor argument.
+struct FileIndex {
+  uint64_t every_n = 0u;      // Zero for the `Full` in-memory index.
+  uint64_t first_index = 0u;  // The index of the first entry of the file, non-zero for the segments of `SegmentedFile`.
+
+  static FileIndex Full() { return FileIndex(); }
+
+  static FileIndex Sparse(uint64_t every_n = 1024u) {
+    CURRENT_ASSERT(every_n > 0u);
+    FileIndex result;
+    result.every_n = every_n;
+    return result;
+  }
+
+  FileIndex StartingFrom(uint64_t index) const {
+    FileIndex result = *this;
+    result.first_index = index;
+    return result;
+  }
+};
+
+namespace impl {
+
+// The sidecar file of the `Sparse` index: the array of `{ offset, us }` of the entries `0`, `every_n`, `2 * every_n`,
+// etc. The file is grown by doubling, and mapped as a whole; it is truncated to the actual size when closed.
+// Not thread-safe: guarded by the publish mutex of the persister.
+//
+// The sidecar is never read back: it is truncated on open, and rebuilt as the file is scanned. Thus its size on disk
+// is never trusted, and the number of checkpoints, `size_`, is only ever the number of them added since.
+class FileSparseIndex final {
+ public:
+  struct Checkpoint {
+    int64_t offset;
+    int64_t us;
+  };
+  static_assert(sizeof(Checkpoint) == 16, "");
+
+  constexpr static size_t kInitialCapacity = 4096u;  // Checkpoints, i.e. 64KB.
+
+  FileSparseIndex(const std::string& filename, uint64_t every_n) : filename_(filename), every_n_(every_n) {
+    CURRENT_ASSERT(every_n_ > 0u);
+#ifndef CURRENT_WINDOWS
+    fd_ = ::open(filename_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+      CURRENT_THROW(PersistenceFileNotWritable(filename_));
+    }
+    Reserve(kInitialCapacity);
+#endif  // CURRENT_WINDOWS
+  }
+
+  ~FileSparseIndex() {
+#ifndef CURRENT_WINDOWS
+    if (data_) {
+      ::munmap(data_, capacity_ * sizeof(Checkpoint));
+    }
+    if (fd_ >= 0) {
+      if (::ftruncate(fd_, static_cast<off_t>(size_ * sizeof(Checkpoint)))) {
+        // Not to leave the sidecar padded with the zero checkpoints behind. It is rebuilt on the next open anyway.
+        ::unlink(filename_.c_str());
+      }
+      ::close(fd_);
+    }
+#endif  // CURRENT_WINDOWS
+  }
+
+  FileSparseIndex(const FileSparseIndex&) = delete;
+  FileSparseIndex& operator=(const FileSparseIndex&) = delete;
+
+  uint64_t EveryN() const { return every_n_; }
+
+  // Must be called for each entry, in order. Only every `every_n`-th one is recorded.
+  void Add(uint64_t index, std::streampos offset, std::chrono::microseconds us) {
+    if (!(index % every_n_)) {
+      CURRENT_ASSERT(index / every_n_ == size_);
+#ifndef CURRENT_WINDOWS
+      if (size_ == capacity_) {
+        Reserve(capacity_ * 2u);
+      }
+      data_[size_] = Checkpoint{static_cast<int64_t>(offset), us.count()};
+#else
+      checkpoints_.push_back(Checkpoint{static_cast<int64_t>(offset), us.count()});
+#endif  // CURRENT_WINDOWS
+      ++size_;
+    }
+  }
+
+  // The indexed entry at or before `index`, as `{ its index, its offset }`. The entry `index` must exist.
+  std::pair<uint64_t, std::streampos> Seek(uint64_t index) const {
+    const uint64_t k = index / every_n_;
+    CURRENT_ASSERT(k < size_);
+    return std::make_pair(k * every_n_, std::streampos(Data()[k].offset));
+  }
+
+  // The last indexed entry with the timestamp strictly less than `us`, or the first indexed entry if there is none.
+  std::pair<uint64_t, std::streampos> SeekBefore(std::chrono::microseconds us) const {
+    CURRENT_ASSERT(size_ > 0u);
+    const Checkpoint* begin = Data();
+    const Checkpoint* it = std::lower_bound(
+        begin, begin + size_, us.count(), [](const Checkpoint& c, int64_t t) { return c.us < t; });
+    const uint64_t k = (it == begin) ? 0u : static_cast<uint64_t>(it - begin) - 1u;
+    return std::make_pair(k * every_n_, std::streampos(begin[k].offset));
+  }
+
+ private:
+#ifndef CURRENT_WINDOWS
+  // The present mapping is only released once the grown file is mapped, so that if growing it fails,
+  // the checkpoints added so far remain valid, and `Add()` can retry.
+  void Reserve(size_t capacity) {
+    if (::ftruncate(fd_, static_cast<off_t>(capacity * sizeof(Checkpoint)))) {
+      CURRENT_THROW(PersistenceFileNotWritable(filename_));
+    }
+    void* data = ::mmap(nullptr, capacity * sizeof(Checkpoint), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      CURRENT_THROW(PersistenceFileNotWritable(filename_));
+    }
+    if (data_) {
+      ::munmap(data_, capacity_ * sizeof(Checkpoint));
+    }
+    data_ = static_cast<Checkpoint*>(data);
+    capacity_ = capacity;
+  }
+
+  const Checkpoint* Data() const { return data_; }
+#else
+  const Checkpoint* Data() const { return checkpoints_.data(); }
+#endif  // CURRENT_WINDOWS
+
+  const std::string filename_;
+  const uint64_t every_n_;
+  uint64_t size_ = 0u;
+#ifndef CURRENT_WINDOWS
+  int fd_ = -1;
+  Checkpoint* data_ = nullptr;
+  size_t capacity_ = 0u;
+#else
+  std::vector<Checkpoint> checkpoints_;  // No memory mapping on Windows, but still only every `every_n`-th entry.
+#endif  // CURRENT_WINDOWS
+};
+
+}  // namespace impl
+}  // namespace persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_FILE_INDEX_H
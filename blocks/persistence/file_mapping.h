@@ -0,0 +1,166 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The read-only memory mapping of the file of `current::persistence::File`, shared by all its mapped iterators.
+//
+// The file only grows, so the mapping is remapped, with spare capacity, once an iterator needs the bytes past
+// its end. The previous, smaller, regions are kept mapped until the mapping itself is destroyed, so that
+// the `strings::Chunk`-s handed out by the iterators remain valid for as long as the persister lives, even once
+// the iterator has moved on to a larger region. As the capacity doubles, all the regions take up less than twice
+// the address space of the last one.
+// On Windows the "mapping" is a copy of the file in memory, re-read when it has grown.
+
+#ifndef BLOCKS_PERSISTENCE_FILE_MAPPING_H
+#define BLOCKS_PERSISTENCE_FILE_MAPPING_H
+
+#include "../../port.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef CURRENT_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <sstream>
+#endif  // CURRENT_WINDOWS
+
+#include "exceptions.h"
+
+namespace current {
+namespace persistence {
+namespace impl {
+
+class FileMapping final {
+ public:
+  constexpr static size_t kMinCapacity = 1u << 20;
+
+  // The first `Size()` bytes of the file. The size of the region grows as the file does, up to its capacity.
+  class Region final {
+   public:
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_.load(); }
+
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+
+#ifndef CURRENT_WINDOWS
+    Region(const char* data, size_t size, size_t capacity) : data_(data), size_(size), capacity_(capacity) {}
+    ~Region() { ::munmap(const_cast<char*>(data_), capacity_); }
+#else
+    explicit Region(std::string&& contents)
+        : contents_(std::move(contents)), data_(contents_.data()), size_(contents_.size()), capacity_(size_) {}
+#endif  // CURRENT_WINDOWS
+
+   private:
+    friend class FileMapping;
+#ifdef CURRENT_WINDOWS
+    const std::string contents_;
+#endif  // CURRENT_WINDOWS
+    const char* const data_;
+    std::atomic_size_t size_;
+    const size_t capacity_;
+  };
+
+  explicit FileMapping(const std::string& filename) : filename_(filename) {}
+
+#ifndef CURRENT_WINDOWS
+  ~FileMapping() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+#endif  // CURRENT_WINDOWS
+
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+
+  // The region covering at least the first `bytes` bytes of the file, if the file is at least this long.
+  std::shared_ptr<const Region> AtLeast(size_t bytes) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (region_ && region_->Size() >= bytes) {
+      return region_;
+    }
+#ifndef CURRENT_WINDOWS
+    if (fd_ < 0) {
+      fd_ = ::open(filename_.c_str(), O_RDONLY);
+      if (fd_ < 0) {
+        CURRENT_THROW(PersistenceFileNotMappable(filename_));
+      }
+    }
+    struct stat st;
+    if (::fstat(fd_, &st)) {
+      CURRENT_THROW(PersistenceFileNotMappable(filename_));
+    }
+    const size_t file_size = static_cast<size_t>(st.st_size);
+    if (region_ && file_size <= region_->capacity_) {
+      // Mapped past the end of the file, which has grown since. No need to remap.
+      region_->size_.store(std::max(region_->Size(), file_size));
+      return region_;
+    }
+    size_t capacity = region_ ? region_->capacity_ * 2u : kMinCapacity;
+    while (capacity < file_size) {
+      capacity *= 2u;
+    }
+    void* data = ::mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) {
+      CURRENT_THROW(PersistenceFileNotMappable(filename_));
+    }
+    if (region_) {
+      superseded_regions_.push_back(std::move(region_));
+    }
+    region_ = std::make_shared<Region>(static_cast<const char*>(data), file_size, capacity);
+#else
+    std::ifstream fi(filename_, std::ios::binary);
+    std::ostringstream os;
+    os << fi.rdbuf();
+    if (region_) {
+      superseded_regions_.push_back(std::move(region_));
+    }
+    region_ = std::make_shared<Region>(os.str());
+#endif  // CURRENT_WINDOWS
+    return region_;
+  }
+
+ private:
+  const std::string filename_;
+  mutable std::mutex mutex_;
+  mutable std::shared_ptr<Region> region_;
+  mutable std::vector<std::shared_ptr<Region>> superseded_regions_;  // Still referred to by the chunks handed out.
+#ifndef CURRENT_WINDOWS
+  mutable int fd_ = -1;
+#endif  // CURRENT_WINDOWS
+};
+
+}  // namespace impl
+}  // namespace persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_FILE_MAPPING_H
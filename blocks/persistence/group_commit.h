@@ -0,0 +1,299 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// Group commit for the file persister.
+//
+// In the default, `Strict`, mode, each `Publish()` writes and flushes its own entry while holding the publish mutex.
+// In the `GroupCommit` mode, `Publish()` only appends the serialized entry to the in-memory batch, and a dedicated
+// committer thread writes the whole batch with a single `write()` (followed by an optional `fdatasync()`).
+// A batch is committed once `window` has elapsed since its first entry, or once it has grown to `max_batch_bytes`.
+// Each publisher blocks only until the batch holding its own entry is committed.
+// If writing or syncing a batch fails, neither it nor any later batch is committed, and the publishers waiting
+// for them get `PersistenceFileCommitFailed` thrown. As the persister is closed, the file is cut back to the last
+// committed batch.
+//
+// Only the publishers that wait with the publish mutex released are batched together. The ones publishing from
+// a locked section, `MutexLockStatus::AlreadyLocked`, wait with the mutex held, and thus commit a batch each,
+// the full `window` later. This is the case for the storage, which publishes its transactions so, and should use
+// the `window` of zero, for a transaction to only wait for its own write.
+
+#ifndef BLOCKS_PERSISTENCE_GROUP_COMMIT_H
+#define BLOCKS_PERSISTENCE_GROUP_COMMIT_H
+
+#include "../../port.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#ifndef CURRENT_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // CURRENT_WINDOWS
+
+#include "exceptions.h"
+
+#include "../../typesystem/struct.h"
+
+namespace current {
+namespace persistence {
+
+// The durability policy of `current::persistence::File`, passed as an optional last constructor argument.
+struct FileDurability {
+  bool group_commit = false;
+  std::chrono::microseconds window = std::chrono::microseconds(0);
+  size_t max_batch_bytes = 1024 * 1024;
+  bool fdatasync = false;
+
+  // Flush after every entry, from within the very `Publish()` call. The default.
+  static FileDurability Strict() { return FileDurability(); }
+
+  // With the `window` of zero the batch is whatever has been published while the previous batch was being written.
+  static FileDurability GroupCommit(std::chrono::microseconds window = std::chrono::microseconds(0),
+                                    size_t max_batch_bytes = 1024 * 1024,
+                                    bool fdatasync = false) {
+    FileDurability result;
+    result.group_commit = true;
+    result.window = window;
+    result.max_batch_bytes = max_batch_bytes;
+    result.fdatasync = fdatasync;
+    return result;
+  }
+};
+
+CURRENT_STRUCT(FileGroupCommitStats) {
+  CURRENT_FIELD(batches, uint64_t, 0u);
+  CURRENT_FIELD(entries, uint64_t, 0u);
+  CURRENT_FIELD(bytes, uint64_t, 0u);
+  CURRENT_FIELD(max_batch_entries, uint64_t, 0u);
+  CURRENT_FIELD(max_batch_bytes, uint64_t, 0u);
+  // From the first entry of the batch being appended till the batch being written (and synced).
+  CURRENT_FIELD(total_commit_latency, std::chrono::microseconds, std::chrono::microseconds(0));
+  CURRENT_FIELD(max_commit_latency, std::chrono::microseconds, std::chrono::microseconds(0));
+};
+
+namespace impl {
+
+// `STATE` is what becomes visible to the readers of the persister once the batch is committed,
+// i.e. the `end_t` of the last entry in the batch for `FilePersister`.
+template <typename STATE>
+class GroupCommitter final {
+ public:
+  using on_commit_t = std::function<void(const STATE&)>;
+
+  GroupCommitter(std::ostream& os, const std::string& filename, const FileDurability& policy, on_commit_t on_commit)
+      : os_(os), filename_(filename), policy_(policy), on_commit_(on_commit) {
+#ifndef CURRENT_WINDOWS
+    if (policy_.fdatasync) {
+      // `fdatasync()` is per file, not per descriptor, so a dedicated descriptor does the job.
+      sync_fd_ = ::open(filename.c_str(), O_WRONLY);
+      if (sync_fd_ < 0) {
+        CURRENT_THROW(PersistenceFileNotWritable(filename));
+      }
+    }
+#endif  // CURRENT_WINDOWS
+    thread_ = std::thread([this]() { Thread(); });
+  }
+
+  ~GroupCommitter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      destructing_ = true;
+    }
+    append_cv_.notify_all();
+    thread_.join();
+#ifndef CURRENT_WINDOWS
+    if (sync_fd_ >= 0) {
+      ::close(sync_fd_);
+    }
+#endif  // CURRENT_WINDOWS
+  }
+
+  // Appends `data` to the currently open batch. Returns the ID of this batch, to wait for via `WaitUntilCommitted()`.
+  // Must be called from within the publish mutex, so that batches preserve the order of the entries.
+  template <typename F>
+  uint64_t Append(F&& append_to_buffer, const STATE& state_after) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+      batch_opened_at_ = std::chrono::steady_clock::now();
+    }
+    append_to_buffer(pending_);
+    pending_state_ = state_after;
+    ++pending_entries_;
+    if (pending_entries_ == 1u || pending_.length() >= policy_.max_batch_bytes) {
+      append_cv_.notify_one();
+    }
+    return open_batch_id_;
+  }
+
+  // Throws `PersistenceFileCommitFailed` if the batch could not be written.
+  void WaitUntilCommitted(uint64_t batch_id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    commit_cv_.wait(lock, [this, batch_id]() { return committed_batch_id_ >= batch_id; });
+    ThrowIfFailedFromLockedSection(batch_id);
+  }
+
+  // Commits everything appended so far, without waiting for the window to elapse.
+  void CommitAndWait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const uint64_t batch_id = pending_.empty() ? open_batch_id_ - 1u : open_batch_id_;
+    if (!pending_.empty()) {
+      commit_requested_ = true;
+      append_cv_.notify_one();
+    }
+    commit_cv_.wait(lock, [this, batch_id]() { return committed_batch_id_ >= batch_id; });
+    ThrowIfFailedFromLockedSection(batch_id);
+  }
+
+  FileGroupCommitStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+  // Whether a batch could not be written, and thus nothing is written from then on.
+  bool Failed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_batch_id_ != 0u;
+  }
+
+ private:
+  void ThrowIfFailedFromLockedSection(uint64_t batch_id) const {
+    if (failed_batch_id_ && batch_id >= failed_batch_id_) {
+      CURRENT_THROW(PersistenceFileCommitFailed(filename_));
+    }
+  }
+
+  // Writes and, if requested, syncs the batch. Returns `false` on any failure.
+  bool WriteBatch(const std::string& batch) {
+    os_.write(batch.data(), batch.length());
+    os_.flush();
+    if (!os_.good()) {
+      return false;
+    }
+#ifndef CURRENT_WINDOWS
+    if (sync_fd_ >= 0) {
+#ifdef CURRENT_APPLE
+      return !::fsync(sync_fd_);
+#else
+      return !::fdatasync(sync_fd_);
+#endif  // CURRENT_APPLE
+    }
+#endif  // CURRENT_WINDOWS
+    return true;
+  }
+
+  void Thread() {
+    std::string batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      append_cv_.wait(lock, [this]() { return destructing_ || !pending_.empty(); });
+      if (pending_.empty()) {
+        return;  // `destructing_`, and nothing left to commit.
+      }
+      append_cv_.wait_until(lock, batch_opened_at_ + policy_.window, [this]() {
+        return destructing_ || commit_requested_ || pending_.length() >= policy_.max_batch_bytes;
+      });
+      commit_requested_ = false;
+
+      batch.clear();
+      std::swap(batch, pending_);
+      const STATE state = pending_state_;
+      const uint64_t batch_id = open_batch_id_++;
+      const uint64_t batch_entries = pending_entries_;
+      const auto batch_opened_at = batch_opened_at_;
+      pending_entries_ = 0u;
+
+      if (failed_batch_id_) {
+        // The file is in an unknown state after a failed write, so nothing past it is written.
+        committed_batch_id_ = batch_id;
+        commit_cv_.notify_all();
+        continue;
+      }
+
+      lock.unlock();
+      const bool written = WriteBatch(batch);
+      if (written) {
+        on_commit_(state);
+      }
+      const auto latency =
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - batch_opened_at);
+      lock.lock();
+
+      if (!written) {
+        failed_batch_id_ = batch_id;
+        committed_batch_id_ = batch_id;
+        commit_cv_.notify_all();
+        continue;
+      }
+
+      ++stats_.batches;
+      stats_.entries += batch_entries;
+      stats_.bytes += batch.length();
+      stats_.max_batch_entries = std::max(stats_.max_batch_entries, batch_entries);
+      stats_.max_batch_bytes = std::max(stats_.max_batch_bytes, static_cast<uint64_t>(batch.length()));
+      stats_.total_commit_latency += latency;
+      stats_.max_commit_latency = std::max(stats_.max_commit_latency, latency);
+
+      committed_batch_id_ = batch_id;
+      commit_cv_.notify_all();
+    }
+  }
+
+  std::ostream& os_;
+  const std::string filename_;
+  const FileDurability policy_;
+  const on_commit_t on_commit_;
+#ifndef CURRENT_WINDOWS
+  int sync_fd_ = -1;
+#endif  // CURRENT_WINDOWS
+
+  mutable std::mutex mutex_;
+  std::condition_variable append_cv_;
+  std::condition_variable commit_cv_;
+  bool destructing_ = false;
+  bool commit_requested_ = false;
+
+  std::string pending_;
+  STATE pending_state_;
+  uint64_t pending_entries_ = 0u;
+  std::chrono::steady_clock::time_point batch_opened_at_;
+  uint64_t open_batch_id_ = 1u;
+  uint64_t committed_batch_id_ = 0u;  // The last batch processed, committed or failed.
+  uint64_t failed_batch_id_ = 0u;     // The first batch that could not be written, if any.
+
+  FileGroupCommitStats stats_;
+
+  std::thread thread_;
+};
+
+}  // namespace impl
+}  // namespace persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_GROUP_COMMIT_H
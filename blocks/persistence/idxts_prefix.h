@@ -0,0 +1,97 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// Parsing the `{"index":...,"us":...}` prefix of the raw log line without parsing JSON.
+//
+// Each entry of a persisted stream is stored, and sent over the wire, as `JSON(idxts)`, a tab, and `JSON(entry)`.
+// The code that only needs the index and the timestamp of the entry, such as `PublishUnsafe()` of the file persister
+// or the raw replication, does not need a JSON parser to extract them from the line as `JSON(idxts_t)` writes it.
+
+#ifndef BLOCKS_PERSISTENCE_IDXTS_PREFIX_H
+#define BLOCKS_PERSISTENCE_IDXTS_PREFIX_H
+
+#include "../../port.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include "../ss/idx_ts.h"
+
+#include "../../typesystem/serialization/json.h"
+
+namespace current {
+namespace persistence {
+
+// Scans `[begin, end)` as `JSON(idxts_t)` writes it, i.e., `{"index":<digits>,"us":<digits>}`, with no whitespace.
+// Returns `false` if the range is formatted in any other way.
+inline bool ScanIndexAndTimestampPrefix(const char* begin, const char* end, idxts_t& result) {
+  const auto skip = [&begin, end](const char* expected, size_t length) {
+    if (static_cast<size_t>(end - begin) >= length && !std::memcmp(begin, expected, length)) {
+      begin += length;
+      return true;
+    } else {
+      return false;
+    }
+  };
+  const auto scan = [&begin, end](uint64_t& value) {
+    // Up to 18 digits, so that the value fits into `int64_t` as well.
+    const char* digits_end = begin + std::min(static_cast<ptrdiff_t>(18), end - begin);
+    const char* p = begin;
+    value = 0u;
+    while (p != digits_end && *p >= '0' && *p <= '9') {
+      value = value * 10u + static_cast<uint64_t>(*p - '0');
+      ++p;
+    }
+    if (p == begin || (p != end && *p >= '0' && *p <= '9')) {
+      return false;
+    }
+    begin = p;
+    return true;
+  };
+  uint64_t index;
+  uint64_t us;
+  if (skip("{\"index\":", 9u) && scan(index) && skip(",\"us\":", 6u) && scan(us) && skip("}", 1u) && begin == end) {
+    result = idxts_t(index, std::chrono::microseconds(static_cast<int64_t>(us)));
+    return true;
+  } else {
+    return false;
+  }
+}
+
+// Returns the `idxts_t` the raw log line starts with, given the position of its tab.
+// Falls back to `ParseJSON<idxts_t>` if the prefix is formatted differently, and throws the same way it does.
+inline idxts_t ParseIndexAndTimestampPrefix(const std::string& raw_log_line, size_t tab_pos) {
+  idxts_t result;
+  if (!ScanIndexAndTimestampPrefix(raw_log_line.data(), raw_log_line.data() + tab_pos, result)) {
+    result = ParseJSON<idxts_t>(raw_log_line.substr(0, tab_pos));
+  }
+  return result;
+}
+
+}  // namespace persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_IDXTS_PREFIX_H
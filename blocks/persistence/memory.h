@@ -42,6 +42,7 @@ SOFTWARE.
 #include <mutex>
 
 #include "exceptions.h"
+#include "idxts_prefix.h"
 
 #include "../ss/persister.h"
 #include "../ss/signature.h"
@@ -174,7 +175,7 @@ class MemoryPersister {
     if (tab_pos == std::string::npos) {
       CURRENT_THROW(MalformedEntryException(raw_log_line));
     }
-    const auto idxts = ParseJSON<idxts_t>(raw_log_line.substr(0, tab_pos));
+    const auto idxts = ParseIndexAndTimestampPrefix(raw_log_line, tab_pos);
     const auto expected_index = static_cast<uint64_t>(container_->entries_.size());
     if (idxts.index != expected_index) {
       CURRENT_THROW(UnsafePublishBadIndexTimestampException(expected_index, idxts.index));
@@ -0,0 +1,655 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// A persister keeping the stream in a sequence of `File`-format segments rather than in one ever-growing file.
+//
+// The active, last, segment is rolled over to a new one once it reaches a size or a time span threshold.
+// The segments are named `<filename>.<%020 index of its first entry>`, and `<filename>.manifest` lists their
+// index and timestamp ranges. The indexes stay global: each segment file contains the very lines the single
+// `File` would, so that raw lines can be replicated as is.
+//
+// The retention policy drops whole sealed segments, never rewriting anything. `Size()` and the indexes are not
+// affected, but the dropped entries can no longer be iterated over; `FirstAvailableIndex()` returns the lowest
+// index still available. Streams start their subscribers at this index if it is greater than the requested one.
+// The files of the dropped segment are only removed once the iterations already reading from it are done.
+//
+// Only the active segment is validated at startup. The sealed ones are opened, and validated, when first read from.
+// The segments are written in the `Strict` durability mode.
+
+#ifndef BLOCKS_PERSISTENCE_SEGMENTED_H
+#define BLOCKS_PERSISTENCE_SEGMENTED_H
+
+#include "../../port.h"
+
+#include <deque>
+#include <fstream>
+#include <memory>
+
+#include "exceptions.h"
+#include "file.h"
+#include "idxts_prefix.h"
+
+#include "../ss/persister.h"
+
+#include "../../bricks/file/file.h"
+#include "../../bricks/strings/printf.h"
+#include "../../bricks/sync/locks.h"
+#include "../../bricks/util/atomic_that_works.h"
+#include "../../typesystem/struct.h"
+#include "../../typesystem/serialization/json.h"
+
+namespace current {
+namespace persistence {
+
+// When to roll the active segment over to a new one, passed as an optional constructor argument.
+struct FileSegmentation {
+  constexpr static uint64_t kDefaultMaxSegmentBytes = 64ull << 20;
+
+  uint64_t max_segment_bytes = kDefaultMaxSegmentBytes;
+  std::chrono::microseconds max_segment_duration = std::chrono::microseconds(0);  // Zero for no time limit.
+
+  static FileSegmentation BySize(uint64_t max_segment_bytes) {
+    FileSegmentation result;
+    result.max_segment_bytes = max_segment_bytes;
+    return result;
+  }
+
+  // The segment is rolled over once the timestamp of the new entry is this far from its first one.
+  static FileSegmentation ByDuration(std::chrono::microseconds max_segment_duration,
+                                     uint64_t max_segment_bytes = kDefaultMaxSegmentBytes) {
+    FileSegmentation result;
+    result.max_segment_bytes = max_segment_bytes;
+    result.max_segment_duration = max_segment_duration;
+    return result;
+  }
+};
+
+// Which sealed segments to keep, passed as an optional constructor argument. Zeroes stand for no limit.
+// Applied each time a segment is rolled over. The active segment is never dropped.
+struct FileRetention {
+  uint64_t max_sealed_segments = 0u;
+  uint64_t max_total_bytes = 0u;                                   // Including the active segment.
+  std::chrono::microseconds max_age = std::chrono::microseconds(0);  // Relative to the most recent entry.
+
+  static FileRetention Forever() { return FileRetention(); }
+
+  static FileRetention BySegments(uint64_t max_sealed_segments) {
+    FileRetention result;
+    result.max_sealed_segments = max_sealed_segments;
+    return result;
+  }
+
+  static FileRetention ByBytes(uint64_t max_total_bytes) {
+    FileRetention result;
+    result.max_total_bytes = max_total_bytes;
+    return result;
+  }
+
+  static FileRetention ByAge(std::chrono::microseconds max_age) {
+    FileRetention result;
+    result.max_age = max_age;
+    return result;
+  }
+};
+
+CURRENT_STRUCT(FileSegmentInfo) {
+  CURRENT_FIELD(begin, uint64_t);  // The index of the first entry of the segment, also the suffix of its file name.
+  CURRENT_FIELD(end, uint64_t);    // One past the index of its last entry. Only up to date for the sealed segments.
+  CURRENT_FIELD(first_us, std::chrono::microseconds);
+  CURRENT_FIELD(last_us, std::chrono::microseconds);
+  CURRENT_FIELD(bytes, uint64_t);
+  CURRENT_DEFAULT_CONSTRUCTOR(FileSegmentInfo) : begin(0u), end(0u), first_us(-1), last_us(-1), bytes(0u) {}
+  CURRENT_CONSTRUCTOR(FileSegmentInfo)(uint64_t index) : begin(index), end(index), first_us(-1), last_us(-1), bytes(0u) {}
+};
+
+CURRENT_STRUCT(FileSegmentsManifest) {
+  CURRENT_FIELD(segments, std::vector<FileSegmentInfo>);  // Oldest first, the last one being the active one.
+};
+
+namespace impl {
+
+template <typename ENTRY>
+class SegmentedFilePersister {
+ private:
+  using segment_persister_t = FilePersister<ENTRY>;
+
+  struct Segment {
+    FileSegmentInfo info;
+    std::shared_ptr<segment_persister_t> persister;  // Null for the sealed segments not read from yet.
+  };
+
+  // Removes the files of the segment once its persister is released, if the segment has been dropped meanwhile,
+  // as the `Piece`-s of the iterations over it share the persister, and only open the file when first read from.
+  struct SegmentDeleter {
+    std::string segment_file_name;
+    bool dropped;  // Set under the lock, read by whichever owner releases the persister last.
+
+    void operator()(segment_persister_t* persister) const {
+      delete persister;
+      if (dropped) {
+        RemoveSegmentFiles(segment_file_name);
+      }
+    }
+  };
+
+  // { last_published_index + 1, last_published_us, current_head_us }, or { 0, -1us, -1us } for an empty persister.
+  struct end_t {
+    uint64_t next_index;
+    std::chrono::microseconds last_entry_us;
+    std::chrono::microseconds head;
+  };
+
+  // The range of one segment, together with the segment itself, to keep it alive while iterated over.
+  template <typename SEGMENT_RANGE>
+  struct Piece {
+    std::shared_ptr<segment_persister_t> persister;
+    SEGMENT_RANGE range;
+    uint64_t begin;
+    uint64_t end;
+  };
+
+ public:
+  SegmentedFilePersister() = delete;
+  SegmentedFilePersister(const SegmentedFilePersister&) = delete;
+  SegmentedFilePersister(SegmentedFilePersister&&) = delete;
+  SegmentedFilePersister& operator=(const SegmentedFilePersister&) = delete;
+  SegmentedFilePersister& operator=(SegmentedFilePersister&&) = delete;
+
+  SegmentedFilePersister(std::mutex& publish_mutex_ref,
+                         const ss::StreamNamespaceName& namespace_name,
+                         const std::string& filename,
+                         const FileSegmentation& segmentation = FileSegmentation(),
+                         const FileRetention& retention = FileRetention::Forever(),
+                         const FileIndex& index = FileIndex::Full())
+      : publish_mutex_ref_(publish_mutex_ref),
+        namespace_name_(namespace_name),
+        filename_(filename),
+        manifest_filename_(filename + ".manifest"),
+        segmentation_(segmentation),
+        retention_(retention),
+        index_(index) {
+    if (std::ifstream(manifest_filename_).good()) {
+      const auto manifest = ParseJSON<FileSegmentsManifest>(FileSystem::ReadFileAsString(manifest_filename_));
+      if (manifest.segments.empty()) {
+        CURRENT_THROW(InvalidSegmentsManifest("no segments in `" + manifest_filename_ + "`."));
+      }
+      for (const auto& info : manifest.segments) {
+        if (!segments_.empty() && segments_.back().info.end != info.begin) {
+          CURRENT_THROW(InvalidSegmentsManifest("a gap before the segment at " + current::ToString(info.begin) + '.'));
+        }
+        segments_.push_back(Segment{info, nullptr});
+      }
+    } else {
+      segments_.push_back(Segment{FileSegmentInfo(0u), nullptr});
+      SaveManifestFromLockedSection();
+    }
+
+    // The active segment is the source of truth for its own range, as the manifest is only updated on rollover.
+    Segment& active = segments_.back();
+    OpenSegmentFromLockedSection(active);
+    const auto head_idxts = active.persister->template PersisterHeadAndLastPublishedIndexAndTimestampImpl<
+        current::locks::MutexLockStatus::AlreadyLocked>();
+    if (Exists(head_idxts.idxts)) {
+      active.info.end = Value(head_idxts.idxts).index + 1u;
+      active.info.last_us = Value(head_idxts.idxts).us;
+      for (const auto& e : active.persister->template PersisterIterate<current::locks::MutexLockStatus::AlreadyLocked>(
+               active.info.begin, active.info.begin + 1u)) {
+        active.info.first_us = e.idx_ts.us;
+      }
+    }
+    active.info.bytes = active.persister->FileSizeFromLockedSection();
+
+    end_t end{active.info.end, std::chrono::microseconds(-1), head_idxts.head};
+    for (const auto& segment : segments_) {
+      if (segment.info.end > segment.info.begin) {
+        end.last_entry_us = segment.info.last_us;
+      }
+    }
+    end.head = std::max(end.head, end.last_entry_us);
+    end_.store(end);
+  }
+
+  template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
+  uint64_t FirstAvailableIndex() const {
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    return segments_.front().info.begin;
+  }
+
+  template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
+  FileSegmentsManifest Segments() const {
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    FileSegmentsManifest result;
+    for (const auto& segment : segments_) {
+      result.segments.push_back(segment.info);
+    }
+    return result;
+  }
+
+  std::string SegmentFileName(uint64_t begin) const {
+    return filename_ + '.' + current::strings::Printf("%020llu", static_cast<unsigned long long>(begin));
+  }
+
+  // `TIMESTAMP` can be `std::chrono::microseconds` or `current::time::DefaultTimeArgument`.
+  template <current::locks::MutexLockStatus MLS, typename E, typename TIMESTAMP>
+  idxts_t PersisterPublishImpl(E&& entry, const TIMESTAMP provided_timestamp) {
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
+    CheckTimestampFromLockedSection(timestamp);
+    RollOverIfNeededFromLockedSection(timestamp);
+    const auto idxts = segments_.back().persister->template PersisterPublishImpl<
+        current::locks::MutexLockStatus::AlreadyLocked>(std::forward<E>(entry), timestamp);
+    OnPublishedFromLockedSection(idxts);
+    return idxts;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  idxts_t PersisterPublishUnsafeImpl(const std::string& raw_log_line) {
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    const auto tab_pos = raw_log_line.find('\t');
+    if (tab_pos == std::string::npos) {
+      CURRENT_THROW(MalformedEntryException(raw_log_line));
+    }
+    const auto timestamp = ParseIndexAndTimestampPrefix(raw_log_line, tab_pos).us;
+    CheckTimestampFromLockedSection(timestamp);
+    RollOverIfNeededFromLockedSection(timestamp);
+    const auto idxts = segments_.back().persister->template PersisterPublishUnsafeImpl<
+        current::locks::MutexLockStatus::AlreadyLocked>(raw_log_line);
+    OnPublishedFromLockedSection(idxts);
+    return idxts;
+  }
+
+  template <current::locks::MutexLockStatus MLS, typename TIMESTAMP>
+  void PersisterUpdateHeadImpl(const TIMESTAMP provided_timestamp) {
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    const auto timestamp = current::time::TimestampAsMicroseconds(provided_timestamp);
+    CheckTimestampFromLockedSection(timestamp);
+    segments_.back().persister->template PersisterUpdateHeadImpl<current::locks::MutexLockStatus::AlreadyLocked>(
+        timestamp);
+    end_t end = end_.load();
+    end.head = timestamp;
+    end_.store(end);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  bool PersisterEmptyImpl() const {
+    return !end_.load().next_index;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  uint64_t PersisterSizeImpl() const noexcept {
+    return end_.load().next_index;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  std::chrono::microseconds PersisterCurrentHeadImpl() const noexcept {
+    return end_.load().head;
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  idxts_t PersisterLastPublishedIndexAndTimestampImpl() const {
+    const auto end = end_.load();
+    if (end.next_index) {
+      return idxts_t(end.next_index - 1, end.last_entry_us);
+    } else {
+      CURRENT_THROW(NoEntriesPublishedYet());
+    }
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  head_optidxts_t PersisterHeadAndLastPublishedIndexAndTimestampImpl() const noexcept {
+    const auto end = end_.load();
+    if (end.next_index) {
+      return head_optidxts_t(end.head, end.next_index - 1, end.last_entry_us);
+    } else {
+      return head_optidxts_t(end.head);
+    }
+  }
+
+  // Uses the timestamp ranges of the segments to only look into the one segment for each of the two bounds.
+  template <current::locks::MutexLockStatus MLS>
+  std::pair<uint64_t, uint64_t> PersisterIndexRangeByTimestampRangeImpl(std::chrono::microseconds from,
+                                                                        std::chrono::microseconds till) const {
+    std::pair<uint64_t, uint64_t> result{static_cast<uint64_t>(-1), static_cast<uint64_t>(-1)};
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    // `upper_bound(till)` is the first entry with the timestamp of at least `till + 1us`.
+    result.first = FirstIndexWithTimestampNotBeforeFromLockedSection(from);
+    if (till.count() > 0) {
+      result.second = FirstIndexWithTimestampNotBeforeFromLockedSection(till + std::chrono::microseconds(1));
+    }
+    return result;
+  }
+
+  // Iterates over the entries of the consecutive segments.
+  template <typename SEGMENT_RANGE>
+  class IteratorImpl final {
+   private:
+    using segment_iterator_t = decltype(std::declval<const SEGMENT_RANGE&>().begin());
+
+   public:
+    IteratorImpl() = delete;
+    IteratorImpl(const IteratorImpl&) = delete;
+    IteratorImpl(IteratorImpl&&) = default;
+    IteratorImpl& operator=(const IteratorImpl&) = delete;
+    IteratorImpl& operator=(IteratorImpl&&) = default;
+
+    IteratorImpl(std::shared_ptr<const std::vector<Piece<SEGMENT_RANGE>>> pieces, uint64_t i)
+        : pieces_(std::move(pieces)), i_(i) {}
+
+    // `operator*` relies on the fact each entry will be requested at most once.
+    // The range-based for-loop works fine. -- D.K.
+    decltype(*std::declval<const segment_iterator_t&>()) operator*() const {
+      while (i_ >= (*pieces_)[piece_].end) {
+        ++piece_;
+        segment_iterator_.reset();
+      }
+      if (!segment_iterator_) {
+        const auto& piece = (*pieces_)[piece_];
+        segment_iterator_ = std::make_unique<segment_iterator_t>(piece.range.begin());
+        for (uint64_t i = piece.begin; i < i_; ++i) {
+          ++(*segment_iterator_);
+        }
+      }
+      return **segment_iterator_;
+    }
+
+    IteratorImpl& operator++() {
+      ++i_;
+      if (segment_iterator_) {
+        ++(*segment_iterator_);
+      }
+      return *this;
+    }
+    bool operator==(const IteratorImpl& rhs) const { return i_ == rhs.i_; }
+    bool operator!=(const IteratorImpl& rhs) const { return !operator==(rhs); }
+    operator bool() const { return static_cast<bool>(pieces_); }
+
+   private:
+    std::shared_ptr<const std::vector<Piece<SEGMENT_RANGE>>> pieces_;
+    uint64_t i_;
+    mutable size_t piece_ = 0u;
+    mutable std::unique_ptr<segment_iterator_t> segment_iterator_;
+  };
+
+  template <typename SEGMENT_RANGE>
+  class IterableRangeImpl {
+   public:
+    IterableRangeImpl(std::shared_ptr<const std::vector<Piece<SEGMENT_RANGE>>> pieces, uint64_t begin, uint64_t end)
+        : pieces_(std::move(pieces)), begin_(begin), end_(end) {}
+
+    IteratorImpl<SEGMENT_RANGE> begin() const { return IteratorImpl<SEGMENT_RANGE>(pieces_, begin_); }
+    IteratorImpl<SEGMENT_RANGE> end() const { return IteratorImpl<SEGMENT_RANGE>(pieces_, end_); }
+
+    operator bool() const { return static_cast<bool>(pieces_); }
+
+   private:
+    const std::shared_ptr<const std::vector<Piece<SEGMENT_RANGE>>> pieces_;
+    const uint64_t begin_;
+    const uint64_t end_;
+  };
+
+  using IterableRange = IterableRangeImpl<typename segment_persister_t::IterableRange>;
+  using IterableRangeUnsafe = IterableRangeImpl<typename segment_persister_t::IterableRangeUnsafe>;
+  using IterableRangeMapped = IterableRangeImpl<typename segment_persister_t::IterableRangeMapped>;
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRange PersisterIterate(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRange>(
+        begin_index, end_index, [](const segment_persister_t& segment, uint64_t begin, uint64_t end) {
+          return segment.template PersisterIterate<current::locks::MutexLockStatus::AlreadyLocked>(begin, end);
+        });
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeUnsafe PersisterIterateUnsafe(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRangeUnsafe>(
+        begin_index, end_index, [](const segment_persister_t& segment, uint64_t begin, uint64_t end) {
+          return segment.template PersisterIterateUnsafe<current::locks::MutexLockStatus::AlreadyLocked>(begin, end);
+        });
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeMapped PersisterIterateMapped(uint64_t begin_index, uint64_t end_index) const {
+    return PersisterIterateImpl<MLS, IterableRangeMapped>(
+        begin_index, end_index, [](const segment_persister_t& segment, uint64_t begin, uint64_t end) {
+          return segment.template PersisterIterateMapped<current::locks::MutexLockStatus::AlreadyLocked>(begin, end);
+        });
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRange PersisterIterate(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    const auto index_range = IndexRangeByTimestampRange<MLS>(from, till);
+    return PersisterIterate<MLS>(index_range.first, index_range.second);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeUnsafe PersisterIterateUnsafe(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    const auto index_range = IndexRangeByTimestampRange<MLS>(from, till);
+    return PersisterIterateUnsafe<MLS>(index_range.first, index_range.second);
+  }
+
+  template <current::locks::MutexLockStatus MLS>
+  IterableRangeMapped PersisterIterateMapped(std::chrono::microseconds from, std::chrono::microseconds till) const {
+    const auto index_range = IndexRangeByTimestampRange<MLS>(from, till);
+    return PersisterIterateMapped<MLS>(index_range.first, index_range.second);
+  }
+
+ private:
+  // The `{ begin, end }` to iterate over, with `{ 0, 0 }` if no entries are in the requested range.
+  template <current::locks::MutexLockStatus MLS>
+  std::pair<uint64_t, uint64_t> IndexRangeByTimestampRange(std::chrono::microseconds from,
+                                                           std::chrono::microseconds till) const {
+    if (till.count() > 0 && till < from) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+    const auto index_range = PersisterIndexRangeByTimestampRangeImpl<MLS>(from, till);
+    if (index_range.first != static_cast<uint64_t>(-1)) {
+      return index_range;
+    } else {  // No entries found in the requested range.
+      return std::make_pair(0u, 0u);
+    }
+  }
+
+  template <current::locks::MutexLockStatus MLS, typename ITERABLE, typename F>
+  ITERABLE PersisterIterateImpl(uint64_t begin_index, uint64_t end_index, F&& segment_range) const {
+    using segment_range_t = decltype(segment_range(std::declval<const segment_persister_t&>(), 0u, 0u));
+
+    // OK to only lock the mutex later, as `end_` is an `atomic`.
+    const uint64_t current_size = end_.load().next_index;
+    if (end_index == static_cast<uint64_t>(-1)) {
+      end_index = current_size;
+    }
+    if (end_index > current_size) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+    auto pieces = std::make_shared<std::vector<Piece<segment_range_t>>>();
+    if (begin_index == end_index) {
+      return ITERABLE(std::move(pieces), 0u, 0u);
+    }
+    if (end_index < begin_index) {
+      CURRENT_THROW(InvalidIterableRangeException());
+    }
+
+    current::locks::SmartMutexLockGuard<MLS> lock(publish_mutex_ref_);
+    // The entries dropped by the retention policy are skipped over. Clamped under the lock, as the retention policy
+    // may have dropped more segments since the caller has obtained the first available index.
+    begin_index = std::max(begin_index, segments_.front().info.begin);
+    if (begin_index >= end_index) {
+      return ITERABLE(std::move(pieces), 0u, 0u);
+    }
+    for (auto& segment : segments_) {
+      const uint64_t begin = std::max(begin_index, segment.info.begin);
+      const uint64_t end = std::min(end_index, segment.info.end);
+      if (begin < end) {
+        OpenSegmentFromLockedSection(segment);
+        pieces->push_back(Piece<segment_range_t>{segment.persister, segment_range(*segment.persister, begin, end), begin, end});
+      }
+    }
+    return ITERABLE(std::move(pieces), begin_index, end_index);
+  }
+
+  void CheckTimestampFromLockedSection(std::chrono::microseconds timestamp) const {
+    const auto head = end_.load().head;
+    if (!(timestamp > head)) {
+      CURRENT_THROW(ss::InconsistentTimestampException(head + std::chrono::microseconds(1), timestamp));
+    }
+  }
+
+  void OnPublishedFromLockedSection(idxts_t idxts) {
+    Segment& active = segments_.back();
+    if (active.info.end == active.info.begin) {
+      active.info.first_us = idxts.us;
+    }
+    active.info.end = idxts.index + 1u;
+    active.info.last_us = idxts.us;
+    end_.store(end_t{idxts.index + 1u, idxts.us, idxts.us});
+  }
+
+  // The active segment is rolled over before the entry which would make it exceed the thresholds is published.
+  void RollOverIfNeededFromLockedSection(std::chrono::microseconds timestamp) {
+    Segment& active = segments_.back();
+    if (active.info.end == active.info.begin) {
+      return;  // Never leave an empty segment behind.
+    }
+    active.info.bytes = active.persister->FileSizeFromLockedSection();
+    const bool too_large = active.info.bytes >= segmentation_.max_segment_bytes;
+    const bool too_old = segmentation_.max_segment_duration.count() > 0 &&
+                         timestamp - active.info.first_us >= segmentation_.max_segment_duration;
+    if (!too_large && !too_old) {
+      return;
+    }
+
+    segments_.push_back(Segment{FileSegmentInfo(active.info.end), nullptr});
+    std::vector<Segment> dropped;
+    while (segments_.size() > 1u && ShouldDropOldestSegmentFromLockedSection(timestamp)) {
+      dropped.push_back(std::move(segments_.front()));
+      segments_.pop_front();
+    }
+    // The manifest goes first, so that a crash never leaves it referring to a removed segment file.
+    SaveManifestFromLockedSection();
+    for (auto& segment : dropped) {
+      if (segment.persister) {
+        // Removed right away by `SegmentDeleter`, unless some iteration still holds the persister.
+        std::get_deleter<SegmentDeleter>(segment.persister)->dropped = true;
+        segment.persister.reset();
+      } else {
+        RemoveSegmentFiles(SegmentFileName(segment.info.begin));
+      }
+    }
+    OpenSegmentFromLockedSection(segments_.back());
+  }
+
+  // Only looks at the sealed segments. `now` is the timestamp of the entry about to be published.
+  bool ShouldDropOldestSegmentFromLockedSection(std::chrono::microseconds now) const {
+    const size_t sealed_segments = segments_.size() - 1u;
+    if (retention_.max_sealed_segments && sealed_segments > retention_.max_sealed_segments) {
+      return true;
+    }
+    if (retention_.max_total_bytes) {
+      uint64_t total_bytes = 0u;
+      for (const auto& segment : segments_) {
+        total_bytes += segment.info.bytes;
+      }
+      if (total_bytes > retention_.max_total_bytes) {
+        return true;
+      }
+    }
+    if (retention_.max_age.count() > 0 && now - segments_.front().info.last_us > retention_.max_age) {
+      return true;
+    }
+    return false;
+  }
+
+  uint64_t FirstIndexWithTimestampNotBeforeFromLockedSection(std::chrono::microseconds t) const {
+    for (auto& segment : segments_) {
+      if (segment.info.end > segment.info.begin && segment.info.last_us >= t) {
+        OpenSegmentFromLockedSection(segment);
+        return segment.persister->template PersisterIndexRangeByTimestampRangeImpl<
+                                        current::locks::MutexLockStatus::AlreadyLocked>(t, std::chrono::microseconds(-1))
+            .first;
+      }
+    }
+    return static_cast<uint64_t>(-1);
+  }
+
+  void OpenSegmentFromLockedSection(Segment& segment) const {
+    if (!segment.persister) {
+      const std::string segment_file_name = SegmentFileName(segment.info.begin);
+      segment.persister = std::shared_ptr<segment_persister_t>(
+          new segment_persister_t(publish_mutex_ref_,
+                                  namespace_name_,
+                                  segment_file_name,
+                                  FileDurability::Strict(),
+                                  index_.StartingFrom(segment.info.begin)),
+          SegmentDeleter{segment_file_name, false});
+      if (&segment != &segments_.back()) {
+        const auto size = segment.persister->template PersisterSizeImpl<current::locks::MutexLockStatus::AlreadyLocked>();
+        if (size != segment.info.end) {
+          CURRENT_THROW(InvalidSegmentsManifest("the segment at " + current::ToString(segment.info.begin) +
+                                                " ends at " + current::ToString(size) + ", not at " +
+                                                current::ToString(segment.info.end) + '.'));
+        }
+      }
+    }
+  }
+
+  static void RemoveSegmentFiles(const std::string& segment_file_name) {
+    FileSystem::RmFile(segment_file_name, FileSystem::RmFileParameters::Silent);
+    FileSystem::RmFile(segment_file_name + ".idx", FileSystem::RmFileParameters::Silent);
+  }
+
+  void SaveManifestFromLockedSection() const {
+    FileSegmentsManifest manifest;
+    for (const auto& segment : segments_) {
+      manifest.segments.push_back(segment.info);
+    }
+    // Written into a temporary file first, synced, and renamed once complete, so that the manifest is never partial.
+    // The directory is synced after the rename, so that the new manifest is durable before any segment is removed.
+    const std::string tmp_filename = manifest_filename_ + ".tmp";
+    FileSystem::WriteStringToFile(JSON(manifest), tmp_filename.c_str());
+    FileSystem::SyncPath(tmp_filename);
+    FileSystem::RenameFile(tmp_filename, manifest_filename_);
+    const size_t separator = manifest_filename_.rfind(FileSystem::GetPathSeparator());
+    FileSystem::SyncPath(separator == std::string::npos ? "." : manifest_filename_.substr(0u, separator + 1u));
+  }
+
+  std::mutex& publish_mutex_ref_;  // Guards `segments_`, and is shared with the `FilePersister`-s of the segments.
+  const ss::StreamNamespaceName namespace_name_;
+  const std::string filename_;
+  const std::string manifest_filename_;
+  const FileSegmentation segmentation_;
+  const FileRetention retention_;
+  const FileIndex index_;
+  mutable std::deque<Segment> segments_;  // `mutable`, as the sealed segments are opened lazily.
+  current::atomic_that_works<end_t> end_;
+};
+
+}  // namespace impl
+
+template <typename ENTRY>
+using SegmentedFile = ss::EntryPersister<impl::SegmentedFilePersister<ENTRY>, ENTRY>;
+
+}  // namespace persistence
+}  // namespace current
+
+#endif  // BLOCKS_PERSISTENCE_SEGMENTED_H
@@ -25,12 +25,22 @@ SOFTWARE.
 
 #include "../../port.h"
 
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+
+#ifndef CURRENT_WINDOWS
+#include <csignal>
+#include <sys/resource.h>
+#endif  // CURRENT_WINDOWS
 
 #define CURRENT_MOCK_TIME  // `SetNow()`.
 
 #include "memory.h"
 #include "file.h"
+#include "segmented.h"
+#include "binary.h"
 
 #include "../ss/ss.h"
 
@@ -556,6 +566,492 @@ TEST(PersistenceLayer, FileDirectives) {
       current::FileSystem::ReadFileAsString(persistence_file_name));
 }
 
+TEST(PersistenceLayer, FileGroupCommit) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  using IMPL = current::persistence::File<StorableString>;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const auto file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+
+  constexpr size_t kThreads = 4u;
+  constexpr size_t kEntriesPerThread = 50u;
+  constexpr size_t kTotalEntries = kThreads * kEntriesPerThread;
+
+  {
+    std::mutex mutex;
+    IMPL impl(mutex,
+              namespace_name,
+              persistence_file_name,
+              current::persistence::FileDurability::GroupCommit(std::chrono::milliseconds(5)));
+
+    // The mock time is auto-incremented on each call, so concurrent publishers get distinct timestamps.
+    current::time::SetNow(std::chrono::microseconds(100), std::chrono::microseconds(1000000));
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0u; t < kThreads; ++t) {
+      threads.emplace_back([&impl, t]() {
+        for (size_t i = 0u; i < kEntriesPerThread; ++i) {
+          const auto idxts = impl.Publish(StorableString(Printf("%d:%d", static_cast<int>(t), static_cast<int>(i))));
+          // By the time `Publish()` returns, the entry is committed.
+          EXPECT_GT(impl.Size(), idxts.index);
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    EXPECT_EQ(kTotalEntries, impl.Size());
+    const auto stats = impl.GroupCommitStats();
+    EXPECT_EQ(kTotalEntries, stats.entries);
+    EXPECT_LT(stats.batches, kTotalEntries);
+    EXPECT_GT(stats.max_batch_entries, 1u);
+    EXPECT_GE(stats.max_commit_latency.count(), stats.total_commit_latency.count() / static_cast<int64_t>(stats.batches));
+
+    const auto head = impl.CurrentHead();
+    impl.UpdateHead(head + std::chrono::microseconds(10));
+    impl.Publish(StorableString("last"), head + std::chrono::microseconds(20));
+    EXPECT_EQ(kTotalEntries + 1u, impl.Size());
+    EXPECT_EQ(kTotalEntries + 1u, impl.GroupCommitStats().entries);
+
+    uint64_t expected_index = 0u;
+    for (const auto& e : impl.Iterate()) {
+      EXPECT_EQ(expected_index, e.idx_ts.index);
+      ++expected_index;
+    }
+    EXPECT_EQ(kTotalEntries + 1u, expected_index);
+
+    std::vector<std::string> last_two_unsafe;
+    for (const auto& e : impl.IterateUnsafe(kTotalEntries - 1u)) {
+      last_two_unsafe.push_back(e);
+    }
+    ASSERT_EQ(2u, last_two_unsafe.size());
+    EXPECT_EQ(Printf("{\"index\":%d,\"us\":%d}\t{\"s\":\"last\"}",
+                     static_cast<int>(kTotalEntries),
+                     static_cast<int>((head + std::chrono::microseconds(20)).count())),
+              last_two_unsafe[1]);
+  }
+
+  {
+    // Confirm the file written in batches is replayed by the default, `Strict`, persister.
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name);
+    EXPECT_EQ(kTotalEntries + 1u, impl.Size());
+    EXPECT_EQ(0u, impl.GroupCommitStats().batches);
+    std::set<std::string> all_entries;
+    for (const auto& e : impl.Iterate()) {
+      all_entries.insert(e.entry.s);
+    }
+    EXPECT_EQ(kTotalEntries + 1u, all_entries.size());
+    EXPECT_EQ(1u, all_entries.count("3:49"));
+    EXPECT_EQ(1u, all_entries.count("last"));
+  }
+}
+
+TEST(PersistenceLayer, FileGroupCommitFailure) {
+  std::ostringstream os;
+  std::vector<int> committed;
+  {
+    current::persistence::impl::GroupCommitter<int> committer(
+        os, "test", current::persistence::FileDurability::GroupCommit(), [&committed](const int& state) {
+          committed.push_back(state);
+        });
+
+    committer.WaitUntilCommitted(committer.Append([](std::string& batch) { batch += "one\n"; }, 1));
+    EXPECT_EQ("one\n", os.str());
+    EXPECT_EQ(std::vector<int>({1}), committed);
+
+    // Once a write fails, neither that batch nor any later one is committed, and their publishers get an exception.
+    os.setstate(std::ios::badbit);
+    const uint64_t failed_batch_id = committer.Append([](std::string& batch) { batch += "two\n"; }, 2);
+    ASSERT_THROW(committer.WaitUntilCommitted(failed_batch_id), current::persistence::PersistenceFileCommitFailed);
+    os.clear();
+    const uint64_t next_batch_id = committer.Append([](std::string& batch) { batch += "three\n"; }, 3);
+    ASSERT_THROW(committer.WaitUntilCommitted(next_batch_id), current::persistence::PersistenceFileCommitFailed);
+    EXPECT_EQ(std::vector<int>({1}), committed);
+    EXPECT_EQ(1u, committer.Stats().batches);
+  }
+  EXPECT_EQ("one\n", os.str());
+}
+
+#ifndef CURRENT_WINDOWS
+TEST(PersistenceLayer, FileGroupCommitFailureRecovery) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  using IMPL = current::persistence::File<StorableString>;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const auto file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name, current::persistence::FileDurability::GroupCommit());
+    impl.Publish(StorableString("one"), std::chrono::microseconds(100));
+    EXPECT_EQ(1u, impl.Size());
+
+    // Have the file not grow any further, so that writing the next batch fails.
+    struct rlimit saved_limit;
+    ASSERT_EQ(0, ::getrlimit(RLIMIT_FSIZE, &saved_limit));
+    struct rlimit limit = saved_limit;
+    limit.rlim_cur = static_cast<rlim_t>(current::FileSystem::GetFileSize(persistence_file_name));
+    const auto saved_handler = std::signal(SIGXFSZ, SIG_IGN);
+    ASSERT_EQ(0, ::setrlimit(RLIMIT_FSIZE, &limit));
+    EXPECT_THROW(impl.Publish(StorableString("two"), std::chrono::microseconds(200)),
+                 current::persistence::PersistenceFileCommitFailed);
+    ASSERT_EQ(0, ::setrlimit(RLIMIT_FSIZE, &saved_limit));
+    std::signal(SIGXFSZ, saved_handler);
+
+    // The publisher is ahead of the readers by the failed entry, which they never see, and nothing is written past it.
+    EXPECT_EQ(1u, impl.Size());
+    EXPECT_THROW(impl.Publish(StorableString("three"), std::chrono::microseconds(300)),
+                 current::persistence::PersistenceFileCommitFailed);
+    EXPECT_EQ(1u, impl.Size());
+    std::vector<std::string> entries;
+    for (const auto& e : impl.Iterate()) {
+      entries.push_back(e.entry.s);
+    }
+    EXPECT_EQ("one", Join(entries, ','));
+  }
+
+  {
+    // Reopened, the file has the committed entries only, and is published to from the last one of them on.
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name, current::persistence::FileDurability::GroupCommit());
+    EXPECT_EQ(1u, impl.Size());
+    EXPECT_EQ(1u, impl.Publish(StorableString("two"), std::chrono::microseconds(200)).index);
+    std::vector<std::string> entries;
+    for (const auto& e : impl.Iterate()) {
+      entries.push_back(e.entry.s);
+    }
+    EXPECT_EQ("one,two", Join(entries, ','));
+  }
+}
+#endif  // CURRENT_WINDOWS
+
+TEST(PersistenceLayer, FileSparseIndex) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  using IMPL = current::persistence::File<StorableString>;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string full_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const std::string sparse_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "sparse_data");
+  const std::string sparse_index_file_name = sparse_file_name + ".idx";
+  const auto full_file_remover = current::FileSystem::ScopedRmFile(full_file_name);
+  const auto sparse_file_remover = current::FileSystem::ScopedRmFile(sparse_file_name);
+  const auto sparse_index_file_remover = current::FileSystem::ScopedRmFile(sparse_index_file_name);
+
+  constexpr uint64_t kEveryN = 10u;
+  constexpr uint64_t kTotalEntries = 1000u;
+
+  const auto entries_as_string = [](IMPL& impl, uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.Iterate(begin, end)) {
+      result.push_back(JSON(e.idx_ts) + ' ' + e.entry.s);
+    }
+    return Join(result, ',');
+  };
+  const auto unsafe_entries_as_string = [](IMPL& impl, uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.IterateUnsafe(begin, end)) {
+      result.push_back(e);
+    }
+    return Join(result, ',');
+  };
+  const auto timestamp_range_as_string = [](IMPL& impl, int64_t from, int64_t till) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.Iterate(std::chrono::microseconds(from), std::chrono::microseconds(till))) {
+      result.push_back(current::ToString(e.idx_ts.index));
+    }
+    for (const auto& e : impl.IterateUnsafe(std::chrono::microseconds(from), std::chrono::microseconds(till))) {
+      result.push_back(e.substr(0, e.find('\t')));
+    }
+    return Join(result, ',');
+  };
+
+  {
+    std::mutex full_mutex;
+    IMPL full(full_mutex, namespace_name, full_file_name);
+    std::mutex sparse_mutex;
+    IMPL sparse(sparse_mutex, namespace_name, sparse_file_name, current::persistence::FileIndex::Sparse(kEveryN));
+
+    // Entries at 10us, 20us, etc., with a few head directives in between.
+    for (uint64_t i = 0u; i < kTotalEntries; ++i) {
+      const auto us = std::chrono::microseconds(static_cast<int64_t>(i + 1u) * 10);
+      full.Publish(StorableString(current::ToString(i)), us);
+      sparse.Publish(StorableString(current::ToString(i)), us);
+      if (i % 7u == 3u) {
+        full.UpdateHead(us + std::chrono::microseconds(5));
+        sparse.UpdateHead(us + std::chrono::microseconds(5));
+      }
+    }
+    EXPECT_EQ(kTotalEntries, sparse.Size());
+
+    for (const auto& range : std::vector<std::pair<uint64_t, uint64_t>>{
+             {0u, 1u}, {0u, 10u}, {3u, 9u}, {9u, 11u}, {10u, 20u}, {17u, 123u}, {995u, 1000u}, {0u, 1000u}}) {
+      EXPECT_EQ(entries_as_string(full, range.first, range.second),
+                entries_as_string(sparse, range.first, range.second));
+      EXPECT_EQ(unsafe_entries_as_string(full, range.first, range.second),
+                unsafe_entries_as_string(sparse, range.first, range.second));
+    }
+
+    EXPECT_EQ("4,5,6,7,{\"index\":4,\"us\":50},{\"index\":5,\"us\":60},{\"index\":6,\"us\":70},{\"index\":7,\"us\":80}",
+              timestamp_range_as_string(sparse, 45, 80));
+    EXPECT_EQ("0,{\"index\":0,\"us\":10}", timestamp_range_as_string(sparse, 0, 19));
+    EXPECT_EQ("998,999,{\"index\":998,\"us\":9990},{\"index\":999,\"us\":10000}",
+              timestamp_range_as_string(sparse, 9990, 0));
+    EXPECT_EQ("", timestamp_range_as_string(sparse, 10001, 0));
+    for (const auto& range : std::vector<std::pair<int64_t, int64_t>>{
+             {0, 0}, {1, 99}, {95, 105}, {100, 200}, {101, 109}, {1234, 5678}, {5000, 0}}) {
+      EXPECT_EQ(timestamp_range_as_string(full, range.first, range.second),
+                timestamp_range_as_string(sparse, range.first, range.second));
+    }
+  }
+
+  // Only every `kEveryN`-th entry is indexed, and the sidecar file is truncated to its actual size.
+  EXPECT_EQ(kTotalEntries / kEveryN * 16u, current::FileSystem::ReadFileAsString(sparse_index_file_name).length());
+
+  {
+    // The sparse index is rebuilt on startup.
+    std::mutex mutex;
+    IMPL sparse(mutex, namespace_name, sparse_file_name, current::persistence::FileIndex::Sparse(kEveryN));
+    EXPECT_EQ(kTotalEntries, sparse.Size());
+    EXPECT_EQ("{\"index\":512,\"us\":5130} 512,{\"index\":513,\"us\":5140} 513", entries_as_string(sparse, 512u, 514u));
+    sparse.Publish(StorableString("more"), std::chrono::microseconds(20000));
+    EXPECT_EQ("{\"index\":1000,\"us\":20000} more", entries_as_string(sparse, 1000u, 1001u));
+    EXPECT_EQ("1000,{\"index\":1000,\"us\":20000}", timestamp_range_as_string(sparse, 10001, 0));
+  }
+  EXPECT_EQ((kTotalEntries / kEveryN + 1u) * 16u,
+            current::FileSystem::ReadFileAsString(sparse_index_file_name).length());
+}
+
+TEST(PersistenceLayer, FileMappedIterators) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  using IMPL = current::persistence::File<StorableString>;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const auto file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+
+  std::mutex mutex;
+  IMPL impl(mutex, namespace_name, persistence_file_name);
+
+  const auto unsafe_entries = [&impl](uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.IterateUnsafe(begin, end)) {
+      result.push_back(e);
+    }
+    return Join(result, '\n');
+  };
+  const auto mapped_entries = [&impl](uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const current::strings::Chunk& e : impl.IterateMapped(begin, end)) {
+      result.push_back(e);
+    }
+    return Join(result, '\n');
+  };
+
+  impl.Publish(StorableString("foo"), std::chrono::microseconds(100));
+  impl.Publish(StorableString("bar"), std::chrono::microseconds(200));
+  impl.UpdateHead(std::chrono::microseconds(300));
+  impl.Publish(StorableString("meh"), std::chrono::microseconds(400));
+  impl.UpdateHead(std::chrono::microseconds(500));
+
+  EXPECT_EQ(
+      "{\"index\":0,\"us\":100}\t{\"s\":\"foo\"}\n"
+      "{\"index\":1,\"us\":200}\t{\"s\":\"bar\"}\n"
+      "{\"index\":2,\"us\":400}\t{\"s\":\"meh\"}",
+      mapped_entries(0u, 3u));
+  EXPECT_EQ("{\"index\":2,\"us\":400}\t{\"s\":\"meh\"}", mapped_entries(2u, 3u));
+  EXPECT_EQ("", mapped_entries(3u, 3u));
+  {
+    std::vector<std::string> result;
+    for (const auto& e : impl.IterateMapped(std::chrono::microseconds(150), std::chrono::microseconds(400))) {
+      result.push_back(e);
+    }
+    EXPECT_EQ("{\"index\":1,\"us\":200}\t{\"s\":\"bar\"},{\"index\":2,\"us\":400}\t{\"s\":\"meh\"}", Join(result, ','));
+  }
+
+  // Grow the file past the initial capacity of the mapping, while an iterator over the original one is alive.
+  auto range = impl.IterateMapped(0u, 3u);
+  auto it = range.begin();
+  EXPECT_EQ("{\"index\":0,\"us\":100}\t{\"s\":\"foo\"}", static_cast<std::string>(*it));
+  const std::string padding(1000, '.');
+  const uint64_t total_entries = 3u + current::persistence::impl::FileMapping::kMinCapacity * 3u / padding.length();
+  for (uint64_t i = 3u; i < total_entries; ++i) {
+    impl.Publish(StorableString(current::ToString(i) + padding), std::chrono::microseconds(1000 + i));
+  }
+  ++it;
+  EXPECT_EQ("{\"index\":1,\"us\":200}\t{\"s\":\"bar\"}", static_cast<std::string>(*it));
+
+  EXPECT_EQ(unsafe_entries(0u, total_entries), mapped_entries(0u, total_entries));
+  EXPECT_EQ(unsafe_entries(total_entries - 5u, total_entries), mapped_entries(total_entries - 5u, total_entries));
+  EXPECT_EQ(unsafe_entries(1000u, 1001u), mapped_entries(1000u, 1001u));
+}
+
+TEST(PersistenceLayer, SegmentedFile) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+  using current::persistence::FileRetention;
+  using current::persistence::FileSegmentation;
+
+  using IMPL = current::persistence::SegmentedFile<StorableString>;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string base_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "segmented");
+  const std::string retained_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "retained");
+  const auto segment_file_name = [](const std::string& base, uint64_t begin) {
+    return base + '.' + Printf("%020llu", static_cast<unsigned long long>(begin));
+  };
+  std::vector<std::unique_ptr<current::FileSystem::ScopedRmFile>> removers;
+  for (const std::string& base : {base_file_name, retained_file_name}) {
+    removers.push_back(std::make_unique<current::FileSystem::ScopedRmFile>(base + ".manifest"));
+    for (uint64_t begin = 0u; begin <= 60u; begin += 10u) {
+      removers.push_back(std::make_unique<current::FileSystem::ScopedRmFile>(segment_file_name(base, begin)));
+    }
+  }
+  const auto file_exists = [](const std::string& file_name) { return std::ifstream(file_name).good(); };
+
+  const auto segment_begins = [](const IMPL& impl) {
+    std::vector<std::string> result;
+    for (const auto& segment : impl.Segments().segments) {
+      result.push_back(current::ToString(segment.begin));
+    }
+    return Join(result, ',');
+  };
+  const auto indexes = [](const IMPL& impl, uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.Iterate(begin, end)) {
+      result.push_back(current::ToString(e.idx_ts.index) + ':' + e.entry.s);
+    }
+    return Join(result, ',');
+  };
+  const auto unsafe_entries = [](const IMPL& impl, uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const auto& e : impl.IterateUnsafe(begin, end)) {
+      result.push_back(e);
+    }
+    return Join(result, '\n');
+  };
+  const auto mapped_entries = [](const IMPL& impl, uint64_t begin, uint64_t end) {
+    std::vector<std::string> result;
+    for (const current::strings::Chunk& e : impl.IterateMapped(begin, end)) {
+      result.push_back(e);
+    }
+    return Join(result, '\n');
+  };
+
+  // Entries at 10us, 20us, etc., ten per segment.
+  const auto segmentation = FileSegmentation::ByDuration(std::chrono::microseconds(100));
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, base_file_name, segmentation);
+    for (uint64_t i = 0u; i < 50u; ++i) {
+      impl.Publish(StorableString(current::ToString(i)), std::chrono::microseconds(static_cast<int64_t>(i + 1u) * 10));
+    }
+    impl.UpdateHead(std::chrono::microseconds(505));
+
+    EXPECT_EQ(50u, impl.Size());
+    EXPECT_EQ(0u, impl.FirstAvailableIndex());
+    EXPECT_EQ(505, impl.CurrentHead().count());
+    EXPECT_EQ("0,10,20,30,40", segment_begins(impl));
+    EXPECT_TRUE(current::FileSystem::GetFileSize(segment_file_name(base_file_name, 30u)) > 0u);
+
+    EXPECT_EQ("8:8,9:9,10:10,11:11", indexes(impl, 8u, 12u));
+    EXPECT_EQ("19:19,20:20", indexes(impl, 19u, 21u));
+    EXPECT_EQ("", indexes(impl, 30u, 30u));
+    EXPECT_EQ(
+        "{\"index\":9,\"us\":100}\t{\"s\":\"9\"}\n"
+        "{\"index\":10,\"us\":110}\t{\"s\":\"10\"}",
+        unsafe_entries(impl, 9u, 11u));
+    EXPECT_EQ(unsafe_entries(impl, 0u, 50u), mapped_entries(impl, 0u, 50u));
+    EXPECT_EQ(unsafe_entries(impl, 5u, 45u), mapped_entries(impl, 5u, 45u));
+
+    {
+      std::vector<std::string> result;
+      for (const auto& e : impl.Iterate(std::chrono::microseconds(95), std::chrono::microseconds(125))) {
+        result.push_back(current::ToString(e.idx_ts.index));
+      }
+      EXPECT_EQ("9,10,11", Join(result, ','));
+    }
+    EXPECT_EQ(std::make_pair(uint64_t(29u), uint64_t(41u)),
+              impl.IndexRangeByTimestampRange(std::chrono::microseconds(300), std::chrono::microseconds(410)));
+
+    ASSERT_THROW(impl.Iterate(0u, 51u), current::persistence::InvalidIterableRangeException);
+  }
+
+  // The segments and the global indexes survive the restart.
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, base_file_name, segmentation);
+    EXPECT_EQ(50u, impl.Size());
+    EXPECT_EQ(505, impl.CurrentHead().count());
+    EXPECT_EQ("0,10,20,30,40", segment_begins(impl));
+    EXPECT_EQ("38:38,39:39,40:40,41:41", indexes(impl, 38u, 42u));
+    EXPECT_EQ(50u, impl.Publish(StorableString("50"), std::chrono::microseconds(510)).index);
+    EXPECT_EQ("0,10,20,30,40,50", segment_begins(impl));
+    EXPECT_EQ("49:49,50:50", indexes(impl, 49u, 51u));
+  }
+
+  // The retention policy drops whole sealed segments, leaving the indexes as they were.
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, retained_file_name, segmentation, FileRetention::BySegments(2u));
+    for (uint64_t i = 0u; i < 50u; ++i) {
+      impl.Publish(StorableString(current::ToString(i)), std::chrono::microseconds(static_cast<int64_t>(i + 1u) * 10));
+    }
+    EXPECT_EQ(50u, impl.Size());
+    EXPECT_EQ(20u, impl.FirstAvailableIndex());
+    EXPECT_EQ("20,30,40", segment_begins(impl));
+    EXPECT_FALSE(file_exists(segment_file_name(retained_file_name, 0u)));
+    EXPECT_FALSE(file_exists(segment_file_name(retained_file_name, 10u)));
+    EXPECT_TRUE(file_exists(segment_file_name(retained_file_name, 20u)));
+    EXPECT_EQ("20:20,21:21", indexes(impl, 20u, 22u));
+    // The entries dropped are skipped over.
+    EXPECT_EQ("20:20,21:21", indexes(impl, 19u, 22u));
+    EXPECT_EQ("", indexes(impl, 0u, 20u));
+    {
+      std::vector<std::string> result;
+      for (const auto& e : impl.Iterate(std::chrono::microseconds(0))) {
+        result.push_back(current::ToString(e.idx_ts.index));
+      }
+      EXPECT_EQ(30u, result.size());
+      EXPECT_EQ("20", result.front());
+    }
+    {
+      // The segment dropped while iterated over is only removed once the iteration is done.
+      const auto range = impl.IterateUnsafe(20u, 30u);
+      for (uint64_t i = 50u; i < 70u; ++i) {
+        impl.Publish(StorableString(current::ToString(i)),
+                     std::chrono::microseconds(static_cast<int64_t>(i + 1u) * 10));
+      }
+      EXPECT_EQ("40,50,60", segment_begins(impl));
+      EXPECT_TRUE(file_exists(segment_file_name(retained_file_name, 20u)));
+      EXPECT_FALSE(file_exists(segment_file_name(retained_file_name, 30u)));
+      std::vector<std::string> result;
+      for (const auto& e : range) {
+        result.push_back(e);
+      }
+      EXPECT_EQ(10u, result.size());
+      EXPECT_EQ("{\"index\":29,\"us\":300}\t{\"s\":\"29\"}", result.back());
+    }
+    EXPECT_FALSE(file_exists(segment_file_name(retained_file_name, 20u)));
+  }
+}
+
 TEST(PersistenceLayer, FileExceptions) {
   using namespace persistence_test;
 
@@ -987,6 +1483,186 @@ TEST(PersistenceLayer, FileIteratorCanNotOutliveFile) {
   t.join();
 }
 
+TEST(PersistenceLayer, Binary) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  using IMPL = current::persistence::Binary<StorableString>;
+
+  static_assert(current::ss::IsPersister<IMPL>::value, "");
+  static_assert(current::ss::IsEntryPersister<IMPL, StorableString>::value, "");
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const auto file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name);
+    EXPECT_EQ(0u, impl.Size());
+    current::time::SetNow(std::chrono::microseconds(100));
+    impl.Publish(StorableString("foo"));
+    current::time::SetNow(std::chrono::microseconds(200));
+    impl.Publish(StorableString("bar"));
+    current::time::SetNow(std::chrono::microseconds(300));
+    impl.UpdateHead();
+    current::time::SetNow(std::chrono::microseconds(400));
+    impl.UpdateHead();
+    EXPECT_EQ(400, impl.CurrentHead().count());
+    impl.PublishUnsafe("{\"index\":2,\"us\":500}\t{\"s\":\"meh\"}");
+    EXPECT_EQ(3u, impl.Size());
+    ASSERT_THROW(impl.PublishUnsafe("{\"index\":2,\"us\":600}\t{\"s\":\"dup\"}"),
+                 current::persistence::UnsafePublishBadIndexTimestampException);
+    current::time::SetNow(std::chrono::microseconds(600));
+    impl.UpdateHead();
+  }
+
+  {
+    // Confirm the data has been saved and can be replayed.
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name);
+    EXPECT_EQ(3u, impl.Size());
+    EXPECT_EQ(600, impl.CurrentHead().count());
+    EXPECT_EQ(500, impl.LastPublishedIndexAndTimestamp().us.count());
+
+    std::vector<std::string> all_three;
+    for (const auto& e : impl.Iterate()) {
+      all_three.push_back(Printf(
+          "%s %d %d", e.entry.s.c_str(), static_cast<int>(e.idx_ts.index), static_cast<int>(e.idx_ts.us.count())));
+    }
+    EXPECT_EQ("foo 0 100,bar 1 200,meh 2 500", Join(all_three, ","));
+
+    std::vector<std::string> last_two_unsafe;
+    for (const auto& e : impl.IterateUnsafe(std::chrono::microseconds(150))) {
+      last_two_unsafe.push_back(e);
+    }
+    EXPECT_EQ(
+        "{\"index\":1,\"us\":200}\t{\"s\":\"bar\"},"
+        "{\"index\":2,\"us\":500}\t{\"s\":\"meh\"}",
+        Join(last_two_unsafe, ","));
+
+    current::time::SetNow(std::chrono::microseconds(999));
+    impl.Publish(StorableString("blah"));
+    EXPECT_EQ(4u, impl.Size());
+  }
+
+  {
+    std::mutex mutex;
+    IMPL impl(mutex, namespace_name, persistence_file_name);
+    EXPECT_EQ(4u, impl.Size());
+    EXPECT_EQ(999, impl.CurrentHead().count());
+    std::vector<std::string> just_the_last_one;
+    for (const auto& e : impl.Iterate(3)) {
+      just_the_last_one.push_back(e.entry.s);
+    }
+    EXPECT_EQ("blah", Join(just_the_last_one, ","));
+  }
+
+  {
+    // Different signature.
+    std::mutex mutex;
+    ASSERT_THROW(current::persistence::Binary<std::string>(mutex, namespace_name, persistence_file_name),
+                 current::persistence::InvalidStreamSignature);
+  }
+
+  {
+    // The lengths of the signature and of the first record are corrupted, and are not allocated as such.
+    const std::string contents = current::FileSystem::ReadFileAsString(persistence_file_name);
+    const std::string corrupted_file_name = persistence_file_name + ".corrupted";
+    const auto corrupted_file_remover = current::FileSystem::ScopedRmFile(corrupted_file_name);
+    const size_t first_record_offset = 16u + current::persistence::impl::binary::GetUInt32(contents.data() + 12u);
+    std::mutex mutex;
+    {
+      std::string corrupted = contents;
+      current::persistence::impl::binary::PutUInt32(&corrupted[12u], 0xffffffffu);
+      current::FileSystem::WriteStringToFile(corrupted, corrupted_file_name.c_str());
+      ASSERT_THROW(IMPL(mutex, namespace_name, corrupted_file_name), current::persistence::MalformedEntryException);
+    }
+    {
+      std::string corrupted = contents;
+      current::persistence::impl::binary::PutUInt32(&corrupted[first_record_offset], 0x7fffffffu);
+      current::FileSystem::WriteStringToFile(corrupted, corrupted_file_name.c_str());
+      ASSERT_THROW(IMPL(mutex, namespace_name, corrupted_file_name), current::persistence::MalformedEntryException);
+    }
+  }
+
+  {
+    // The payload of the last record is corrupted.
+    std::string contents = current::FileSystem::ReadFileAsString(persistence_file_name);
+    ASSERT_EQ('h', contents[contents.length() - 1u]);
+    contents[contents.length() - 1u] = 'H';
+    current::FileSystem::WriteStringToFile(contents, persistence_file_name.c_str());
+    std::mutex mutex;
+    ASSERT_THROW(IMPL(mutex, namespace_name, persistence_file_name),
+                 current::persistence::BinaryRecordChecksumMismatchException);
+  }
+
+  {
+    // The last record is truncated.
+    std::string contents = current::FileSystem::ReadFileAsString(persistence_file_name);
+    current::FileSystem::WriteStringToFile(contents.substr(0u, contents.length() - 1u),
+                                           persistence_file_name.c_str());
+    std::mutex mutex;
+    ASSERT_THROW(IMPL(mutex, namespace_name, persistence_file_name), current::persistence::MalformedEntryException);
+  }
+}
+
+TEST(PersistenceLayer, BinaryConversion) {
+  current::time::ResetToZero();
+
+  using namespace persistence_test;
+
+  const auto namespace_name = current::ss::StreamNamespaceName("namespace", "entry_name");
+  const std::string text_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data");
+  const auto text_file_remover = current::FileSystem::ScopedRmFile(text_file_name);
+  const std::string binary_file_name = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data.bin");
+  const auto binary_file_remover = current::FileSystem::ScopedRmFile(binary_file_name);
+  const std::string text_file_name_2 = current::FileSystem::JoinPath(FLAGS_persistence_test_tmpdir, "data.2");
+  const auto text_file_remover_2 = current::FileSystem::ScopedRmFile(text_file_name_2);
+
+  // Realistic timestamps, to have the sizes of the text and the binary files comparable.
+  const std::chrono::microseconds kEpoch(1500000000000000ll);
+
+  {
+    std::mutex mutex;
+    current::persistence::File<StorableString> impl(mutex, namespace_name, text_file_name);
+    for (int i = 1; i <= 100; ++i) {
+      impl.Publish(StorableString(current::ToString(i)), kEpoch + std::chrono::microseconds(i * 10));
+    }
+    impl.UpdateHead(kEpoch + std::chrono::microseconds(2000));
+  }
+
+  EXPECT_EQ(100u,
+            (current::persistence::ConvertFileToBinary<StorableString>(
+                text_file_name, binary_file_name, namespace_name)));
+
+  {
+    std::mutex mutex;
+    current::persistence::Binary<StorableString> impl(mutex, namespace_name, binary_file_name);
+    EXPECT_EQ(100u, impl.Size());
+    EXPECT_EQ((kEpoch + std::chrono::microseconds(2000)).count(), impl.CurrentHead().count());
+    int expected = 1;
+    for (const auto& e : impl.Iterate()) {
+      EXPECT_EQ(current::ToString(expected), e.entry.s);
+      EXPECT_EQ((kEpoch + std::chrono::microseconds(expected * 10)).count(), e.idx_ts.us.count());
+      ++expected;
+    }
+    // The binary file is more compact than the text one, as it does not store the JSON-ified index and timestamp.
+    EXPECT_LT(current::FileSystem::GetFileSize(binary_file_name), current::FileSystem::GetFileSize(text_file_name));
+  }
+
+  ASSERT_THROW((current::persistence::ConvertFileToBinary<StorableString>(
+                   text_file_name, binary_file_name, namespace_name)),
+               current::persistence::PersistenceFileNotEmpty);
+
+  EXPECT_EQ(100u,
+            (current::persistence::ConvertBinaryToFile<StorableString>(
+                binary_file_name, text_file_name_2, namespace_name)));
+  EXPECT_EQ(current::FileSystem::ReadFileAsString(text_file_name),
+            current::FileSystem::ReadFileAsString(text_file_name_2));
+}
+
 TEST(PersistenceLayer, Exceptions) {
   using namespace persistence_test;
   using IMPL = current::persistence::File<StorableString>;
@@ -1026,3 +1702,44 @@ TEST(PersistenceLayer, Exceptions) {
     EXPECT_THROW(IMPL impl(mutex, namespace_name, persistence_file_name), InconsistentTimestampException);
   }
 }
+
+TEST(PersistenceLayer, IndexAndTimestampPrefix) {
+  using current::persistence::ScanIndexAndTimestampPrefix;
+  using current::persistence::ParseIndexAndTimestampPrefix;
+
+  const auto scan = [](const std::string& s) {
+    idxts_t idxts;
+    return ScanIndexAndTimestampPrefix(s.data(), s.data() + s.length(), idxts)
+               ? current::ToString(idxts.index) + '@' + current::ToString(idxts.us.count())
+               : "N/A";
+  };
+
+  EXPECT_EQ("42@1000", scan("{\"index\":42,\"us\":1000}"));
+  EXPECT_EQ("0@0", scan("{\"index\":0,\"us\":0}"));
+  EXPECT_EQ("42@1000", scan(JSON(idxts_t(42u, std::chrono::microseconds(1000)))));
+  EXPECT_EQ("123456789012345678@1", scan("{\"index\":123456789012345678,\"us\":1}"));
+
+  // Anything but the exact format of `JSON(idxts_t)` is not scanned.
+  EXPECT_EQ("N/A", scan(""));
+  EXPECT_EQ("N/A", scan("{\"index\":42,\"us\":1000"));
+  EXPECT_EQ("N/A", scan("{\"index\":42,\"us\":1000}x"));
+  EXPECT_EQ("N/A", scan("{\"index\":,\"us\":1000}"));
+  EXPECT_EQ("N/A", scan("{\"index\":-1,\"us\":1000}"));
+  EXPECT_EQ("N/A", scan("{\"index\": 42, \"us\": 1000}"));
+  EXPECT_EQ("N/A", scan("{\"us\":1000,\"index\":42}"));
+  EXPECT_EQ("N/A", scan("{\"index\":1234567890123456789,\"us\":1}"));
+
+  // The prefix that is not scanned is parsed as JSON.
+  {
+    const idxts_t idxts = ParseIndexAndTimestampPrefix("{\"index\":42,\"us\":1000}\t{\"s\":\"foo\"}", 22u);
+    EXPECT_EQ(42u, idxts.index);
+    EXPECT_EQ(1000, idxts.us.count());
+  }
+  {
+    const idxts_t idxts = ParseIndexAndTimestampPrefix("{\"us\":1000, \"index\":42}\t{\"s\":\"foo\"}", 23u);
+    EXPECT_EQ(42u, idxts.index);
+    EXPECT_EQ(1000, idxts.us.count());
+  }
+  EXPECT_THROW(ParseIndexAndTimestampPrefix("{\"index\":\"x\"}\t{}", 13u),
+               current::serialization::json::TypeSystemParseJSONException);
+}
@@ -70,16 +70,10 @@ class EntryPersister : public GenericEntryPersister<ENTRY>, public IMPL {
   }
 
   // Publishes the `raw_log_line` as is without parsing and validating its content.
+  // The index and the timestamp are taken from the `raw_log_line` itself.
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
-  idxts_t PublishUnsafe(const std::string& raw_log_line,
-                        current::time::DefaultTimeArgument = current::time::DefaultTimeArgument()) {
-    return IMPL::template PersisterPublishUnsafeImpl<MLS>(raw_log_line, current::time::DefaultTimeArgument());
-  }
-
-  // Publishes the `raw_log_line` as is without parsing and validating its content.
-  template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
-  idxts_t PublishUnsafe(const std::string& raw_log_line, std::chrono::microseconds us) {
-    return IMPL::template PersisterPublishUnsafeImpl<MLS>(raw_log_line, us);
+  idxts_t PublishUnsafe(const std::string& raw_log_line) {
+    return IMPL::template PersisterPublishUnsafeImpl<MLS>(raw_log_line);
   }
 
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
@@ -147,6 +141,33 @@ class EntryPersister : public GenericEntryPersister<ENTRY>, public IMPL {
                                     std::chrono::microseconds till = std::chrono::microseconds(-1)) const {
     return IMPL::template PersisterIterateUnsafe<MLS>(from, till);
   }
+
+  // Iterates over "raw" log lines as `current::strings::Chunk`-s, with no copies, if the persister supports it.
+  template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock, typename I = IMPL>
+  typename I::IterableRangeMapped IterateMapped(uint64_t begin = static_cast<uint64_t>(0),
+                                                uint64_t end = static_cast<size_t>(-1)) const {
+    return I::template PersisterIterateMapped<MLS>(begin, end);
+  }
+
+  template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock, typename I = IMPL>
+  typename I::IterableRangeMapped IterateMapped(std::chrono::microseconds from,
+                                                std::chrono::microseconds till = std::chrono::microseconds(-1)) const {
+    return I::template PersisterIterateMapped<MLS>(from, till);
+  }
+};
+
+// Whether the persister supports `IterateMapped()`.
+template <typename T>
+struct HasMappedIteration {
+  template <typename U>
+  static constexpr bool Check(typename U::IterableRangeMapped*) {
+    return true;
+  }
+  template <typename>
+  static constexpr bool Check(...) {
+    return false;
+  }
+  static constexpr bool value = Check<T>(nullptr);
 };
 
 // For `static_assert`-s.
@@ -28,10 +28,13 @@ SOFTWARE.
 
 #include "../../port.h"
 
+#include <vector>
+
 #include "idx_ts.h"
 #include "types.h"
 
 #include "../../typesystem/variant.h"
+#include "../../bricks/strings/chunk.h"
 #include "../../bricks/time/chrono.h"
 #include "../../bricks/sync/locks.h"
 
@@ -122,6 +125,28 @@ struct IsStreamPublisher {
 enum class EntryResponse { Done = 0, More = 1 };
 enum class TerminationResponse { Wait = 0, Terminate = 1 };
 
+// The subscribers can opt in to receive the entries in batches, by handling
+// `EntryResponse operator()(const std::vector<BatchedEntry<ENTRY>>& batch, idxts_t last)` for checked subscriptions,
+// and `EntryResponse operator()(const std::vector<BatchedRawLogLine>& batch, idxts_t last)` for unchecked ones.
+// A batch is a run of consecutive entries (of the subscribed to type), of up to `MaxBatchSize()` entries,
+// if the subscriber defines it, or `kDefaultMaxBatchSize` otherwise. The batch is only valid within the call.
+// Returning `EntryResponse::Done` ends the subscription after the batch.
+constexpr size_t kDefaultMaxBatchSize = 1000u;
+
+template <typename ENTRY>
+struct BatchedEntry {
+  const ENTRY& entry;
+  idxts_t current;
+  BatchedEntry(const ENTRY& entry, idxts_t current) : entry(entry), current(current) {}
+};
+
+struct BatchedRawLogLine {
+  current::strings::Chunk raw_log_line;
+  uint64_t current_index;
+  BatchedRawLogLine(current::strings::Chunk raw_log_line, uint64_t current_index)
+      : raw_log_line(raw_log_line), current_index(current_index) {}
+};
+
 struct GenericSubscriber {};
 
 template <typename ENTRY>
@@ -139,11 +164,26 @@ class EntrySubscriber : public GenericEntrySubscriber<ENTRY>, public IMPL {
   EntryResponse operator()(const std::string& raw_log_line, uint64_t current_index, idxts_t last) {
     return IMPL::operator()(raw_log_line, current_index, last);
   }
+  EntryResponse operator()(const current::strings::Chunk& raw_log_line, uint64_t current_index, idxts_t last) {
+    return IMPL::operator()(raw_log_line, current_index, last);
+  }
   EntryResponse operator()(ENTRY&& e, idxts_t current, idxts_t last) {
     return IMPL::operator()(std::move(e), current, last);
   }
   EntryResponse operator()(std::chrono::microseconds ts) { return IMPL::operator()(ts); }
 
+  // Only present for the batch subscribers.
+  template <typename T, typename I = IMPL>
+  auto operator()(const std::vector<BatchedEntry<T>>& batch, idxts_t last)
+      -> decltype(std::declval<I&>()(batch, last)) {
+    return I::operator()(batch, last);
+  }
+  template <typename I = IMPL>
+  auto operator()(const std::vector<BatchedRawLogLine>& batch, idxts_t last)
+      -> decltype(std::declval<I&>()(batch, last)) {
+    return I::operator()(batch, last);
+  }
+
   // If a type-filtered subscriber hits the end which it doesn't see as the last entry does not pass the filter,
   // we need a way to ask that subscriber whether it wants to terminate or continue.
   EntryResponse EntryResponseIfNoMorePassTypeFilter() const { return IMPL::EntryResponseIfNoMorePassTypeFilter(); }
@@ -175,6 +215,34 @@ struct IsStreamSubscriber {
   static constexpr bool value = std::is_base_of<GenericStreamSubscriber<current::decay<E>>, current::decay<T>>::value;
 };
 
+template <typename T, typename E>
+struct IsBatchSubscriber {
+  template <typename F>
+  static constexpr bool Check(decltype(std::declval<F&>()(std::declval<const std::vector<BatchedEntry<E>>&>(),
+                                                          std::declval<idxts_t>()))*) {
+    return true;
+  }
+  template <typename F>
+  static constexpr bool Check(...) {
+    return false;
+  }
+  static constexpr bool value = Check<current::decay<T>>(nullptr);
+};
+
+template <typename T>
+struct IsRawBatchSubscriber {
+  template <typename F>
+  static constexpr bool Check(decltype(std::declval<F&>()(std::declval<const std::vector<BatchedRawLogLine>&>(),
+                                                          std::declval<idxts_t>()))*) {
+    return true;
+  }
+  template <typename F>
+  static constexpr bool Check(...) {
+    return false;
+  }
+  static constexpr bool value = Check<current::decay<T>>(nullptr);
+};
+
 namespace impl {
 
 template <typename TYPE_SUBSCRIBED_TO, typename STREAM_UNDERLYING_VARIANT>
@@ -209,6 +277,28 @@ struct PassEntryToSubscriberIfTypeMatchesImpl<T, T> {
   }
 };
 
+template <typename TYPE_SUBSCRIBED_TO, typename STREAM_UNDERLYING_VARIANT>
+struct AppendEntryToBatchIfTypeMatchesImpl {
+  static bool Append(std::vector<BatchedEntry<TYPE_SUBSCRIBED_TO>>& batch,
+                     const STREAM_UNDERLYING_VARIANT& entry,
+                     idxts_t current) {
+    if (Exists<TYPE_SUBSCRIBED_TO>(entry)) {
+      batch.emplace_back(Value<TYPE_SUBSCRIBED_TO>(entry), current);
+      return true;
+    } else {
+      return false;
+    }
+  }
+};
+
+template <typename T>
+struct AppendEntryToBatchIfTypeMatchesImpl<T, T> {
+  static bool Append(std::vector<BatchedEntry<T>>& batch, const T& entry, idxts_t current) {
+    batch.emplace_back(entry, current);
+    return true;
+  }
+};
+
 }  // namespace current::ss::impl
 
 template <typename TYPE_SUBSCRIBED_TO, typename STREAM_UNDERLYING_VARIANT, typename F, typename G, typename E>
@@ -217,6 +307,15 @@ EntryResponse PassEntryToSubscriberIfTypeMatches(F&& f, G&& fallback, E&& entry,
       std::forward<F>(f), std::forward<G>(fallback), std::forward<E>(entry), current, last);
 }
 
+// The batch counterpart of `PassEntryToSubscriberIfTypeMatches`. Returns whether the entry was added to the batch.
+template <typename TYPE_SUBSCRIBED_TO, typename STREAM_UNDERLYING_VARIANT>
+bool AppendEntryToBatchIfTypeMatches(std::vector<BatchedEntry<TYPE_SUBSCRIBED_TO>>& batch,
+                                     const STREAM_UNDERLYING_VARIANT& entry,
+                                     idxts_t current) {
+  return impl::AppendEntryToBatchIfTypeMatchesImpl<TYPE_SUBSCRIBED_TO, STREAM_UNDERLYING_VARIANT>::Append(
+      batch, entry, current);
+}
+
 }  // namespace current::ss
 }  // namespace current
 
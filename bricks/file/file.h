@@ -41,6 +41,7 @@ SOFTWARE.
 
 #ifndef CURRENT_WINDOWS
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
 #else
 #include <direct.h>
@@ -218,6 +219,24 @@ struct FileSystem {
     }
   }
 
+  // Flushes the contents of the file, or the entries of the directory, to the disk. Calling `SyncPath()` on
+  // the file before renaming it and on its directory after makes the rename durable. A no-op on Windows.
+  static inline void SyncPath(const std::string& file_or_directory_name) {
+#ifndef CURRENT_WINDOWS
+    const int fd = ::open(file_or_directory_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+      CURRENT_THROW(FileException(file_or_directory_name));
+    }
+    const int result = ::fsync(fd);
+    ::close(fd);
+    if (result) {
+      CURRENT_THROW(FileException(file_or_directory_name));
+    }
+#else
+    static_cast<void>(file_or_directory_name);
+#endif
+  }
+
   // TODO(dkorolev): Make OutputFile not as tightly coupled with std::ofstream as it is now.
   typedef std::ofstream OutputFile;
 
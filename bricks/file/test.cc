@@ -179,6 +179,21 @@ TEST(File, RenameFile) {
   ASSERT_THROW(FileSystem::RenameFile(fn1, fn2), FileException);
 }
 
+TEST(File, SyncPath) {
+  FileSystem::MkDir(FLAGS_file_test_tmpdir, FileSystem::MkDirParameters::Silent);
+
+  const std::string fn = FileSystem::JoinPath(FLAGS_file_test_tmpdir, "synced");
+  FileSystem::WriteStringToFile("data", fn.c_str());
+  FileSystem::SyncPath(fn);
+  FileSystem::SyncPath(FLAGS_file_test_tmpdir);
+  EXPECT_EQ("data", FileSystem::ReadFileAsString(fn));
+
+#ifndef CURRENT_WINDOWS
+  FileSystem::RmFile(fn);
+  ASSERT_THROW(FileSystem::SyncPath(fn), FileException);
+#endif
+}
+
 TEST(File, DirOperations) {
   // Required for Windows tests.
   FileSystem::MkDir(FLAGS_file_test_tmpdir, FileSystem::MkDirParameters::Silent);
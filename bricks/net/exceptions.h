@@ -106,6 +106,10 @@ struct ChunkSizeNotAValidHEXValue : HTTPException {};
 // AttemptedToSendHTTPResponseMoreThanOnce is a user code exception; not really an HTTP one.
 struct AttemptedToSendHTTPResponseMoreThanOnce : Exception {};
 
+// AttemptedToReadBodyOfMovedAwayRequest is a user code exception too, thrown when the body of the request is read
+// via the `Request` that has been moved into another one, which now owns the connection.
+struct AttemptedToReadBodyOfMovedAwayRequest : Exception {};
+
 }  // namespace net
 }  // namespace current
 
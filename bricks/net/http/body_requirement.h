@@ -29,6 +29,8 @@ SOFTWARE.
 
 #include <string>
 
+#include "codes.h"
+
 namespace current {
 namespace net {
 
@@ -36,6 +38,13 @@ inline bool NeedContentLengthHeader(const std::string& method) {
   return method == "POST" || method == "PUT" || method == "PATCH";
 }
 
+// The responses which never have a body, and thus have neither `Content-Length` nor `Content-Type`, RFC 7230 3.3.
+inline bool ResponseHasNoBody(HTTPResponseCodeValue code) {
+  const int value = static_cast<int>(code);
+  return (value >= 100 && value < 200) || code == HTTPResponseCodeValue::NoContent ||
+         code == HTTPResponseCodeValue::NotModified;
+}
+
 }  // namespace net
 }  // namespace current
 
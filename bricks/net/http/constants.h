@@ -49,6 +49,17 @@ constexpr char kContentLengthHeaderKey[] = "Content-Length";
 constexpr char kTransferEncodingHeaderKey[] = "Transfer-Encoding";
 constexpr char kTransferEncodingChunkedValue[] = "chunked";
 constexpr char kHTTPMethodOverrideHeaderKey[] = "X-HTTP-Method-Override";
+constexpr char kConnectionHeaderKey[] = "Connection";
+constexpr char kAcceptEncodingHeaderKey[] = "Accept-Encoding";
+constexpr char kContentEncodingHeaderKey[] = "Content-Encoding";
+
+// The responses with shorter bodies are not worth compressing, even if the client accepts it.
+constexpr size_t kMinCompressedBodySizeInBytes = 1024;
+
+// The buffers requests are read into are reused by the requests parsed later on the same thread.
+// Up to this many are kept per thread, and those grown larger than this are released instead.
+constexpr size_t kMaxPooledRequestBuffersPerThread = 16;
+constexpr size_t kMaxPooledRequestBufferSizeInBytes = 1024 * 1024;
 
 // By default:
 // * HTTP responses that use `struct Response` will have the CORS header set.
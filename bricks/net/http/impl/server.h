@@ -25,12 +25,26 @@ SOFTWARE.
 #ifndef BRICKS_NET_HTTP_IMPL_SERVER_H
 #define BRICKS_NET_HTTP_IMPL_SERVER_H
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifndef CURRENT_WINDOWS
+#include <poll.h>
+#endif  // CURRENT_WINDOWS
+
 #include "../body_requirement.h"
 #include "../codes.h"
 #include "../constants.h"
@@ -48,9 +62,13 @@ SOFTWARE.
 #include "../../../../typesystem/serialization/json.h"
 #include "../../../../typesystem/struct.h"
 
+#include "../../../strings/chunk.h"
 #include "../../../strings/split.h"
 #include "../../../strings/util.h"
 
+#include "../../../util/gzip.h"
+#include "../../../util/singleton.h"
+
 #include "../../../../blocks/url/url.h"
 
 #ifndef CURRENT_BRICKS_DEBUG_HTTP
@@ -62,7 +80,6 @@ SOFTWARE.
 #else
 
 #include "../../../strings/printf.h"
-#include "../../../util/singleton.h"
 
 #define CURRENT_BRICKS_LOG_HTTP_EVENT(...)                             \
   do {                                                                 \
@@ -98,6 +115,24 @@ inline EventsJournal& HTTPDataJournal() { return current::Singleton<EventsJourna
 // HTTP response helpers. Used from both `GenericHTTPRequestData` and `GenericHTTPServerConnection`.
 struct HTTPResponder {
   typedef enum { ConnectionClose, ConnectionKeepAlive } ConnectionType;
+  enum class ContentEncoding : int { Identity, GZip, Deflate };
+
+  // What has been negotiated with the client: whether the connection is kept open after the response,
+  // and whether the body of the response may be compressed.
+  struct ResponseMode final {
+    ConnectionType connection_type;
+    ContentEncoding content_encoding;
+    ResponseMode(ConnectionType connection_type, ContentEncoding content_encoding = ContentEncoding::Identity)
+        : connection_type(connection_type), content_encoding(content_encoding) {}
+  };
+
+  static const char* ContentEncodingAsString(ContentEncoding content_encoding) {
+    return content_encoding == ContentEncoding::GZip ? "gzip" : "deflate";
+  }
+  static gzip::Format ContentEncodingAsGZipFormat(ContentEncoding content_encoding) {
+    return content_encoding == ContentEncoding::GZip ? gzip::Format::GZip : gzip::Format::Deflate;
+  }
+
   static void PrepareHTTPResponseHeader(std::ostream& os,
                                         ConnectionType connection_type,
                                         HTTPResponseCodeValue code = HTTPResponseCode.OK,
@@ -105,7 +140,9 @@ struct HTTPResponder {
                                         const std::string& content_type = constants::kDefaultContentType) {
     os << "HTTP/1.1 " << static_cast<int>(code);
     os << " " << HTTPResponseCodeAsString(code) << constants::kCRLF;
-    os << "Content-Type: " << content_type << constants::kCRLF;
+    if (!ResponseHasNoBody(code)) {
+      os << "Content-Type: " << content_type << constants::kCRLF;
+    }
     os << "Connection: " << (connection_type == ConnectionKeepAlive ? "keep-alive" : "close") << constants::kCRLF;
     for (const auto& cit : headers) {
       os << cit.header << ": " << cit.value << constants::kCRLF;
@@ -123,61 +160,92 @@ struct HTTPResponder {
   }
 
   // The actual implementation of sending the HTTP response.
+  // The body is compressed if the client accepts it, unless it is short or already has its `Content-Encoding`.
   template <typename T>
   static void SendHTTPResponseImpl(Connection& connection,
+                                   ResponseMode mode,
                                    const T& begin,
                                    const T& end,
                                    HTTPResponseCodeValue code,
                                    const http::Headers& headers,
                                    const std::string& content_type) {
     std::ostringstream os;
-    PrepareHTTPResponseHeader(os, ConnectionClose, code, headers, content_type);
-    os << "Content-Length: " << (end - begin) << constants::kCRLF << constants::kCRLF;
-    connection.BlockingWrite(os.str(), true);
-    connection.BlockingWrite(begin, end, false);
+    PrepareHTTPResponseHeader(os, mode.connection_type, code, headers, content_type);
+    if (ResponseHasNoBody(code)) {
+      // Such as "304 Not Modified", which is all headers, whatever the body passed in.
+      os << constants::kCRLF;
+      connection.BlockingWrite(os.str(), false);
+    } else if (mode.content_encoding != ContentEncoding::Identity &&
+        static_cast<size_t>(end - begin) >= constants::kMinCompressedBodySizeInBytes &&
+        !headers.Has(constants::kContentEncodingHeaderKey)) {
+      const std::string body =
+          gzip::Compress(std::string(begin, end), ContentEncodingAsGZipFormat(mode.content_encoding));
+      os << constants::kContentEncodingHeaderKey << ": " << ContentEncodingAsString(mode.content_encoding)
+         << constants::kCRLF;
+      os << "Vary: " << constants::kAcceptEncodingHeaderKey << constants::kCRLF;
+      os << "Content-Length: " << body.length() << constants::kCRLF << constants::kCRLF;
+      connection.BlockingWrite(os.str(), true);
+      connection.BlockingWrite(body, false);
+    } else {
+      os << "Content-Length: " << (end - begin) << constants::kCRLF << constants::kCRLF;
+      connection.BlockingWrite(os.str(), true);
+      connection.BlockingWrite(begin, end, false);
+    }
   }
 
   // Only support STL containers of chars and bytes, this does not yet cover std::string.
   template <typename T>
   static ENABLE_IF<sizeof(typename T::value_type) == 1> SendHTTPResponse(
       Connection& connection,
+      ResponseMode mode,
       const T& begin,
       const T& end,
       HTTPResponseCodeValue code = HTTPResponseCode.OK,
       const std::string& content_type = constants::kDefaultContentType,
       const http::Headers& headers = http::Headers()) {
-    SendHTTPResponseImpl(connection, begin, end, code, headers, content_type);
+    SendHTTPResponseImpl(connection, mode, begin, end, code, headers, content_type);
   }
   template <typename T>
   static ENABLE_IF<sizeof(typename T::value_type) == 1> SendHTTPResponse(
       Connection& connection,
+      ResponseMode mode,
       T&& container,
       HTTPResponseCodeValue code = HTTPResponseCode.OK,
       const http::Headers& headers = http::Headers(),
       const std::string& content_type = constants::kDefaultContentType) {
-    SendHTTPResponseImpl(connection, container.begin(), container.end(), code, headers, content_type);
+    SendHTTPResponseImpl(connection, mode, container.begin(), container.end(), code, headers, content_type);
   }
 
   // Special case to handle std::string.
   static void SendHTTPResponse(Connection& connection,
+                               ResponseMode mode,
                                const std::string& string,
                                HTTPResponseCodeValue code = HTTPResponseCode.OK,
                                const http::Headers& headers = http::Headers(),
                                const std::string& content_type = constants::kDefaultContentType) {
-    SendHTTPResponseImpl(connection, string.begin(), string.end(), code, headers, content_type);
+    SendHTTPResponseImpl(connection, mode, string.begin(), string.end(), code, headers, content_type);
   }
 
   // Support `CURRENT_STRUCT`-s and `CURRENT_VARIANT`-s.
   template <class T>
   static ENABLE_IF<IS_CURRENT_STRUCT_OR_VARIANT(current::decay<T>)> SendHTTPResponse(
       Connection& connection,
+      ResponseMode mode,
       T&& object,
       HTTPResponseCodeValue code = HTTPResponseCode.OK,
       const http::Headers& headers = http::Headers(),
       const std::string& content_type = constants::kDefaultJSONContentType) {
     // TODO(dkorolev): We should probably make this not only correct but also efficient.
     const std::string s = JSON(std::forward<T>(object)) + '\n';
-    SendHTTPResponseImpl(connection, s.begin(), s.end(), code, headers, content_type);
+    SendHTTPResponseImpl(connection, mode, s.begin(), s.end(), code, headers, content_type);
+  }
+
+  // Without the explicit `ResponseMode`, the connection is closed after the response, and nothing is compressed.
+  template <typename T, typename... ARGS>
+  static ENABLE_IF<!std::is_same<current::decay<T>, ConnectionType>::value &&
+                   !std::is_same<current::decay<T>, ResponseMode>::value>
+  SendHTTPResponse(Connection& connection, T&& first, ARGS&&... args) {
+    SendHTTPResponse(connection, ConnectionClose, std::forward<T>(first), std::forward<ARGS>(args)...);
   }
 };
 
@@ -208,6 +276,186 @@ class HTTPDefaultHelper {
   std::string body_;
 };
 
+// HTTPZeroCopyHelper does not copy the headers into `http::Headers`; they are looked up in the buffer
+// the request was read into, via `HasHeader()` / `HeaderValue()` / `HeaderAt()` of `GenericHTTPRequestData`.
+class HTTPZeroCopyHelper {
+ public:
+  struct ConstructionParams {};
+  HTTPZeroCopyHelper(const ConstructionParams&) {}
+
+ protected:
+  HTTPZeroCopyHelper() = default;
+
+  inline void OnHeader(const char*, const char*) {}
+
+  inline void OnChunk(const char* chunk, size_t length) { body_.append(chunk, length); }
+
+  inline void OnChunkedBodyDone(const char*& begin, const char*& end) {
+    begin = body_.data();
+    end = begin + body_.length();
+  }
+
+ private:
+  std::string body_;
+};
+
+// The view of a header of the request, both the name and the value are null-terminated in place.
+struct HTTPHeaderView final {
+  strings::Chunk name;
+  strings::Chunk value;
+};
+
+// The memory `GenericHTTPRequestData` reads and parses the request into.
+struct HTTPRequestBuffer final {
+  struct HeaderOffsets final {
+    size_t name_offset;
+    size_t name_length;
+    size_t value_offset;
+    size_t value_length;
+  };
+  std::vector<char> bytes;
+  std::vector<HeaderOffsets> headers;
+  // The copy of the beginning of `bytes` through the headers, for the requests with chunked bodies only.
+  std::vector<char> headers_bytes;
+
+  const char* HeadersBase() const { return headers_bytes.empty() ? bytes.data() : headers_bytes.data(); }
+};
+
+// The per-thread pool of `HTTPRequestBuffer`-s, so that a thread serving request after request
+// does not allocate, and zero-fill, the memory to read each of them into anew.
+// A request destroyed on another thread than the one it was read on, as the ones handed over to an executor are,
+// frees its buffer instead, so that the buffers do not pile up in the pools of the threads that never read requests.
+class HTTPRequestBufferPool final {
+ public:
+  std::unique_ptr<HTTPRequestBuffer> Acquire() {
+    if (buffers_.empty()) {
+      return std::make_unique<HTTPRequestBuffer>();
+    }
+    std::unique_ptr<HTTPRequestBuffer> buffer = std::move(buffers_.back());
+    buffers_.pop_back();
+    return buffer;
+  }
+
+  void Release(std::unique_ptr<HTTPRequestBuffer> buffer) {
+    if (buffer && buffers_.size() < constants::kMaxPooledRequestBuffersPerThread &&
+        buffer->bytes.capacity() <= constants::kMaxPooledRequestBufferSizeInBytes) {
+      buffer->headers.clear();
+      buffer->headers_bytes.clear();
+      buffers_.push_back(std::move(buffer));
+    }
+  }
+
+  size_t Size() const { return buffers_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<HTTPRequestBuffer>> buffers_;
+};
+
+// Tells whether `[begin, end)` starts with a complete HTTP request, without parsing it, for the servers that read
+// requests with non-blocking calls before passing them on to the blocking `GenericHTTPRequestData`.
+// Returns the length of the first request, including its body, or zero if more data is needed.
+// The requests `GenericHTTPRequestData` would reject, such as those with invalid chunk sizes or too large bodies,
+// are reported as complete, so that the error response is sent right away.
+inline size_t CompleteHTTPRequestLength(const char* begin, const char* end) {
+  const auto find_crlf = [end](const char* from) -> const char* {
+    for (const char* p = from; p + 1 < end; ++p) {
+      if (p[0] == '\r' && p[1] == '\n') {
+        return p;
+      }
+    }
+    return nullptr;
+  };
+  const auto header_name_equals = [](const char* name, const char* name_end, const char* golden) {
+    const auto normalize = [](char c) { return c != '_' ? static_cast<char>(std::tolower(c)) : '-'; };
+    while (name < name_end && *golden) {
+      if (normalize(*name++) != normalize(*golden++)) {
+        return false;
+      }
+    }
+    return name == name_end && !*golden;
+  };
+  const auto trimmed = [](const char* b, const char* e) {
+    while (b < e && (*b == ' ' || *b == '\t')) {
+      ++b;
+    }
+    while (e > b && (*(e - 1) == ' ' || *(e - 1) == '\t')) {
+      --e;
+    }
+    return std::string(b, e);
+  };
+
+  const char* p = begin;
+  // The blank lines before the first one are ignored, as they are by `GenericHTTPRequestData`.
+  while (p + 1 < end && p[0] == '\r' && p[1] == '\n') {
+    p += constants::kCRLFLength;
+  }
+  const char* first_line_end = find_crlf(p);
+  if (!first_line_end) {
+    return 0u;
+  }
+  const std::string method(p, std::find(p, first_line_end, ' '));
+  size_t content_length = static_cast<size_t>(-1);
+  bool chunked = false;
+  p = first_line_end + constants::kCRLFLength;
+  while (true) {
+    const char* line_end = find_crlf(p);
+    if (!line_end) {
+      return 0u;
+    }
+    if (line_end == p) {
+      p += constants::kCRLFLength;
+      break;
+    }
+    const char* colon = std::find(p, line_end, constants::kHeaderKeyValueSeparator);
+    if (colon != line_end) {
+      if (header_name_equals(p, colon, constants::kContentLengthHeaderKey)) {
+        content_length = static_cast<size_t>(atoi(trimmed(colon + 1, line_end).c_str()));
+      } else if (header_name_equals(p, colon, constants::kTransferEncodingHeaderKey)) {
+        const std::string value = trimmed(colon + 1, line_end);
+        chunked = header_name_equals(value.data(), value.data() + value.length(), constants::kTransferEncodingChunkedValue);
+      }
+    }
+    p = line_end + constants::kCRLFLength;
+  }
+  if (!chunked) {
+    if (content_length == static_cast<size_t>(-1)) {
+      return p - begin;
+    } else if (content_length > constants::kMaxHTTPPayloadSizeInBytes) {
+      return end - begin;
+    } else {
+      return static_cast<size_t>(end - p) >= content_length ? (p - begin) + content_length : 0u;
+    }
+  }
+  while (true) {
+    const char* line_end = find_crlf(p);
+    if (!line_end) {
+      return 0u;
+    }
+    if (line_end == p) {
+      p += constants::kCRLFLength;  // The CRLF after the chunk data.
+      continue;
+    }
+    char* hex_end;
+    const std::string hex(p, line_end);
+    const size_t chunk_length = static_cast<size_t>(std::strtoul(hex.c_str(), &hex_end, 16));
+    if (hex_end == hex.c_str()) {
+      return end - begin;
+    }
+    p = line_end + constants::kCRLFLength;
+    if (!chunk_length) {
+      // Include the final CRLF if it has been received already.
+      if (p + 1 < end && p[0] == '\r' && p[1] == '\n') {
+        p += constants::kCRLFLength;
+      }
+      return p - begin;
+    }
+    if (static_cast<size_t>(end - p) < chunk_length) {
+      return 0u;
+    }
+    p += chunk_length;
+  }
+}
+
 // In constructor, GenericHTTPRequestData parses HTTP response from `Connection&` is was provided with.
 // Extracts method, path (URL + parameters), and, if provided, the body.
 //
@@ -216,6 +464,13 @@ class HTTPDefaultHelper {
 // * std::string RawPath() (the URL before parsing).
 // * std::string Method().
 // * std::string Body(), size_t BodyLength(), const char* Body{Begin,End}().
+// * bool HasHeader(name), strings::Chunk HeaderValue(name), HTTPHeaderView HeaderAt(index), size_t HeadersCount().
+//
+// The request is read into, and parsed within, a buffer from the per-thread `HTTPRequestBufferPool`.
+// The headers are available as zero-copy views into this buffer, regardless of the `HELPER`.
+//
+// If `stream_body` is provided, it is called once the headers of a request with a body have been parsed,
+// and, should it return true, the body is not read, see `BodyIsStreamed()`.
 //
 // Exceptions:
 // * ConnectionResetByPeer       : When the server is using chunked transfer and doesn't fully send one.
@@ -228,8 +483,14 @@ class GenericHTTPRequestData : public HELPER {
       Connection& c,
       const typename HELPER::ConstructionParams& params = typename HELPER::ConstructionParams(),
       const int initial_buffer_size = 16 * 1024 + 1,
-      const double buffer_growth_k = 1.95)
-      : HELPER(params), buffer_(initial_buffer_size) {
+      const double buffer_growth_k = 1.95,
+      const std::function<bool(const GenericHTTPRequestData&)>& stream_body = nullptr)
+      : HELPER(params),
+        origin_pool_(current::ThreadLocalSingleton<HTTPRequestBufferPool>()),
+        pooled_buffer_(origin_pool_.Acquire()),
+        buffer_(pooled_buffer_->bytes) {
+    buffer_.resize(initial_buffer_size);
+
     // `offset` is the number of bytes read into `buffer_` so far.
     // `length_cap` is infinity first (size_t is unsigned), and it changes/ to the absolute offset
     // of the end of HTTP body in the buffer_, once `Content-Length` and two consecutive CRLS have been seen.
@@ -290,14 +551,29 @@ class GenericHTTPRequestData : public HELPER {
         if (!first_line_parsed) {
           if (!line_is_blank) {
             // It's recommended by W3 to wait for the first line ignoring prior CRLF-s.
-            const std::vector<std::string> pieces =
-                strings::Split<strings::ByWhitespace>(&buffer_[current_line_offset]);
-            if (pieces.size() >= 1) {
-              method_ = pieces[0];
-            }
-            if (pieces.size() >= 2) {
-              raw_path_ = pieces[1];
-              url_ = current::url::URL(raw_path_);
+            // The method, the URL, and the HTTP version are split in place, without copying the line.
+            const auto IsSpace = [](const char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+            char* token = &buffer_[current_line_offset];
+            for (size_t i = 0; i < 3u; ++i) {
+              while (*token && IsSpace(*token)) {
+                ++token;
+              }
+              if (!*token) {
+                break;
+              }
+              char* token_end = token;
+              while (*token_end && !IsSpace(*token_end)) {
+                ++token_end;
+              }
+              if (i == 0u) {
+                method_.assign(token, token_end);
+              } else if (i == 1u) {
+                raw_path_.assign(token, token_end);
+                url_ = current::url::URL(raw_path_);
+              } else {
+                http_version_.assign(token, token_end);
+              }
+              token = token_end;
             }
             first_line_parsed = true;
           }
@@ -320,6 +596,8 @@ class GenericHTTPRequestData : public HELPER {
             if (chunk_length == 0) {
               // Done with the body.
               HELPER::OnChunkedBodyDone(body_buffer_begin_, body_buffer_end_);
+              body_is_delimited_ = true;
+              ReturnUnparsedBytes(c, next_line_offset, offset);
               return;
             } else {
               // A chunk of length `chunk_length` bytes starts right at next_line_offset.
@@ -381,19 +659,19 @@ class GenericHTTPRequestData : public HELPER {
             }
             *next_crlf_ptr = '\0';
 
+            pooled_buffer_->headers.push_back({static_cast<size_t>(key - &buffer_[0]),
+                                               static_cast<size_t>(p - 1 - key),
+                                               static_cast<size_t>(value - &buffer_[0]),
+                                               static_cast<size_t>(next_crlf_ptr - value)});
             HELPER::OnHeader(key, value);
             if (HeaderNameEquals(key, constants::kContentLengthHeaderKey)) {
               body_length = static_cast<size_t>(atoi(value));
-              if (body_length > constants::kMaxHTTPPayloadSizeInBytes) {
-                HTTPResponder::SendHTTPResponse(c,
-                                                net::DefaultRequestEntityTooLargeMessage(),
-                                                HTTPResponseCode.RequestEntityTooLarge,
-                                                http::Headers(),
-                                                net::constants::kDefaultHTMLContentType);
-                CURRENT_THROW(HTTPPayloadTooLarge());
-              }
             } else if (HeaderNameEquals(key, constants::kHTTPMethodOverrideHeaderKey)) {
               method_ = current::strings::ToUpper(value);
+            } else if (HeaderNameEquals(key, constants::kConnectionHeaderKey)) {
+              connection_header_ = current::strings::ToLower(value);
+            } else if (HeaderNameEquals(key, constants::kAcceptEncodingHeaderKey)) {
+              accept_encoding_ = current::strings::ToLower(value);
             } else if (HeaderNameEquals(key, constants::kTransferEncodingHeaderKey)) {
               if (HeaderNameEquals(value, constants::kTransferEncodingChunkedValue)) {
                 chunked_transfer_encoding = true;
@@ -402,6 +680,16 @@ class GenericHTTPRequestData : public HELPER {
           }
         } else {
           CURRENT_BRICKS_LOG_HTTP_EVENT("http header is parsed\n");
+          if ((chunked_transfer_encoding || body_length != static_cast<size_t>(-1)) && stream_body &&
+              stream_body(*this)) {
+            // Leave the body in the connection, for the user code to read it as it arrives.
+            CURRENT_BRICKS_LOG_HTTP_EVENT("leave the body to be streamed\n");
+            body_is_streamed_ = true;
+            streamed_body_is_chunked_ = chunked_transfer_encoding;
+            streamed_body_length_ = chunked_transfer_encoding ? 0u : body_length;
+            ReturnUnparsedBytes(c, next_line_offset, offset);
+            return;
+          }
           // The blank line is what separates HTTP headers from HTTP body.
           if (!chunked_transfer_encoding) {
             // HTTP body starts right after this last CRLF.
@@ -409,6 +697,14 @@ class GenericHTTPRequestData : public HELPER {
             // Non-chunked encoding. Assume BODY follows as raw data.
             // Only accept HTTP body if Content-Length has been set; ignore it otherwise.
             if (body_length != static_cast<size_t>(-1)) {
+              if (body_length > constants::kMaxHTTPPayloadSizeInBytes) {
+                HTTPResponder::SendHTTPResponse(c,
+                                                net::DefaultRequestEntityTooLargeMessage(),
+                                                HTTPResponseCode.RequestEntityTooLarge,
+                                                http::Headers(),
+                                                net::constants::kDefaultHTMLContentType);
+                CURRENT_THROW(HTTPPayloadTooLarge());
+              }
               // Has HTTP body to parse.
               length_cap = body_offset + body_length;
               // Keep in mind that `buffer_` should have the size of `length_cap + 1`, to include the `\0'.
@@ -423,6 +719,8 @@ class GenericHTTPRequestData : public HELPER {
               }
               body_buffer_begin_ = &buffer_[body_offset];
               body_buffer_end_ = body_buffer_begin_ + body_length;
+              body_is_delimited_ = true;
+              ReturnUnparsedBytes(c, length_cap, offset);
               return;
             } else {
               if (NeedContentLengthHeader(method_)) {
@@ -433,10 +731,16 @@ class GenericHTTPRequestData : public HELPER {
                                                 net::constants::kDefaultHTMLContentType);
                 CURRENT_THROW(HTTPRequestBodyLengthNotProvided());
               }
+              // The responses that never have a body, such as "304 Not Modified", end with their headers.
+              body_is_delimited_ = method_.compare(0, 5, "HTTP/") == 0 &&
+                                   ResponseHasNoBody(static_cast<HTTPResponseCodeValue>(atoi(raw_path_.c_str())));
+              ReturnUnparsedBytes(c, body_offset, offset);
               return;
             }
           } else {
             receiving_body_in_chunks = true;
+            // The chunks are moved to the beginning of the buffer as they are received, so the headers are set aside.
+            pooled_buffer_->headers_bytes.assign(buffer_.begin(), buffer_.begin() + next_line_offset);
           }
         }
         current_line_offset = next_line_offset;
@@ -457,21 +761,113 @@ class GenericHTTPRequestData : public HELPER {
     }
   }
 
+  ~GenericHTTPRequestData() {
+    HTTPRequestBufferPool& pool = current::ThreadLocalSingleton<HTTPRequestBufferPool>();
+    if (&pool == &origin_pool_) {
+      pool.Release(std::move(pooled_buffer_));
+    }
+  }
+
   inline const std::string& Method() const { return method_; }
   inline const current::url::URL& URL() const { return url_; }
   inline const std::string& RawPath() const { return raw_path_; }
+  inline const std::string& HTTPVersion() const { return http_version_; }
+
+  // Whether the other side is fine with the connection kept open: HTTP/1.1 connections are persistent unless
+  // `Connection: close` is sent, HTTP/1.0 ones only with `Connection: keep-alive`.
+  inline bool KeepAliveRequested() const {
+    // For the responses, parsed by the same code, the HTTP version is the first token, not the third one.
+    const std::string& version = (method_.compare(0, 5, "HTTP/") == 0) ? method_ : http_version_;
+    if (version == "HTTP/1.1") {
+      return connection_header_ != "close";
+    } else {
+      return connection_header_ == "keep-alive";
+    }
+  }
+
+  // Whether the other side has sent `Connection: keep-alive` explicitly. The client only pools the connections
+  // the server has announced it keeps alive, as a server may well close an HTTP/1.1 connection without saying so.
+  inline bool KeepAliveAnnounced() const { return connection_header_ == "keep-alive"; }
+
+  // Whether the end of the body was known from `Content-Length` or the chunked encoding. For the responses,
+  // the body is otherwise terminated by closing the connection, which then can not be reused.
+  inline bool HasDelimitedBody() const { return body_is_delimited_; }
+
+  // Whether the body was left unread in the connection, as `stream_body` has asked for once the headers were parsed.
+  // It then is read with `GenericHTTPServerConnection::ReadBody()`, and `Body()` is empty.
+  inline bool BodyIsStreamed() const { return body_is_streamed_; }
+  inline bool StreamedBodyIsChunked() const { return streamed_body_is_chunked_; }
+  inline size_t StreamedBodyLength() const { return streamed_body_length_; }  // From `Content-Length`, if not chunked.
+
+  // The compression of the response the client accepts, per its `Accept-Encoding`. Prefers gzip to deflate.
+  // Always `Identity` when built without zlib.
+  inline HTTPResponder::ContentEncoding AcceptedContentEncoding() const {
+    if (!gzip::kAvailable) {
+      return HTTPResponder::ContentEncoding::Identity;
+    }
+    bool gzip = false;
+    bool deflate = false;
+    for (const std::string& item : strings::Split(accept_encoding_, ',')) {
+      const std::vector<std::string> pieces = strings::Split(item, ';');
+      bool rejected = false;
+      for (size_t i = 1; i < pieces.size(); ++i) {
+        // The `q=0` quality value means "not acceptable".
+        const std::string param = strings::Trim(pieces[i]);
+        if (param.compare(0, 2, "q=") == 0 && std::atof(param.c_str() + 2) == 0.0) {
+          rejected = true;
+        }
+      }
+      if (!pieces.empty() && !rejected) {
+        const std::string coding = strings::Trim(pieces[0]);
+        if (coding == "gzip" || coding == "x-gzip") {
+          gzip = true;
+        } else if (coding == "deflate") {
+          deflate = true;
+        }
+      }
+    }
+    if (gzip) {
+      return HTTPResponder::ContentEncoding::GZip;
+    } else if (deflate) {
+      return HTTPResponder::ContentEncoding::Deflate;
+    } else {
+      return HTTPResponder::ContentEncoding::Identity;
+    }
+  }
+
+  // The headers of the request, in the order they were received, as views into its buffer.
+  // The names are compared case-insensitively, with '-' and '_' treated as equal. Unlike with `http::Headers`,
+  // the values of repeated headers are not concatenated, `HeaderValue()` returns the first one.
+  inline size_t HeadersCount() const { return pooled_buffer_->headers.size(); }
+
+  inline HTTPHeaderView HeaderAt(size_t index) const {
+    const auto& header = pooled_buffer_->headers[index];
+    return HTTPHeaderView{strings::Chunk(pooled_buffer_->HeadersBase() + header.name_offset, header.name_length),
+                          strings::Chunk(pooled_buffer_->HeadersBase() + header.value_offset, header.value_length)};
+  }
+
+  inline bool HasHeader(const strings::Chunk& name) const { return FindHeader(name) != nullptr; }
+
+  inline strings::Chunk HeaderValue(const strings::Chunk& name) const {
+    const auto header = FindHeader(name);
+    if (!header) {
+      CURRENT_THROW(http::HeaderNotFoundException(name));
+    }
+    return strings::Chunk(pooled_buffer_->HeadersBase() + header->value_offset, header->value_length);
+  }
 
   // Note that `Body*()` methods assume that the body was fully read into memory.
   // If other means of reading the body, for example, event-based chunk parsing, is used,
   // then `Body()` will return empty string and all other `Body*()` methods will return nullptr.
 
   inline const std::string& Body() const {
+    if (body_buffer_begin_ == body_buffer_end_) {
+      // Most requests, all the `GET` ones for a start, have no body, and it is not worth allocating.
+      static const std::string empty_body;
+      return empty_body;
+    }
     if (!prepared_body_) {
-      if (body_buffer_begin_) {
-        prepared_body_.reset(new std::string(body_buffer_begin_, body_buffer_end_));
-      } else {
-        prepared_body_.reset(new std::string());
-      }
+      prepared_body_.reset(new std::string(body_buffer_begin_, body_buffer_end_));
     }
     return *prepared_body_.get();
   }
@@ -490,6 +886,22 @@ class GenericHTTPRequestData : public HELPER {
   }
 
  private:
+  // The bytes read past the end of this request belong to the next, pipelined, one on the same connection.
+  void ReturnUnparsedBytes(Connection& c, size_t begin, size_t end) {
+    if (begin < end) {
+      c.PrependToReadBuffer(std::string(&buffer_[begin], &buffer_[end]));
+    }
+  }
+
+  const HTTPRequestBuffer::HeaderOffsets* FindHeader(const strings::Chunk& name) const {
+    for (const auto& header : pooled_buffer_->headers) {
+      if (HeaderNameEquals(pooled_buffer_->HeadersBase() + header.name_offset, name.c_str())) {
+        return &header;
+      }
+    }
+    return nullptr;
+  }
+
   static char NormalizeHeaderChar(char c) { return c != '_' ? std::tolower(c) : '-'; }
   static bool HeaderNameEquals(const char* lhs, const char* rhs) {
     while (*lhs && *rhs) {
@@ -504,11 +916,20 @@ class GenericHTTPRequestData : public HELPER {
   std::string method_;
   current::url::URL url_;
   std::string raw_path_;
+  std::string http_version_;
+  std::string connection_header_;
+  std::string accept_encoding_;
+  bool body_is_delimited_ = false;
+  bool body_is_streamed_ = false;
+  bool streamed_body_is_chunked_ = false;
+  size_t streamed_body_length_ = 0u;
 
   // HTTP parsing fields that have to be caried out of the parsing routine.
-  std::vector<char> buffer_;                 // The buffer into which data has been read, except for chunked case.
-  const char* body_buffer_begin_ = nullptr;  // If BODY has been provided, pointer pair to it.
-  const char* body_buffer_end_ = nullptr;    // Will not be nullptr if body_buffer_begin_ is not nullptr.
+  HTTPRequestBufferPool& origin_pool_;                // The pool of the thread the request is read on.
+  std::unique_ptr<HTTPRequestBuffer> pooled_buffer_;  // Goes back to `origin_pool_`, if destroyed on its thread.
+  std::vector<char>& buffer_;                         // The data read, except for the chunked body, if any.
+  const char* body_buffer_begin_ = nullptr;           // If BODY has been provided, pointer pair to it.
+  const char* body_buffer_end_ = nullptr;             // Will not be nullptr if body_buffer_begin_ is not nullptr.
 
   // HTTP body gets converted to an std::string representation as it's first requested.
   // TODO(dkorolev): This pattern is worth revisiting. StringPiece?
@@ -525,8 +946,195 @@ class GenericHTTPRequestData : public HELPER {
 // The default implementation is exposed as HTTPRequestData.
 using HTTPRequestData = GenericHTTPRequestData<HTTPDefaultHelper>;
 
+// The implementation that does not copy the headers, see `HTTPZeroCopyHelper`.
+using HTTPZeroCopyRequestData = GenericHTTPRequestData<HTTPZeroCopyHelper>;
+
 enum class ChunkFlush : bool { NoFlush = false, Flush = true };
 
+// How the chunks of a chunked response sent with `ChunkFlush::NoFlush` are buffered before being written out.
+// By default, up to the `CACHE_SIZE` of the `ChunkedResponseSender`, and until it is full or the next flush.
+// Use as `ChunkedResponseOptions().MaxBufferedBytes(64 * 1024).MaxLatency(std::chrono::milliseconds(50))`.
+struct ChunkedResponseOptions final {
+  size_t max_buffered_bytes = 0u;                                       // Zero for the `CACHE_SIZE`.
+  std::chrono::milliseconds max_latency = std::chrono::milliseconds(0);  // Zero for no bound.
+  bool non_blocking = false;
+
+  // The buffered chunks are written out once this many bytes are buffered.
+  ChunkedResponseOptions MaxBufferedBytes(size_t bytes) const {
+    ChunkedResponseOptions result = *this;
+    result.max_buffered_bytes = bytes;
+    return result;
+  }
+
+  // The buffered chunks are written out no later than this after the first of them was sent, even if no more
+  // chunks follow, for a response that is idle, such as a live tail of a stream, to not hold its data back.
+  ChunkedResponseOptions MaxLatency(std::chrono::milliseconds latency) const {
+    ChunkedResponseOptions result = *this;
+    result.max_latency = latency;
+    return result;
+  }
+
+  // The chunks are never written out blocking: whatever the socket does not take is kept, and the user code
+  // is to hold off sending more while `Backlogged()` is true, for one thread to serve many slow clients.
+  // Completing the response writes out the rest blocking, unless the client is backlogged, and then it is cut short.
+  ChunkedResponseOptions NonBlocking() const {
+    ChunkedResponseOptions result = *this;
+    result.non_blocking = true;
+    return result;
+  }
+};
+
+// The interface for `ChunkedResponseFlusher` to write out the buffered chunks of a response.
+// `FlushIfDue()` must not block, as a single thread flushes all the responses.
+struct ChunkedResponseFlushable {
+  virtual ~ChunkedResponseFlushable() = default;
+  virtual void FlushIfDue(std::chrono::steady_clock::time_point now) = 0;
+};
+
+// Writes out the buffered chunks of the responses with `ChunkedResponseOptions::MaxLatency()` once it has passed.
+// A single thread, started on first use, serves all of them. The responses are referred to weakly,
+// and the ones completed since are skipped.
+class ChunkedResponseFlusher final {
+ public:
+  ChunkedResponseFlusher() : thread_([this]() { Thread(); }) {}
+
+  ~ChunkedResponseFlusher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      terminating_ = true;
+    }
+    condition_variable_.notify_one();
+    thread_.join();
+  }
+
+  void Schedule(std::weak_ptr<ChunkedResponseFlushable> response, std::chrono::steady_clock::time_point deadline) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool earliest = (deadlines_.empty() || deadline < deadlines_.begin()->first);
+    deadlines_.emplace(deadline, std::move(response));
+    if (earliest) {
+      condition_variable_.notify_one();
+    }
+  }
+
+ private:
+  void Thread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!terminating_) {
+      if (deadlines_.empty()) {
+        condition_variable_.wait(lock);
+      } else {
+        const auto now = std::chrono::steady_clock::now();
+        if (now < deadlines_.begin()->first) {
+          condition_variable_.wait_until(lock, deadlines_.begin()->first);
+        } else {
+          std::vector<std::weak_ptr<ChunkedResponseFlushable>> due;
+          while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+            due.push_back(std::move(deadlines_.begin()->second));
+            deadlines_.erase(deadlines_.begin());
+          }
+          // Flush without the lock held, as the responses schedule their flushes while holding their own locks.
+          lock.unlock();
+          for (const auto& weak_response : due) {
+            const auto response = weak_response.lock();
+            if (response) {
+              response->FlushIfDue(now);
+            }
+          }
+          lock.lock();
+        }
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::multimap<std::chrono::steady_clock::time_point, std::weak_ptr<ChunkedResponseFlushable>> deadlines_;
+  bool terminating_ = false;
+  std::thread thread_;
+};
+
+// The interface for `ChunkedResponseWritabilityWatcher` to tell a non-blocking response its socket takes data again.
+struct ChunkedResponseWritable {
+  virtual ~ChunkedResponseWritable() = default;
+  virtual void OnWritable() = 0;
+};
+
+// Waits for the sockets of the non-blocking responses, see `ChunkedResponseOptions::NonBlocking()`, to take data
+// again, once they have not taken all of it. A single thread, started on first use, polls all of them.
+// The responses are referred to weakly, and the ones completed since are skipped.
+class ChunkedResponseWritabilityWatcher final {
+ public:
+  ChunkedResponseWritabilityWatcher() : thread_([this]() { Thread(); }) {}
+
+  ~ChunkedResponseWritabilityWatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      terminating_ = true;
+    }
+    condition_variable_.notify_one();
+    thread_.join();
+  }
+
+  // `OnWritable()` is called once, as soon as the socket takes data, or has failed.
+  void Watch(SOCKET socket, std::weak_ptr<ChunkedResponseWritable> response) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    watched_.emplace_back(socket, std::move(response));
+    condition_variable_.notify_one();
+  }
+
+ private:
+  // The sockets to watch added while the others are being polled are polled next time, at most this much later.
+  constexpr static int kPollIntervalMS = 10;
+
+  void Thread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!terminating_) {
+      if (watched_.empty()) {
+        condition_variable_.wait(lock);
+        continue;
+      }
+      std::vector<pollfd> fds(watched_.size());
+      for (size_t i = 0u; i < fds.size(); ++i) {
+        fds[i].fd = watched_[i].first;
+        fds[i].events = POLLOUT;
+        fds[i].revents = 0;
+      }
+      // Poll without the lock held, for the responses to be able to add themselves meanwhile, at the end.
+      lock.unlock();
+#ifndef CURRENT_WINDOWS
+      const int ready = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), kPollIntervalMS);
+#else
+      const int ready = ::WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), kPollIntervalMS);
+#endif  // CURRENT_WINDOWS
+      lock.lock();
+      if (ready > 0) {
+        std::vector<std::weak_ptr<ChunkedResponseWritable>> writable;
+        for (size_t i = fds.size(); i-- > 0u;) {
+          if (fds[i].revents) {
+            writable.push_back(std::move(watched_[i].second));
+            watched_.erase(watched_.begin() + static_cast<std::ptrdiff_t>(i));
+          }
+        }
+        // Without the lock held, as the responses add themselves while holding their own locks.
+        lock.unlock();
+        for (const auto& weak_response : writable) {
+          const auto response = weak_response.lock();
+          if (response) {
+            response->OnWritable();
+          }
+        }
+        lock.lock();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+  std::vector<std::pair<SOCKET, std::weak_ptr<ChunkedResponseWritable>>> watched_;
+  bool terminating_ = false;
+  std::thread thread_;
+};
+
 template <class HTTP_REQUEST_DATA>
 class GenericHTTPServerConnection final : public HTTPResponder {
  public:
@@ -536,9 +1144,23 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       Connection&& c,
       const typename HTTP_REQUEST_DATA::ConstructionParams& params = typename HTTP_REQUEST_DATA::ConstructionParams(),
       const int initial_buffer_size = 16 * 1024 + 1,
-      const double buffer_growth_k = 1.95)
-      : connection_(std::move(c)), message_(connection_, params, initial_buffer_size, buffer_growth_k) {}
+      const double buffer_growth_k = 1.95,
+      const std::function<bool(const GenericHTTPRequestData<HTTP_REQUEST_DATA>&)>& stream_body = nullptr)
+      : connection_(std::move(c)),
+        message_(connection_, params, initial_buffer_size, buffer_growth_k, stream_body),
+        content_encoding_(message_.AcceptedContentEncoding()) {}
+
+  // Stops reading the request after its headers if `stream_body` returns true for them, leaving the body,
+  // if there is one, to be read with `ReadBody()`.
+  GenericHTTPServerConnection(Connection&& c,
+                              const std::function<bool(const GenericHTTPRequestData<HTTP_REQUEST_DATA>&)>& stream_body)
+      : GenericHTTPServerConnection(std::move(c),
+                                    typename HTTP_REQUEST_DATA::ConstructionParams(),
+                                    16 * 1024 + 1,
+                                    1.95,
+                                    stream_body) {}
   ~GenericHTTPServerConnection() {
+    bool keep_alive = (keep_alive_ && connection_type_ == ConnectionKeepAlive);
     if (!responded_) {
       // If a user code throws an exception in a different thread, it will not be caught.
       // But, at least, capitalized "INTERNAL SERVER ERROR" will be returned.
@@ -546,6 +1168,7 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       // LCOV_EXCL_START
       try {
         HTTPResponder::SendHTTPResponse(connection_,
+                                        connection_type_,
                                         DefaultInternalServerErrorMessage(),
                                         HTTPResponseCode.InternalServerError,
                                         http::Headers(),
@@ -561,9 +1184,101 @@ class GenericHTTPServerConnection final : public HTTPResponder {
           std::cerr << "In: " << message_.Method() << ' ' << message_.RawPath() << std::endl;
           std::cerr << e.what() << std::endl;
         }
+        keep_alive = false;
       }
       // LCOV_EXCL_STOP
     }
+    if (keep_alive) {
+      try {
+        keep_alive_(std::move(connection_));
+      } catch (const std::exception& e) {                                                  // LCOV_EXCL_LINE
+        std::cerr << "Failed to keep the HTTP connection alive: " << e.what() << std::endl;  // LCOV_EXCL_LINE
+      }
+    }
+  }
+
+  // Keeps the connection open after the response, unless the client has asked to close it, and passes it on
+  // to `keep_alive` once this request is done with, for the server to serve the next request on it.
+  // Must be called before the response is sent.
+  void KeepAlive(std::function<void(Connection&&)> keep_alive) {
+    if (message_.KeepAliveRequested()) {
+      keep_alive_ = std::move(keep_alive);
+      connection_type_ = ConnectionKeepAlive;
+    } else {
+      connection_type_ = ConnectionClose;
+    }
+  }
+
+  // Reads up to `max_length` next bytes of the body of the request into `buffer`, returns zero once it is over.
+  // If the body was left in the connection, see `BodyIsStreamed()`, it is read from the socket as this is called,
+  // so that a slow reader slows down the client, instead of the body piling up in memory. The chunked body is decoded.
+  // A body longer than `LimitBodyLength()` is responded to with "413 Request Entity Too Large",
+  // and `HTTPPayloadTooLarge` is thrown. If the body is not read through, the connection is not kept alive.
+  size_t ReadBody(char* buffer, size_t max_length) {
+    if (!message_.BodyIsStreamed()) {
+      const size_t length = std::min(max_length, message_.BodyLength() - body_bytes_read_);
+      if (length) {
+        std::memcpy(buffer, message_.BodyBegin() + body_bytes_read_, length);
+        body_bytes_read_ += length;
+      }
+      return length;
+    }
+    if (body_read_through_ || !max_length) {
+      return 0u;
+    }
+    if (!message_.StreamedBodyIsChunked()) {
+      const size_t length = message_.StreamedBodyLength();
+      if (length > max_body_length_) {
+        RespondWithPayloadTooLarge();
+      }
+      if (body_bytes_read_ == length) {
+        OnStreamedBodyReadThrough();
+        return 0u;
+      }
+      const size_t bytes_read = ReadStreamedBodyBytes(buffer, std::min(max_length, length - body_bytes_read_));
+      body_bytes_read_ += bytes_read;
+      if (body_bytes_read_ == length) {
+        OnStreamedBodyReadThrough();
+      }
+      return bytes_read;
+    }
+    if (!body_chunk_bytes_left_) {
+      // The chunk size line, skipping the CRLF that terminates the previous chunk.
+      std::string line;
+      do {
+        line = ReadStreamedBodyLine();
+      } while (line.empty());
+      char* end;
+      const size_t chunk_length = static_cast<size_t>(std::strtoull(line.c_str(), &end, 16));
+      if (end == line.c_str()) {
+        RespondWithInvalidHEXChunkSize();
+      }
+      if (!chunk_length) {
+        // Done with the body, skip the trailer headers, if any, up to the blank line.
+        while (!ReadStreamedBodyLine().empty()) {
+        }
+        OnStreamedBodyReadThrough();
+        return 0u;
+      }
+      if (chunk_length > max_body_length_ - body_bytes_read_) {
+        RespondWithPayloadTooLarge();
+      }
+      body_chunk_bytes_left_ = chunk_length;
+    }
+    const size_t bytes_read = ReadStreamedBodyBytes(buffer, std::min(max_length, body_chunk_bytes_left_));
+    body_chunk_bytes_left_ -= bytes_read;
+    body_bytes_read_ += bytes_read;
+    return bytes_read;
+  }
+
+  // The longest body `ReadBody()` accepts, `kMaxHTTPPayloadSizeInBytes` by default. Responds with "413 Request Entity
+  // Too Large", and throws `HTTPPayloadTooLarge`, right away if the `Content-Length` of the request exceeds it.
+  void LimitBodyLength(size_t max_body_length) {
+    max_body_length_ = max_body_length;
+    if (message_.BodyIsStreamed() && !message_.StreamedBodyIsChunked() &&
+        message_.StreamedBodyLength() > max_body_length_) {
+      RespondWithPayloadTooLarge();
+    }
   }
 
   template <typename... ARGS>
@@ -571,62 +1286,251 @@ class GenericHTTPServerConnection final : public HTTPResponder {
     if (responded_) {
       CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
     } else {
-      HTTPResponder::SendHTTPResponse(connection_, std::forward<ARGS>(args)...);
+      CloseConnectionIfBodyIsNotReadThrough();
+      HTTPResponder::SendHTTPResponse(
+          connection_, ResponseMode(connection_type_, content_encoding_), std::forward<ARGS>(args)...);
+      responded_ = true;
+    }
+  }
+
+  // Sends `length` bytes of the open file `fd`, starting from `offset`, as the body of the response,
+  // without reading them into memory, see `Connection::BlockingSendFile()`. The body is not compressed.
+  void SendHTTPResponseFromFile(int fd,
+                                size_t offset,
+                                size_t length,
+                                HTTPResponseCodeValue code = HTTPResponseCode.OK,
+                                const http::Headers& headers = http::Headers(),
+                                const std::string& content_type = constants::kDefaultContentType) {
+    if (responded_) {
+      CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
+    } else {
+      CloseConnectionIfBodyIsNotReadThrough();
+      std::ostringstream os;
+      PrepareHTTPResponseHeader(os, connection_type_, code, headers, content_type);
+      os << "Content-Length: " << length << constants::kCRLF << constants::kCRLF;
+      connection_.BlockingWrite(os.str(), length != 0u);
+      connection_.BlockingSendFile(fd, offset, length);
       responded_ = true;
     }
   }
 
   // The wrapper to send HTTP response in chunks.
+  // The chunks sent with `ChunkFlush::NoFlush` are buffered, see `ChunkedResponseOptions`, and the chunks that
+  // do not fit the buffer, or are flushed, are written together with the buffered ones, with a single system call.
   template <uint64_t CACHE_SIZE>
   struct ChunkedResponseSender final {
-    // `struct Impl` is the logic wrapped into an `std::unique_ptr<>` to call the destructor only once.
-    struct Impl final {
-      explicit Impl(Connection& connection) : connection_(connection) {}
+    // `struct Impl` is the logic wrapped into an `std::shared_ptr<>` for `ChunkedResponseFlusher` to refer to it.
+    // The response is completed, once, by the destructor of the very `ChunkedResponseSender` that has it.
+    struct Impl final : ChunkedResponseFlushable, ChunkedResponseWritable, std::enable_shared_from_this<Impl> {
+      Impl(Connection& connection, ContentEncoding content_encoding, const ChunkedResponseOptions& options)
+          : connection_(connection),
+            max_buffered_bytes_(options.max_buffered_bytes ? options.max_buffered_bytes : CACHE_SIZE),
+            max_latency_(options.max_latency),
+            non_blocking_(options.non_blocking) {
+        if (content_encoding != ContentEncoding::Identity) {
+          compressor_ = std::make_unique<gzip::Compressor>(ContentEncodingAsGZipFormat(content_encoding));
+        }
+      }
 
-      ~Impl() {
+      void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resume_ = nullptr;
         if (!can_no_longer_write_) {
           try {
-            if (cache_size_) {
-              connection_.BlockingWrite(data_cache_, cache_size_, true);
+            if (due_bytes_) {
+              const size_t written = connection_.NonBlockingWrite(buffer_.data(), due_bytes_);
+              buffer_.erase(0u, written);
+              due_bytes_ -= written;
+            }
+            // Non-blocking only: the client not taking the data due by now is not waited for, it gets cut short.
+            if (!due_bytes_) {
+              if (compressor_) {
+                SendChunk(compressor_->Finish(), std::string(), ChunkFlush::NoFlush);
+              }
+              // The last chunk, with no trailer, is the zero-length one followed by two CRLF-s.
+              static const char last_chunk[] = "0\r\n\r\n";
+              const Connection::WriteBuffer buffers[] = {{buffer_.data(), buffer_.length()},
+                                                         {last_chunk, sizeof(last_chunk) - 1}};
+              connection_.BlockingWriteV(buffers, 2u, false);
             }
-            connection_.BlockingWrite("0", true);
-            // Should send CRLF twice.
-            connection_.BlockingWrite(constants::kCRLF, true);
-            connection_.BlockingWrite(constants::kCRLF, false);
           } catch (const SocketException& e) {                                          // LCOV_EXCL_LINE
             std::cerr << "Chunked response closure failed: " << e.what() << std::endl;  // LCOV_EXCL_LINE
           }                                                                             // LCOV_EXCL_LINE
         }
+        can_no_longer_write_ = true;
+        buffer_.clear();
+      }
+
+      // Writes out as much of the buffered data as the socket takes without blocking, and reschedules the rest.
+      // If the user code is sending a chunk at the moment, it is the next attempt that writes out the data.
+      void FlushIfDue(std::chrono::steady_clock::time_point now) override {
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+          current::Singleton<ChunkedResponseFlusher>().Schedule(this->shared_from_this(), now + max_latency_);
+          return;
+        }
+        if (can_no_longer_write_ || !flush_scheduled_ || now < flush_deadline_) {
+          return;
+        }
+        flush_scheduled_ = false;
+        try {
+          if (compressor_ && compressor_has_pending_data_) {
+            // Make everything compressed so far decompressible on the receiving end.
+            compressor_has_pending_data_ = false;
+            const std::string compressed = compressor_->Compress(nullptr, 0u, true);
+            if (!compressed.empty()) {
+              AppendChunkToBuffer(compressed);
+            }
+          }
+          if (!buffer_.empty()) {
+            buffer_.erase(0u, connection_.NonBlockingWrite(buffer_.data(), buffer_.length()));
+            if (!buffer_.empty()) {
+              ScheduleFlush();
+            }
+            if (non_blocking_) {
+              due_bytes_ = buffer_.length();
+            }
+          }
+        } catch (const current::Exception&) {
+          can_no_longer_write_ = true;
+          buffer_.clear();
+          due_bytes_ = 0u;
+        }
+      }
+
+      // Whether some of the data to be written out by now is still not, see `ChunkedResponseOptions::NonBlocking()`,
+      // once as much of it as the socket takes is. If so, `resume` is called, once, when the socket takes data again,
+      // for the user code to check this again and send more, unless the response is completed by then.
+      bool Backlogged(std::function<void()> resume) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!due_bytes_) {
+          return false;
+        }
+        try {
+          const size_t written = connection_.NonBlockingWrite(buffer_.data(), due_bytes_);
+          buffer_.erase(0u, written);
+          due_bytes_ -= written;
+        } catch (const SocketException&) {
+          can_no_longer_write_ = true;
+          buffer_.clear();
+          due_bytes_ = 0u;
+        }
+        if (!due_bytes_) {
+          return false;
+        }
+        resume_ = std::move(resume);
+        current::Singleton<ChunkedResponseWritabilityWatcher>().Watch(connection_.socket, this->shared_from_this());
+        return true;
+      }
+
+      // Calls `resume_` with the lock held, so that it is never called once `Close()` is done.
+      void OnWritable() override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (resume_) {
+          std::function<void()> resume = std::move(resume_);
+          resume_ = nullptr;
+          resume();
+        }
+      }
+
+      // With compression, the data is compressed as a single stream across the chunks. Each flush makes
+      // everything sent so far decompressible on the receiving end, so that the response stays incremental.
+      // The two parts, such as an entry and its trailing newline, go out as a single chunk, with no concatenation.
+      template <typename T1, typename T2>
+      void SendImpl(const T1& data1, const T2& data2, ChunkFlush flush) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (compressor_) {
+          if (!data1.empty() || !data2.empty() || flush == ChunkFlush::Flush) {
+            std::string compressed;
+            try {
+              compressed = compressor_->Compress(reinterpret_cast<const char*>(data1.data()),
+                                                 data1.size(),
+                                                 data2.empty() && flush == ChunkFlush::Flush);
+              if (!data2.empty()) {
+                compressed += compressor_->Compress(
+                    reinterpret_cast<const char*>(data2.data()), data2.size(), flush == ChunkFlush::Flush);
+              }
+            } catch (const GZipException&) {
+              can_no_longer_write_ = true;  // LCOV_EXCL_LINE
+              throw;                        // LCOV_EXCL_LINE
+            }
+            // The compressor holds back the data passed to it without a flush, so it is flushed on schedule too.
+            compressor_has_pending_data_ = (flush == ChunkFlush::NoFlush);
+            if (compressor_has_pending_data_) {
+              ScheduleFlush();
+            }
+            SendChunk(compressed, std::string(), flush);
+          }
+        } else {
+          SendChunk(data1, data2, flush);
+        }
       }
 
-      // The actual implementation of sending HTTP chunk data.
       template <typename T>
-      void SendImpl(T&& data, ChunkFlush flush) {
-        if (!data.empty() || (flush == ChunkFlush::Flush && cache_size_)) {
+      void SendImpl(const T& data, ChunkFlush flush) {
+        SendImpl(data, std::string(), flush);
+      }
+
+      // The actual implementation of sending HTTP chunk data, made of the two parts.
+      template <typename T1, typename T2>
+      void SendChunk(const T1& data1, const T2& data2, ChunkFlush flush) {
+        const size_t data1_bytes = data1.size() * sizeof(*data1.data());
+        const size_t data2_bytes = data2.size() * sizeof(*data2.data());
+        const size_t data_bytes = data1_bytes + data2_bytes;
+        if (data_bytes || (flush == ChunkFlush::Flush && !buffer_.empty())) {
           try {
-            if (!data.empty()) {
-              const auto chunk_header = strings::Printf("%lX", data.size()) + constants::kCRLF;
-              const auto chunk_size = chunk_header.size() + data.size() + constants::kCRLFLength;
-              if (cache_size_ && (flush == ChunkFlush::Flush || chunk_size > CACHE_SIZE - cache_size_)) {
-                connection_.BlockingWrite(data_cache_, cache_size_, true);
-                cache_size_ = 0;
+            char chunk_header[32];
+            const size_t chunk_header_length = !data_bytes ? 0u : static_cast<size_t>(snprintf(
+                chunk_header, sizeof(chunk_header), "%lX\r\n", static_cast<unsigned long>(data_bytes)));
+            const size_t chunk_size = !data_bytes ? 0u : chunk_header_length + data_bytes + constants::kCRLFLength;
+            if (non_blocking_ && (flush == ChunkFlush::Flush || due_bytes_ ||
+                                  buffer_.length() + chunk_size > max_buffered_bytes_)) {
+              if (can_no_longer_write_) {
+                CURRENT_THROW(SocketWriteException());
               }
-              if (flush == ChunkFlush::Flush || chunk_size > CACHE_SIZE) {
-                connection_.BlockingWrite(chunk_header, true);
-                connection_.BlockingWrite(std::forward<T>(data), true);
-                connection_.BlockingWrite(constants::kCRLF, false);
-              } else {
-                ::memcpy(data_cache_ + cache_size_, chunk_header.c_str(), chunk_header.size());
-                cache_size_ += chunk_header.size();
-                ::memcpy(data_cache_ + cache_size_, data.data(), data.size());
-                cache_size_ += data.size();
-                ::memcpy(data_cache_ + cache_size_, constants::kCRLF, constants::kCRLFLength);
-                cache_size_ += constants::kCRLFLength;
+              // As much of the buffered chunks and this one as the socket takes, and the rest is kept to be written.
+              const Connection::WriteBuffer buffers[] = {
+                  {buffer_.data(), buffer_.length()},
+                  {chunk_header, chunk_header_length},
+                  {data1.data(), data1_bytes},
+                  {data2.data(), data2_bytes},
+                  {constants::kCRLF, !data_bytes ? 0u : constants::kCRLFLength}};
+              size_t written = connection_.NonBlockingWriteV(buffers, 5u);
+              const size_t written_from_buffer = std::min(written, buffer_.length());
+              buffer_.erase(0u, written_from_buffer);
+              written -= written_from_buffer;
+              for (size_t i = 1u; i < 5u; ++i) {
+                if (written >= buffers[i].length) {
+                  written -= buffers[i].length;
+                } else {
+                  buffer_.append(static_cast<const char*>(buffers[i].data) + written, buffers[i].length - written);
+                  written = 0u;
+                }
               }
-            } else {
-              connection_.BlockingWrite(data_cache_, cache_size_, false);
-              cache_size_ = 0;
+              due_bytes_ = buffer_.length();
+              return;
             }
+            if (flush == ChunkFlush::Flush || buffer_.length() + chunk_size > max_buffered_bytes_) {
+              if (chunk_size > max_buffered_bytes_ || flush == ChunkFlush::Flush) {
+                // Write the buffered chunks and this one at once.
+                const Connection::WriteBuffer buffers[] = {
+                    {buffer_.data(), buffer_.length()},
+                    {chunk_header, chunk_header_length},
+                    {data1.data(), data1_bytes},
+                    {data2.data(), data2_bytes},
+                    {constants::kCRLF, !data_bytes ? 0u : constants::kCRLFLength}};
+                connection_.BlockingWriteV(buffers, 5u, false);
+                buffer_.clear();
+                return;
+              }
+              connection_.BlockingWrite(buffer_, false);
+              buffer_.clear();
+            }
+            ScheduleFlush();
+            buffer_.append(chunk_header, chunk_header_length);
+            buffer_.append(reinterpret_cast<const char*>(data1.data()), data1_bytes);
+            buffer_.append(reinterpret_cast<const char*>(data2.data()), data2_bytes);
+            buffer_.append(constants::kCRLF, constants::kCRLFLength);
           } catch (const SocketException&) {
             // For chunked HTTP responses, if the receiving end has closed the connection,
             // as detected during `Send`, suppress logging about the failure to send the final "zero" chunk.
@@ -636,6 +1540,25 @@ class GenericHTTPServerConnection final : public HTTPResponder {
         }
       }
 
+      void AppendChunkToBuffer(const std::string& data) {
+        char chunk_header[32];
+        const size_t chunk_header_length = static_cast<size_t>(
+            snprintf(chunk_header, sizeof(chunk_header), "%lX\r\n", static_cast<unsigned long>(data.size())));
+        buffer_.append(chunk_header, chunk_header_length);
+        buffer_.append(data);
+        buffer_.append(constants::kCRLF, constants::kCRLFLength);
+      }
+
+      // Has `ChunkedResponseFlusher` write out the data not sent yet once `max_latency_` has passed, unless
+      // it is scheduled to already. The data flushed by the user code before that is then just not there.
+      void ScheduleFlush() {
+        if (max_latency_.count() && !flush_scheduled_) {
+          flush_scheduled_ = true;
+          flush_deadline_ = std::chrono::steady_clock::now() + max_latency_;
+          current::Singleton<ChunkedResponseFlusher>().Schedule(this->shared_from_this(), flush_deadline_);
+        }
+      }
+
       // Only support STL containers of chars and bytes, this does not yet cover std::string.
       template <typename T>
       inline ENABLE_IF<std::is_same<typename T::value_type, char>::value ||
@@ -648,6 +1571,15 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       // Special case to handle std::string.
       inline void Send(const std::string& data, ChunkFlush flush) { SendImpl(data, flush); }
 
+      // Two parts sent as one chunk, with no copying them into a single buffer first, such as a line of
+      // a memory-mapped file via an `std::string_view`, and the newline after it.
+      template <typename T1, typename T2>
+      inline ENABLE_IF<std::is_same<typename current::decay<T1>::value_type, char>::value &&
+                       std::is_same<typename current::decay<T2>::value_type, char>::value>
+      Send(T1&& data1, T2&& data2, ChunkFlush flush) {
+        SendImpl(data1, data2, flush);
+      }
+
       // Support `CURRENT_STRUCT`-s.
       template <class T>
       inline ENABLE_IF<IS_CURRENT_STRUCT(current::decay<T>)> Send(T&& object, ChunkFlush flush) {
@@ -655,9 +1587,20 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       }
 
       Connection& connection_;
+      const size_t max_buffered_bytes_;
+      const std::chrono::milliseconds max_latency_;
+      const bool non_blocking_;
+      std::unique_ptr<gzip::Compressor> compressor_;
+      // Locked by the user code sending the chunks, and by `ChunkedResponseFlusher` flushing them.
+      std::mutex mutex_;
       bool can_no_longer_write_ = false;
-      char data_cache_[CACHE_SIZE];
-      uint64_t cache_size_ = 0;
+      std::string buffer_;  // The chunks sent with `ChunkFlush::NoFlush`, formatted, and not yet written out.
+      bool compressor_has_pending_data_ = false;
+      bool flush_scheduled_ = false;
+      std::chrono::steady_clock::time_point flush_deadline_;
+      // Non-blocking only: the first bytes of `buffer_` the socket has not taken, and who to tell once it takes more.
+      size_t due_bytes_ = 0u;
+      std::function<void()> resume_;
 
       Impl() = delete;
       Impl(const Impl&) = delete;
@@ -666,7 +1609,18 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       void operator=(Impl&&) = delete;
     };
 
-    explicit ChunkedResponseSender(Connection& connection) : impl_(new Impl(connection)) {}
+    explicit ChunkedResponseSender(Connection& connection,
+                                   ContentEncoding content_encoding = ContentEncoding::Identity,
+                                   const ChunkedResponseOptions& options = ChunkedResponseOptions())
+        : impl_(std::make_shared<Impl>(connection, content_encoding, options)) {}
+
+    ChunkedResponseSender(ChunkedResponseSender&&) = default;
+
+    ~ChunkedResponseSender() {
+      if (impl_) {
+        impl_->Close();
+      }
+    }
 
     template <typename T>
     inline ChunkedResponseSender& Send(T&& data, ChunkFlush flush = ChunkFlush::Flush) {
@@ -692,23 +1646,39 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       return *this;
     }
 
-    std::unique_ptr<Impl> impl_;
+    // For the non-blocking responses, see `ChunkedResponseOptions::NonBlocking()`.
+    bool Backlogged(std::function<void()> resume) { return impl_->Backlogged(std::move(resume)); }
+
+    std::shared_ptr<Impl> impl_;
+
+    ChunkedResponseSender(const ChunkedResponseSender&) = delete;
+    void operator=(const ChunkedResponseSender&) = delete;
+    void operator=(ChunkedResponseSender&&) = delete;
   };
 
   template <uint64_t CACHE_SIZE = CURRENT_BRICKS_HTTP_DEFAULT_CHUNK_CACHE_SIZE>
   inline ChunkedResponseSender<CACHE_SIZE> SendChunkedHTTPResponse(
       HTTPResponseCodeValue code = HTTPResponseCode.OK,
       const http::Headers& headers = http::Headers(),
-      const std::string& content_type = constants::kDefaultJSONContentType) {
+      const std::string& content_type = constants::kDefaultJSONContentType,
+      const ChunkedResponseOptions& options = ChunkedResponseOptions()) {
     if (responded_) {
       CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
     } else {
       responded_ = true;
+      CloseConnectionIfBodyIsNotReadThrough();
       std::ostringstream os;
-      PrepareHTTPResponseHeader(os, ConnectionKeepAlive, code, headers, content_type);
+      PrepareHTTPResponseHeader(os, connection_type_, code, headers, content_type);
+      const ContentEncoding content_encoding =
+          headers.Has(constants::kContentEncodingHeaderKey) ? ContentEncoding::Identity : content_encoding_;
+      if (content_encoding != ContentEncoding::Identity) {
+        os << constants::kContentEncodingHeaderKey << ": " << ContentEncodingAsString(content_encoding)
+           << constants::kCRLF;
+        os << "Vary: " << constants::kAcceptEncodingHeaderKey << constants::kCRLF;
+      }
       os << "Transfer-Encoding: chunked" << constants::kCRLF << constants::kCRLF;
       connection_.BlockingWrite(os.str(), true);
-      return ChunkedResponseSender<CACHE_SIZE>(connection_);
+      return ChunkedResponseSender<CACHE_SIZE>(connection_, content_encoding, options);
     }
   }
 
@@ -729,9 +1699,100 @@ class GenericHTTPServerConnection final : public HTTPResponder {
   Connection& RawConnection() { return connection_; }
 
  private:
+  // The rest of the body, if it is left unread, would be taken for the next request on the connection.
+  void CloseConnectionIfBodyIsNotReadThrough() {
+    if (message_.BodyIsStreamed() && !body_read_through_) {
+      connection_type_ = ConnectionClose;
+      keep_alive_ = nullptr;
+    }
+  }
+
+  // The bytes read ahead while looking for the end of a line of the chunked body go first.
+  size_t ReadStreamedBodyBytes(char* buffer, size_t max_length) {
+    if (body_read_ahead_offset_ < body_read_ahead_.length()) {
+      const size_t length = std::min(max_length, body_read_ahead_.length() - body_read_ahead_offset_);
+      std::memcpy(buffer, body_read_ahead_.data() + body_read_ahead_offset_, length);
+      body_read_ahead_offset_ += length;
+      return length;
+    }
+    const size_t length = connection_.BlockingRead(buffer, max_length);
+    if (!length) {
+      CURRENT_THROW(ConnectionResetByPeer());  // LCOV_EXCL_LINE
+    }
+    return length;
+  }
+
+  // Returns the next line of the chunked body, without the CRLF.
+  std::string ReadStreamedBodyLine() {
+    // A chunk size, or a trailer header, this long is not a valid one.
+    constexpr size_t kMaxLineLength = 4096u;
+    while (true) {
+      const size_t crlf = body_read_ahead_.find(constants::kCRLF, body_read_ahead_offset_);
+      if (crlf != std::string::npos) {
+        std::string line = body_read_ahead_.substr(body_read_ahead_offset_, crlf - body_read_ahead_offset_);
+        body_read_ahead_offset_ = crlf + constants::kCRLFLength;
+        return line;
+      }
+      body_read_ahead_.erase(0, body_read_ahead_offset_);
+      body_read_ahead_offset_ = 0u;
+      if (body_read_ahead_.length() > kMaxLineLength) {
+        RespondWithInvalidHEXChunkSize();
+      }
+      char block[kMaxLineLength];
+      const size_t length = connection_.BlockingRead(block, sizeof(block));
+      if (!length) {
+        CURRENT_THROW(ConnectionResetByPeer());  // LCOV_EXCL_LINE
+      }
+      body_read_ahead_.append(block, length);
+    }
+  }
+
+  // The bytes read past the end of the body belong to the next, pipelined, request on the same connection.
+  void OnStreamedBodyReadThrough() {
+    body_read_through_ = true;
+    if (body_read_ahead_offset_ < body_read_ahead_.length()) {
+      connection_.PrependToReadBuffer(body_read_ahead_.substr(body_read_ahead_offset_));
+    }
+    body_read_ahead_.clear();
+    body_read_ahead_offset_ = 0u;
+  }
+
+  void RespondWithPayloadTooLarge() {
+    if (!responded_) {
+      SendHTTPResponse(DefaultRequestEntityTooLargeMessage(),
+                       HTTPResponseCode.RequestEntityTooLarge,
+                       http::Headers(),
+                       constants::kDefaultHTMLContentType);
+    }
+    CURRENT_THROW(HTTPPayloadTooLarge());
+  }
+
+  void RespondWithInvalidHEXChunkSize() {
+    if (!responded_) {
+      SendHTTPResponse(DefaultInvalidHEXChunkSizeBadRequestMessage(),
+                       HTTPResponseCode.BadRequest,
+                       http::Headers(),
+                       constants::kDefaultHTMLContentType);
+    }
+    CURRENT_THROW(ChunkSizeNotAValidHEXValue());
+  }
+
   bool responded_ = false;
+  // The connection is only kept alive, and the response says so, if the server has asked for it, see `KeepAlive()`.
+  ConnectionType connection_type_ = ConnectionClose;
+  std::function<void(Connection&&)> keep_alive_;
   Connection connection_;
   GenericHTTPRequestData<HTTP_REQUEST_DATA> message_;
+  // Negotiated from the `Accept-Encoding` header of the request.
+  ContentEncoding content_encoding_;
+
+  // The state of `ReadBody()`.
+  size_t max_body_length_ = constants::kMaxHTTPPayloadSizeInBytes;
+  size_t body_bytes_read_ = 0u;
+  size_t body_chunk_bytes_left_ = 0u;
+  bool body_read_through_ = false;
+  std::string body_read_ahead_;
+  size_t body_read_ahead_offset_ = 0u;
 
   // Disable any copy/move support for extra safety.
   GenericHTTPServerConnection(const GenericHTTPServerConnection&) = delete;
@@ -26,12 +26,15 @@ SOFTWARE.
 
 #include "headers/test.cc"
 
+#include <atomic>
+#include <string_view>
 #include <thread>
 
 #define CURRENT_BRICKS_DEBUG_HTTP
 #include "http.h"
 
 #include "../../dflags/dflags.h"
+#include "../../strings/join.h"
 #include "../../strings/printf.h"
 #include "../../system/syscalls.h"
 
@@ -223,7 +226,7 @@ TEST(PosixHTTPServerTest, SmokeChunkedResponse) {
   ExpectToReceive(
       "HTTP/1.1 200 OK\r\n"
       "Content-Type: application/json; charset=utf-8\r\n"
-      "Connection: keep-alive\r\n"
+      "Connection: close\r\n"
       "Transfer-Encoding: chunked\r\n"
       "\r\n"
       "B\r\n"
@@ -254,7 +257,7 @@ TEST(PosixHTTPServerTest, SmokeChunkedResponseWithCORSHeader) {
   ExpectToReceive(
       "HTTP/1.1 200 OK\r\n"
       "Content-Type: application/json; charset=utf-8\r\n"
-      "Connection: keep-alive\r\n"
+      "Connection: close\r\n"
       "Access-Control-Allow-Origin: *\r\n"
       "Transfer-Encoding: chunked\r\n"
       "\r\n"
@@ -269,6 +272,61 @@ TEST(PosixHTTPServerTest, SmokeChunkedResponseWithCORSHeader) {
   t.join();
 }
 
+TEST(PosixHTTPServerTest, BufferedChunkedResponse) {
+  std::atomic_bool client_received_buffered_chunk(false);
+  std::thread t([&client_received_buffered_chunk](Socket s) {
+    HTTPServerConnection c(s.Accept());
+    auto r = c.SendChunkedHTTPResponse(
+        HTTPResponseCode.OK,
+        current::net::http::Headers(),
+        current::net::constants::kDefaultContentType,
+        current::net::ChunkedResponseOptions().MaxBufferedBytes(16u).MaxLatency(std::chrono::milliseconds(10)));
+    r.Send("one", current::net::ChunkFlush::NoFlush);
+    r.Send("two", current::net::ChunkFlush::NoFlush);
+    // Does not fit the buffer along with the two above, which are written out.
+    r.Send("three", current::net::ChunkFlush::NoFlush);
+    // Only reaches the client after the `MaxLatency()`, as no more chunks are sent until it is received.
+    for (int i = 0; i < 5000 && !client_received_buffered_chunk; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(client_received_buffered_chunk);
+    // Larger than the buffer, so is written out right away.
+    r.Send(std::string(20u, '.'), current::net::ChunkFlush::NoFlush);
+    r.Send("four", current::net::ChunkFlush::NoFlush);
+    // The two parts make a single chunk.
+    r.Send(std::string_view("fi"), std::string_view("ve"), current::net::ChunkFlush::NoFlush);
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  connection.BlockingWrite("GET /chunked HTTP/1.1\r\n\r\n", false);
+  std::string response;
+  char buffer[1024];
+  while (response.find("\r\n0\r\n\r\n") == std::string::npos) {
+    const size_t read = connection.BlockingRead(buffer, sizeof(buffer));
+    ASSERT_GT(read, 0u);
+    response.append(buffer, read);
+    if (response.find("5\r\nthree\r\n") != std::string::npos) {
+      client_received_buffered_chunk = true;
+    }
+  }
+  EXPECT_EQ(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: close\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "\r\n"
+      "3\r\none\r\n"
+      "3\r\ntwo\r\n"
+      "5\r\nthree\r\n"
+      "14\r\n" +
+          std::string(20u, '.') +
+          "\r\n"
+          "4\r\nfour\r\n"
+          "4\r\nfive\r\n"
+          "0\r\n\r\n",
+      response);
+  t.join();
+}
+
 TEST(PosixHTTPServerTest, SmokeWithHeaders) {
   std::thread t([](Socket s) {
     HTTPServerConnection c(s.Accept());
@@ -952,6 +1010,317 @@ TYPED_TEST(HTTPTest, DoesNotSendResponseAtAll) {
             current::strings::Trim(TypeParam::MakeGetRequest(t, "/")));
 }
 
+TEST(PosixHTTPServerTest, KeepAliveAndPipelining) {
+  std::thread t([](Socket s) {
+    std::unique_ptr<Connection> connection(new Connection(s.Accept()));
+    std::vector<std::string> requests;
+    while (connection) {
+      std::unique_ptr<Connection> next;
+      {
+        HTTPServerConnection c(std::move(*connection));
+        c.KeepAlive([&next](Connection&& kept) { next.reset(new Connection(std::move(kept))); });
+        requests.push_back(c.HTTPRequest().Method() + ' ' + c.HTTPRequest().RawPath() + ' ' +
+                           c.HTTPRequest().HTTPVersion() + ' ' + c.HTTPRequest().Body());
+        c.SendHTTPResponse(c.HTTPRequest().RawPath().substr(1));
+      }
+      connection = std::move(next);
+    }
+    EXPECT_EQ("GET /one HTTP/1.1 ,POST /two HTTP/1.1 abc,GET /three HTTP/1.1 ",
+              current::strings::Join(requests, ','));
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  // Three pipelined requests, sent at once. The last one asks to close the connection.
+  connection.BlockingWrite(
+      "GET /one HTTP/1.1\r\nHost: localhost\r\n\r\n"
+      "POST /two HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\nabc"
+      "GET /three HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n",
+      false);
+  ExpectToReceive(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: 3\r\n"
+      "\r\n"
+      "one"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: 3\r\n"
+      "\r\n"
+      "two"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: close\r\n"
+      "Content-Length: 5\r\n"
+      "\r\n"
+      "three",
+      connection);
+  t.join();
+}
+
+TEST(PosixHTTPServerTest, KeepAliveIsOptInForHTTP10) {
+  std::thread t([](Socket s) {
+    bool kept_alive = false;
+    {
+      HTTPServerConnection c(s.Accept());
+      c.KeepAlive([&kept_alive](Connection&&) { kept_alive = true; });
+      c.SendHTTPResponse("OK");
+    }
+    EXPECT_FALSE(kept_alive);
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  connection.BlockingWrite("GET / HTTP/1.0\r\n\r\n", false);
+  ExpectToReceive(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: close\r\n"
+      "Content-Length: 2\r\n"
+      "\r\n"
+      "OK",
+      connection);
+  t.join();
+}
+
+#ifdef CURRENT_HAS_ZLIB
+TEST(PosixHTTPServerTest, CompressedResponse) {
+  const std::string body = current::strings::Join(std::vector<std::string>(100u, "Compressible body."), ' ');
+  std::thread t([&body](Socket s) {
+    {
+      HTTPServerConnection c(s.Accept());
+      c.SendHTTPResponse(body);
+    }
+    {
+      HTTPServerConnection c(s.Accept());
+      c.SendHTTPResponse("Too short to compress.");
+    }
+    {
+      HTTPServerConnection c(s.Accept());
+      c.SendHTTPResponse(body);
+    }
+  }, Socket(FLAGS_net_http_test_port));
+  {
+    Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+    connection.BlockingWrite("GET / HTTP/1.1\r\nAccept-Encoding: deflate, gzip;q=0.9\r\n\r\n", false);
+    HTTPRequestData response(connection);
+    EXPECT_EQ("gzip", response.headers().Get("Content-Encoding"));
+    EXPECT_EQ("Accept-Encoding", response.headers().Get("Vary"));
+    EXPECT_LT(response.Body().length() * 5, body.length());
+    EXPECT_EQ(body, current::gzip::Decompress(response.Body()));
+  }
+  {
+    Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+    connection.BlockingWrite("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n", false);
+    HTTPRequestData response(connection);
+    EXPECT_FALSE(response.headers().Has("Content-Encoding"));
+    EXPECT_EQ("Too short to compress.", response.Body());
+  }
+  {
+    Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+    connection.BlockingWrite("GET / HTTP/1.1\r\nAccept-Encoding: gzip;q=0, identity\r\n\r\n", false);
+    HTTPRequestData response(connection);
+    EXPECT_FALSE(response.headers().Has("Content-Encoding"));
+    EXPECT_EQ(body, response.Body());
+  }
+  t.join();
+}
+
+TEST(PosixHTTPServerTest, CompressedChunkedResponse) {
+  std::thread t([](Socket s) {
+    HTTPServerConnection c(s.Accept());
+    auto r = c.SendChunkedHTTPResponse();
+    r.Send("one", current::net::ChunkFlush::NoFlush);
+    r.Send("two");
+    r.Send(HTTPTestObject());
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  connection.BlockingWrite("GET /chunked HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n", false);
+  HTTPRequestData response(connection);
+  EXPECT_EQ("gzip", response.headers().Get("Content-Encoding"));
+  EXPECT_EQ("onetwo{\"number\":42,\"text\":\"text\",\"array\":[1,2,3]}\n",
+            current::gzip::Decompress(response.Body()));
+  t.join();
+}
+
+TEST(PosixHTTPServerTest, CompressedBufferedChunkedResponse) {
+  std::atomic_bool client_decompressed_buffered_chunk(false);
+  std::thread t([&client_decompressed_buffered_chunk](Socket s) {
+    HTTPServerConnection c(s.Accept());
+    auto r = c.SendChunkedHTTPResponse(HTTPResponseCode.OK,
+                                       current::net::http::Headers(),
+                                       current::net::constants::kDefaultContentType,
+                                       current::net::ChunkedResponseOptions().MaxLatency(std::chrono::milliseconds(10)));
+    r.Send("idle tail", current::net::ChunkFlush::NoFlush);
+    // Held back by the compressor, and only sync-flushed to the client after the `MaxLatency()`.
+    for (int i = 0; i < 5000 && !client_decompressed_buffered_chunk; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(client_decompressed_buffered_chunk);
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  connection.BlockingWrite("GET /chunked HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n", false);
+  current::gzip::Decompressor decompressor;
+  std::string response;
+  std::string decompressed;
+  size_t offset = std::string::npos;
+  char buffer[1024];
+  while (!decompressor.Done()) {
+    const size_t read = connection.BlockingRead(buffer, sizeof(buffer));
+    ASSERT_GT(read, 0u);
+    response.append(buffer, read);
+    if (offset == std::string::npos) {
+      offset = response.find("\r\n\r\n");
+      if (offset == std::string::npos) {
+        continue;
+      }
+      EXPECT_NE(std::string::npos, response.find("Content-Encoding: gzip"));
+      offset += 4u;
+    }
+    // Decompress the complete chunks received so far.
+    while (true) {
+      const size_t eol = response.find("\r\n", offset);
+      if (eol == std::string::npos) {
+        break;
+      }
+      const size_t length = static_cast<size_t>(std::stoul(response.substr(offset, eol - offset), nullptr, 16));
+      if (response.length() < eol + 2u + length + 2u) {
+        break;
+      }
+      decompressed += decompressor.Decompress(response.data() + eol + 2u, length);
+      offset = eol + 2u + length + 2u;
+    }
+    if (decompressed == "idle tail") {
+      client_decompressed_buffered_chunk = true;
+    }
+  }
+  EXPECT_EQ("idle tail", decompressed);
+  t.join();
+}
+#endif  // CURRENT_HAS_ZLIB
+
+TEST(PosixHTTPServerTest, ZeroCopyRequestParsing) {
+  std::string body;
+  std::string chunked_body;
+  for (int i = 0; i < 50; ++i) {
+    const std::string chunk = current::strings::Printf("chunk%05d", i);
+    body += chunk;
+    chunked_body += "a\r\n" + chunk + "\r\n";
+  }
+  std::thread t([&body](Socket s) {
+    const auto& pool = current::ThreadLocalSingleton<current::net::HTTPRequestBufferPool>();
+    Connection connection(s.Accept());
+    for (int i = 0; i < 2; ++i) {
+      {
+        // The small initial buffer makes sure the headers survive the buffer growing, and the chunks moving in it.
+        const current::net::HTTPZeroCopyRequestData request(
+            connection, current::net::HTTPZeroCopyHelper::ConstructionParams(), 32 + 1);
+        EXPECT_EQ("POST", request.Method());
+        EXPECT_EQ("/zero/copy?i=" + current::ToString(i), request.RawPath());
+        EXPECT_EQ("/zero/copy", request.URL().path);
+        EXPECT_EQ("HTTP/1.1", request.HTTPVersion());
+        ASSERT_EQ(5u, request.HeadersCount());
+        EXPECT_EQ("Host", std::string(request.HeaderAt(0).name));
+        EXPECT_EQ("localhost", std::string(request.HeaderAt(0).value));
+        EXPECT_TRUE(request.HasHeader("x_custom_header"));
+        EXPECT_EQ("spaces around are trimmed", std::string(request.HeaderValue("X-Custom-Header")));
+        EXPECT_EQ("first", std::string(request.HeaderValue("X-Repeated")));
+        EXPECT_EQ("second", std::string(request.HeaderAt(4).value));
+        EXPECT_FALSE(request.HasHeader("Content-Length"));
+        EXPECT_THROW(request.HeaderValue("Content-Length"), current::net::http::HeaderNotFoundException);
+        EXPECT_EQ(body, request.Body());
+      }
+      // The buffer goes back to the pool, and the next request is read into it.
+      EXPECT_EQ(1u, pool.Size());
+    }
+    {
+      // A request destroyed on another thread frees its buffer, instead of leaving it in the pool of that thread.
+      auto request = std::make_unique<current::net::HTTPZeroCopyRequestData>(connection);
+      EXPECT_EQ("/zero/copy?i=2", request->RawPath());
+      EXPECT_EQ(0u, pool.Size());
+      std::thread([&request]() {
+        request = nullptr;
+        EXPECT_EQ(0u, current::ThreadLocalSingleton<current::net::HTTPRequestBufferPool>().Size());
+      }).join();
+      EXPECT_EQ(0u, pool.Size());
+    }
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  for (int i = 0; i < 3; ++i) {
+    connection.BlockingWrite("POST /zero/copy?i=" + current::ToString(i) + " HTTP/1.1\r\n", true);
+    connection.BlockingWrite("Host: localhost\r\n", true);
+    connection.BlockingWrite("Transfer-Encoding: chunked\r\n", true);
+    connection.BlockingWrite("X-Custom-Header: \t spaces around are trimmed \t\r\n", true);
+    connection.BlockingWrite("X-Repeated: first\r\nX-Repeated: second\r\n", true);
+    connection.BlockingWrite("\r\n", true);
+    connection.BlockingWrite(chunked_body + "0\r\n\r\n", false);
+  }
+  t.join();
+}
+
+TEST(PosixHTTPServerTest, StreamedBodyAndPipelining) {
+  std::thread t([](Socket s) {
+    std::unique_ptr<Connection> connection(new Connection(s.Accept()));
+    std::vector<std::string> requests;
+    while (connection) {
+      std::unique_ptr<Connection> next;
+      {
+        HTTPServerConnection c(std::move(*connection), [](const current::net::HTTPRequestData& request) {
+          return request.URL().path.compare(0, 7, "/stream") == 0;
+        });
+        c.KeepAlive([&next](Connection&& kept) { next.reset(new Connection(std::move(kept))); });
+        std::string body;
+        if (c.HTTPRequest().URL().path != "/stream/unread") {
+          char buffer[4];
+          size_t length;
+          while ((length = c.ReadBody(buffer, sizeof(buffer))) != 0u) {
+            body.append(buffer, length);
+          }
+        }
+        requests.push_back(c.HTTPRequest().URL().path + ' ' + (c.HTTPRequest().BodyIsStreamed() ? '1' : '0') + ' ' +
+                           body);
+        c.SendHTTPResponse(body.empty() ? "unread" : body);
+      }
+      connection = std::move(next);
+    }
+    EXPECT_EQ("/stream 1 0123456789,/stream 1 abcdefg,/buffered 0 xyz,/stream/unread 1 ",
+              current::strings::Join(requests, ','));
+  }, Socket(FLAGS_net_http_test_port));
+  Connection connection(ClientSocket("localhost", FLAGS_net_http_test_port));
+  // The body of the last request is not read by the server, so the connection is closed after it.
+  connection.BlockingWrite(
+      "POST /stream HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789"
+      "POST /stream HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n"
+      "POST /buffered HTTP/1.1\r\nContent-Length: 3\r\n\r\nxyz"
+      "POST /stream/unread HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello",
+      false);
+  ExpectToReceive(
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: 10\r\n"
+      "\r\n"
+      "0123456789"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: 7\r\n"
+      "\r\n"
+      "abcdefg"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: keep-alive\r\n"
+      "Content-Length: 3\r\n"
+      "\r\n"
+      "xyz"
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain\r\n"
+      "Connection: close\r\n"
+      "Content-Length: 6\r\n"
+      "\r\n"
+      "unread",
+      connection);
+  t.join();
+}
+
 TEST(HTTPCodesTest, SmokeTest) {
   EXPECT_EQ("OK", HTTPResponseCodeAsString(HTTPResponseCode(200)));
   EXPECT_EQ("Not Found", HTTPResponseCodeAsString(HTTPResponseCode(404)));
@@ -976,6 +1345,32 @@ TEST(HTTPMimeTypeTest, SmokeTest) {
   EXPECT_EQ("image/x-icon", GetFileMimeType("favicon.ico"));
 }
 
+TEST(HTTPRequestFramingTest, CompleteHTTPRequestLength) {
+  using current::net::CompleteHTTPRequestLength;
+  const auto length = [](const std::string& s) { return CompleteHTTPRequestLength(s.data(), s.data() + s.length()); };
+
+  EXPECT_EQ(0u, length(""));
+  EXPECT_EQ(0u, length("GET / HTTP/1.1\r\nHost: x\r\n"));
+  EXPECT_EQ(27u, length("GET / HTTP/1.1\r\nHost: x\r\n\r\n"));
+  EXPECT_EQ(31u, length("\r\n\r\nGET / HTTP/1.1\r\nHost: x\r\n\r\nGET /next"));
+
+  EXPECT_EQ(0u, length("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nabc"));
+  EXPECT_EQ(45u, length("POST / HTTP/1.1\r\ncontent_length:  5 \r\n\r\nabcde"));
+  EXPECT_EQ(43u, length("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nabcdeGET / HTTP/1.1\r\n\r\n"));
+
+  const std::string chunked = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+  EXPECT_EQ(0u, length(chunked));
+  EXPECT_EQ(0u, length(chunked + "3\r\nabc\r\n"));
+  EXPECT_EQ(0u, length(chunked + "3\r\nab"));
+  EXPECT_EQ(chunked.length() + 11u, length(chunked + "3\r\nabc\r\n0\r\n"));
+  EXPECT_EQ(chunked.length() + 13u, length(chunked + "3\r\nabc\r\n0\r\n\r\nGET / HTTP/1.1\r\n\r\n"));
+
+  // The requests to be rejected are complete right away, for the error to be returned without waiting.
+  EXPECT_EQ(chunked.length() + 5u, length(chunked + "xyz\r\n"));
+  const std::string too_large = "POST / HTTP/1.1\r\nContent-Length: 100000000\r\n\r\n";
+  EXPECT_EQ(too_large.length(), length(too_large));
+}
+
 // TODO(dkorolev): Figure out a way to test ConnectionResetByPeer exceptions.
 
 #if 0
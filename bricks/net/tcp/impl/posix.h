@@ -34,6 +34,7 @@ SOFTWARE.
 #include "../../../util/singleton.h"
 #include "../../../template/enable_if.h"
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -46,8 +47,13 @@ SOFTWARE.
 #include <netdb.h>
 #include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#ifndef CURRENT_APPLE
+#include <sys/sendfile.h>
+#endif  // CURRENT_APPLE
+
 // Bricks uses `SOCKET` for socket handles in *nix.
 // Makes it easier to have the code run on both Windows and *nix.
 typedef int SOCKET;
@@ -263,6 +269,20 @@ class Connection : public SocketHandle {
                                                         BlockingReadPolicy policy = BlockingReadPolicy::ReturnASAP) {
     if (max_length == 0) {
       return 0;  // LCOV_EXCL_LINE
+    } else if (prefetched_offset_ < prefetched_.length()) {
+      // Return the data read ahead by the server first, and only read the rest, if requested, from the socket.
+      const size_t length = std::min(max_length, prefetched_.length() - prefetched_offset_);
+      std::memcpy(output_buffer, prefetched_.data() + prefetched_offset_, length);
+      prefetched_offset_ += length;
+      if (prefetched_offset_ == prefetched_.length()) {
+        prefetched_.clear();
+        prefetched_offset_ = 0u;
+      }
+      if (length < max_length && policy == BlockingReadPolicy::FillFullBuffer) {
+        return length + BlockingRead(output_buffer + length, max_length - length, policy);
+      } else {
+        return length;
+      }
     } else {
       uint8_t* buffer = reinterpret_cast<uint8_t*>(output_buffer);
       uint8_t* ptr = buffer;
@@ -368,6 +388,27 @@ class Connection : public SocketHandle {
     }
   }
 
+  // Makes the next `BlockingRead()`-s return `data` before reading anything from the socket.
+  // For the servers which read the requests ahead, before they are parsed by the blocking code.
+  void PrependToReadBuffer(std::string data) {
+    if (prefetched_offset_ < prefetched_.length()) {
+      data.append(prefetched_, prefetched_offset_, std::string::npos);
+    }
+    prefetched_ = std::move(data);
+    prefetched_offset_ = 0u;
+  }
+
+  // Returns and forgets the data that was prepended to the read buffer and has not been read yet.
+  std::string ExtractReadBuffer() {
+    std::string result;
+    if (prefetched_offset_ < prefetched_.length()) {
+      result = prefetched_.substr(prefetched_offset_);
+    }
+    prefetched_.clear();
+    prefetched_offset_ = 0u;
+    return result;
+  }
+
   inline Connection& BlockingWrite(const void* buffer, size_t write_length, bool more) {
 #if defined(CURRENT_APPLE) || defined(CURRENT_WINDOWS)
     static_cast<void>(more);  // Supress the 'unused parameter' warning.
@@ -393,6 +434,43 @@ class Connection : public SocketHandle {
     return *this;
   }
 
+  // Writes as much of the data as the socket takes right away, possibly nothing. Returns the number of bytes written.
+  inline size_t NonBlockingWrite(const void* buffer, size_t write_length) {
+    CURRENT_ASSERT(buffer);
+#if !defined(CURRENT_WINDOWS)
+#if !defined(CURRENT_APPLE)
+    const ssize_t result = ::send(socket, buffer, write_length, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+    const ssize_t result = ::send(socket, buffer, write_length, MSG_DONTWAIT);
+#endif
+    if (result < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return 0u;
+      }
+      CURRENT_THROW(SocketWriteException());  // LCOV_EXCL_LINE
+    }
+#else
+    u_long non_blocking = 1;
+    ::ioctlsocket(socket, FIONBIO, &non_blocking);
+    const int result =
+        static_cast<int>(::send(socket, static_cast<const char*>(buffer), static_cast<int>(write_length), 0));
+    const int wsa_last_error = ::WSAGetLastError();
+    non_blocking = 0;
+    ::ioctlsocket(socket, FIONBIO, &non_blocking);
+    if (result < 0) {
+      if (wsa_last_error == WSAEWOULDBLOCK) {
+        return 0u;
+      }
+      CURRENT_THROW(SocketWriteException());
+    }
+#endif
+    CURRENT_BRICKS_NET_LOG("S%05d NonBlockingWrite(%d bytes) : %d\n",
+                           static_cast<SOCKET>(socket),
+                           static_cast<int>(write_length),
+                           static_cast<int>(result));
+    return static_cast<size_t>(result);
+  }
+
   inline Connection& BlockingWrite(const char* s, bool more) {
     CURRENT_ASSERT(s);
     return BlockingWrite(s, strlen(s), more);
@@ -414,9 +492,160 @@ class Connection : public SocketHandle {
     BlockingWrite(container.begin(), container.end(), more);
   }
 
+  // A piece of the data written by `BlockingWriteV()`.
+  struct WriteBuffer final {
+    const void* data;
+    size_t length;
+  };
+
+  // Writes the `count` buffers one after another with a single system call where available, `sendmsg()`,
+  // for the data assembled from several pieces not to be copied into one buffer, nor sent in as many packets.
+  inline Connection& BlockingWriteV(const WriteBuffer* buffers, size_t count, bool more) {
+#if !defined(CURRENT_WINDOWS)
+    constexpr size_t kMaxBuffersPerCall = 16u;
+    while (count) {
+      struct iovec iov[kMaxBuffersPerCall];
+      const size_t iov_count = std::min(count, kMaxBuffersPerCall);
+      size_t total_length = 0u;
+      for (size_t i = 0; i < iov_count; ++i) {
+        iov[i].iov_base = const_cast<void*>(buffers[i].data);
+        iov[i].iov_len = buffers[i].length;
+        total_length += buffers[i].length;
+      }
+      struct msghdr message;
+      std::memset(&message, 0, sizeof(message));
+      message.msg_iov = iov;
+      message.msg_iovlen = iov_count;
+      CURRENT_BRICKS_NET_LOG("S%05d BlockingWriteV(%d buffers, %d bytes) ...\n",
+                             static_cast<SOCKET>(socket),
+                             static_cast<int>(iov_count),
+                             static_cast<int>(total_length));
+#ifndef CURRENT_APPLE
+      const int flags = MSG_NOSIGNAL | ((more || iov_count < count) ? MSG_MORE : 0);
+#else
+      const int flags = 0;
+#endif
+      const ssize_t result = ::sendmsg(socket, &message, flags);
+      if (result < 0) {
+        CURRENT_THROW(SocketWriteException());  // LCOV_EXCL_LINE
+      } else if (static_cast<size_t>(result) != total_length) {
+        CURRENT_THROW(SocketCouldNotWriteEverythingException());  // LCOV_EXCL_LINE
+      }
+      buffers += iov_count;
+      count -= iov_count;
+    }
+    static_cast<void>(more);
+#else
+    for (size_t i = 0; i < count; ++i) {
+      if (buffers[i].length) {
+        BlockingWrite(buffers[i].data, buffers[i].length, more || i + 1 < count);
+      }
+    }
+#endif
+    return *this;
+  }
+
+  // Writes as much of the `count` buffers, one after another, as the socket takes right away, possibly nothing.
+  // Returns the number of bytes written.
+  inline size_t NonBlockingWriteV(const WriteBuffer* buffers, size_t count) {
+#if !defined(CURRENT_WINDOWS)
+    constexpr size_t kMaxBuffersPerCall = 16u;
+    struct iovec iov[kMaxBuffersPerCall];
+    const size_t iov_count = std::min(count, kMaxBuffersPerCall);
+    size_t total_length = 0u;
+    for (size_t i = 0; i < iov_count; ++i) {
+      iov[i].iov_base = const_cast<void*>(buffers[i].data);
+      iov[i].iov_len = buffers[i].length;
+      total_length += buffers[i].length;
+    }
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = iov_count;
+#ifndef CURRENT_APPLE
+    const ssize_t result = ::sendmsg(socket, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+#else
+    const ssize_t result = ::sendmsg(socket, &message, MSG_DONTWAIT);
+#endif
+    if (result < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        return 0u;
+      }
+      CURRENT_THROW(SocketWriteException());  // LCOV_EXCL_LINE
+    }
+    CURRENT_BRICKS_NET_LOG("S%05d NonBlockingWriteV(%d buffers, %d bytes) : %d\n",
+                           static_cast<SOCKET>(socket),
+                           static_cast<int>(iov_count),
+                           static_cast<int>(total_length),
+                           static_cast<int>(result));
+    return static_cast<size_t>(result);
+#else
+    size_t result = 0u;
+    for (size_t i = 0; i < count; ++i) {
+      if (buffers[i].length) {
+        const size_t written = NonBlockingWrite(buffers[i].data, buffers[i].length);
+        result += written;
+        if (written != buffers[i].length) {
+          break;
+        }
+      }
+    }
+    return result;
+#endif
+  }
+
+  // Writes `length` bytes of the open file `fd`, starting from `offset`. On Linux, uses `sendfile()`,
+  // so that the contents of the file are not copied into user space. Elsewhere, reads the file in blocks.
+  inline Connection& BlockingSendFile(int fd, size_t offset, size_t length) {
+    CURRENT_BRICKS_NET_LOG(
+        "S%05d BlockingSendFile(%d bytes) ...\n", static_cast<SOCKET>(socket), static_cast<int>(length));
+#if !defined(CURRENT_WINDOWS) && !defined(CURRENT_APPLE)
+    off_t position = static_cast<off_t>(offset);
+    while (length) {
+      const ssize_t result = ::sendfile(socket, fd, &position, length);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;  // LCOV_EXCL_LINE
+        }
+        CURRENT_THROW(SocketWriteException());  // LCOV_EXCL_LINE
+      } else if (result == 0) {
+        // The file is shorter than it was expected to be.
+        CURRENT_THROW(SocketCouldNotWriteEverythingException());  // LCOV_EXCL_LINE
+      }
+      length -= static_cast<size_t>(result);
+    }
+#else
+#ifndef CURRENT_WINDOWS
+    if (::lseek(fd, static_cast<off_t>(offset), SEEK_SET) < 0) {
+#else
+    if (::_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+#endif  // CURRENT_WINDOWS
+      CURRENT_THROW(SocketCouldNotWriteEverythingException());
+    }
+    std::vector<char> block(std::min(length, static_cast<size_t>(64 * 1024)));
+    while (length) {
+      const unsigned int block_size = static_cast<unsigned int>(std::min(length, block.size()));
+#ifndef CURRENT_WINDOWS
+      const int result = static_cast<int>(::read(fd, &block[0], block_size));
+#else
+      const int result = ::_read(fd, &block[0], block_size);
+#endif  // CURRENT_WINDOWS
+      if (result <= 0) {
+        CURRENT_THROW(SocketCouldNotWriteEverythingException());
+      }
+      length -= static_cast<size_t>(result);
+      BlockingWrite(&block[0], static_cast<size_t>(result), length != 0);
+    }
+#endif
+    CURRENT_BRICKS_NET_LOG("S%05d BlockingSendFile() : OK\n", static_cast<SOCKET>(socket));
+    return *this;
+  }
+
  private:
   const IPAndPort local_ip_and_port_;
   const IPAndPort remote_ip_and_port_;
+  std::string prefetched_;
+  size_t prefetched_offset_ = 0u;
 
   Connection() = delete;
   Connection(const Connection&) = delete;
@@ -426,10 +655,24 @@ class Connection : public SocketHandle {
 
 class Socket final : public SocketHandle {
  public:
+  // With `reuse_port`, several sockets, each created with it, can listen on the same port, and the kernel
+  // distributes the incoming connections among them. Requires `SO_REUSEPORT`, Linux 3.9+ or BSD.
   inline explicit Socket(const int port,
                          const int max_connections = kMaxServerQueuedConnections,
-                         const bool disable_nagle_algorithm = kDisableNagleAlgorithmByDefault)
+                         const bool disable_nagle_algorithm = kDisableNagleAlgorithmByDefault,
+                         const bool reuse_port = false)
       : SocketHandle(SocketHandle::NewHandle(), disable_nagle_algorithm) {
+    if (reuse_port) {
+#ifdef SO_REUSEPORT
+      int just_one = 1;
+      if (::setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &just_one, sizeof(just_one))) {
+        CURRENT_THROW(SocketCreateException());  // LCOV_EXCL_LINE
+      }
+#else
+      CURRENT_THROW(SocketCreateException());
+#endif  // SO_REUSEPORT
+    }
+
     sockaddr_in addr_server;
     memset(&addr_server, 0, sizeof(addr_server));
     addr_server.sin_family = AF_INET;
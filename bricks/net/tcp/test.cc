@@ -22,6 +22,8 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 *******************************************************************************/
 
+#include <fcntl.h>
+
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -30,6 +32,7 @@ SOFTWARE.
 #include "tcp.h"
 
 #include "../../dflags/dflags.h"
+#include "../../file/file.h"
 
 #include "../../strings/printf.h"
 #include "../../util/singleton.h"
@@ -163,6 +166,42 @@ TEST(TCPTest, ReceiveMessageAsResponse) {
   server.join();
 }
 
+TEST(TCPTest, SendFile) {
+  const std::string file_name = current::FileSystem::GenTmpFileName();
+  const auto file_remover = current::FileSystem::ScopedRmFile(file_name);
+  std::string contents;
+  for (int i = 0; i < 100000; ++i) {
+    contents += Printf("%05d,", i);
+  }
+  current::FileSystem::WriteStringToFile(contents, file_name.c_str());
+  thread server([&file_name](Socket socket) {
+    Connection connection = socket.Accept();
+    const int fd = ::open(file_name.c_str(), O_RDONLY);
+    ASSERT_LE(0, fd);
+    connection.BlockingWrite("[", true).BlockingSendFile(fd, 6, 600000 - 12).BlockingWrite("]", false);
+    ::close(fd);
+  }, Socket(FLAGS_net_tcp_test_port));
+  ExpectFromSocket("[" + contents.substr(6, 600000 - 12) + "]", server);
+}
+
+TEST(TCPTest, WriteV) {
+  std::vector<std::string> pieces;
+  std::string expected;
+  for (int i = 0; i < 40; ++i) {
+    pieces.push_back(std::string(static_cast<size_t>(i * 1000), static_cast<char>('a' + i % 26)));
+    expected += pieces.back();
+  }
+  thread server([&pieces](Socket socket) {
+    Connection connection = socket.Accept();
+    std::vector<Connection::WriteBuffer> buffers;
+    for (const std::string& piece : pieces) {
+      buffers.push_back({piece.data(), piece.length()});
+    }
+    connection.BlockingWriteV(&buffers[0], buffers.size(), false);
+  }, Socket(FLAGS_net_tcp_test_port));
+  ExpectFromSocket(expected, server);
+}
+
 TEST(TCPTest, CanNotUseMovedAwayConnection) {
   thread server([](Socket socket) {
     Connection connection = socket.Accept();
@@ -274,6 +313,16 @@ TEST(TCPTest, CanNotBindTwoSocketsToTheSamePortSimultaneously) {
   std::unique_ptr<Socket> s2;
   ASSERT_THROW(s2.reset(new Socket(FLAGS_net_tcp_test_port)), SocketBindException);
 }
+
+TEST(TCPTest, SocketsWithReusePortShareThePort) {
+  const int max_connections = current::net::kMaxServerQueuedConnections;
+  const bool nagle = current::net::kDisableNagleAlgorithmByDefault;
+  Socket s1(FLAGS_net_tcp_test_port, max_connections, nagle, true);
+  Socket s2(FLAGS_net_tcp_test_port, max_connections, nagle, true);
+  std::unique_ptr<Socket> s3;
+  // Only the sockets that all have asked for it share the port.
+  ASSERT_THROW(s3.reset(new Socket(FLAGS_net_tcp_test_port)), SocketBindException);
+}
 #endif
 
 #if !defined(CURRENT_WINDOWS) && !defined(CURRENT_APPLE)
@@ -0,0 +1,122 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `EventCount` lets any number of threads wait for "something new" without locking a mutex of the notifier,
+// and without the notifier keeping track of the waiters.
+//
+// The waiter grabs the key first, then checks its condition, and only waits if the condition does not hold yet:
+//
+//   while (true) {
+//     const auto key = event_count.PrepareWait();
+//     if (condition()) {
+//       break;
+//     }
+//     event_count.Wait(key);
+//   }
+//
+// The notifier makes the condition hold, and then calls `NotifyAll()`. Since the key is the number of the calls
+// to `NotifyAll()` so far, no notification can be lost between checking the condition and waiting.
+//
+// `NotifyAll()` is an atomic increment, plus, if there are waiters, a single futex wake-up call on Linux,
+// or a single `notify_all()` of a condition variable elsewhere. That call still wakes up every waiter, so its cost,
+// paid by the notifier, grows linearly with the number of the waiters, and so does the scheduling that follows.
+
+#ifndef BRICKS_SYNC_EVENT_COUNT_H
+#define BRICKS_SYNC_EVENT_COUNT_H
+
+#include "../../port.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#if defined(CURRENT_POSIX) && defined(__linux__)
+#define CURRENT_EVENT_COUNT_FUTEX
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace current {
+
+class EventCount final {
+ public:
+  using key_t = uint32_t;
+
+  EventCount() : epoch_(0u), waiters_(0u) {}
+
+  key_t PrepareWait() const { return epoch_.load(); }
+
+  void NotifyAll() {
+    epoch_.fetch_add(1u);
+    if (waiters_.load()) {
+#ifdef CURRENT_EVENT_COUNT_FUTEX
+      ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+      { std::lock_guard<std::mutex> lock(mutex_); }
+      condition_variable_.notify_all();
+#endif
+    }
+  }
+
+  // Returns as soon as `NotifyAll()` has been called since `key` was obtained, or once `timeout` has passed.
+  // May return spuriously.
+  void Wait(key_t key, std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) {
+    ++waiters_;
+#ifdef CURRENT_EVENT_COUNT_FUTEX
+    if (epoch_.load() == key) {
+      struct timespec ts;
+      ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+      ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+      ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, key, &ts, nullptr, 0);
+    }
+#else
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_variable_.wait_for(lock, timeout, [this, key]() { return epoch_.load() != key; });
+    }
+#endif
+    --waiters_;
+  }
+
+ private:
+  EventCount(const EventCount&) = delete;
+  EventCount& operator=(const EventCount&) = delete;
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "The futex must be a plain 32-bit word.");
+  std::atomic<uint32_t> epoch_;
+  std::atomic<uint32_t> waiters_;
+#ifndef CURRENT_EVENT_COUNT_FUTEX
+  std::mutex mutex_;
+  std::condition_variable condition_variable_;
+#endif
+};
+
+}  // namespace current
+
+#endif  // BRICKS_SYNC_EVENT_COUNT_H
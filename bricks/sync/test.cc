@@ -24,8 +24,12 @@ SOFTWARE.
 
 #include "owned_borrowed.h"
 #include "waitable_atomic.h"
+#include "event_count.h"
 
+#include <atomic>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 #include "../../3rdparty/gtest/gtest-main.h"
 
@@ -355,3 +359,42 @@ TEST(WaitableAtomic, IntrusiveClientsCanBeTransferred) {
   auto f = [](IntrusiveClient& c) { static_cast<void>(c); };
   std::thread([&f](IntrusiveClient c) { f(c); }, object.RegisterScopedClient()).detach();
 }
+
+TEST(EventCount, WakesUpAllWaiters) {
+  current::EventCount event_count;
+  std::atomic_bool ready(false);
+  std::atomic_size_t woken_up(0u);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0u; i < 8u; ++i) {
+    threads.emplace_back([&]() {
+      while (true) {
+        const auto key = event_count.PrepareWait();
+        if (ready) {
+          break;
+        }
+        event_count.Wait(key, std::chrono::seconds(10));
+      }
+      ++woken_up;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(0u, woken_up);
+  ready = true;
+  event_count.NotifyAll();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(8u, woken_up);
+}
+
+TEST(EventCount, NotificationBetweenPrepareAndWaitIsNotLost) {
+  current::EventCount event_count;
+  const auto key = event_count.PrepareWait();
+  event_count.NotifyAll();
+  const auto begin = std::chrono::steady_clock::now();
+  event_count.Wait(key, std::chrono::seconds(10));
+  EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+  EXPECT_NE(key, event_count.PrepareWait());
+}
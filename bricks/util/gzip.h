@@ -0,0 +1,202 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Maxim Zhurovich <zhurovich@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// Streaming gzip and deflate compression via zlib, for HTTP `Content-Encoding`.
+//
+// `Compressor` produces the output incrementally: with `flush`, everything passed in so far can be decoded
+// by the receiving side right away, which keeps compressed chunked HTTP responses incremental.
+// `Decompressor` accepts both the gzip and the zlib ("deflate") formats, fed piece by piece.
+//
+// zlib is only used with `CURRENT_HAS_ZLIB`, see `port.h`. Without it `gzip::kAvailable` is `false`, the HTTP
+// server sends all the responses uncompressed, and `Compressor` and `Decompressor` throw `GZipException`.
+
+#ifndef BRICKS_UTIL_GZIP_H
+#define BRICKS_UTIL_GZIP_H
+
+#include "../../port.h"
+
+#include <string>
+
+#ifdef CURRENT_HAS_ZLIB
+#include <zlib.h>
+#endif  // CURRENT_HAS_ZLIB
+
+#include "../exception.h"
+
+namespace current {
+
+struct GZipException : Exception {
+  using Exception::Exception;
+};
+
+namespace gzip {
+
+enum class Format : int { GZip, Deflate };
+
+#ifdef CURRENT_HAS_ZLIB
+
+constexpr bool kAvailable = true;
+
+class Compressor final {
+ public:
+  explicit Compressor(Format format = Format::GZip, int level = Z_DEFAULT_COMPRESSION) {
+    // Window bits of 15 are zlib's default; adding 16 makes it write the gzip header and trailer instead.
+    const int window_bits = (format == Format::GZip) ? (15 + 16) : 15;
+    if (deflateInit2(&z_, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+      CURRENT_THROW(GZipException("`deflateInit2()` failed."));  // LCOV_EXCL_LINE
+    }
+  }
+
+  ~Compressor() { deflateEnd(&z_); }
+
+  // Returns the compressed bytes ready so far, possibly none unless `flush` is set.
+  std::string Compress(const char* data, size_t size, bool flush) {
+    return Deflate(data, size, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+  }
+  std::string Compress(const std::string& data, bool flush = false) {
+    return Compress(data.data(), data.length(), flush);
+  }
+
+  // Returns the remaining compressed bytes, including the trailer. No more data can be compressed after this.
+  std::string Finish() { return Deflate(nullptr, 0u, Z_FINISH); }
+
+ private:
+  std::string Deflate(const char* data, size_t size, int mode) {
+    std::string result;
+    z_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    z_.avail_in = static_cast<uInt>(size);
+    do {
+      z_.next_out = reinterpret_cast<Bytef*>(buffer_);
+      z_.avail_out = sizeof(buffer_);
+      if (deflate(&z_, mode) == Z_STREAM_ERROR) {
+        CURRENT_THROW(GZipException("`deflate()` failed."));  // LCOV_EXCL_LINE
+      }
+      result.append(buffer_, sizeof(buffer_) - z_.avail_out);
+    } while (z_.avail_out == 0);
+    return result;
+  }
+
+  z_stream z_ = z_stream();
+  char buffer_[16 * 1024];
+
+  Compressor(const Compressor&) = delete;
+  Compressor(Compressor&&) = delete;
+  void operator=(const Compressor&) = delete;
+  void operator=(Compressor&&) = delete;
+};
+
+class Decompressor final {
+ public:
+  Decompressor() {
+    // Adding 32 to the window bits enables the automatic detection of the gzip or zlib header.
+    if (inflateInit2(&z_, 15 + 32) != Z_OK) {
+      CURRENT_THROW(GZipException("`inflateInit2()` failed."));  // LCOV_EXCL_LINE
+    }
+  }
+
+  ~Decompressor() { inflateEnd(&z_); }
+
+  // Returns the decompressed bytes ready so far. The input may be split at any byte.
+  std::string Decompress(const char* data, size_t size) {
+    std::string result;
+    if (done_) {
+      return result;
+    }
+    z_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    z_.avail_in = static_cast<uInt>(size);
+    do {
+      z_.next_out = reinterpret_cast<Bytef*>(buffer_);
+      z_.avail_out = sizeof(buffer_);
+      const int retval = inflate(&z_, Z_NO_FLUSH);
+      if (retval != Z_OK && retval != Z_STREAM_END && retval != Z_BUF_ERROR) {
+        CURRENT_THROW(GZipException("Malformed compressed data."));
+      }
+      result.append(buffer_, sizeof(buffer_) - z_.avail_out);
+      if (retval == Z_STREAM_END) {
+        done_ = true;
+        break;
+      }
+    } while (z_.avail_out == 0);
+    return result;
+  }
+  std::string Decompress(const std::string& data) { return Decompress(data.data(), data.length()); }
+
+  // Whether the end of the compressed stream has been seen.
+  bool Done() const { return done_; }
+
+ private:
+  z_stream z_ = z_stream();
+  bool done_ = false;
+  char buffer_[16 * 1024];
+
+  Decompressor(const Decompressor&) = delete;
+  Decompressor(Decompressor&&) = delete;
+  void operator=(const Decompressor&) = delete;
+  void operator=(Decompressor&&) = delete;
+};
+
+#else
+
+constexpr bool kAvailable = false;
+
+// LCOV_EXCL_START
+class Compressor final {
+ public:
+  explicit Compressor(Format = Format::GZip, int = -1) { CURRENT_THROW(GZipException("Built without zlib.")); }
+  std::string Compress(const char*, size_t, bool) { return std::string(); }
+  std::string Compress(const std::string&, bool = false) { return std::string(); }
+  std::string Finish() { return std::string(); }
+};
+
+class Decompressor final {
+ public:
+  Decompressor() { CURRENT_THROW(GZipException("Built without zlib.")); }
+  std::string Decompress(const char*, size_t) { return std::string(); }
+  std::string Decompress(const std::string&) { return std::string(); }
+  bool Done() const { return false; }
+};
+// LCOV_EXCL_STOP
+
+#endif  // CURRENT_HAS_ZLIB
+
+inline std::string Compress(const std::string& data, Format format = Format::GZip) {
+  Compressor compressor(format);
+  std::string result = compressor.Compress(data);
+  result += compressor.Finish();
+  return result;
+}
+
+inline std::string Decompress(const std::string& data) {
+  Decompressor decompressor;
+  std::string result = decompressor.Decompress(data);
+  if (!decompressor.Done()) {
+    CURRENT_THROW(GZipException("Truncated compressed data."));
+  }
+  return result;
+}
+
+}  // namespace gzip
+}  // namespace current
+
+#endif  // BRICKS_UTIL_GZIP_H
@@ -28,6 +28,7 @@ SOFTWARE.
 #include "base64.h"
 #include "comparators.h"
 #include "crc32.h"
+#include "gzip.h"
 #include "iterator.h"
 #include "lazy_instantiation.h"
 #include "make_scope_guard.h"
@@ -289,6 +290,46 @@ TEST(Util, CRC32) {
   EXPECT_EQ(2514197138u, current::CRC32(test_string.c_str()));
 }
 
+#ifdef CURRENT_HAS_ZLIB
+TEST(Util, GZip) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += "{\"index\":" + std::to_string(i) + ",\"value\":\"Test string\"}\n";
+  }
+
+  for (current::gzip::Format format : {current::gzip::Format::GZip, current::gzip::Format::Deflate}) {
+    const std::string compressed = current::gzip::Compress(data, format);
+    EXPECT_LT(compressed.length() * 5, data.length());
+    EXPECT_EQ(data, current::gzip::Decompress(compressed));
+  }
+  EXPECT_EQ("\x1f\x8b", current::gzip::Compress(data).substr(0, 2));  // The gzip magic bytes.
+  EXPECT_EQ("", current::gzip::Decompress(current::gzip::Compress("")));
+
+  EXPECT_THROW(current::gzip::Decompress("Not compressed."), current::GZipException);
+  EXPECT_THROW(current::gzip::Decompress(current::gzip::Compress(data).substr(0, 100)), current::GZipException);
+}
+
+TEST(Util, GZipStreaming) {
+  current::gzip::Compressor compressor;
+  current::gzip::Decompressor decompressor;
+
+  // Without a flush, the data may stay buffered in the compressor.
+  std::string compressed = compressor.Compress("foo");
+  // With a flush, everything passed in so far gets decompressed, even if fed byte by byte.
+  compressed += compressor.Compress("bar", true);
+  std::string decompressed;
+  for (char c : compressed) {
+    decompressed += decompressor.Decompress(&c, 1u);
+  }
+  EXPECT_EQ("foobar", decompressed);
+  EXPECT_FALSE(decompressor.Done());
+
+  EXPECT_EQ("baz", decompressor.Decompress(compressor.Compress("baz", true)));
+  EXPECT_EQ("", decompressor.Decompress(compressor.Finish()));
+  EXPECT_TRUE(decompressor.Done());
+}
+#endif  // CURRENT_HAS_ZLIB
+
 TEST(Util, SHA256) {
   EXPECT_EQ("a591a6d40bf420404a011733cfb7b190d62c65bf0bcda32b57b277d9ad9f146e",
             static_cast<std::string>(current::SHA256("Hello World")));
@@ -24,10 +24,16 @@ SOFTWARE.
 
 #include "../../../current.h"
 
+#include "scenario_binary.h"
 #include "scenario_golden_1k_qps.h"
 #include "scenario_json.h"
+#include "scenario_json_writer.h"
+#include "scenario_mmq.h"
 #include "scenario_simple_http.h"
 #include "scenario_storage.h"
+#include "scenario_storage_reads.h"
+#include "scenario_stream_catch_up.h"
+#include "scenario_stream_publish.h"
 #include "scenario_nginx_client.h"
 #include "scenario_replication.h"
 
@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# Publishes into an in-memory message queue, `MMQ` or `LockFreeMMQ`, from 1, 4, and 16 producers.
+# With `--mmq_wait=false`, measures the throughput of the queue.
+# With `--mmq_wait=true`, measures the publish-to-consume latency, which is the number of producers divided by QPS.
+
+if [ ! -f .current/run ] ; then
+  echo "Building '.current/run' to run the tests. You may want to check the compilation flags."
+  make .current/run
+fi
+
+CMD="./.current/run --scenario=mmq"
+
+for MMQ_WAIT in false true ; do
+  for MMQ_IMPL in mutex lock_free ; do
+    for PRODUCERS in 1 4 16 ; do
+      echo -n "wait=$MMQ_WAIT,$MMQ_IMPL,producers=$PRODUCERS : "
+      $CMD \
+        --mmq_impl=$MMQ_IMPL \
+        --mmq_wait=$MMQ_WAIT \
+        --threads=$PRODUCERS \
+        --seconds=2
+    done
+  done
+done
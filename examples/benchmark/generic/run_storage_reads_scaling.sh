@@ -0,0 +1,20 @@
+#!/bin/bash
+
+# Runs read-only storage transactions from an increasing number of threads, under both transaction policies.
+
+if [ ! -f .current/run ] ; then
+  echo "Building '.current/run' to run the tests. You may want to check the compilation flags."
+  make .current/run
+fi
+
+CMD="./.current/run --scenario=storage_reads"
+
+for STORAGE_READS_POLICY in synchronous concurrent ; do
+  for THREADS in 1 2 4 8 16 ; do
+    echo -n "$STORAGE_READS_POLICY,threads=$THREADS : "
+    $CMD \
+      --storage_reads_policy=$STORAGE_READS_POLICY \
+      --threads=$THREADS \
+      --seconds=2
+  done
+done
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Publishes into a stream tailed by an increasing number of subscribers, run in their own threads or on an executor.
+# With `--stream_publish_wait=true`, measures the time until the entry has reached all the subscribers.
+# With `--stream_publish_wait=false`, measures the cost of the publish call alone.
+
+if [ ! -f .current/run ] ; then
+  echo "Building '.current/run' to run the tests. You may want to check the compilation flags."
+  make .current/run
+fi
+
+CMD="./.current/run --scenario=stream_publish"
+
+for STREAM_PUBLISH_WAIT in true false ; do
+  for STREAM_PUBLISH_MODE in threads executor ; do
+    for SUBSCRIBERS in 1 10 100 1000 3000 ; do
+      echo -n "wait=$STREAM_PUBLISH_WAIT,$STREAM_PUBLISH_MODE,subscribers=$SUBSCRIBERS : "
+      $CMD \
+        --stream_publish_mode=$STREAM_PUBLISH_MODE \
+        --stream_publish_subscribers=$SUBSCRIBERS \
+        --stream_publish_wait=$STREAM_PUBLISH_WAIT \
+        --threads=1 \
+        --seconds=2
+    done
+  done
+done
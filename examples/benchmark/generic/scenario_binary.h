@@ -0,0 +1,73 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_BINARY_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_BINARY_H
+
+#include "../../../port.h"
+
+#include "../../../typesystem/serialization/binary.h"
+
+#include "scenario_json.h"  // Reuse `TopLevel` for an apples-to-apples comparison with the `json` scenario.
+
+#include "benchmark.h"
+
+#include "../../../bricks/dflags/dflags.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(binary, "gen", "Binary action to take in the performance test, gen/parse/both.");
+#else
+DECLARE_string(binary);
+#endif
+
+SCENARIO(binary, "Binary serialization performance test, same object as in `json`.") {
+  const TopLevel test_object;
+  const std::string test_object_binary;
+  constexpr static size_t test_object_binary_golden_length = 7145;
+  std::function<void()> f;
+
+  binary() : test_object(), test_object_binary(SaveIntoBinary(test_object)) {
+    if (test_object_binary.length() != test_object_binary_golden_length) {
+      std::cerr << "Actual binary length: " << test_object_binary.length() << ", expected "
+                << test_object_binary_golden_length << std::endl;
+      CURRENT_ASSERT(false);
+    }
+    if (FLAGS_binary == "gen") {
+      f = [this]() { SaveIntoBinary(test_object); };
+    } else if (FLAGS_binary == "parse") {
+      f = [this]() { LoadFromBinary<TopLevel>(test_object_binary); };
+    } else if (FLAGS_binary == "both") {
+      f = [this]() { LoadFromBinary<TopLevel>(SaveIntoBinary(test_object)); };
+    } else {
+      std::cerr << "The `--binary` flag must be 'gen', 'parse', or 'both'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+  }
+
+  void RunOneQuery() override { f(); }
+};
+
+REGISTER_SCENARIO(binary);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_BINARY_H
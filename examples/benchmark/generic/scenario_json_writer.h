@@ -0,0 +1,88 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2019 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_JSON_WRITER_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_JSON_WRITER_H
+
+#include "../../../port.h"
+
+#include "../../../typesystem/serialization/json.h"
+
+#define SMOKE_TEST_STRUCT_NAMESPACE benchmark_json_writer
+#include "../../../typesystem/schema/smoke_test_struct.h"
+#undef SMOKE_TEST_STRUCT_NAMESPACE
+
+#include "benchmark.h"
+
+#include "../../../bricks/dflags/dflags.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(json_writer, "sax", "JSON generation path to test, sax/dom/append.");
+#else
+DECLARE_string(json_writer);
+#endif
+
+SCENARIO(json_writer, "JSON generation of the schema smoke test struct, via the SAX writer or via a DOM.") {
+  benchmark_json_writer::FullTest test_object;
+  std::string buffer;
+  std::function<void()> f;
+
+  json_writer() : test_object(benchmark_json_writer::B2()) {
+    using namespace benchmark_json_writer;
+    test_object.q = C{A()};
+    test_object.w2.bar = X();
+    test_object.w5.meh = Y();
+    test_object.v1.push_back("foo");
+    test_object.v2.assign(10u, test_object.primitives);
+    test_object.o = test_object.primitives;
+    test_object.tsc.o5 = std::vector<A>(10u);
+    test_object.tsc.o7["null"] = nullptr;
+    test_object.tsc.o7["value"] = A();
+
+    if (JSON(test_object) != JSONViaRapidJSONDocument(test_object)) {
+      std::cerr << "The SAX and DOM paths produce different JSON-s." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+
+    if (FLAGS_json_writer == "sax") {
+      f = [this]() { JSON(test_object); };
+    } else if (FLAGS_json_writer == "dom") {
+      f = [this]() { JSONViaRapidJSONDocument(test_object); };
+    } else if (FLAGS_json_writer == "append") {
+      f = [this]() {
+        buffer.clear();
+        AppendJSON(buffer, test_object);
+      };
+    } else {
+      std::cerr << "The `--json_writer` flag must be 'sax', 'dom', or 'append'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+  }
+
+  void RunOneQuery() override { f(); }
+};
+
+REGISTER_SCENARIO(json_writer);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_JSON_WRITER_H
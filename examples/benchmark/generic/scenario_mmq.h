@@ -0,0 +1,111 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_MMQ_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_MMQ_H
+
+#include "../../../port.h"
+
+#include "benchmark.h"
+
+#include "../../../blocks/mmq/mmq.h"
+#include "../../../blocks/mmq/lock_free_mmq.h"
+
+#include "../../../bricks/dflags/dflags.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(mmq_impl, "mutex", "The queue to publish into: `mutex` for `MMQ`, or `lock_free` for `LockFreeMMQ`.");
+DEFINE_uint32(mmq_buffer_size, 1024, "The number of messages the queue can hold.");
+DEFINE_bool(mmq_drop_on_overflow, false, "Drop the messages once the queue is full, instead of waiting.");
+DEFINE_bool(mmq_wait, false, "Wait until each published message has reached the consumer.");
+#else
+DECLARE_string(mmq_impl);
+DECLARE_uint32(mmq_buffer_size);
+DECLARE_bool(mmq_drop_on_overflow);
+DECLARE_bool(mmq_wait);
+#endif
+
+// Publishing into an in-memory message queue from `--threads` producers.
+// Without `--mmq_wait`, measures the throughput of the queue. With `--mmq_wait`, each query lasts until the message
+// it has published has reached the consumer, so that the publish-to-consume latency is `--threads` divided by QPS.
+SCENARIO(mmq, "Publish into an in-memory message queue, guarded by a mutex or lock-free.") {
+  struct ConsumerImpl {
+    std::atomic<uint64_t> last_index;
+
+    ConsumerImpl() : last_index(0u) {}
+
+    current::ss::EntryResponse operator()(uint64_t, idxts_t current, idxts_t) {
+      last_index = current.index;
+      return current::ss::EntryResponse::More;
+    }
+  };
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, uint64_t>;
+
+  // The consumer must outlive the queue, which is destructed first.
+  Consumer consumer;
+  std::unique_ptr<current::mmq::MMQ<uint64_t, Consumer, 1024, false>> mmq_waiting;
+  std::unique_ptr<current::mmq::MMQ<uint64_t, Consumer, 1024, true>> mmq_dropping;
+  std::unique_ptr<current::mmq::LockFreeMMQ<uint64_t, Consumer, 1024, false>> lock_free_mmq_waiting;
+  std::unique_ptr<current::mmq::LockFreeMMQ<uint64_t, Consumer, 1024, true>> lock_free_mmq_dropping;
+  std::function<uint64_t()> publish;
+
+  mmq() {
+    if (FLAGS_mmq_impl == "mutex") {
+      if (!FLAGS_mmq_drop_on_overflow) {
+        Create(mmq_waiting);
+      } else {
+        Create(mmq_dropping);
+      }
+    } else if (FLAGS_mmq_impl == "lock_free") {
+      if (!FLAGS_mmq_drop_on_overflow) {
+        Create(lock_free_mmq_waiting);
+      } else {
+        Create(lock_free_mmq_dropping);
+      }
+    } else {
+      std::cerr << "The `--mmq_impl` flag must be 'mutex' or 'lock_free'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+  }
+
+  template <typename QUEUE>
+  void Create(std::unique_ptr<QUEUE>& queue) {
+    queue = std::make_unique<QUEUE>(consumer, FLAGS_mmq_buffer_size);
+    QUEUE* raw_queue = queue.get();
+    publish = [raw_queue]() { return raw_queue->Publish(static_cast<uint64_t>(42u)).index; };
+  }
+
+  void RunOneQuery() override {
+    const uint64_t index = publish();
+    if (FLAGS_mmq_wait && index) {
+      while (consumer.last_index < index) {
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+
+REGISTER_SCENARIO(mmq);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_MMQ_H
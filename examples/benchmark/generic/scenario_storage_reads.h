@@ -0,0 +1,101 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STORAGE_READS_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STORAGE_READS_H
+
+#include "../../../port.h"
+
+#include "benchmark.h"
+
+#include "scenario_storage.h"
+
+#include "../../../storage/transaction_policy.h"
+
+#include "../../../bricks/dflags/dflags.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(storage_reads_policy, "concurrent", "The transaction policy to test reads with, `synchronous` or `concurrent`.");
+DEFINE_uint32(storage_reads_lookups, 100, "The number of lookups per read-only transaction.");
+#else
+DECLARE_string(storage_reads_policy);
+DECLARE_uint32(storage_reads_lookups);
+#endif
+
+// Read-only transactions, run from `--threads` threads, to compare how reads scale with the number of cores
+// under the default `Synchronous` policy, where they are serialized, and under `SynchronousWithConcurrentReads`.
+SCENARIO(storage_reads, "Concurrent read-only storage transactions test.") {
+  using synchronous_storage_t = KeyValueDB<StreamInMemoryStreamPersister>;
+  using concurrent_storage_t =
+      KeyValueDB<StreamInMemoryStreamPersister, current::storage::transaction_policy::SynchronousWithConcurrentReads>;
+
+  Optional<current::Owned<synchronous_storage_t>> synchronous_db;
+  Optional<current::Owned<concurrent_storage_t>> concurrent_db;
+  std::function<void()> f;
+
+  static uint32_t RandomUInt32() { return current::random::RandomIntegral<uint32_t>(1000000, 999999); }
+
+  template <typename STORAGE>
+  static current::Owned<STORAGE> CreateAndPopulate() {
+    auto db = STORAGE::CreateMasterStorage();
+    db->ReadWriteTransaction([](MutableFields<STORAGE> fields) {
+      for (uint32_t i = 0; i < FLAGS_storage_initial_size; ++i) {
+        fields.hashmap_uint32.Add(UInt32KeyValuePair(RandomUInt32(), RandomUInt32()));
+      }
+    }).Wait();
+    return db;
+  }
+
+  template <typename STORAGE>
+  static void Lookup(const STORAGE& db) {
+    Value(db.ReadOnlyTransaction([](ImmutableFields<STORAGE> fields) {
+      size_t found = 0u;
+      for (uint32_t i = 0; i < FLAGS_storage_reads_lookups; ++i) {
+        if (Exists(fields.hashmap_uint32[RandomUInt32()])) {
+          ++found;
+        }
+      }
+      return found;
+    }).Go());
+  }
+
+  storage_reads() {
+    if (FLAGS_storage_reads_policy == "synchronous") {
+      synchronous_db = CreateAndPopulate<synchronous_storage_t>();
+      f = [this]() { Lookup(*Value(synchronous_db)); };
+    } else if (FLAGS_storage_reads_policy == "concurrent") {
+      concurrent_db = CreateAndPopulate<concurrent_storage_t>();
+      f = [this]() { Lookup(*Value(concurrent_db)); };
+    } else {
+      std::cerr << "The `--storage_reads_policy` flag must be 'synchronous' or 'concurrent'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+  }
+
+  void RunOneQuery() override { f(); }
+};
+
+REGISTER_SCENARIO(storage_reads);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STORAGE_READS_H
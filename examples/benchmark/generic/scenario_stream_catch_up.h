@@ -0,0 +1,120 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_CATCH_UP_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_CATCH_UP_H
+
+#include "../../../port.h"
+
+#include "benchmark.h"
+
+#include "../replication/generate_stream.h"
+
+#include "../../../bricks/dflags/dflags.h"
+#include "../../../bricks/file/file.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(stream_catch_up_mode,
+              "subscribe",
+              "How to read the stream from index 0: `subscribe`, `mapped` or `unsafe`. The first one subscribes, "
+              "and the other two call `IterateMapped()` or `IterateUnsafe()` directly.");
+DEFINE_uint32(stream_catch_up_entries, 100000, "The number of entries in the stream to catch up on.");
+DEFINE_uint32(stream_catch_up_entry_length, 100, "The length of each of these entries.");
+#else
+DECLARE_string(stream_catch_up_mode);
+DECLARE_uint32(stream_catch_up_entries);
+DECLARE_uint32(stream_catch_up_entry_length);
+#endif
+
+// Subscribers catching up on a file-persisted stream from index 0, run from `--threads` threads concurrently.
+// Unchecked subscribers to a file-persisted stream receive the raw lines of the memory-mapped file.
+SCENARIO(stream_catch_up, "Concurrent raw subscribers catching up on a persisted stream from its beginning.") {
+  using stream_t = benchmark::replication::stream_t;
+
+  struct CatchUpSubscriberImpl {
+    size_t total_bytes = 0u;
+    std::atomic_bool done;
+
+    CatchUpSubscriberImpl() : done(false) {}
+
+    current::ss::EntryResponse operator()(const current::strings::Chunk& raw_log_line, uint64_t index, idxts_t last) {
+      total_bytes += raw_log_line.length();
+      return index == last.index ? current::ss::EntryResponse::Done : current::ss::EntryResponse::More;
+    }
+
+    current::ss::EntryResponse operator()(std::chrono::microseconds) const { return current::ss::EntryResponse::More; }
+    static current::ss::EntryResponse EntryResponseIfNoMorePassTypeFilter() { return current::ss::EntryResponse::More; }
+    static current::ss::TerminationResponse Terminate() { return current::ss::TerminationResponse::Terminate; }
+  };
+  using CatchUpSubscriber = current::ss::StreamSubscriber<CatchUpSubscriberImpl, benchmark::replication::Entry>;
+
+  const std::string filename;
+  const current::FileSystem::ScopedRmFile file_remover;
+  Optional<current::Owned<stream_t>> stream;
+  std::function<size_t()> f;
+
+  stream_catch_up() : filename(current::FileSystem::GenTmpFileName()), file_remover(filename) {
+    benchmark::replication::GenerateStream(
+        filename, FLAGS_stream_catch_up_entry_length, FLAGS_stream_catch_up_entries, stream);
+    const auto& persister = *Value(stream)->Data();
+    if (FLAGS_stream_catch_up_mode == "subscribe") {
+      f = [this]() {
+        CatchUpSubscriber subscriber;
+        {
+          const auto scope = Value(stream)->SubscribeUnchecked(
+              subscriber, 0u, std::chrono::microseconds(0), [&subscriber]() { subscriber.done = true; });
+          while (!subscriber.done) {
+            std::this_thread::yield();
+          }
+        }
+        return subscriber.total_bytes;
+      };
+    } else if (FLAGS_stream_catch_up_mode == "mapped") {
+      f = [&persister]() {
+        size_t total_bytes = 0u;
+        for (const auto& e : persister.IterateMapped()) {
+          total_bytes += e.length();
+        }
+        return total_bytes;
+      };
+    } else if (FLAGS_stream_catch_up_mode == "unsafe") {
+      f = [&persister]() {
+        size_t total_bytes = 0u;
+        for (const auto& e : persister.IterateUnsafe()) {
+          total_bytes += e.length();
+        }
+        return total_bytes;
+      };
+    } else {
+      std::cerr << "The `--stream_catch_up_mode` flag must be 'subscribe', 'mapped' or 'unsafe'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+  }
+
+  void RunOneQuery() override { CURRENT_ASSERT(f() > 0u); }
+};
+
+REGISTER_SCENARIO(stream_catch_up);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_CATCH_UP_H
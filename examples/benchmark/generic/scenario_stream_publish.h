@@ -0,0 +1,112 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#ifndef EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_PUBLISH_H
+#define EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_PUBLISH_H
+
+#include "../../../port.h"
+
+#include "benchmark.h"
+
+#include "../replication/entry.h"
+
+#include "../../../stream/stream.h"
+
+#include "../../../bricks/dflags/dflags.h"
+
+#ifndef CURRENT_MAKE_CHECK_MODE
+DEFINE_string(stream_publish_mode,
+              "threads",
+              "How to run the subscribers: `threads` for a dedicated thread each, or `executor` for a shared pool.");
+DEFINE_uint32(stream_publish_subscribers, 100, "The number of subscribers tailing the stream.");
+DEFINE_uint32(stream_publish_executor_threads,
+              4,
+              "The number of threads of the executor, zero for the number of cores.");
+DEFINE_bool(stream_publish_wait, true, "Wait until each published entry has reached all the subscribers.");
+#else
+DECLARE_string(stream_publish_mode);
+DECLARE_uint32(stream_publish_subscribers);
+DECLARE_uint32(stream_publish_executor_threads);
+DECLARE_bool(stream_publish_wait);
+#endif
+
+// Publishing into an in-memory stream tailed by `--stream_publish_subscribers` subscribers.
+// With `--stream_publish_wait`, each query lasts until the entry it has published has reached all the subscribers.
+SCENARIO(stream_publish, "Publish into a stream with many subscribers, each in its own thread or on an executor.") {
+  using stream_t = current::stream::Stream<benchmark::replication::Entry>;
+
+  struct TailSubscriberImpl {
+    std::atomic<uint64_t> entries_seen;
+
+    TailSubscriberImpl() : entries_seen(0u) {}
+
+    current::ss::EntryResponse operator()(const benchmark::replication::Entry&, idxts_t current, idxts_t) {
+      entries_seen = current.index + 1u;
+      return current::ss::EntryResponse::More;
+    }
+
+    current::ss::EntryResponse operator()(std::chrono::microseconds) const { return current::ss::EntryResponse::More; }
+    static current::ss::EntryResponse EntryResponseIfNoMorePassTypeFilter() { return current::ss::EntryResponse::More; }
+    static current::ss::TerminationResponse Terminate() { return current::ss::TerminationResponse::Terminate; }
+  };
+  using TailSubscriber = current::ss::StreamSubscriber<TailSubscriberImpl, benchmark::replication::Entry>;
+
+  current::Owned<stream_t> stream;
+  std::vector<std::unique_ptr<TailSubscriber>> subscribers;
+  std::vector<current::stream::SubscriberScope> scopes;
+
+  stream_publish() : stream(stream_t::CreateStream()) {
+    if (FLAGS_stream_publish_mode == "executor") {
+      stream->SetSubscriberExecutor(
+          std::make_shared<current::stream::SubscriberExecutor>(FLAGS_stream_publish_executor_threads));
+    } else if (FLAGS_stream_publish_mode != "threads") {
+      std::cerr << "The `--stream_publish_mode` flag must be 'threads' or 'executor'." << std::endl;
+      CURRENT_ASSERT(false);
+    }
+    for (uint32_t i = 0; i < FLAGS_stream_publish_subscribers; ++i) {
+      subscribers.push_back(std::make_unique<TailSubscriber>());
+      scopes.push_back(stream->Subscribe(*subscribers.back()));
+    }
+  }
+
+  ~stream_publish() {
+    // The subscribers must be gone before the stream is.
+    scopes.clear();
+  }
+
+  void RunOneQuery() override {
+    const uint64_t index = stream->Publisher()->Publish(benchmark::replication::Entry("x")).index;
+    if (FLAGS_stream_publish_wait) {
+      for (const auto& subscriber : subscribers) {
+        while (subscriber->entries_seen <= index) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+};
+
+REGISTER_SCENARIO(stream_publish);
+
+#endif  // EXAMLPES_BENCHMARK_GENERIC_SCENARIO_STREAM_PUBLISH_H
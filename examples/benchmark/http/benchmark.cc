@@ -28,6 +28,21 @@ SOFTWARE.
 
 using namespace current;
 
+// Every heap allocation made by this binary is counted, to report the number of allocations per request.
+// With `--spawn_server`, this covers both the client and the server side of the requests.
+static std::atomic<uint64_t> allocations_count(0u);
+
+void* operator new(size_t size) {
+  ++allocations_count;
+  if (void* p = std::malloc(size ? size : 1u)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 DEFINE_double(seconds, 2.5, "Run the load test for this many seconds.");
 DEFINE_string(url,
               "http://localhost:%d/add",
@@ -40,14 +55,49 @@ DEFINE_int32(threads,
              "measurement will be imprecise if (ping) / (time to service the request) is greater than "
              "FLAGS_threads. Thus, this benchmarking tool is not useful when profiling remote servers.");
 
+DEFINE_bool(spawn_server, false, "Set to run the server in this binary, on `--port`, instead of using `binary.cc`.");
+DEFINE_string(engine, "accept", "The engine of the spawned server, `accept` or `epoll`. Requires `--spawn_server`.");
+DEFINE_int32(workers, 0, "The number of workers for the `epoll` engine, 0 for one per core.");
+DEFINE_bool(keep_alive,
+            false,
+            "Set to send the requests of each thread over one persistent connection, instead of connecting for each "
+            "request. With `--spawn_server`, also enables keep-alive in the `epoll` engine.");
+DEFINE_int32(slow_clients,
+             0,
+             "The number of extra connections that send an incomplete request and then stay silent for the whole "
+             "duration of the test, to see how the server copes with slow clients.");
+
 int main(int argc, char** argv) {
   ParseDFlags(&argc, &argv);
 
+  std::unique_ptr<BenchmarkTestServer> server;
+  if (FLAGS_spawn_server) {
+    server = std::make_unique<BenchmarkTestServer>(
+        FLAGS_port,
+        "/add",
+        BenchmarkServerOptions(FLAGS_engine, static_cast<size_t>(FLAGS_workers), FLAGS_keep_alive));
+  }
+
+  // NOTE: The slow clients hang up on their own once the test is over, as with the `accept` engine
+  // the workers would otherwise wait for them forever.
+  std::vector<std::thread> slow_clients;
+  for (int i = 0; i < FLAGS_slow_clients; ++i) {
+    slow_clients.emplace_back([]() {
+      try {
+        net::Connection connection(net::ClientSocket("localhost", FLAGS_port));
+        connection.BlockingWrite("GET /add?a=1&b=1 HTTP/1.1\r\n", true);
+        std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int64_t>(FLAGS_seconds * 1e6)));
+      } catch (const net::SocketException&) {
+      }
+    });
+  }
+
   class Worker {
    public:
     explicit Worker(double seconds) : seconds_(seconds), queries_(0u), thread_(&Worker::Thread, this) {}
     void Join() { thread_.join(); }
     size_t TotalQueries() const { return queries_; }
+    const std::vector<double>& LatenciesInMilliseconds() const { return latencies_ms_; }
 
    private:
     static double NowInSeconds() { return 1e-6 * static_cast<double>(time::Now().count()); }
@@ -56,19 +106,46 @@ int main(int argc, char** argv) {
       while (NowInSeconds() < timestamp_end) {
         const int a = current::random::RandomIntegral(-1000000, +1000000);
         const int b = current::random::RandomIntegral(-1000000, +1000000);
-        const auto r =
-            HTTP(GET(strings::Printf(FLAGS_url.c_str(), FLAGS_port) + strings::Printf("?a=%d&b=%d", a, b)));
-        CURRENT_ASSERT(r.code == HTTPResponseCode.OK);
-        CURRENT_ASSERT(ParseJSON<AddResult>(r.body).sum == a + b);
+        const std::string query = strings::Printf("?a=%d&b=%d", a, b);
+        const double request_begin = NowInSeconds();
+        if (!FLAGS_keep_alive) {
+          const auto r = HTTP(GET(strings::Printf(FLAGS_url.c_str(), FLAGS_port) + query));
+          latencies_ms_.push_back(1e3 * (NowInSeconds() - request_begin));
+          CURRENT_ASSERT(r.code == HTTPResponseCode.OK);
+          CURRENT_ASSERT(ParseJSON<AddResult>(r.body).sum == a + b);
+        } else {
+          const std::string body = KeepAliveGET(query);
+          latencies_ms_.push_back(1e3 * (NowInSeconds() - request_begin));
+          CURRENT_ASSERT(ParseJSON<AddResult>(body).sum == a + b);
+        }
         ++queries_;
       }
     }
 
+    // Sends the request over the persistent connection, and reconnects if the server has closed it.
+    std::string KeepAliveGET(const std::string& query) {
+      const url::URL url(strings::Printf(FLAGS_url.c_str(), FLAGS_port));
+      if (!connection_) {
+        connection_ = std::make_unique<net::Connection>(net::ClientSocket(url.host, url.port));
+      }
+      connection_->BlockingWrite("GET " + url.path + query + " HTTP/1.1\r\nHost: " + url.host + "\r\n\r\n", false);
+      const net::HTTPZeroCopyRequestData response(*connection_);
+      CURRENT_ASSERT(response.RawPath() == "200");
+      if (!response.HasHeader("Connection") || response.HeaderValue("Connection") != "keep-alive") {
+        connection_ = nullptr;
+      }
+      return response.Body();
+    }
+
     const double seconds_;
     size_t queries_;
+    std::vector<double> latencies_ms_;
+    std::unique_ptr<net::Connection> connection_;
     std::thread thread_;
   };
 
+  const uint64_t allocations_count_begin = allocations_count;
+
   std::vector<std::unique_ptr<Worker>> threads(FLAGS_threads);
   for (auto& t : threads) {
     t = std::make_unique<Worker>(FLAGS_seconds);
@@ -78,10 +155,34 @@ int main(int argc, char** argv) {
     t->Join();
   }
 
+  const uint64_t allocations_count_end = allocations_count;
+
+  for (auto& t : slow_clients) {
+    t.join();
+  }
+
   size_t total_queries = 0u;
+  std::vector<double> latencies_ms;
   for (auto& t : threads) {
     total_queries += t->TotalQueries();
+    latencies_ms.insert(latencies_ms.end(), t->LatenciesInMilliseconds().begin(), t->LatenciesInMilliseconds().end());
   }
 
   std::cout << "QPS: " << std::setw(3) << (total_queries / FLAGS_seconds) << std::endl;
+  if (total_queries) {
+    std::cout << strings::Printf("Allocations per request: %.1lf",
+                                 static_cast<double>(allocations_count_end - allocations_count_begin) /
+                                     total_queries) << std::endl;
+  }
+  if (!latencies_ms.empty()) {
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    const auto percentile = [&latencies_ms](double p) {
+      return latencies_ms[std::min(latencies_ms.size() - 1, static_cast<size_t>(p * latencies_ms.size()))];
+    };
+    std::cout << strings::Printf("Latency, ms: p50 %.3lf, p90 %.3lf, p99 %.3lf, max %.3lf",
+                                 percentile(0.50),
+                                 percentile(0.90),
+                                 percentile(0.99),
+                                 latencies_ms.back()) << std::endl;
+  }
 }
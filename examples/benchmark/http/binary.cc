@@ -31,9 +31,16 @@ using namespace current;
 
 DEFINE_string(benchmark_local_route, "/add", "The route spawn the server on.");
 DEFINE_int32(benchmark_local_port, PickPortForUnitTest(), "The local port to spawn the server on.");
+DEFINE_string(benchmark_local_engine, "accept", "The HTTP server engine to use, `accept` or `epoll`.");
+DEFINE_int32(benchmark_local_workers, 0, "The number of worker threads for the `epoll` engine, 0 for one per core.");
+DEFINE_bool(benchmark_local_keep_alive, false, "Set to keep the connections alive, with the `epoll` engine.");
 
 int main(int argc, char** argv) {
   ParseDFlags(&argc, &argv);
 
-  BenchmarkTestServer(FLAGS_benchmark_local_port, FLAGS_benchmark_local_route).Join();
+  BenchmarkTestServer(FLAGS_benchmark_local_port,
+                      FLAGS_benchmark_local_route,
+                      BenchmarkServerOptions(FLAGS_benchmark_local_engine,
+                                             static_cast<size_t>(FLAGS_benchmark_local_workers),
+                                             FLAGS_benchmark_local_keep_alive)).Join();
 }
@@ -32,21 +32,40 @@ CURRENT_STRUCT(AddResult) {
   CURRENT_CONSTRUCTOR(AddResult)(int64_t sum = 0) : sum(sum) {}
 };
 
+// `engine` is either "accept", for the default accept loop, or "epoll", for the epoll reactor with a worker pool.
+// Keep-alive is only supported by the "epoll" engine.
+inline current::http::HTTPServerOptions BenchmarkServerOptions(const std::string& engine,
+                                                               size_t workers,
+                                                               bool keep_alive = false) {
+  if (engine == "accept") {
+    return current::http::HTTPServerOptions::AcceptLoop();
+  } else if (engine == "epoll") {
+    const auto options = current::http::HTTPServerOptions::EPoll(workers);
+    return keep_alive ? options.KeepAlive() : options;
+  } else {
+    std::cerr << "The engine should be either `accept` or `epoll`, not `" << engine << "`." << std::endl;
+    std::exit(-1);
+  }
+}
+
 class BenchmarkTestServer {
  public:
-  BenchmarkTestServer(int port, const std::string& route)
-      : port_(port),
-        scope_(HTTP(port).Register(route,
-                                   [](Request r) {
-                                     r(AddResult(current::FromString<int64_t>(r.url.query["a"]) +
-                                                 current::FromString<int64_t>(r.url.query["b"])));
-                                   }) +
-               HTTP(port).Register("/perftest", [](Request r) { r("perftest ok\n"); })) {}
+  BenchmarkTestServer(int port,
+                      const std::string& route,
+                      const current::http::HTTPServerOptions& options = current::http::HTTPServerOptions())
+      : server_(HTTP(port, options)),
+        scope_(server_.Register(route,
+                                [](Request r) {
+                                  r(AddResult(current::FromString<int64_t>(r.url.query["a"]) +
+                                              current::FromString<int64_t>(r.url.query["b"])));
+                                }) +
+               server_.Register("/perftest", [](Request r) { r("perftest ok\n"); })) {}
 
-  void Join() { HTTP(port_).Join(); }
+  void Join() { server_.Join(); }
 
  private:
-  const int port_;
+  // NOTE: The server is obtained once, before the routes are registered, so that it is created with `options`.
+  current::http::HTTPServerPOSIX& server_;
   HTTPRoutesScope scope_;
 };
 
@@ -48,7 +48,7 @@ struct FakeStreamReplicatorImpl {
   using TerminationResponse = current::ss::TerminationResponse;
   using entry_t = STREAM_ENTRY;
 
-  FakeStreamReplicatorImpl() : whole_data_length_(0) {}
+  FakeStreamReplicatorImpl() : count_of_a_letters_(0u), entries_replicated_(0u), whole_data_length_(0u) {}
   virtual ~FakeStreamReplicatorImpl() = default;
 
   EntryResponse operator()(entry_t&& entry, idxts_t current, idxts_t last) {
@@ -153,8 +153,10 @@ void Replicate(ARGS&&... args) {
                                                      : current::stream::SubscriptionMode::Unchecked;
     const auto subscriber_scope =
         FLAGS_use_safe_replication
-            ? static_cast<current::stream::SubscriberScope>(remote_stream.Subscribe(*replicator, 0, mode))
-            : static_cast<current::stream::SubscriberScope>(remote_stream.SubscribeUnchecked(*replicator, 0, mode));
+            ? static_cast<current::stream::SubscriberScope>(
+                  remote_stream.Subscribe(*replicator, 0u, std::chrono::microseconds(0), mode))
+            : static_cast<current::stream::SubscriberScope>(
+                  remote_stream.SubscribeUnchecked(*replicator, 0u, std::chrono::microseconds(0), mode));
     std::cerr << "\b\b\bOK" << std::endl;
     auto next_print_time = start_time + print_delay;
 
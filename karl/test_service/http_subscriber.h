@@ -107,8 +107,8 @@ class HTTPStreamSubscriber {
   std::atomic_bool destructing_;
   uint64_t index_;
   std::atomic_bool has_terminate_id_;
+  std::string terminate_id_;  // Must be constructed before `thread_` starts, as `OnHeader()` may set it right away.
   std::thread thread_;
-  std::string terminate_id_;
 };
 
 #endif  // KARL_TEST_SERVICE_HTTP_SUBSCRIBER_H
@@ -175,6 +175,13 @@ inline void CURRENT_NSLOG(...) {}
 #define CURRENT_HAS_THREAD_LOCAL
 #endif
 
+// zlib, for the gzip and deflate HTTP content encodings, is linked by the POSIX makefiles, see `scripts/MakefileImpl`.
+// Elsewhere, or with `CURRENT_NO_ZLIB`, the HTTP responses are not compressed, unless `CURRENT_HAS_ZLIB` is defined
+// explicitly, and zlib is linked.
+#if !defined(CURRENT_HAS_ZLIB) && !defined(CURRENT_WINDOWS) && !defined(CURRENT_NO_ZLIB)
+#define CURRENT_HAS_ZLIB
+#endif
+
 // Current internals rely heavily on specific implementations of certain data types.
 static_assert(sizeof(uint8_t) == 1u, "`uint8_t` must be exactly 1 byte.");
 static_assert(sizeof(uint16_t) == 2u, "`uint16_t` must be exactly 2 bytes.");
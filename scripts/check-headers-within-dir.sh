@@ -10,7 +10,7 @@ set -u -e
 EXTRA_INCLUDE_DIR="${1:-.}"
 
 CPPFLAGS="-std=c++11 -g -Wall -W -DCURRENT_MAKE_CHECK_MODE -fPIC"
-LDFLAGS="-pthread"
+LDFLAGS="-pthread -lz"
 
 if [ $(uname) = "Darwin" ] ; then
   CPPFLAGS+=" -stdlib=libc++ -x objective-c++ -fobjc-arc"
@@ -5,7 +5,7 @@
 set -u -e
 
 CPPFLAGS="-std=c++11 -g -Wall -W -fprofile-arcs -ftest-coverage -DCURRENT_COVERAGE_REPORT_MODE"
-LDFLAGS="-pthread"
+LDFLAGS="-pthread -lz"
 
 # NOTE: TMP_DIR must be resolved from the current working directory.
 
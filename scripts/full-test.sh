@@ -9,7 +9,7 @@
 set -u -e
 
 CPPFLAGS="-std=c++11 -g -Wall -W -fprofile-arcs -ftest-coverage -DCURRENT_COVERAGE_REPORT_MODE"
-LDFLAGS="-pthread -ldl"
+LDFLAGS="-pthread -ldl -lz"
 if [ $(uname) = "Darwin" ] ; then
   CPPFLAGS+=" -stdlib=libc++ -x objective-c++ -fobjc-arc"
   LDFLAGS+=" -framework Foundation"
@@ -137,9 +137,9 @@ struct PerFieldRESTfulHandlerGenerator {
     const auto generic_data_handler = [&storage, restful_url_prefix, field_name](Request request) {
       // TODO(dkorolev): Pass `BorrowedWithCallback<Storage>` into the request handler.
       auto generic_input = RESTfulGenericInput<STORAGE>(storage, restful_url_prefix);
-      std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
-      const bool is_master = storage.template IsMasterStorage<current::locks::MutexLockStatus::AlreadyLocked>();
       if (request.method == "GET") {
+        // The reads do not lock the publishing mutex, but leave the locking to the transaction policy of the storage,
+        // so that, with `SynchronousWithConcurrentReads`, they run concurrently with each other.
         GETHandler handler;
         Optional<FieldExportParams> requested_export_params;
         if (request.url.query.has(kRESTfulExportURLQueryParameter)) {
@@ -154,30 +154,35 @@ struct PerFieldRESTfulHandlerGenerator {
         handler.Enter(
             std::move(request),
             // Capture by reference since this lambda is run synchronously.
-            [&storage, &handler, &generic_input, &field_name, requested_export_params](
+            [&handler, &generic_input, &field_name, requested_export_params](
                 Request request,
                 const Optional<typename field_type_dependent_t<specific_field_t>::url_key_t>& url_key) {
               const specific_field_t& field = generic_input.storage(::current::storage::ImmutableFieldByIndex<INDEX>());
               generic_input.storage
-                  .template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
+                  .ReadOnlyTransaction(
                        // Capture local variables by value for safe async transactions.
-                       [&storage, handler, generic_input, &field, url_key, field_name, requested_export_params](
+                       [handler, generic_input, &field, url_key, field_name, requested_export_params](
                            immutable_fields_t fields) -> Response {
+                         // Read within the transaction, so that it agrees with the fields being exported.
+                         const bool is_master = generic_input.storage.IsMasterStorageFromLockedSection();
                          using GETInput = RESTfulGETInput<STORAGE, specific_field_t>;
-                         const GETInput input(
-                             std::move(generic_input),
-                             fields,
-                             field,
-                             field_name,
-                             url_key,
-                             storage.template IsMasterStorage<current::locks::MutexLockStatus::AlreadyLocked>(),
-                             requested_export_params);
+                         const GETInput input(std::move(generic_input),
+                                              fields,
+                                              field,
+                                              field_name,
+                                              url_key,
+                                              is_master,
+                                              requested_export_params);
                          return handler.Run(input);
                        },
                        std::move(request))
                   .Detach();
             });
-      } else if (request.method == "POST" && is_master) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
+      const bool is_master = storage.template IsMasterStorage<current::locks::MutexLockStatus::AlreadyLocked>();
+      if (request.method == "POST" && is_master) {
         POSTHandler handler;
         handler.Enter(
             std::move(request),
@@ -329,7 +334,7 @@ struct PerFieldRESTfulHandlerGenerator {
 
     return [&storage, restful_url_prefix, field_name](Request request) {
       // TODO(dkorolev): Pass `BorrowedWithCallback<Storage>` into the request handler.
-      std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
+      // Read-only, so the locking is left to the transaction policy of the storage.
       auto generic_input = RESTfulGenericInput<STORAGE>(storage, restful_url_prefix);
       if (request.method == "GET") {
         DataHandlerImpl<GET, PARTIAL_KEY_OPERATION, specific_field_t, entry_t, key_t> handler;
@@ -338,7 +343,7 @@ struct PerFieldRESTfulHandlerGenerator {
             // Capture by reference since this lambda is run synchronously.
             [&handler, &generic_input, &field_name](Request request, const Optional<std::string>& url_key) {
               const specific_field_t& field = generic_input.storage(::current::storage::ImmutableFieldByIndex<INDEX>());
-              generic_input.storage.template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
+              generic_input.storage.ReadOnlyTransaction(
                                         // Capture local variables by value for safe async transactions.
                                         [handler, generic_input, &field, url_key, field_name](
                                             immutable_fields_t fields) -> Response {
@@ -592,7 +597,7 @@ class RESTfulStorage {
     const Data& data = *data_;
 
     const auto cqs_query_handler = [&data, &storage, restful_url_prefix](Request request) {
-      std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
+      // Read-only, so the locking is left to the transaction policy of the storage.
       if (request.url_path_args.empty()) {
         request(Response(cqs::CQSHandlerNotSpecified(), HTTPResponseCode.NotFound));
       } else if (request.method != "GET") {
@@ -616,7 +621,7 @@ class RESTfulStorage {
                 [&handler, &f_run_query, &generic_input, &type_erased_query, &context](Request request) {
                   const STORAGE_IMPL& storage = generic_input.storage;
                   const cqs::CQSParameters cqs_parameters(generic_input.restful_url_prefix, request);
-                  storage.template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
+                  storage.ReadOnlyTransaction(
                               // TODO(dkorolev): Revisit this as Owned/Borrowed are the organic part of Storage.
                               // Capture local variables by value for safe async transactions.
                               [&f_run_query, handler, cqs_parameters, type_erased_query, context](
@@ -25,6 +25,9 @@ SOFTWARE.
 #ifndef CURRENT_STORAGE_CONTAINER_COMMON_H
 #define CURRENT_STORAGE_CONTAINER_COMMON_H
 
+#include <chrono>
+#include <memory>
+
 #include "../../bricks/util/comparators.h"
 
 namespace current {
@@ -37,6 +40,42 @@ using Unordered = std::unordered_map<KEY, VALUE, GenericHashFunction<KEY>>;
 template <typename KEY, typename VALUE>
 using Ordered = std::map<KEY, VALUE, CurrentComparator<KEY>>;
 
+namespace impl {
+
+template <typename T>
+const T& SnapshotValue(const T& value) {
+  return value;
+}
+
+template <typename T>
+const T& SnapshotValue(const std::unique_ptr<T>& value) {
+  return *value;
+}
+
+}  // namespace impl
+
+// Passes to `f` the events which, replayed into an empty container, recreate its state, last modified
+// timestamps included. The deletions of the erased keys go first, so that, replayed into the matrix containers,
+// they only restore the timestamps and do not touch the rows and cols of the entries restored afterwards.
+// Shared by the `ExportSnapshot()` methods of all the containers; `map` holds the values or owning pointers to them.
+template <typename UPDATE_EVENT, typename DELETE_EVENT, typename LAST_MODIFIED, typename MAP, typename F>
+void ExportSnapshotOfContainer(const LAST_MODIFIED& last_modified, const MAP& map, F&& f) {
+  for (const auto& lm : last_modified) {
+    if (map.find(lm.first) == map.end()) {
+      DELETE_EVENT e;
+      e.us = lm.second;
+      e.key = lm.first;
+      f(std::move(e));
+    }
+  }
+  for (const auto& lm : last_modified) {
+    const auto cit = map.find(lm.first);
+    if (cit != map.end()) {
+      f(UPDATE_EVENT(lm.second, impl::SnapshotValue(cit->second)));
+    }
+  }
+}
+
 }  // namespace container
 }  // namespace storage
 }  // namespace current
@@ -178,6 +178,13 @@ class GenericDictionary {
     last_modified_[e.key] = e.us;
     map_.erase(e.key);
   }
+
+  // Passes to `f` the events which, replayed into an empty container, recreate its state.
+  // See `ExportSnapshotOfContainer()` in `common.h`.
+  template <typename F>
+  void ExportSnapshot(F&& f) const {
+    ExportSnapshotOfContainer<UPDATE_EVENT, DELETE_EVENT>(last_modified_, map_, std::forward<F>(f));
+  }
 #ifdef CURRENT_STORAGE_PATCH_SUPPORT
   struct DummyStructForNonExistentPatch {};  // Essential, as can't form a reference to `void` even if disabled.
   void operator()(const typename std::conditional<HasPatch<entry_t>(),
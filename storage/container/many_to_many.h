@@ -152,6 +152,12 @@ class GenericManyToMany {
   }
   void operator()(const DELETE_EVENT& e) { DoEraseWithLastModified(e.us, std::make_pair(e.key.first, e.key.second)); }
 
+  // See `ExportSnapshotOfContainer()` in `common.h`.
+  template <typename F>
+  void ExportSnapshot(F&& f) const {
+    ExportSnapshotOfContainer<UPDATE_EVENT, DELETE_EVENT>(last_modified_, map_, std::forward<F>(f));
+  }
+
   template <typename OUTER_MAP>
   struct OuterAccessor final {
     using OUTER_KEY = typename OUTER_MAP::key_type;
@@ -199,6 +199,12 @@ class GenericOneToMany {
   }
   void operator()(const DELETE_EVENT& e) { DoEraseWithLastModified(e.us, std::make_pair(e.key.first, e.key.second)); }
 
+  // See `ExportSnapshotOfContainer()` in `common.h`.
+  template <typename F>
+  void ExportSnapshot(F&& f) const {
+    ExportSnapshotOfContainer<UPDATE_EVENT, DELETE_EVENT>(last_modified_, map_, std::forward<F>(f));
+  }
+
   template <typename ROWS_MAP>
   struct RowsAccessor final {
     using key_t = typename ROWS_MAP::key_type;
@@ -249,6 +249,12 @@ class GenericOneToOne {
   }
   void operator()(const DELETE_EVENT& e) { DoEraseWithLastModified(e.us, std::make_pair(e.key.first, e.key.second)); }
 
+  // See `ExportSnapshotOfContainer()` in `common.h`.
+  template <typename F>
+  void ExportSnapshot(F&& f) const {
+    ExportSnapshotOfContainer<UPDATE_EVENT, DELETE_EVENT>(last_modified_, map_, std::forward<F>(f));
+  }
+
   using rows_outer_accessor_t = GenericMapAccessor<forward_map_t>;
   rows_outer_accessor_t Rows() const { return GenericMapAccessor<forward_map_t>(forward_); }
 
@@ -47,19 +47,23 @@ class StreamStreamPersisterImpl final {
                                                      transaction_t,
                                                      STREAM_RECORD_TYPE>::type;
   using stream_t = stream::Stream<stream_entry_t, UNDERLYING_PERSISTER>;
-  using fields_update_function_t = std::function<void(const variant_t&)>;
+  // Applies all the mutations of a transaction, so that the storage can lock its fields once per transaction.
+  // The second argument advances the persisted position, and must be called within the same locked section
+  // as the mutations, so that no reader of the fields can observe the position and the fields disagree.
+  using fields_update_function_t = std::function<void(const transaction_t&, const std::function<void()>&)>;
 
   struct StreamSubscriberImpl {
     using EntryResponse = current::ss::EntryResponse;
     using TerminationResponse = current::ss::TerminationResponse;
-    using replay_function_t = std::function<void(const transaction_t&, std::chrono::microseconds)>;
+    using replay_function_t = std::function<void(const transaction_t&, idxts_t)>;
     replay_function_t replay_f_;
-    uint64_t next_replay_index_ = 0u;
+    uint64_t next_replay_index_;
 
-    StreamSubscriberImpl(replay_function_t f) : replay_f_(f) {}
+    StreamSubscriberImpl(replay_function_t f, uint64_t next_replay_index)
+        : replay_f_(f), next_replay_index_(next_replay_index) {}
 
     EntryResponse operator()(const transaction_t& transaction, idxts_t current, idxts_t) {
-      replay_f_(transaction, current.us);
+      replay_f_(transaction, current);
       next_replay_index_ = current.index + 1u;
       return EntryResponse::More;
     }
@@ -74,31 +78,47 @@ class StreamStreamPersisterImpl final {
   struct Master {};
   struct Following {};
 
-  StreamStreamPersisterImpl(Master, fields_update_function_t f, Borrowed<stream_t> stream)
+  // The optional `next_index` and `last_applied_timestamp` are set when the fields already reflect the stream
+  // up to a certain point, i.e. have been loaded from a snapshot, so that only the remaining entries are replayed.
+  StreamStreamPersisterImpl(Master,
+                            fields_update_function_t f,
+                            Borrowed<stream_t> stream,
+                            uint64_t next_index = 0u,
+                            std::chrono::microseconds last_applied_timestamp = std::chrono::microseconds(-1))
       : fields_update_f_(f),
         stream_publishing_mutex_ref_(stream->Impl()->publishing_mutex),
         stream_(std::move(stream)),
-        publisher_used_(stream_->BecomeFollowingStream()) {
+        publisher_used_(stream_->BecomeFollowingStream()),
+        next_index_(next_index),
+        last_applied_timestamp_(last_applied_timestamp) {
     subscriber_instance_ = std::make_unique<StreamSubscriber>(
-        [this](const transaction_t& transaction, std::chrono::microseconds timestamp) {
+        [this](const transaction_t& transaction, idxts_t idxts) {
           std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-          ApplyMutationsFromLockedSectionOrConstructor(transaction, timestamp);
-        });
+          ApplyMutationsFromLockedSectionOrConstructor(transaction, idxts);
+        },
+        next_index);
     std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-    SyncReplayStreamFromLockedSectionOrConstructor(0u);
+    SyncReplayStreamFromLockedSectionOrConstructor(next_index);
   }
 
-  StreamStreamPersisterImpl(Following, fields_update_function_t f, Borrowed<stream_t> stream)
+  StreamStreamPersisterImpl(Following,
+                            fields_update_function_t f,
+                            Borrowed<stream_t> stream,
+                            uint64_t next_index = 0u,
+                            std::chrono::microseconds last_applied_timestamp = std::chrono::microseconds(-1))
       : fields_update_f_(f),
         stream_publishing_mutex_ref_(stream->Impl()->publishing_mutex),
-        stream_(std::move(stream)) {
+        stream_(std::move(stream)),
+        next_index_(next_index),
+        last_applied_timestamp_(last_applied_timestamp) {
     subscriber_instance_ = std::make_unique<StreamSubscriber>(
-        [this](const transaction_t& transaction, std::chrono::microseconds timestamp) {
+        [this](const transaction_t& transaction, idxts_t idxts) {
           std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-          ApplyMutationsFromLockedSectionOrConstructor(transaction, timestamp);
-        });
+          ApplyMutationsFromLockedSectionOrConstructor(transaction, idxts);
+        },
+        next_index);
     std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-    SubscribeToStreamFromLockedSection();
+    SubscribeToStreamFromLockedSection(next_index);
   }
 
   ~StreamStreamPersisterImpl() {
@@ -118,6 +138,16 @@ class StreamStreamPersisterImpl final {
     return last_applied_timestamp_;
   }
 
+  // Whether the storage is the master one, consistently with the fields the transaction observes.
+  // Invariant: the fields are locked for the transaction.
+  bool IsMasterStoragePersisterFromLockedSection() const { return Exists(publisher_used_); }
+
+  // The index of the first stream entry not yet applied to the fields, and the timestamp of the last one applied.
+  // Invariant: the fields are locked for the transaction, so that these two stay consistent with them.
+  std::pair<uint64_t, std::chrono::microseconds> NextIndexAndLastAppliedTimestampFromLockedSection() const {
+    return std::make_pair(next_index_, last_applied_timestamp_);
+  }
+
   void PersistJournalFromLockedSection(MutationJournal& journal) {
     const std::chrono::microseconds timestamp = current::time::Now();
     CURRENT_ASSERT(Exists(publisher_used_));
@@ -132,9 +162,12 @@ class StreamStreamPersisterImpl final {
         transaction.mutations.emplace_back(BypassVariantTypeCheck(), std::move(entry));
       }
       std::swap(transaction.meta, journal.transaction_meta);
-      Value(publisher_used_)
-          ->template Publish<current::locks::MutexLockStatus::AlreadyLocked>(std::move(transaction), timestamp);
-      SetLastAppliedTimestampFromLockedSection(timestamp);
+      // With the file persister in the `GroupCommit` mode, this waits for the commit with the publish mutex held,
+      // so the transactions are not batched together, see `group_commit.h`.
+      const idxts_t idxts =
+          Value(publisher_used_)
+              ->template Publish<current::locks::MutexLockStatus::AlreadyLocked>(std::move(transaction), timestamp);
+      SetLastAppliedFromLockedSection(idxts);
     }
     journal.Clear();
   }
@@ -165,11 +198,13 @@ class StreamStreamPersisterImpl final {
     } else {
       TerminateStreamSubscriptionFromLockedSection();
       std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-      publisher_used_ = nullptr;
-      publisher_used_ = stream_->template BecomeFollowingStream<current::locks::MutexLockStatus::AlreadyLocked>();
+      auto publisher = stream_->template BecomeFollowingStream<current::locks::MutexLockStatus::AlreadyLocked>();
       const uint64_t save_replay_index = subscriber_instance_->next_replay_index_;
       subscriber_instance_ = nullptr;
       SyncReplayStreamFromLockedSectionOrConstructor(save_replay_index);
+      // Flip to master under the same lock as the fields, with no mutations to apply, so that a transaction
+      // observes the storage as the master one only once it has caught up with the stream.
+      fields_update_f_(transaction_t(), [this, &publisher]() { publisher_used_ = std::move(publisher); });
     }
   }
 
@@ -183,34 +218,31 @@ class StreamStreamPersisterImpl final {
          stream_->Data()->template Iterate<current::locks::MutexLockStatus::AlreadyLocked>(from_idx)) {
       if (Exists<transaction_t>(stream_record.entry)) {
         const transaction_t& transaction = Value<transaction_t>(stream_record.entry);
-        ApplyMutationsFromLockedSectionOrConstructor(transaction, stream_record.idx_ts.us);
+        ApplyMutationsFromLockedSectionOrConstructor(transaction, stream_record.idx_ts);
       }
     }
   }
 
-  void ApplyMutationsFromLockedSectionOrConstructor(const transaction_t& transaction,
-                                                    std::chrono::microseconds timestamp) {
-    for (const auto& mutation : transaction.mutations) {
-      fields_update_f_(mutation);
-    }
-    SetLastAppliedTimestampFromLockedSection(timestamp);
+  void ApplyMutationsFromLockedSectionOrConstructor(const transaction_t& transaction, idxts_t idxts) {
+    fields_update_f_(transaction, [this, idxts]() { SetLastAppliedFromLockedSection(idxts); });
   }
 
  private:
   // Invariant: `master_follower_change_mutex_` is locked, or the call is happening from the constructor.
-  void SubscribeToStreamFromLockedSection() {
+  void SubscribeToStreamFromLockedSection(uint64_t from_idx) {
     CURRENT_ASSERT(!subscriber_scope_);
     CURRENT_ASSERT(subscriber_instance_);
-    subscriber_scope_ = std::move(stream_->template Subscribe<transaction_t>(*subscriber_instance_));
+    subscriber_scope_ = std::move(stream_->template Subscribe<transaction_t>(*subscriber_instance_, from_idx));
   }
 
   // Invariant: `master_follower_change_mutex_` is locked.
   // Important: The publishing mutex of the respective stream must be unlocked!
   void TerminateStreamSubscriptionFromLockedSection() { subscriber_scope_ = nullptr; }
 
-  void SetLastAppliedTimestampFromLockedSection(std::chrono::microseconds timestamp) {
-    CURRENT_ASSERT(timestamp > last_applied_timestamp_);
-    last_applied_timestamp_ = timestamp;
+  void SetLastAppliedFromLockedSection(idxts_t idxts) {
+    CURRENT_ASSERT(idxts.us > last_applied_timestamp_);
+    next_index_ = idxts.index + 1u;
+    last_applied_timestamp_ = idxts.us;
   }
 
  private:
@@ -224,7 +256,8 @@ class StreamStreamPersisterImpl final {
   std::unique_ptr<StreamSubscriber> subscriber_instance_;
   current::stream::SubscriberScope subscriber_scope_;
 
-  std::chrono::microseconds last_applied_timestamp_ = std::chrono::microseconds(-1);  // Replayed or from the master.
+  uint64_t next_index_;                                // The index of the first stream entry not applied yet.
+  std::chrono::microseconds last_applied_timestamp_;  // Replayed or from the master.
 
   HTTPRoutesScope handlers_scope_;
 };
@@ -0,0 +1,211 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// Storage snapshots, to not replay the whole stream when the storage starts.
+//
+// A snapshot is the list of the mutations which, applied to the empty fields, recreate their state as of
+// a certain stream index. It is kept in the `snapshot.<next_index>` file of a dedicated directory, as the
+// JSON of `StorageSnapshotHeader` on the first line, followed by one mutation per line.
+//
+// Taking a snapshot copies all the fields in memory from within a read-only transaction, during which the writes to
+// the storage wait; under the default `Synchronous` transaction policy, so do the reads. Serializing the copy and
+// writing it to disk happen outside the transaction.
+
+#ifndef CURRENT_STORAGE_SNAPSHOT_H
+#define CURRENT_STORAGE_SNAPSHOT_H
+
+#include "../port.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#include "../typesystem/struct.h"
+#include "../typesystem/optional.h"
+#include "../typesystem/serialization/json.h"
+
+#include "../bricks/file/file.h"
+#include "../bricks/strings/fixed_size_serializer.h"
+
+namespace current {
+namespace storage {
+
+CURRENT_STRUCT(StorageSnapshotHeader) {
+  CURRENT_FIELD(next_index, uint64_t);                // The index of the first stream entry not in the snapshot.
+  CURRENT_FIELD(last_us, std::chrono::microseconds);  // The timestamp of the last stream entry in the snapshot.
+  CURRENT_FIELD(mutations, uint64_t);                 // The number of mutations following the header.
+  CURRENT_DEFAULT_CONSTRUCTOR(StorageSnapshotHeader) : next_index(0u), last_us(-1), mutations(0u) {}
+};
+
+template <typename VARIANT>
+struct StorageSnapshot {
+  StorageSnapshotHeader header;
+  std::vector<VARIANT> mutations;
+};
+
+template <typename VARIANT>
+class StorageSnapshotsDir final {
+ public:
+  constexpr static size_t kRetainedSnapshots = 2u;
+  constexpr static const char* kSnapshotPrefix = "snapshot.";
+  constexpr static const char* kTmpSuffix = ".tmp";
+
+  explicit StorageSnapshotsDir(std::string dir) : dir_(std::move(dir)) {}
+
+  const std::string& Dir() const { return dir_; }
+
+  // The snapshot is written into a temporary file first, synced, and renamed once complete, so that an interrupted
+  // save never leaves a partial snapshot under a valid name. The snapshots beyond `kRetainedSnapshots` are removed.
+  void Save(const StorageSnapshot<VARIANT>& snapshot) const {
+    CURRENT_ASSERT(snapshot.header.mutations == snapshot.mutations.size());
+    std::lock_guard<std::mutex> lock(save_mutex_);
+    const std::string file_name =
+        FileSystem::JoinPath(dir_, kSnapshotPrefix + strings::PackToString(snapshot.header.next_index));
+    const std::string tmp_file_name = file_name + kTmpSuffix;
+    {
+      std::ofstream fo(tmp_file_name, std::ofstream::trunc | std::ofstream::binary);
+      std::string line;
+      AppendJSON(line, snapshot.header);
+      line += '\n';
+      for (const auto& mutation : snapshot.mutations) {
+        AppendJSON(line, mutation);
+        line += '\n';
+        fo << line;
+        line.clear();
+      }
+      fo << line;
+      fo.flush();
+      if (!fo.good()) {
+        FileSystem::RmFile(tmp_file_name, FileSystem::RmFileParameters::Silent);
+        CURRENT_THROW(FileException(tmp_file_name));
+      }
+    }
+    try {
+      FileSystem::SyncPath(tmp_file_name);
+    } catch (const FileException&) {
+      FileSystem::RmFile(tmp_file_name, FileSystem::RmFileParameters::Silent);
+      throw;
+    }
+    FileSystem::RenameFile(tmp_file_name, file_name);
+    FileSystem::SyncPath(dir_);
+    const auto snapshots = ListSnapshotsNewestFirst();
+    for (size_t i = kRetainedSnapshots; i < snapshots.size(); ++i) {
+      FileSystem::RmFile(snapshots[i].second, FileSystem::RmFileParameters::Silent);
+    }
+  }
+
+  // Returns the most recent snapshot which is complete, and which `is_valid(header)` confirms to match the stream.
+  template <typename F>
+  Optional<StorageSnapshot<VARIANT>> LoadLatest(F&& is_valid) const {
+    for (const auto& index_and_file_name : ListSnapshotsNewestFirst()) {
+      StorageSnapshot<VARIANT> snapshot;
+      bool has_header = false;
+      bool parsed = true;
+      try {
+        FileSystem::ReadFileByLines(index_and_file_name.second, [&](std::string&& line) {
+          if (!parsed) {
+            return;
+          } else if (!has_header) {
+            ParseJSON(line, snapshot.header);
+            has_header = true;
+            parsed = (snapshot.header.next_index == index_and_file_name.first && is_valid(snapshot.header));
+            if (parsed) {
+              snapshot.mutations.reserve(static_cast<size_t>(snapshot.header.mutations));
+            }
+          } else {
+            snapshot.mutations.push_back(ParseJSON<VARIANT>(line));
+          }
+        });
+      } catch (const current::Exception&) {
+        parsed = false;
+      }
+      if (parsed && has_header && snapshot.mutations.size() == snapshot.header.mutations) {
+        return snapshot;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  std::vector<std::pair<uint64_t, std::string>> ListSnapshotsNewestFirst() const {
+    std::vector<std::pair<uint64_t, std::string>> snapshots;
+    const std::string prefix = kSnapshotPrefix;
+    const size_t name_length = prefix.length() + strings::FixedSizeSerializer<uint64_t>::size_in_bytes;
+    FileSystem::ScanDir(dir_, [&](const FileSystem::ScanDirItemInfo& item) {
+      if (item.basename.length() == name_length && !item.basename.compare(0, prefix.length(), prefix)) {
+        snapshots.emplace_back(strings::FixedSizeSerializer<uint64_t>::UnpackFromString(item.basename.substr(prefix.length())),
+                               item.pathname);
+      }
+    });
+    std::sort(snapshots.rbegin(), snapshots.rend());
+    return snapshots;
+  }
+
+  const std::string dir_;
+  mutable std::mutex save_mutex_;
+};
+
+// Calls `f` every `period` from a dedicated thread, until destructed.
+class PeriodicStorageSnapshotter final {
+ public:
+  PeriodicStorageSnapshotter(std::chrono::milliseconds period, std::function<void()> f)
+      : period_(period), f_(std::move(f)), thread_([this]() { Thread(); }) {}
+
+  ~PeriodicStorageSnapshotter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      destructing_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+ private:
+  void Thread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, period_, [this]() { return destructing_; })) {
+      lock.unlock();
+      try {
+        f_();
+      } catch (const std::exception& e) {
+        std::cerr << "Taking the storage snapshot failed: " << e.what() << std::endl;
+      }
+      lock.lock();
+    }
+  }
+
+  const std::chrono::milliseconds period_;
+  const std::function<void()> f_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool destructing_ = false;
+  std::thread thread_;
+};
+
+}  // namespace current::storage
+}  // namespace current
+
+#endif  // CURRENT_STORAGE_SNAPSHOT_H
@@ -46,6 +46,7 @@ SOFTWARE.
 #include <atomic>
 
 #include "base.h"
+#include "snapshot.h"
 #include "transaction.h"
 #include "transaction_policy.h"
 #include "transaction_result.h"
@@ -302,10 +303,16 @@ class StorageImpl {
   using stream_t = typename persister_t::stream_t;
 
  private:
+  using transaction_policy_t = TRANSACTION_POLICY<persister_t>;
+
   FIELDS fields_;
   Optional<Owned<stream_t>> owned_stream_;  // Valid iff the Storage has been constructed to keep its own stream.
+  // The transaction policy precedes the persister, as the persister replays the stream into the fields through it.
+  transaction_policy_t transaction_policy_;
+  std::unique_ptr<StorageSnapshotsDir<fields_variant_t>> snapshots_;  // Set iff the snapshots are enabled.
+  Optional<StorageSnapshotHeader> snapshot_loaded_;  // The snapshot the fields were initialized from, if any.
   persister_t persister_;
-  TRANSACTION_POLICY<persister_t> transaction_policy_;
+  std::unique_ptr<PeriodicStorageSnapshotter> periodic_snapshotter_;  // Destructed first, as it uses the persister.
 
  public:
   using fields_by_ref_t = FIELDS&;
@@ -331,6 +338,18 @@ class StorageImpl {
     return MakeOwned<StorageImpl>(typename persister_t::Following(), UseExistingStream(), stream);
   }
 
+  // With the snapshots enabled, the storage starts from the latest valid snapshot in `snapshots_dir`,
+  // and only replays the part of the stream that follows it.
+  static Owned<StorageImpl> CreateMasterStorageAtopExistingStream(Borrowed<stream_t> stream,
+                                                                  const std::string& snapshots_dir) {
+    return MakeOwned<StorageImpl>(typename persister_t::Master(), UseExistingStream(), stream, snapshots_dir);
+  }
+
+  static Owned<StorageImpl> CreateFollowingStorageAtopExistingStream(Borrowed<stream_t> stream,
+                                                                     const std::string& snapshots_dir) {
+    return MakeOwned<StorageImpl>(typename persister_t::Following(), UseExistingStream(), stream, snapshots_dir);
+  }
+
  private:
   // Magic to enable `current::MakeOwned<Storage>` create instances of `Storage`.
   friend struct sync::impl::UniqueInstance<StorageImpl>;
@@ -339,15 +358,80 @@ class StorageImpl {
 
   template <typename CONSTRUCTION_TYPE>
   StorageImpl(CONSTRUCTION_TYPE, UseExistingStream, Borrowed<stream_t> stream)
-      : persister_(CONSTRUCTION_TYPE(), [this](const fields_variant_t& entry) { entry.Call(fields_); }, stream),
-        transaction_policy_(persister_, fields_.current_storage_mutation_journal_) {}
+      : transaction_policy_(persister_, fields_.current_storage_mutation_journal_),
+        persister_(CONSTRUCTION_TYPE(),
+                   [this](const transaction_t& transaction, const std::function<void()>& set_last_applied) {
+                     Replay(transaction, set_last_applied);
+                   },
+                   stream) {}
 
   template <typename CONSTRUCTION_TYPE, typename... ARGS>
   StorageImpl(CONSTRUCTION_TYPE, CreateStreamAsWell, ARGS&&... args)
       : owned_stream_(std::move(stream_t::CreateStream(std::forward<ARGS>(args)...))),
-        persister_(
-            CONSTRUCTION_TYPE(), [this](const fields_variant_t& entry) { entry.Call(fields_); }, Value(owned_stream_)),
-        transaction_policy_(persister_, fields_.current_storage_mutation_journal_) {}
+        transaction_policy_(persister_, fields_.current_storage_mutation_journal_),
+        persister_(CONSTRUCTION_TYPE(),
+                   [this](const transaction_t& transaction, const std::function<void()>& set_last_applied) {
+                     Replay(transaction, set_last_applied);
+                   },
+                   Value(owned_stream_)) {}
+
+  template <typename CONSTRUCTION_TYPE>
+  StorageImpl(CONSTRUCTION_TYPE, UseExistingStream, Borrowed<stream_t> stream, const std::string& snapshots_dir)
+      : transaction_policy_(persister_, fields_.current_storage_mutation_journal_),
+        snapshots_(std::make_unique<StorageSnapshotsDir<fields_variant_t>>(snapshots_dir)),
+        snapshot_loaded_(LoadSnapshotFromConstructor(*stream)),
+        persister_(CONSTRUCTION_TYPE(),
+                   [this](const transaction_t& transaction, const std::function<void()>& set_last_applied) {
+                     Replay(transaction, set_last_applied);
+                   },
+                   stream,
+                   Exists(snapshot_loaded_) ? Value(snapshot_loaded_).next_index : 0u,
+                   Exists(snapshot_loaded_) ? Value(snapshot_loaded_).last_us : std::chrono::microseconds(-1)) {}
+
+  // Only accepts the snapshot if the stream entry it ends with is still there, with the same timestamp.
+  Optional<StorageSnapshotHeader> LoadSnapshotFromConstructor(const stream_t& stream) {
+    const auto snapshot = snapshots_->LoadLatest([&stream](const StorageSnapshotHeader& header) {
+      if (!header.next_index) {
+        return true;
+      }
+      if (header.next_index > stream.Data()->Size()) {
+        return false;
+      }
+      for (const auto& e : stream.Data()->Iterate(header.next_index - 1u, header.next_index)) {
+        return e.idx_ts.us == header.last_us;
+      }
+      return false;
+    });
+    if (Exists(snapshot)) {
+      for (const auto& mutation : Value(snapshot).mutations) {
+        mutation.Call(fields_);
+      }
+      return Value(snapshot).header;
+    } else {
+      return nullptr;
+    }
+  }
+
+  template <int... NS>
+  void ExportSnapshotOfFields(std::vector<fields_variant_t>& mutations,
+                              current::variadic_indexes::indexes<NS...>) const {
+    const auto exporter = [&mutations](const auto& field) {
+      field.ExportSnapshot([&mutations](auto&& mutation) { mutations.emplace_back(std::move(mutation)); });
+    };
+    const int dummy[] = {0, (fields_(::current::storage::ImmutableFieldByIndex<NS>(), exporter), 0)...};
+    static_cast<void>(dummy);
+  }
+
+  // Invariant: the publishing mutex of the stream is locked, or the call is happening from the constructor.
+  // The position of the persister is advanced under the same lock as the fields, see `CollectSnapshot()`.
+  void Replay(const transaction_t& transaction, const std::function<void()>& set_last_applied) {
+    transaction_policy_.ReplayFromLockedSection([this, &transaction, &set_last_applied]() {
+      for (const auto& mutation : transaction.mutations) {
+        mutation.Call(fields_);
+      }
+      set_last_applied();
+    });
+  }
 
  public:
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
@@ -355,6 +439,9 @@ class StorageImpl {
     return persister_.template IsMasterStoragePersister<MLS>();
   }
 
+  // To be called from within a transaction, as it does not lock, and reflects the state of the fields it observes.
+  bool IsMasterStorageFromLockedSection() const { return persister_.IsMasterStoragePersisterFromLockedSection(); }
+
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock>
   std::chrono::microseconds LastAppliedTimestamp() const {
     return persister_.template LastAppliedTimestampPersister<MLS>();
@@ -393,7 +480,8 @@ class StorageImpl {
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock, typename F>
   ::current::Future<::current::storage::TransactionResult<f_result_t<F>>, ::current::StrictFuture::Strict>
   ReadOnlyTransaction(F&& f) const {
-    current::locks::SmartMutexLockGuard<MLS> lock(persister_.Stream()->Impl()->publishing_mutex);
+    typename transaction_policy_t::template read_only_transaction_lock_t<MLS> lock(
+        persister_.Stream()->Impl()->publishing_mutex);
     return transaction_policy_.TransactionFromLockedSection(
         [&f, this]() { return f(static_cast<const FIELDS&>(fields_)); });
   }
@@ -401,7 +489,8 @@ class StorageImpl {
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock, typename F1, typename F2>
   ::current::Future<::current::storage::TransactionResult<void>, ::current::StrictFuture::Strict> ReadOnlyTransaction(
       F1&& f1, F2&& f2) const {
-    current::locks::SmartMutexLockGuard<MLS> lock(persister_.Stream()->Impl()->publishing_mutex);
+    typename transaction_policy_t::template read_only_transaction_lock_t<MLS> lock(
+        persister_.Stream()->Impl()->publishing_mutex);
     return transaction_policy_.TransactionFromLockedSection(
         [&f1, this]() { return f1(static_cast<const FIELDS&>(fields_)); }, std::forward<F2>(f2));
   }
@@ -436,6 +525,44 @@ class StorageImpl {
 
   void GracefulShutdown() { transaction_policy_.GracefulShutdown(); }
 
+  // The state of all the fields, as the mutations to recreate it, along with the position in the stream it reflects.
+  // Collected from within a read-only transaction, so it blocks the writers only for the time of copying the fields.
+  // With the default `Synchronous` transaction policy, that transaction holds the publishing mutex of the stream,
+  // so the readers and the writers of the storage are all held for the copy. With `SynchronousWithConcurrentReads`,
+  // only the writers are, and the readers run alongside it.
+  StorageSnapshot<fields_variant_t> CollectSnapshot() const {
+    StorageSnapshot<fields_variant_t> snapshot;
+    ReadOnlyTransaction([this, &snapshot](const FIELDS&) {
+      const auto position = persister_.NextIndexAndLastAppliedTimestampFromLockedSection();
+      snapshot.header.next_index = position.first;
+      snapshot.header.last_us = position.second;
+      ExportSnapshotOfFields(snapshot.mutations, current::variadic_indexes::generate_indexes<FIELDS_COUNT>());
+    }).Go();
+    snapshot.header.mutations = snapshot.mutations.size();
+    return snapshot;
+  }
+
+  // Saves the snapshot into the snapshots directory. Serializing and writing it happen outside the transaction.
+  StorageSnapshotHeader TakeSnapshot() const {
+    if (!snapshots_) {
+      CURRENT_THROW(StorageSnapshotsNotEnabledException());
+    }
+    const auto snapshot = CollectSnapshot();
+    snapshots_->Save(snapshot);
+    return snapshot.header;
+  }
+
+  // Takes a snapshot every `period` from a background thread, for as long as the storage is alive.
+  void TakeSnapshotsPeriodically(std::chrono::milliseconds period) {
+    if (!snapshots_) {
+      CURRENT_THROW(StorageSnapshotsNotEnabledException());
+    }
+    periodic_snapshotter_ = nullptr;
+    periodic_snapshotter_ = std::make_unique<PeriodicStorageSnapshotter>(period, [this]() { TakeSnapshot(); });
+  }
+
+  const Optional<StorageSnapshotHeader>& SnapshotLoadedAtStartup() const { return snapshot_loaded_; }
+
  private:
   StorageImpl() = delete;
   StorageImpl(const StorageImpl&) = delete;
@@ -469,7 +596,7 @@ class NullStoragePersisterImpl {
   using transaction_t = Transaction<variant_t>;
 
   // NOTE(dkorolev): Commented out to not make the compiler match the type.
-  // using fields_update_function_t = std::function<void(const variant_t&)>;
+  // using fields_update_function_t = std::function<void(const transaction_t&, const std::function<void()>&)>;
   // NullStoragePersisterImpl(std::mutex&, fields_update_function_t) {}
 
   void PersistJournal(MutationJournal& journal) { journal.Clear(); }
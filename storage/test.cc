@@ -1916,6 +1916,49 @@ TEST(TransactionalStorage, WorkWithUnderlyingStream) {
       collected);
 }
 
+TEST(TransactionalStorage, GroupCommitDoesNotBatchTransactions) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = TestStorage<StreamStreamPersister>;
+
+  const std::string storage_file_name =
+      current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "storage_group_commit");
+  const auto storage_file_remover = current::FileSystem::ScopedRmFile(storage_file_name);
+
+  constexpr size_t kThreads = 4u;
+  constexpr size_t kTransactionsPerThread = 10u;
+
+  {
+    auto storage =
+        storage_t::CreateMasterStorage(storage_file_name, current::persistence::FileDurability::GroupCommit());
+
+    // The mock time is auto-incremented on each call, so concurrent transactions get distinct timestamps.
+    current::time::SetNow(std::chrono::microseconds(100), std::chrono::microseconds(1000000));
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0u; t < kThreads; ++t) {
+      threads.emplace_back([&storage, t]() {
+        for (size_t i = 0u; i < kTransactionsPerThread; ++i) {
+          const auto result = storage->ReadWriteTransaction([t, i](MutableFields<storage_t> fields) {
+            fields.d.Add(Record{current::ToString(t) + ':' + current::ToString(i), static_cast<int32_t>(i)});
+          }).Go();
+          EXPECT_TRUE(WasCommitted(result));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // The storage waits for the commit with the publish mutex held, so each transaction is a batch of its own.
+    const auto stats = storage->BorrowUnderlyingStream()->Data()->GroupCommitStats();
+    EXPECT_EQ(kThreads * kTransactionsPerThread, stats.entries);
+    EXPECT_EQ(stats.entries, stats.batches);
+    EXPECT_EQ(1u, stats.max_batch_entries);
+  }
+}
+
 TEST(TransactionalStorage, GracefulShutdown) {
   current::time::ResetToZero();
 
@@ -1928,6 +1971,236 @@ TEST(TransactionalStorage, GracefulShutdown) {
   ASSERT_THROW(result.Go(), current::storage::StorageInGracefulShutdownException);
 }
 
+TEST(TransactionalStorage, ConcurrentReadOnlyTransactions) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = TestStorage<StreamStreamPersister, current::storage::transaction_policy::SynchronousWithConcurrentReads>;
+
+  const std::string storage_file_name =
+      current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "storage_concurrent_reads");
+  const auto storage_file_remover = current::FileSystem::ScopedRmFile(storage_file_name);
+
+  {
+    auto storage = storage_t::CreateMasterStorage(storage_file_name);
+
+    // Two read-only transactions can be inside the storage at the same time.
+    {
+      std::atomic_int inside(0);
+      const auto reader = [&]() {
+        return Value(storage->ReadOnlyTransaction([&inside](ImmutableFields<storage_t>) {
+          ++inside;
+          const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+          while (inside < 2 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+          }
+          return inside == 2;
+        }).Go());
+      };
+      bool first = false;
+      bool second = false;
+      std::thread thread([&]() { first = reader(); });
+      second = reader();
+      thread.join();
+      EXPECT_TRUE(first);
+      EXPECT_TRUE(second);
+    }
+
+    // Readers never observe a partially applied transaction, nor the one which was rolled back.
+    {
+      std::atomic_bool done(false);
+      std::atomic_size_t inconsistencies(0u);
+      std::vector<std::thread> readers;
+      for (size_t i = 0u; i < 4u; ++i) {
+        readers.emplace_back([&]() {
+          while (!done) {
+            const bool consistent = Value(storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+              if (!Exists(fields.d["a"])) {
+                return !Exists(fields.d["b"]);
+              } else {
+                return Exists(fields.d["b"]) && Value(fields.d["a"]).rhs + Value(fields.d["b"]).rhs == 0;
+              }
+            }).Go());
+            if (!consistent) {
+              ++inconsistencies;
+            }
+          }
+        });
+      }
+      for (int32_t i = 1; i <= 100; ++i) {
+        EXPECT_TRUE(WasCommitted(storage->ReadWriteTransaction([i](MutableFields<storage_t> fields) {
+          fields.d.Add(Record{"a", i});
+          fields.d.Add(Record{"b", -i});
+        }).Go()));
+        EXPECT_FALSE(WasCommitted(storage->ReadWriteTransaction([](MutableFields<storage_t> fields) {
+          fields.d.Add(Record{"a", 1000});
+          CURRENT_STORAGE_THROW_ROLLBACK();
+        }).Go()));
+      }
+      done = true;
+      for (auto& thread : readers) {
+        thread.join();
+      }
+      EXPECT_EQ(0u, inconsistencies);
+    }
+
+    EXPECT_EQ(100, Value(storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      return Value(fields.d["a"]).rhs;
+    }).Go()));
+  }
+
+  // The following storage replays the stream through the same policy.
+  {
+    using stream_t = typename storage_t::stream_t;
+    auto owned_stream(stream_t::CreateStream(storage_file_name));
+    current::Borrowed<stream_t::publisher_t> stream_publisher_owner = owned_stream->BecomeFollowingStream();
+    auto storage = storage_t::CreateFollowingStorageAtopExistingStream(owned_stream);
+    EXPECT_EQ(100u, storage->UnderlyingStream()->Data()->Size());
+    while (!Value(storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      return Exists(fields.d["a"]) && Value(fields.d["a"]).rhs == 100;
+    }).Go())) {
+      std::this_thread::yield();
+    }
+    const auto result = storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      EXPECT_EQ(100, Value(fields.d["a"]).rhs);
+      EXPECT_EQ(-100, Value(fields.d["b"]).rhs);
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+}
+
+TEST(TransactionalStorage, SnapshotPlusTailEqualsFullReplay) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = TestStorage<StreamStreamPersister>;
+  using stream_t = typename storage_t::stream_t;
+
+  const std::string storage_file_name =
+      current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "storage_snapshotted");
+  const auto storage_file_remover = current::FileSystem::ScopedRmFile(storage_file_name);
+  const std::string snapshots_dir = current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "snapshots");
+  current::FileSystem::RmDir(
+      snapshots_dir, current::FileSystem::RmDirParameters::Silent, current::FileSystem::RmDirRecursive::Yes);
+  current::FileSystem::MkDir(snapshots_dir, current::FileSystem::MkDirParameters::Silent);
+
+  // The snapshot, as the set of the JSON-s of its mutations, since the unordered containers export them in any order.
+  const auto collect = [](const storage_t& storage) {
+    const auto snapshot = storage.CollectSnapshot();
+    std::multiset<std::string> mutations;
+    for (const auto& mutation : snapshot.mutations) {
+      mutations.insert(JSON(mutation));
+    }
+    // Also look up every key directly, so that the comparison does not rely on the snapshot being complete.
+    mutations.insert(Value(storage.ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      std::string lookups;
+      for (int32_t i = -3; i < 40; ++i) {
+        const std::string key = current::ToString(i);
+        lookups += JSON(fields.d[key]) + JSON(fields.d.LastModified(key));
+        for (int32_t j = 0; j < 5; ++j) {
+          const std::string col = current::ToString(j);
+          lookups += JSON(fields.umany_to_umany.Get(i, col)) + JSON(fields.umany_to_umany.LastModified(i, col));
+          lookups += JSON(fields.oone_to_oone.Get(i, col)) + JSON(fields.oone_to_oone.LastModified(i, col));
+          lookups += JSON(fields.uone_to_umany.Get(i, col)) + JSON(fields.uone_to_umany.LastModified(i, col));
+        }
+      }
+      return lookups;
+    }).Go()));
+    return std::make_pair(snapshot.header, mutations);
+  };
+
+  uint64_t first_snapshot_index;
+  std::string second_snapshot_file_name;
+  {
+    auto stream = stream_t::CreateStream(storage_file_name);
+    auto storage = storage_t::CreateMasterStorageAtopExistingStream(stream, snapshots_dir);
+    EXPECT_FALSE(Exists(storage->SnapshotLoadedAtStartup()));
+
+    const auto mutate = [&storage](int32_t i) {
+      storage->ReadWriteTransaction([i](MutableFields<storage_t> fields) {
+        fields.d.Add(Record{current::ToString(i), i});
+        fields.d.Erase(current::ToString(i - 3));
+        fields.umany_to_umany.Add(Cell{i % 5, current::ToString(i % 3), i});
+        fields.umany_to_umany.Erase(i % 7, current::ToString(i % 2));
+        fields.oone_to_oone.Add(Cell{i % 4, current::ToString(i % 3), i});
+        fields.uone_to_umany.Add(Cell{i % 6, current::ToString(i % 5), i});
+        fields.uone_to_umany.Erase(i % 3, current::ToString(i % 4));
+      }).Go();
+    };
+
+    for (int32_t i = 0; i < 20; ++i) {
+      mutate(i);
+    }
+    const auto header = storage->TakeSnapshot();
+    EXPECT_EQ(20u, header.next_index);
+    EXPECT_EQ(stream->Data()->LastPublishedIndexAndTimestamp().us, header.last_us);
+    first_snapshot_index = header.next_index;
+
+    for (int32_t i = 20; i < 30; ++i) {
+      mutate(i);
+    }
+    second_snapshot_file_name = current::FileSystem::JoinPath(
+        snapshots_dir, "snapshot." + current::strings::PackToString(storage->TakeSnapshot().next_index));
+
+    for (int32_t i = 30; i < 40; ++i) {
+      mutate(i);
+    }
+  }
+
+  // Corrupt the most recent snapshot, so that the storage falls back to the previous one.
+  current::FileSystem::WriteStringToFile("{\"next_index\":30,", second_snapshot_file_name.c_str());
+
+  std::pair<current::storage::StorageSnapshotHeader, std::multiset<std::string>> from_snapshot;
+  {
+    auto stream = stream_t::CreateStream(storage_file_name);
+    auto storage = storage_t::CreateMasterStorageAtopExistingStream(stream, snapshots_dir);
+    ASSERT_TRUE(Exists(storage->SnapshotLoadedAtStartup()));
+    EXPECT_EQ(first_snapshot_index, Value(storage->SnapshotLoadedAtStartup()).next_index);
+    from_snapshot = collect(*storage);
+  }
+
+  std::pair<current::storage::StorageSnapshotHeader, std::multiset<std::string>> from_full_replay;
+  {
+    auto stream = stream_t::CreateStream(storage_file_name);
+    auto storage = storage_t::CreateMasterStorageAtopExistingStream(stream);
+    EXPECT_FALSE(Exists(storage->SnapshotLoadedAtStartup()));
+    from_full_replay = collect(*storage);
+  }
+
+  EXPECT_EQ(40u, from_full_replay.first.next_index);
+  EXPECT_EQ(JSON(from_full_replay.first), JSON(from_snapshot.first));
+  EXPECT_FALSE(from_full_replay.second.empty());
+  EXPECT_TRUE(from_full_replay.second == from_snapshot.second);
+
+  // The snapshot of a different stream is ignored, as the entry it ends with does not match.
+  {
+    const std::string other_file_name =
+        current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "storage_snapshotted_other");
+    const auto other_file_remover = current::FileSystem::ScopedRmFile(other_file_name);
+    auto stream = stream_t::CreateStream(other_file_name);
+    for (int32_t i = 0; i < 25; ++i) {
+      stream->Publisher()->Publish(storage_t::transaction_t());
+    }
+    auto storage = storage_t::CreateMasterStorageAtopExistingStream(stream, snapshots_dir);
+    EXPECT_FALSE(Exists(storage->SnapshotLoadedAtStartup()));
+  }
+
+  // The snapshots can be taken in the background.
+  {
+    auto stream = stream_t::CreateStream(storage_file_name);
+    auto storage = storage_t::CreateMasterStorageAtopExistingStream(stream, snapshots_dir);
+    const std::string latest_snapshot_file_name =
+        current::FileSystem::JoinPath(snapshots_dir, "snapshot." + current::strings::PackToString(uint64_t(40)));
+    storage->TakeSnapshotsPeriodically(std::chrono::milliseconds(1));
+    while (!std::ifstream(latest_snapshot_file_name).good()) {
+      std::this_thread::yield();
+    }
+  }
+
+  current::FileSystem::RmDir(
+      snapshots_dir, current::FileSystem::RmDirParameters::Silent, current::FileSystem::RmDirRecursive::Yes);
+}
+
 #endif  // STORAGE_ONLY_RUN_RESTFUL_TESTS
 
 namespace transactional_storage_test {
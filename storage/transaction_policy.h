@@ -29,6 +29,10 @@ SOFTWARE.
 #include "exceptions.h"
 #include "transaction_result.h"
 
+#include <shared_mutex>
+
+#include "../bricks/sync/event_count.h"
+#include "../bricks/sync/locks.h"
 #include "../bricks/util/future.h"
 
 #include "../blocks/ss/ss.h"
@@ -51,6 +55,16 @@ class Synchronous final {
   template <typename F>
   using f_result_t = typename std::result_of<F()>::type;
 
+  // The lock the storage takes on the publishing mutex of its stream for a read-only transaction.
+  template <current::locks::MutexLockStatus MLS>
+  using read_only_transaction_lock_t = current::locks::SmartMutexLockGuard<MLS>;
+
+  // Applies the mutations replayed from the stream. The publishing mutex is already locked, so nothing to do here.
+  template <typename F>
+  void ReplayFromLockedSection(F&& f) {
+    f();
+  }
+
   // Read-write transaction returning non-void type.
   template <typename F, class = std::enable_if_t<!std::is_void<f_result_t<F>>::value>>
   Future<TransactionResult<f_result_t<F>>, StrictFuture::Strict> TransactionFromLockedSection(F&& f) {
@@ -301,6 +315,67 @@ class Synchronous final {
   std::atomic_bool destructing_;
 };
 
+// Same as `Synchronous`, except that read-only transactions do not lock the publishing mutex of the stream,
+// and run concurrently with each other under a shared lock on the fields. Read-write transactions, as well as
+// the mutations replayed from the stream by a following storage, hold this lock exclusively, so the readers
+// only ever observe the fields between transactions, and never a partially applied or rolled back journal.
+// A pending writer holds off new readers, which park until it is through, so that a steady flow of reads does not
+// starve the writes.
+template <class PERSISTER>
+class SynchronousWithConcurrentReads final {
+ public:
+  using transaction_t = typename PERSISTER::transaction_t;
+
+  SynchronousWithConcurrentReads(PERSISTER& persister, MutationJournal& journal) : impl_(persister, journal) {}
+
+  template <current::locks::MutexLockStatus>
+  using read_only_transaction_lock_t = current::locks::NoOpLock;
+
+  template <typename F>
+  void ReplayFromLockedSection(F&& f) {
+    const auto lock = ExclusiveLock();
+    f();
+  }
+
+  // Read-write transactions. The publishing mutex of the stream is locked by the caller.
+  template <typename... ARGS>
+  auto TransactionFromLockedSection(ARGS&&... args) {
+    const auto lock = ExclusiveLock();
+    return impl_.TransactionFromLockedSection(std::forward<ARGS>(args)...);
+  }
+
+  // Read-only transactions. The publishing mutex of the stream may or may not be locked by the caller.
+  template <typename... ARGS>
+  auto TransactionFromLockedSection(ARGS&&... args) const {
+    while (writers_pending_.load()) {
+      const auto key = writers_done_.PrepareWait();
+      if (!writers_pending_.load()) {
+        break;
+      }
+      writers_done_.Wait(key);
+    }
+    std::shared_lock<std::shared_mutex> lock(fields_mutex_);
+    return static_cast<const Synchronous<PERSISTER>&>(impl_).TransactionFromLockedSection(std::forward<ARGS>(args)...);
+  }
+
+  void GracefulShutdown() { impl_.GracefulShutdown(); }
+
+ private:
+  std::unique_lock<std::shared_mutex> ExclusiveLock() {
+    ++writers_pending_;
+    std::unique_lock<std::shared_mutex> lock(fields_mutex_);
+    if (!--writers_pending_) {
+      writers_done_.NotifyAll();
+    }
+    return lock;
+  }
+
+  Synchronous<PERSISTER> impl_;
+  mutable std::shared_mutex fields_mutex_;
+  std::atomic_size_t writers_pending_{0u};
+  mutable EventCount writers_done_;  // Notified once no writer is pending, for the readers held off to proceed.
+};
+
 }  // namespace transaction_policy
 }  // namespace storage
 }  // namespace current
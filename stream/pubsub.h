@@ -28,6 +28,9 @@ SOFTWARE.
 
 #include "../port.h"
 
+#include <algorithm>
+#include <functional>
+#include <string_view>
 #include <utility>
 
 #include "stream_impl.h"
@@ -248,7 +251,8 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
                 {kStreamHeaderCurrentSubscriptionId, subscription_id},
                 {kStreamHeaderCurrentStreamSize, current::ToString(impl_->persister.Size())},
             }),
-            current::net::constants::kDefaultJSONContentType)) {
+            current::net::constants::kDefaultJSONContentType,
+            current::net::ChunkedResponseOptions().MaxLatency(kStreamHTTPSubscriptionMaxLatency).NonBlocking())) {
     if (params_.recent.count() > 0) {
       serving_ = false;  // Start in 'non-serving' mode when `recent` is set.
       from_timestamp_ = r.timestamp - params_.recent;
@@ -301,15 +305,18 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
         }();
         current_response_size_ += entry_json.length();
         try {
+          // While catching up, the entries are written out in batches, and each one is once the tail is reached.
           if (params_.array) {
             if (!output_started_) {
-              http_response_("[\n");
+              http_response_("[\n", current::net::ChunkFlush::NoFlush);
               output_started_ = true;
             } else {
-              http_response_(",\n");
+              http_response_(",\n", current::net::ChunkFlush::NoFlush);
             }
           }
-          http_response_(std::move(entry_json));
+          http_response_(
+              std::move(entry_json),
+              current.index == last.index ? current::net::ChunkFlush::Flush : current::net::ChunkFlush::NoFlush);
         } catch (const current::net::NetworkException&) {  // LCOV_EXCL_LINE
           return ss::EntryResponse::Done;                  // LCOV_EXCL_LINE
         }
@@ -331,26 +338,33 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
       }
       return ss::EntryResponse::More;
     }();
-    if (result == ss::EntryResponse::Done && params_.array) {
-      if (!output_started_) {
-        http_response_("[]\n");
+    if (result == ss::EntryResponse::Done) {
+      if (params_.array) {
+        if (!output_started_) {
+          http_response_("[]\n");
+        } else {
+          http_response_("]\n");
+        }
       } else {
-        http_response_("]\n");
+        // Flush the batched entries.
+        http_response_("", current::net::ChunkFlush::Flush);
       }
     }
     return result;
   }
 
-  ss::EntryResponse operator()(const std::string& raw_log_line, uint64_t current_index, idxts_t last) {
+  // Takes a `Chunk`, so that the raw lines of a memory-mapped file are not copied before being sent out.
+  ss::EntryResponse operator()(const current::strings::Chunk& raw_log_line, uint64_t current_index, idxts_t last) {
     const ss::EntryResponse result = [&, this]() {
       if (time_to_terminate_) {
         return ss::EntryResponse::Done;
       }
+      const char* const tab = std::find(raw_log_line.begin(), raw_log_line.end(), '\t');
       auto current_us = std::chrono::microseconds(0);
       // Obtain current timestamp only when it's necessary by parsing the `raw_log_line`.
-      const auto GetCurrentUs = [&current_us, &raw_log_line]() -> std::chrono::microseconds {
+      const auto GetCurrentUs = [&current_us, &raw_log_line, tab]() -> std::chrono::microseconds {
         if (!current_us.count()) {
-          current_us = ParseJSON<ts_only_t>(raw_log_line.substr(0, raw_log_line.find('\t'))).us;
+          current_us = ParseJSON<ts_only_t>(std::string(raw_log_line.begin(), tab)).us;
         }
         return current_us;
       };
@@ -374,15 +388,10 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
         if (to_timestamp_.count() && GetCurrentUs() > to_timestamp_) {
           return ss::EntryResponse::Done;
         }
-        const std::string response_data = [this, &raw_log_line]() {
-          if (!params_.entries_only) {
-            return raw_log_line;
-          } else {
-            const auto tab_pos = raw_log_line.find('\t');
-            return tab_pos != std::string::npos ? raw_log_line.substr(tab_pos + 1) : raw_log_line;
-          }
-        }() + '\n';
-        current_response_size_ += response_data.length();
+        // Refers to the raw line, the memory-mapped one included, which is sent out with no copies.
+        const char* const begin = (!params_.entries_only || tab == raw_log_line.end()) ? raw_log_line.begin() : tab + 1;
+        const std::string_view response_data(begin, static_cast<size_t>(raw_log_line.end() - begin));
+        current_response_size_ += response_data.length() + 1u;
         try {
           if (params_.array) {
             if (!output_started_) {
@@ -394,6 +403,7 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
           }
           http_response_(
               response_data,
+              std::string_view("\n", 1u),
               current_index == last.index ? current::net::ChunkFlush::Flush : current::net::ChunkFlush::NoFlush);
         } catch (const current::net::NetworkException&) {  // LCOV_EXCL_LINE
           return ss::EntryResponse::Done;                  // LCOV_EXCL_LINE
@@ -455,6 +465,11 @@ class PubSubHTTPEndpointImpl : public AbstractSubscriberObject {
     return ss::EntryResponse::More;
   }
 
+  // The response never blocks on a slow client, so that the subscriber can share the threads of the executor.
+  // Instead, the stream holds off passing the entries to it while the client has not taken what is sent already,
+  // until `resume` is called.
+  bool Backlogged(std::function<void()> resume) { return http_response_.Backlogged(std::move(resume)); }
+
   // TODO(dkorolev): This is a long shot, but looks right: For type-filtered HTTP subscriptions,
   // whether we should terminate or no depends on `nowait`.
   ss::EntryResponse EntryResponseIfNoMorePassTypeFilter() const {
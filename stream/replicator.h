@@ -36,6 +36,7 @@ SOFTWARE.
 #include "stream_impl.h"
 
 #include "../blocks/http/api.h"
+#include "../blocks/persistence/idxts_prefix.h"
 #include "../blocks/ss/ss.h"
 
 #include "../bricks/sync/owned_borrowed.h"
@@ -139,7 +140,8 @@ class SubscribableRemoteStream final {
         }
         // The leftover, previously incomplete record (full line) is now complete,
         // process it and begin processing this chunk from offset `begin_pos`.
-        PassEntryToSubscriber(carried_over_data_ + chunk.substr(0u, begin_pos));
+        carried_over_data_.append(chunk, 0u, begin_pos);
+        PassEntryToSubscriber(carried_over_data_);
         carried_over_data_.clear();
       }
 
@@ -156,10 +158,12 @@ class SubscribableRemoteStream final {
           ++end_pos;
         }
         if (end_pos == chunk_size) {
-          carried_over_data_ = chunk.substr(begin_pos);
+          carried_over_data_.assign(chunk, begin_pos, std::string::npos);
           break;
         }
-        PassEntryToSubscriber(chunk.substr(begin_pos, end_pos - begin_pos));  // NOTE(dkorolev): Can be `Chunk`.
+        // The line is copied into `line_`, which keeps its capacity, so that no memory is allocated per line.
+        line_.assign(chunk, begin_pos, end_pos - begin_pos);
+        PassEntryToSubscriber(line_);
         begin_pos = end_pos + 1u;
       }
     }
@@ -171,6 +175,7 @@ class SubscribableRemoteStream final {
     std::chrono::microseconds from_us_;
     const idxts_t unused_idxts_;
     std::string carried_over_data_;
+    std::string line_;
 
    private:
     template <ReplicationMode MODE = RM>
@@ -209,16 +214,25 @@ class SubscribableRemoteStream final {
       }
     }
 
+    // In `RM::Unchecked` mode the raw log line is passed on as is, and the entry is never parsed. Only the index and
+    // the timestamp it starts with are scanned, which, for the `StreamReplicator`, lets the follower append the line
+    // via `PublishUnsafe()` without a single JSON parse or serialization along the way.
     template <ReplicationMode MODE = RM>
     ENABLE_IF<MODE == ReplicationMode::Unchecked> PassEntryToSubscriber(const std::string& raw_log_line) {
       const auto tab_pos = raw_log_line.find('\t');
       if (tab_pos != std::string::npos) {
-        if (subscriber_(raw_log_line, next_expected_index_, unused_idxts_) == ss::EntryResponse::Done) {
+        idxts_t idxts;
+        try {
+          idxts = persistence::ParseIndexAndTimestampPrefix(raw_log_line, tab_pos);
+        } catch (const current::serialization::json::TypeSystemParseJSONException&) {
+          CURRENT_THROW(RemoteStreamMalformedChunkException());
+        }
+        if (subscriber_(raw_log_line, idxts.index, unused_idxts_) == ss::EntryResponse::Done) {
           CURRENT_THROW(StreamTerminatedBySubscriber());
         }
-        // NOTE(dkorolev) & NOTE(grixa): In `RM::Unchecked` mode
-        // `next_expected_index_` is not checked at all, just incremented.
-        ++next_expected_index_;
+        // NOTE(dkorolev) & NOTE(grixa): In `RM::Unchecked` mode `next_expected_index_` is not checked,
+        // as the follower's `PublishUnsafe()` checks the index against its own.
+        next_expected_index_ = idxts.index + 1u;
         from_us_ = std::chrono::microseconds(0);
       } else {
         try {
@@ -297,7 +311,7 @@ class SubscribableRemoteStream final {
           HTTP(ChunkedGET(bare_stream.GetURLToSubscribe(this->next_expected_index_, this->from_us_, subscription_mode_),
                           [this](const std::string& header, const std::string& value) { OnHeader(header, value); },
                           [this](const std::string& chunk_body) { OnChunk(chunk_body); },
-                          [](){}));
+                          [](){}).AcceptGZip());
         } catch (StreamTerminatedBySubscriber&) {
           break;
         } catch (RemoteStreamMalformedChunkException&) {
@@ -27,12 +27,15 @@ SOFTWARE.
 
 #include "../port.h"
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "exceptions.h"
 #include "stream_impl.h"
@@ -44,6 +47,8 @@ SOFTWARE.
 #include "../blocks/http/api.h"
 #include "../blocks/persistence/memory.h"
 #include "../blocks/persistence/file.h"
+#include "../blocks/persistence/segmented.h"
+#include "../blocks/persistence/binary.h"
 #include "../blocks/ss/ss.h"
 #include "../blocks/ss/signature.h"
 
@@ -70,7 +75,9 @@ SOFTWARE.
 // any number of "borrowed" publishers, forked off the master one.
 //
 // Subscription is done via `auto scope = my_stream.Subscribe(my_subscriber);`, where `my_subscriber`
-// is an instance of the class doing the subscription. Stream runs each subscriber in a dedicated thread.
+// is an instance of the class doing the subscription. Stream runs each subscriber in a dedicated thread,
+// or, after `my_stream->SetSubscriberExecutor(executor)`, on the shared threads of the `SubscriberExecutor`.
+// The HTTP subscribers always run on an executor, the default one, `DefaultHTTPSubscriberExecutor()`, if not set.
 //
 // Stack ownership of `my_subscriber` is respected, and `SubscriberScope` is returned for the user to store.
 // As the returned `scope` object leaves the scope, the subscriber is sent a signal to terminate,
@@ -263,17 +270,27 @@ class Stream final {
   }
 
   // TODO(dkorolev): Master-follower flip between two streams belongs in Stream first, then in Storage.
+  // With no executor, the subscriber runs in its own thread. With the executor, the subscriber is its task.
   template <typename TYPE_SUBSCRIBED_TO, typename F, SubscriptionMode SM>
-  class SubscriberThreadInstance final : public current::stream::SubscriberScope::SubscriberThread {
+  class SubscriberThreadInstance final : public current::stream::SubscriberScope::SubscriberThread,
+                                         public SubscriberExecutor::Task {
    private:
     bool this_is_valid_;
     std::function<void()> done_callback_;
     current::WaitableTerminateSignal terminate_signal_;
     bool terminate_sent_;
+    const std::shared_ptr<SubscriberExecutor> executor_;
     BorrowedWithCallback<impl_t> impl_;
     F& subscriber_;
     const uint64_t begin_idx_;
     const std::chrono::microseconds from_us_;
+    uint64_t index_;
+    std::chrono::microseconds head_;
+    // Whether the subscriber has had the stream hold off the entries, see `SubscriberBacklogged()`.
+    bool backlogged_ = false;
+    // Whether the subscriber is done, and is only waiting for its backlog to be taken to be told so.
+    bool finishing_ = false;
+    std::atomic_bool resumed_{false};
     std::thread thread_;
 
     SubscriberThreadInstance() = delete;
@@ -287,35 +304,54 @@ class Stream final {
                              F& subscriber,
                              uint64_t begin_idx,
                              std::chrono::microseconds from_us,
-                             std::function<void()> done_callback)
+                             std::function<void()> done_callback,
+                             std::shared_ptr<SubscriberExecutor> executor)
         : this_is_valid_(false),
           done_callback_(done_callback),
           terminate_signal_(),
           terminate_sent_(false),
+          executor_(std::move(executor)),
           impl_(std::move(impl),
                 [this]() {
-                  // NOTE(dkorolev): I'm uncertain whether this lock is necessary here. Keeping it for safety now.
-                  std::lock_guard<std::mutex> lock(impl_->publishing_mutex);
-                  terminate_signal_.SignalExternalTermination();
+                  {
+                    // NOTE(dkorolev): I'm uncertain whether this lock is necessary here. Keeping it for safety now.
+                    std::lock_guard<std::mutex> lock(impl_->publishing_mutex);
+                    terminate_signal_.SignalExternalTermination();
+                  }
+                  WakeUpSubscriber();
                 }),
           subscriber_(subscriber),
           begin_idx_(begin_idx),
           from_us_(from_us),
-          thread_(&SubscriberThreadInstance::Thread, this) {
+          index_(begin_idx),
+          head_(from_us - std::chrono::microseconds(1)),
+          thread_(executor_ ? std::thread() : std::thread(&SubscriberThreadInstance::Thread, this)) {
       // Must guard against the constructor of `BorrowedWithCallback<impl_t> impl_` throwing.
       // NOTE(dkorolev): This is obsolete now, but keeping the logic for now, to keep it safe. -- D.K.
       this_is_valid_ = true;
+      if (executor_) {
+        executor_->Schedule(*this);
+      }
     }
 
     ~SubscriberThreadInstance() {
       if (this_is_valid_) {
-        // The constructor has completed successfully. The thread has started, and `impl_` is valid.
-        CURRENT_ASSERT(thread_.joinable());
+        // The constructor has completed successfully. The thread has started, or the task has been scheduled,
+        // and `impl_` is valid.
         if (!subscriber_thread_done_) {
-          std::lock_guard<std::mutex> lock(impl_->publishing_mutex);
-          terminate_signal_.SignalExternalTermination();
+          {
+            std::lock_guard<std::mutex> lock(impl_->publishing_mutex);
+            terminate_signal_.SignalExternalTermination();
+          }
+          WakeUpSubscriber();
+        }
+        if (executor_) {
+          executor_->WaitUntilDone(*this);
+          impl_->waiting_subscriber_tasks.Remove(*this);
+        } else {
+          CURRENT_ASSERT(thread_.joinable());
+          thread_.join();
         }
-        thread_.join();
       } else {
         // The constructor has not completed successfully. The thread was not started, and `impl_` is garbage.
         if (done_callback_) {
@@ -327,7 +363,35 @@ class Stream final {
     void Thread() {
       // Keep the subscriber thread exception-safe. By construction, it's guaranteed to live
       // strictly within the scope of existence of `impl_t` contained in `impl_`.
-      ThreadImpl(begin_idx_);
+      ThreadImpl();
+      SubscriberDone();
+    }
+
+    // The executor counterpart of `Thread()`: passes on what is available, and, unless done, waits to be scheduled.
+    bool RunTask() override {
+      if (finishing_ || PassAvailableEntriesToSubscriber()) {
+        // Unless terminating, the subscriber is done once the consumer has taken everything it was sent.
+        finishing_ = true;
+        if (!terminate_signal_ && SubscriberBacklogged(subscriber_, 0)) {
+          return false;
+        }
+        SubscriberDone();
+        return true;
+      }
+      if (backlogged_) {
+        // Scheduled again once the subscriber can take more, see `ResumeSubscriber()`.
+        return false;
+      }
+      // Registering before checking guarantees the entries published from now on will schedule the task.
+      impl_->waiting_subscriber_tasks.Add(*executor_, *this);
+      if (HasNewEventsForSubscriber()) {
+        impl_->waiting_subscriber_tasks.Remove(*this);
+        executor_->Schedule(*this);
+      }
+      return false;
+    }
+
+    void SubscriberDone() {
       subscriber_thread_done_ = true;
       std::lock_guard<std::mutex> lock(impl_->http_subscriptions_mutex);
       if (done_callback_) {
@@ -335,10 +399,55 @@ class Stream final {
       }
     }
 
+    // Makes sure the subscriber notices the termination signal, even if it is waiting for new entries.
+    void WakeUpSubscriber() {
+      if (executor_) {
+        impl_->waiting_subscriber_tasks.Remove(*this);
+        executor_->Schedule(*this);
+      } else {
+        impl_->subscribers_event_count.NotifyAll();
+      }
+    }
+
+    // The subscribers writing to a slow consumer, such as the HTTP ones, may have the stream hold off passing
+    // the entries to them via `Backlogged(resume)`, which returns `true` while the consumer has not taken
+    // what it was sent. Then `resume()` is to be called, once, as soon as it can take more, unless the subscription
+    // is over by then. Meanwhile, the subscriber does not hold up a thread, which matters with the executor.
+    template <typename G>
+    auto SubscriberBacklogged(G& subscriber, int)
+        -> decltype(static_cast<bool>(subscriber.Backlogged(std::function<void()>()))) {
+      resumed_ = false;
+      return subscriber.Backlogged([this]() { ResumeSubscriber(); });
+    }
+
+    template <typename G>
+    bool SubscriberBacklogged(G&, ...) {
+      return false;
+    }
+
+    // Returns `true` if the subscriber is backlogged, with `index_` set to the entry to resume from.
+    bool PauseIfBacklogged(uint64_t index) {
+      if (SubscriberBacklogged(subscriber_, 0)) {
+        backlogged_ = true;
+        index_ = index;
+        return true;
+      }
+      return false;
+    }
+
+    void ResumeSubscriber() {
+      if (executor_) {
+        executor_->Schedule(*this);
+      } else {
+        resumed_ = true;
+        impl_->subscribers_event_count.NotifyAll();
+      }
+    }
+
     template <SubscriptionMode MODE = SM>
-    ENABLE_IF<MODE == SubscriptionMode::Checked, ss::EntryResponse> PassEntriesToSubscriber(const impl_t& impl,
-                                                                                            uint64_t index,
-                                                                                            uint64_t size) {
+    ENABLE_IF<MODE == SubscriptionMode::Checked && !ss::IsBatchSubscriber<F, TYPE_SUBSCRIBED_TO>::value,
+              ss::EntryResponse>
+    PassEntriesToSubscriber(const impl_t& impl, uint64_t index, uint64_t size) {
       for (const auto& e : impl.persister.Iterate(index, size)) {
         if (!terminate_sent_ && terminate_signal_) {
           terminate_sent_ = true;
@@ -346,6 +455,9 @@ class Stream final {
             return ss::EntryResponse::Done;
           }
         }
+        if (PauseIfBacklogged(e.idx_ts.index)) {
+          return ss::EntryResponse::More;
+        }
         if (current::ss::PassEntryToSubscriberIfTypeMatches<TYPE_SUBSCRIBED_TO, entry_t>(
                 subscriber_,
                 [this]() -> ss::EntryResponse { return subscriber_.EntryResponseIfNoMorePassTypeFilter(); },
@@ -358,17 +470,43 @@ class Stream final {
       return ss::EntryResponse::More;
     }
 
+    // Persisters that can hand out raw lines with no copies, such as the file one, do so via `IterateMapped()`.
+    template <typename PERSISTER>
+    static ENABLE_IF<ss::HasMappedIteration<PERSISTER>::value, typename PERSISTER::IterableRangeMapped> IterateRaw(
+        const PERSISTER& persister, uint64_t begin, uint64_t end) {
+      return persister.IterateMapped(begin, end);
+    }
+
+    template <typename PERSISTER>
+    static ENABLE_IF<!ss::HasMappedIteration<PERSISTER>::value, typename PERSISTER::IterableRangeUnsafe> IterateRaw(
+        const PERSISTER& persister, uint64_t begin, uint64_t end) {
+      return persister.IterateUnsafe(begin, end);
+    }
+
+    // The entries before `FirstAvailableIndex()` of the persisters with a retention policy are skipped over.
+    template <typename PERSISTER>
+    static auto FirstAvailableIndex(const PERSISTER& persister, int) -> decltype(persister.FirstAvailableIndex()) {
+      return persister.FirstAvailableIndex();
+    }
+
+    template <typename PERSISTER>
+    static uint64_t FirstAvailableIndex(const PERSISTER&, ...) {
+      return 0u;
+    }
+
     template <SubscriptionMode MODE = SM>
-    ENABLE_IF<MODE == SubscriptionMode::Unchecked, ss::EntryResponse> PassEntriesToSubscriber(const impl_t& impl,
-                                                                                              uint64_t index,
-                                                                                              uint64_t size) {
-      for (const auto& e : impl.persister.IterateUnsafe(index, size)) {
+    ENABLE_IF<MODE == SubscriptionMode::Unchecked && !ss::IsRawBatchSubscriber<F>::value, ss::EntryResponse>
+    PassEntriesToSubscriber(const impl_t& impl, uint64_t index, uint64_t size) {
+      for (const auto& e : IterateRaw(impl.persister, index, size)) {
         if (!terminate_sent_ && terminate_signal_) {
           terminate_sent_ = true;
           if (subscriber_.Terminate() != ss::TerminationResponse::Wait) {
             return ss::EntryResponse::Done;
           }
         }
+        if (PauseIfBacklogged(index)) {
+          return ss::EntryResponse::More;
+        }
         if (subscriber_(e, index++, impl.persister.LastPublishedIndexAndTimestamp()) == ss::EntryResponse::Done) {
           return ss::EntryResponse::Done;
         }
@@ -376,45 +514,186 @@ class Stream final {
       return ss::EntryResponse::More;
     }
 
-    void ThreadImpl(uint64_t begin_idx) {
-      auto head = from_us_ - std::chrono::microseconds(1);
-      uint64_t index = begin_idx;
-      uint64_t size = 0;
+    // The batch subscribers may limit the size of the batch via `MaxBatchSize()`.
+    template <typename G>
+    static auto MaxBatchSize(const G& subscriber, int) -> decltype(static_cast<size_t>(subscriber.MaxBatchSize())) {
+      return std::max(static_cast<size_t>(subscriber.MaxBatchSize()), static_cast<size_t>(1u));
+    }
+
+    template <typename G>
+    static size_t MaxBatchSize(const G&, ...) {
+      return ss::kDefaultMaxBatchSize;
+    }
+
+    // Checked batch subscribers get the entries of the subscribed to type, with `LastPublishedIndexAndTimestamp()`
+    // called once per batch. The entries are kept in `entries` for as long as the batch refers to them.
+    template <SubscriptionMode MODE = SM>
+    ENABLE_IF<MODE == SubscriptionMode::Checked && ss::IsBatchSubscriber<F, TYPE_SUBSCRIBED_TO>::value,
+              ss::EntryResponse>
+    PassEntriesToSubscriber(const impl_t& impl, uint64_t index, uint64_t size) {
+      auto range = impl.persister.Iterate(index, size);
+      using entry_from_persister_t = current::decay<decltype(*range.begin())>;
+      const size_t max_batch_size = MaxBatchSize(subscriber_, 0);
+      std::vector<entry_from_persister_t> entries;
+      std::vector<ss::BatchedEntry<TYPE_SUBSCRIBED_TO>> batch;
+      entries.reserve(max_batch_size);
+      batch.reserve(max_batch_size);
+      const auto pass_batch = [&]() -> ss::EntryResponse {
+        ss::EntryResponse response = ss::EntryResponse::More;
+        if (!batch.empty()) {
+          response = subscriber_(static_cast<const std::vector<ss::BatchedEntry<TYPE_SUBSCRIBED_TO>>&>(batch),
+                                 impl.persister.LastPublishedIndexAndTimestamp());
+          batch.clear();
+        }
+        entries.clear();
+        return response;
+      };
+      bool last_entry_filtered_out = false;
+      uint64_t last_entry_index = 0u;
+      for (auto&& e : range) {
+        if (!terminate_sent_ && terminate_signal_) {
+          terminate_sent_ = true;
+          if (subscriber_.Terminate() != ss::TerminationResponse::Wait) {
+            return ss::EntryResponse::Done;
+          }
+        }
+        entries.push_back(std::move(e));
+        last_entry_index = entries.back().idx_ts.index;
+        last_entry_filtered_out = !current::ss::AppendEntryToBatchIfTypeMatches<TYPE_SUBSCRIBED_TO, entry_t>(
+            batch, entries.back().entry, entries.back().idx_ts);
+        if (last_entry_filtered_out) {
+          entries.pop_back();
+        }
+        if (batch.size() >= max_batch_size) {
+          if (pass_batch() == ss::EntryResponse::Done) {
+            return ss::EntryResponse::Done;
+          }
+          if (PauseIfBacklogged(last_entry_index + 1u)) {
+            return ss::EntryResponse::More;
+          }
+        }
+      }
+      if (pass_batch() == ss::EntryResponse::Done) {
+        return ss::EntryResponse::Done;
+      }
+      // Same as for the non-batch subscribers, if the last entry of the stream does not pass the type filter.
+      if (last_entry_filtered_out && last_entry_index == impl.persister.LastPublishedIndexAndTimestamp().index) {
+        return subscriber_.EntryResponseIfNoMorePassTypeFilter();
+      }
+      return ss::EntryResponse::More;
+    }
+
+    // Unchecked batch subscribers get the raw log lines, as the memory-mapped chunks where the persister has them.
+    // The mapped chunks outlive the iterator, and the remapping of the growing file, for as long as the persister
+    // lives; the other persisters hand out `std::string`-s, which are kept in `lines` until the batch is passed.
+    template <SubscriptionMode MODE = SM>
+    ENABLE_IF<MODE == SubscriptionMode::Unchecked && ss::IsRawBatchSubscriber<F>::value, ss::EntryResponse>
+    PassEntriesToSubscriber(const impl_t& impl, uint64_t index, uint64_t size) {
+      auto range = IterateRaw(impl.persister, index, size);
+      using raw_log_line_t = current::decay<decltype(*range.begin())>;
+      const size_t max_batch_size = MaxBatchSize(subscriber_, 0);
+      std::vector<raw_log_line_t> lines;
+      std::vector<ss::BatchedRawLogLine> batch;
+      lines.reserve(max_batch_size);
+      batch.reserve(max_batch_size);
+      const auto pass_batch = [&]() -> ss::EntryResponse {
+        ss::EntryResponse response = ss::EntryResponse::More;
+        if (!lines.empty()) {
+          for (const auto& line : lines) {
+            batch.emplace_back(current::strings::Chunk(line), index++);
+          }
+          response = subscriber_(static_cast<const std::vector<ss::BatchedRawLogLine>&>(batch),
+                                 impl.persister.LastPublishedIndexAndTimestamp());
+          batch.clear();
+          lines.clear();
+        }
+        return response;
+      };
+      for (auto&& e : range) {
+        if (!terminate_sent_ && terminate_signal_) {
+          terminate_sent_ = true;
+          if (subscriber_.Terminate() != ss::TerminationResponse::Wait) {
+            return ss::EntryResponse::Done;
+          }
+        }
+        lines.push_back(std::move(e));
+        if (lines.size() >= max_batch_size) {
+          if (pass_batch() == ss::EntryResponse::Done) {
+            return ss::EntryResponse::Done;
+          }
+          if (PauseIfBacklogged(index)) {
+            return ss::EntryResponse::More;
+          }
+        }
+      }
+      return pass_batch();
+    }
+
+    // Passes everything available to the subscriber, without waiting. Returns `true` once the subscriber is done.
+    // Stops early, with `backlogged_` set, if the subscriber is backlogged.
+    bool PassAvailableEntriesToSubscriber() {
+      backlogged_ = false;
       while (true) {
         if (!terminate_sent_ && terminate_signal_) {
           terminate_sent_ = true;
           if (subscriber_.Terminate() != ss::TerminationResponse::Wait) {
-            return;
+            return true;
           }
         }
+        if (PauseIfBacklogged(index_)) {
+          return false;
+        }
         const auto head_idx = impl_->persister.HeadAndLastPublishedIndexAndTimestamp();
-        size = Exists(head_idx.idxts) ? Value(head_idx.idxts).index + 1 : 0;
-        if (head_idx.head > head) {
-          if (size > index) {
-            if (PassEntriesToSubscriber(*impl_, index, size) == ss::EntryResponse::Done) {
-              return;
+        const uint64_t size = Exists(head_idx.idxts) ? Value(head_idx.idxts).index + 1 : 0;
+        if (head_idx.head > head_) {
+          index_ = std::max(index_, FirstAvailableIndex(impl_->persister, 0));
+          if (size > index_) {
+            if (PassEntriesToSubscriber(*impl_, index_, size) == ss::EntryResponse::Done) {
+              return true;
+            }
+            if (backlogged_) {
+              return false;
             }
-            index = size;
-            head = Value(head_idx.idxts).us;
+            index_ = size;
+            head_ = Value(head_idx.idxts).us;
           }
-          if (size >= begin_idx && head_idx.head > head && subscriber_(head_idx.head) == ss::EntryResponse::Done) {
-            return;
+          if (size >= begin_idx_ && head_idx.head > head_ && subscriber_(head_idx.head) == ss::EntryResponse::Done) {
+            return true;
           }
-          head = head_idx.head;
+          head_ = head_idx.head;
         } else {
-          std::unique_lock<std::mutex> lock(impl_->publishing_mutex);
-          current::WaitableTerminateSignalBulkNotifier::Scope scope(impl_->notifier, terminate_signal_);
-          terminate_signal_.WaitUntil(
-              lock,
-              [this, &index, &begin_idx, &head]() {
-                return terminate_signal_ ||
-                       impl_->persister.template Size<current::locks::MutexLockStatus::AlreadyLocked>() > index ||
-                       (index > begin_idx &&
-                        impl_->persister.template CurrentHead<current::locks::MutexLockStatus::AlreadyLocked>() > head);
-              });
+          return false;
         }
       }
     }
+
+    // Takes no locks, as it looks at the size and the head of the stream announced by the publisher.
+    bool HasNewEventsForSubscriber() const {
+      return terminate_signal_ || impl_->published_size.load() > index_ ||
+             (index_ > begin_idx_ && std::chrono::microseconds(impl_->published_head_us.load()) > head_);
+    }
+
+    // Waits for something new for the subscriber, or, if it is backlogged, for it to be able to take more.
+    void WaitForSubscriber() {
+      while (true) {
+        const auto key = impl_->subscribers_event_count.PrepareWait();
+        if (backlogged_ ? (resumed_ || terminate_signal_) : HasNewEventsForSubscriber()) {
+          break;
+        }
+        impl_->subscribers_event_count.Wait(key);
+      }
+    }
+
+    void ThreadImpl() {
+      while (!PassAvailableEntriesToSubscriber()) {
+        WaitForSubscriber();
+      }
+      // Same as in `RunTask()`, unless terminating, the subscriber is done once it has no backlog.
+      while (!terminate_signal_ && SubscriberBacklogged(subscriber_, 0)) {
+        backlogged_ = true;
+        WaitForSubscriber();
+      }
+    }
   };
 
   // Expose the means to control the scope of the subscriber.
@@ -431,9 +710,10 @@ class Stream final {
                         F& subscriber,
                         uint64_t begin_idx,
                         std::chrono::microseconds from_us,
-                        std::function<void()> done_callback)
-        : base_t(std::move(
-              std::make_unique<subscriber_thread_t>(std::move(impl), subscriber, begin_idx, from_us, done_callback))) {}
+                        std::function<void()> done_callback,
+                        std::shared_ptr<SubscriberExecutor> executor)
+        : base_t(std::move(std::make_unique<subscriber_thread_t>(
+              std::move(impl), subscriber, begin_idx, from_us, done_callback, std::move(executor)))) {}
 
     SubscriberScopeImpl(SubscriberScopeImpl&&) = default;
     SubscriberScopeImpl& operator=(SubscriberScopeImpl&&) = default;
@@ -454,7 +734,8 @@ class Stream final {
                                                    std::chrono::microseconds from_us = std::chrono::microseconds(0),
                                                    std::function<void()> done_callback = nullptr) const {
     static_assert(current::ss::IsStreamSubscriber<F, TYPE_SUBSCRIBED_TO>::value, "");
-    return SubscriberScope<F, TYPE_SUBSCRIBED_TO>(impl_, subscriber, begin_idx, from_us, done_callback);
+    return SubscriberScope<F, TYPE_SUBSCRIBED_TO>(
+        impl_, subscriber, begin_idx, from_us, done_callback, std::atomic_load(&impl_->subscriber_executor));
   }
 
   template <typename F>
@@ -462,7 +743,16 @@ class Stream final {
                                                  uint64_t begin_idx = 0u,
                                                  std::chrono::microseconds from_us = std::chrono::microseconds(0),
                                                  std::function<void()> done_callback = nullptr) const {
-    return SubscriberScopeUnchecked<F>(impl_, subscriber, begin_idx, from_us, done_callback);
+    return SubscriberScopeUnchecked<F>(
+        impl_, subscriber, begin_idx, from_us, done_callback, std::atomic_load(&impl_->subscriber_executor));
+  }
+
+  // Runs the subscribers started from now on on the threads of `executor`, instead of in a dedicated thread each.
+  // The same executor can serve many streams. Pass `nullptr` to revert to the threads.
+  // The subscribers already started are unaffected. The HTTP subscribers, see `ServeDataViaHTTP()`, never block
+  // on a slow client, and, with no executor set, run on `DefaultHTTPSubscriberExecutor()`, not in a thread each.
+  void SetSubscriberExecutor(std::shared_ptr<SubscriberExecutor> executor) {
+    std::atomic_store(&impl_->subscriber_executor, std::move(executor));
   }
 
   // Generates a random HTTP subscription.
@@ -584,11 +874,19 @@ class Stream final {
         // Note: Called from a locked section of `borrowed_impl->http_subscriptions_mutex`.
         borrowed_impl->http_subscriptions[subscription_id].second = nullptr;
       };
+      // The HTTP subscriber is held off while its client is slow, see `SubscriberBacklogged()`, instead of blocking
+      // on it, so it runs on the executor, the default one if none is set, not to take up a thread per subscription.
+      using http_subscriber_t = PubSubHTTPEndpoint<entry_t, PERSISTENCE_LAYER, J>;
+      std::shared_ptr<SubscriberExecutor> executor = std::atomic_load(&borrowed_impl->subscriber_executor);
+      if (!executor) {
+        executor = DefaultHTTPSubscriberExecutor();
+      }
       current::stream::SubscriberScope http_chunked_subscriber_scope =
-          request_params.checked ? static_cast<current::stream::SubscriberScope>(
-                                       Subscribe(*http_chunked_subscriber, begin_idx, from_timestamp, done_callback))
-                                 : static_cast<current::stream::SubscriberScope>(SubscribeUnchecked(
-                                       *http_chunked_subscriber, begin_idx, from_timestamp, done_callback));
+          request_params.checked
+              ? static_cast<current::stream::SubscriberScope>(SubscriberScope<http_subscriber_t>(
+                    borrowed_impl, *http_chunked_subscriber, begin_idx, from_timestamp, done_callback, executor))
+              : static_cast<current::stream::SubscriberScope>(SubscriberScopeUnchecked<http_subscriber_t>(
+                    borrowed_impl, *http_chunked_subscriber, begin_idx, from_timestamp, done_callback, executor));
 
       {
         std::lock_guard<std::mutex> lock(borrowed_impl->http_subscriptions_mutex);
@@ -27,9 +27,12 @@ SOFTWARE.
 
 #include "../port.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <thread>
 
+#include "../bricks/sync/event_count.h"
 #include "../bricks/util/random.h"
 #include "../bricks/util/waitable_terminate_signal.h"
 
@@ -37,12 +40,17 @@ SOFTWARE.
 #include "../blocks/persistence/file.h"
 #include "../blocks/ss/pubsub.h"
 
+#include "subscriber_executor.h"
+
 namespace current {
 namespace stream {
 
 constexpr static const char* kStreamHeaderCurrentStreamSize = "X-Current-Stream-Size";
 constexpr static const char* kStreamHeaderCurrentSubscriptionId = "X-Current-Stream-Subscription-Id";
 
+// The longest the HTTP subscription endpoints keep `NoFlush`-ed entries batched before sending them to the client.
+constexpr static std::chrono::milliseconds kStreamHTTPSubscriptionMaxLatency = std::chrono::milliseconds(50);
+
 // A generic top-level `SubscriberScope` to unite any implementations, to allow `std::move()`-ing them into one.
 // Features:
 // 1) Any per-stream and per-type `SyncSubscriber` can be moved into this "global" `SubscriberScope`.
@@ -105,10 +113,22 @@ struct StreamImpl {
   using entry_t = ENTRY;
   using persistence_layer_t = PERSISTENCE_LAYER<entry_t>;
 
-  // Publishing-related mutex and notifier are mutable to wait on them from the subscriber thread.
+  // Publishing-related mutex is mutable to lock it from the subscriber thread.
   mutable std::mutex publishing_mutex;
   persistence_layer_t persister;
-  mutable current::WaitableTerminateSignalBulkNotifier notifier;
+
+  // The size and the head of the stream, as announced to the subscribers after each publish, followed by
+  // `subscribers_event_count.NotifyAll()`. The subscribers waiting for new entries check these and wait on
+  // the event count without locking `publishing_mutex`, so that they do not contend with the publisher for it.
+  // Waking them up still takes time linear in their number, see `EventCount`.
+  std::atomic<uint64_t> published_size;
+  std::atomic<int64_t> published_head_us;
+  mutable current::EventCount subscribers_event_count;
+
+  // The subscribers run by a `SubscriberExecutor` that are waiting for new entries, see `SetSubscriberExecutor()`.
+  // The executor is accessed via `std::atomic_load()` and `std::atomic_store()`, it is `nullptr` unless set.
+  mutable SubscriberExecutor::WaitingTasks waiting_subscriber_tasks;
+  std::shared_ptr<SubscriberExecutor> subscriber_executor;
 
   // The HTTP-subscription-related logic is `mutable` because subscribing to a stream is `const` by convention.
   using http_subscriptions_t =
@@ -118,7 +138,27 @@ struct StreamImpl {
 
   template <typename... ARGS>
   StreamImpl(ARGS&&... args)
-      : persister(publishing_mutex, std::forward<ARGS>(args)...) {}
+      : persister(publishing_mutex, std::forward<ARGS>(args)...),
+        published_size(persister.Size()),
+        published_head_us(persister.CurrentHead().count()) {}
+
+  // Called by the publisher after the stream has changed. The publishers may call it concurrently,
+  // so the announced size and head only ever grow. The publishers with `MutexLockStatus::AlreadyLocked`,
+  // such as the storage, call it with `publishing_mutex` held, so the wake-ups add to the time it is held for.
+  void NotifySubscribers(uint64_t size, std::chrono::microseconds head) {
+    AtomicallyIncreaseTo(published_size, size);
+    AtomicallyIncreaseTo(published_head_us, static_cast<int64_t>(head.count()));
+    subscribers_event_count.NotifyAll();
+    waiting_subscriber_tasks.ScheduleAll();
+  }
+
+ private:
+  template <typename T>
+  static void AtomicallyIncreaseTo(std::atomic<T>& value, T new_value) {
+    T current_value = value.load();
+    while (current_value < new_value && !value.compare_exchange_weak(current_value, new_value)) {
+    }
+  }
 };
 
 template <typename ENTRY, template <typename> class PERSISTENCE_LAYER>
@@ -138,21 +178,21 @@ class StreamPublisherImpl {
   idxts_t PublisherPublishImpl(E&& e, TIMESTAMP&& timestamp) {
     const auto result =
         data_->persister.template PersisterPublishImpl<MLS>(std::forward<E>(e), std::forward<TIMESTAMP>(timestamp));
-    data_->notifier.NotifyAllOfExternalWaitableEvent();
+    data_->NotifySubscribers(result.index + 1u, result.us);
     return result;
   }
 
   template <current::locks::MutexLockStatus MLS>
   idxts_t PublisherPublishUnsafeImpl(const std::string& raw_log_line) {
     const auto result = data_->persister.template PersisterPublishUnsafeImpl<MLS>(raw_log_line);
-    data_->notifier.NotifyAllOfExternalWaitableEvent();
+    data_->NotifySubscribers(result.index + 1u, result.us);
     return result;
   }
 
   template <current::locks::MutexLockStatus MLS, typename TIMESTAMP>
   void PublisherUpdateHeadImpl(TIMESTAMP&& timestamp) {
     data_->persister.template PersisterUpdateHeadImpl<MLS>(std::forward<TIMESTAMP>(timestamp));
-    data_->notifier.NotifyAllOfExternalWaitableEvent();
+    data_->NotifySubscribers(data_->published_size.load(), data_->persister.template CurrentHead<MLS>());
   }
 
  private:
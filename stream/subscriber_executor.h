@@ -0,0 +1,256 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `SubscriberExecutor` runs stream subscribers on a fixed pool of threads, instead of a dedicated thread each.
+//
+// Each subscriber is a `SubscriberExecutor::Task`. Once scheduled, the task is run by one of the threads of the pool.
+// It passes on whatever it has to pass on to the subscriber without waiting for anything, and then either reports
+// it is done, or registers itself to be scheduled again when something new happens, such as an entry published.
+//
+// A task is never run by more than one thread at a time. If it is scheduled while it is running, it is run again
+// once the present run is over.
+//
+// NOTE: The subscribers blocking in their callbacks keep the thread of the pool busy. With all the threads busy,
+// the other subscribers of the executor wait. This is why the HTTP subscribers do not block on writing to the socket
+// of a slow client, but have the stream hold off their entries until the client takes more, see `Backlogged()`.
+//
+// Waiting for a task to be done, see `WaitUntilDone()`, runs the task in the waiting thread unless it is running
+// already, so that it does not depend on a free thread of the pool. And the executor may be destructed from
+// a thread of its own, for instance, by the last of its subscribers as it is destructed from a callback.
+
+#ifndef CURRENT_STREAM_SUBSCRIBER_EXECUTOR_H
+#define CURRENT_STREAM_SUBSCRIBER_EXECUTOR_H
+
+#include "../port.h"
+
+#include "../bricks/util/singleton.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace current {
+namespace stream {
+
+class SubscriberExecutor final {
+ public:
+  class Task {
+   public:
+    Task() = default;
+    virtual ~Task() = default;
+
+    // Returns `true` once the task is done, and should not be run again.
+    virtual bool RunTask() = 0;
+
+   private:
+    friend class SubscriberExecutor;
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // Guarded by the `mutex_` of the executor.
+    bool scheduled_ = false;
+    bool running_ = false;
+    bool done_ = false;
+    bool awaited_ = false;
+  };
+
+  // The tasks waiting for the next event to be scheduled, such as the subscribers that have caught up with the stream.
+  // The task is unregistered as it is scheduled, and should register itself again as it runs out of work.
+  // THREAD-SAFE.
+  class WaitingTasks final {
+   public:
+    void Add(SubscriberExecutor& executor, Task& task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace_back(&executor, &task);
+    }
+
+    void Remove(Task& task) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.erase(std::remove_if(tasks_.begin(),
+                                  tasks_.end(),
+                                  [&task](const std::pair<SubscriberExecutor*, Task*>& e) { return e.second == &task; }),
+                   tasks_.end());
+    }
+
+    void ScheduleAll() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!tasks_.empty()) {
+        // The tasks are scheduled while `mutex_` is locked, as the destructor of the task waits on `Remove()`.
+        for (const auto& e : tasks_) {
+          e.first->Schedule(*e.second);
+        }
+        tasks_.clear();
+      }
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<std::pair<SubscriberExecutor*, Task*>> tasks_;
+  };
+
+  // Zero threads stands for the number of cores.
+  explicit SubscriberExecutor(size_t threads = 0u) : state_(std::make_shared<State>()) {
+    const size_t n =
+        threads ? threads : std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1u));
+    threads_.reserve(n);
+    for (size_t i = 0u; i < n; ++i) {
+      threads_.emplace_back(&SubscriberExecutor::Thread, state_);
+    }
+  }
+
+  // The executor is destructed after all its tasks are done, as each user of it holds a `shared_ptr` to it.
+  // If destructed from a thread of its own, that thread is detached; it holds on to `state_` until it is over.
+  ~SubscriberExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      state_->destructing = true;
+      state_->condition_variable.notify_all();
+    }
+    for (auto& thread : threads_) {
+      if (thread.get_id() == std::this_thread::get_id()) {
+        thread.detach();
+      } else {
+        thread.join();
+      }
+    }
+  }
+
+  size_t Threads() const { return threads_.size(); }
+
+  // Scheduling a task that is done is a no-op. THREAD-SAFE.
+  void Schedule(Task& task) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (!task.done_ && !task.scheduled_) {
+      task.scheduled_ = true;
+      if (!task.running_) {
+        state_->queue.push_back(&task);
+        state_->condition_variable.notify_one();
+      }
+      if (task.awaited_) {
+        state_->task_done_condition_variable.notify_all();
+      }
+    }
+  }
+
+  // Waits until `RunTask()` of this task has returned `true`. After this call the executor never touches the task.
+  // Rather than wait for a thread of the pool, which may all be busy, the task is run in the calling thread when
+  // scheduled and not running. Must not be called from within `RunTask()` of the very task.
+  void WaitUntilDone(Task& task) {
+    CURRENT_ASSERT(ThreadLocalSingleton<CurrentTask>().task != &task);
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    task.awaited_ = true;
+    while (!task.done_) {
+      if (task.scheduled_ && !task.running_) {
+        // The task awaited and scheduled as it was running is not queued, see `RunTaskLocked()`.
+        auto& queue = state_->queue;
+        const auto it = std::find(queue.begin(), queue.end(), &task);
+        if (it != queue.end()) {
+          queue.erase(it);
+        }
+        RunTaskLocked(lock, task, *state_);
+      } else {
+        state_->task_done_condition_variable.wait(
+            lock, [&task]() { return task.done_ || (task.scheduled_ && !task.running_); });
+      }
+    }
+  }
+
+ private:
+  struct State final {
+    std::mutex mutex;
+    std::condition_variable condition_variable;
+    std::condition_variable task_done_condition_variable;
+    std::deque<Task*> queue;
+    bool destructing = false;
+  };
+
+  // The task `RunTask()` of which is being run by this thread, if any.
+  struct CurrentTask final {
+    Task* task = nullptr;
+  };
+
+  // Runs the task with `mutex` unlocked for the duration of `RunTask()`. Must be called with `mutex` locked.
+  static void RunTaskLocked(std::unique_lock<std::mutex>& lock, Task& task, State& state) {
+    task.scheduled_ = false;
+    task.running_ = true;
+    lock.unlock();
+    Task*& current_task = ThreadLocalSingleton<CurrentTask>().task;
+    Task* const previous_task = current_task;
+    current_task = &task;
+    const bool done = task.RunTask();
+    current_task = previous_task;
+    lock.lock();
+    task.running_ = false;
+    if (done) {
+      task.done_ = true;
+      state.task_done_condition_variable.notify_all();
+    } else if (task.scheduled_) {
+      if (task.awaited_) {
+        state.task_done_condition_variable.notify_all();
+      } else {
+        state.queue.push_back(&task);
+        state.condition_variable.notify_one();
+      }
+    }
+  }
+
+  // Holds on to `state`, as the thread may outlive the executor if it is destructed from within `RunTask()`.
+  static void Thread(std::shared_ptr<State> state) {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true) {
+      state->condition_variable.wait(lock, [&state]() { return state->destructing || !state->queue.empty(); });
+      if (state->queue.empty()) {
+        return;
+      }
+      Task& task = *state->queue.front();
+      state->queue.pop_front();
+      RunTaskLocked(lock, task, *state);
+    }
+  }
+
+  SubscriberExecutor(const SubscriberExecutor&) = delete;
+  SubscriberExecutor& operator=(const SubscriberExecutor&) = delete;
+
+  const std::shared_ptr<State> state_;
+  std::vector<std::thread> threads_;
+};
+
+// The executor of the HTTP subscribers of the streams with no executor set, see `Stream::ServeDataViaHTTP()`,
+// so that many HTTP subscriptions do not take as many threads. Started on first use, with a thread per core.
+inline std::shared_ptr<SubscriberExecutor> DefaultHTTPSubscriberExecutor() {
+  struct Holder final {
+    const std::shared_ptr<SubscriberExecutor> executor = std::make_shared<SubscriberExecutor>();
+  };
+  return Singleton<Holder>().executor;
+}
+
+}  // namespace stream
+}  // namespace current
+
+#endif  // CURRENT_STREAM_SUBSCRIBER_EXECUTOR_H
@@ -31,7 +31,9 @@ SOFTWARE.
 
 #include <string>
 #include <atomic>
+#include <memory>
 #include <thread>
+#include <vector>
 
 #include "../typesystem/struct.h"
 #include "../typesystem/variant.h"
@@ -39,6 +41,7 @@ SOFTWARE.
 #include "../blocks/http/api.h"
 #include "../blocks/persistence/memory.h"
 #include "../blocks/persistence/file.h"
+#include "../blocks/persistence/segmented.h"
 
 #include "../bricks/strings/strings.h"
 
@@ -955,6 +958,194 @@ TEST(Stream, HTTPSubscriptionCanBeTerminated) {
   slow_subscriber.join();
 }
 
+TEST(Stream, SubscriberExecutor) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+
+  auto stream = current::stream::Stream<Record>::CreateStream();
+  const auto executor = std::make_shared<current::stream::SubscriberExecutor>(2u);
+  stream->SetSubscriberExecutor(executor);
+  EXPECT_EQ(2u, executor->Threads());
+
+  for (int i = 1; i <= 3; ++i) {
+    stream->Publisher()->Publish(Record(i), std::chrono::microseconds(i));
+  }
+
+  // Many more subscribers than threads, some of them catching up, all of them tailing the stream.
+  const size_t kSubscribers = 32u;
+  std::vector<std::vector<std::string>> rows(kSubscribers);
+  std::vector<std::vector<std::string>> entries(kSubscribers);
+  std::vector<std::unique_ptr<RecordsCollector>> subscribers;
+  std::vector<current::stream::SubscriberScope> scopes;
+  for (size_t i = 0u; i < kSubscribers; ++i) {
+    subscribers.push_back(std::make_unique<RecordsCollector>(rows[i], entries[i]));
+    scopes.push_back(stream->Subscribe(*subscribers.back()));
+  }
+
+  for (int i = 4; i <= 100; ++i) {
+    stream->Publisher()->Publish(Record(i), std::chrono::microseconds(i));
+  }
+
+  for (size_t i = 0u; i < kSubscribers; ++i) {
+    while (subscribers[i]->count_ < 100u) {
+      std::this_thread::yield();
+    }
+    ASSERT_EQ(100u, entries[i].size());
+    EXPECT_EQ("{\"x\":1}\n", entries[i].front());
+    EXPECT_EQ("{\"x\":100}\n", entries[i].back());
+  }
+  for (auto& scope : scopes) {
+    EXPECT_TRUE(scope);
+  }
+
+  // The subscribers waiting for new entries terminate as their scopes are gone.
+  scopes.clear();
+  EXPECT_EQ(100u, subscribers.front()->count_);
+
+  // The HTTP subscribers run on the executor too.
+  const auto http_scope = HTTP(FLAGS_stream_http_test_port).Register("/executor", *stream);
+  const std::string base_url = Printf("http://localhost:%d/executor", FLAGS_stream_http_test_port);
+  {
+    const auto result = HTTP(GET(base_url + "?i=98&n=2"));
+    EXPECT_EQ(200, static_cast<int>(result.code));
+    EXPECT_EQ("{\"index\":98,\"us\":99}\t{\"x\":99}\n{\"index\":99,\"us\":100}\t{\"x\":100}\n", result.body);
+  }
+  {
+    std::thread publisher([&stream]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      stream->Publisher()->Publish(Record(101), std::chrono::microseconds(101));
+    });
+    // The subscriber waiting for the entry to be published may get the head of the stream first.
+    const auto result = HTTP(GET(base_url + "?i=100&n=1"));
+    const std::string golden = "{\"index\":100,\"us\":101}\t{\"x\":101}\n";
+    ASSERT_GE(result.body.length(), golden.length());
+    EXPECT_EQ(golden, result.body.substr(result.body.length() - golden.length()));
+    publisher.join();
+  }
+}
+
+TEST(Stream, HTTPSubscribersOfStalledClientsDoNotHoldUpTheExecutor) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+
+  // The clients that request the whole stream, and never read the response. They outlive the stream.
+  std::vector<current::net::Connection> stalled_clients;
+
+  auto stream = current::stream::Stream<RecordWithTimestamp>::CreateStream();
+  // A single thread, which would be held up by the first client not reading if the HTTP subscribers blocked on it.
+  stream->SetSubscriberExecutor(std::make_shared<current::stream::SubscriberExecutor>(1u));
+
+  // Way more than the buffers of the sockets on the both ends take.
+  const size_t kEntries = 320u;
+  for (size_t i = 0u; i < kEntries; ++i) {
+    stream->Publisher()->Publish(RecordWithTimestamp(std::string(65536u, static_cast<char>('a' + i % 26u)),
+                                                     std::chrono::microseconds(i + 1u)));
+  }
+
+  const auto http_scope = HTTP(FLAGS_stream_http_test_port).Register("/stalled", *stream);
+
+  for (size_t i = 0u; i < 3u; ++i) {
+    stalled_clients.push_back(current::net::ClientSocket("localhost", FLAGS_stream_http_test_port));
+    stalled_clients.back().BlockingWrite(std::string("GET /stalled HTTP/1.1\r\nHost: localhost\r\n\r\n"), false);
+  }
+  // Let them fill up the buffers of their sockets.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  const std::string base_url = Printf("http://localhost:%d/stalled", FLAGS_stream_http_test_port);
+  {
+    const auto result = HTTP(GET(base_url + "?i=100&n=1&entries_only"));
+    EXPECT_EQ(200, static_cast<int>(result.code));
+    EXPECT_EQ(JSON(RecordWithTimestamp(std::string(65536u, 'w'), std::chrono::microseconds(101))) + '\n',
+              result.body);
+  }
+  {
+    const auto result = HTTP(GET(base_url + "?i=319&n=1&entries_only"));
+    EXPECT_EQ(200, static_cast<int>(result.code));
+    EXPECT_EQ(JSON(RecordWithTimestamp(std::string(65536u, 'h'), std::chrono::microseconds(320))) + '\n',
+              result.body);
+  }
+
+  // The subscriptions of the stalled clients end with the stream, with no waiting for the clients to read.
+}
+
+namespace stream_unittest {
+
+// Terminates another subscriber from within its callback, as a subscriber destructing its own `SubscriberScope`s would.
+struct ScopeDestructingSubscriberImpl {
+  current::stream::SubscriberScope& scope_;
+  std::atomic_bool scope_destructed_;
+
+  explicit ScopeDestructingSubscriberImpl(current::stream::SubscriberScope& scope)
+      : scope_(scope), scope_destructed_(false) {}
+
+  EntryResponse operator()(const Record&, idxts_t, idxts_t) {
+    scope_ = nullptr;
+    scope_destructed_ = true;
+    return EntryResponse::Done;
+  }
+
+  EntryResponse operator()(std::chrono::microseconds) const { return EntryResponse::More; }
+
+  static EntryResponse EntryResponseIfNoMorePassTypeFilter() { return EntryResponse::More; }
+
+  TerminationResponse Terminate() { return TerminationResponse::Terminate; }
+};
+
+using ScopeDestructingSubscriber = current::ss::StreamSubscriber<ScopeDestructingSubscriberImpl, Record>;
+
+// Releases the last reference to the executor from within its own thread.
+struct ExecutorReleasingTask final : current::stream::SubscriberExecutor::Task {
+  std::shared_ptr<current::stream::SubscriberExecutor> executor_;
+  std::atomic_bool executor_released_{false};
+
+  bool RunTask() override {
+    executor_ = nullptr;
+    executor_released_ = true;
+    return true;
+  }
+};
+
+}  // namespace stream_unittest
+
+TEST(Stream, SubscriberExecutorSubscriberTerminatedFromCallback) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+
+  auto stream = current::stream::Stream<Record>::CreateStream();
+  // The single thread of the executor is busy running the subscriber terminating the other one.
+  stream->SetSubscriberExecutor(std::make_shared<current::stream::SubscriberExecutor>(1u));
+
+  std::vector<std::string> rows;
+  std::vector<std::string> entries;
+  RecordsCollector collector(rows, entries);
+  current::stream::SubscriberScope collector_scope = stream->Subscribe(collector);
+
+  ScopeDestructingSubscriber terminator(collector_scope);
+  const auto terminator_scope = stream->Subscribe(terminator);
+
+  stream->Publisher()->Publish(Record(1), std::chrono::microseconds(1));
+  while (!terminator.scope_destructed_) {
+    std::this_thread::yield();
+  }
+  EXPECT_FALSE(collector_scope);
+
+  // The executor is only referred to by the subscriber left, and is destructed with it.
+  stream->SetSubscriberExecutor(nullptr);
+}
+
+TEST(Stream, SubscriberExecutorDestructedFromItsOwnThread) {
+  // The task outlives the thread that runs it.
+  static stream_unittest::ExecutorReleasingTask task;
+  task.executor_ = std::make_shared<current::stream::SubscriberExecutor>(1u);
+  task.executor_->Schedule(task);
+  while (!task.executor_released_) {
+    std::this_thread::yield();
+  }
+}
+
 const std::string golden_signature() {
   current::reflection::StructSchema struct_schema;
   struct_schema.AddType<stream_unittest::Record>();
@@ -1017,6 +1208,54 @@ TEST(Stream, PersistsToFile) {
   EXPECT_EQ(stream_golden_data, current::FileSystem::ReadFileAsString(persistence_file_name));
 }
 
+TEST(Stream, SubscriptionsSkipTheSegmentsDroppedByRetention) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+  using current::persistence::FileRetention;
+  using current::persistence::FileSegmentation;
+
+  const std::string base_file_name = current::FileSystem::JoinPath(FLAGS_stream_test_tmpdir, "segmented");
+  std::vector<std::unique_ptr<current::FileSystem::ScopedRmFile>> removers;
+  removers.push_back(std::make_unique<current::FileSystem::ScopedRmFile>(base_file_name + ".manifest"));
+  for (uint64_t begin = 0u; begin <= 20u; begin += 10u) {
+    removers.push_back(std::make_unique<current::FileSystem::ScopedRmFile>(
+        base_file_name + '.' + Printf("%020llu", static_cast<unsigned long long>(begin))));
+  }
+
+  // Ten entries per segment, with only the last sealed segment retained.
+  auto stream = current::stream::Stream<Record, current::persistence::SegmentedFile>::CreateStream(
+      base_file_name,
+      FileSegmentation::ByDuration(std::chrono::microseconds(100)),
+      FileRetention::BySegments(1u));
+  for (int i = 0; i < 30; ++i) {
+    stream->Publisher()->Publish(Record(i), std::chrono::microseconds((i + 1) * 10));
+  }
+  EXPECT_EQ(30u, stream->Data()->Size());
+  EXPECT_EQ(10u, stream->Data()->FirstAvailableIndex());
+
+  Data d;
+  Data d_unchecked;
+  {
+    StreamTestProcessor p(d, false);
+    StreamTestProcessor p_unchecked(d_unchecked, false);
+    p.SetMax(20u);
+    p_unchecked.SetMax(20u);
+    stream->Subscribe(p);
+    stream->SubscribeUnchecked(p_unchecked);
+  }
+  std::vector<std::string> expected_values;
+  for (int i = 10; i < 30; ++i) {
+    expected_values.push_back(current::ToString(i));
+  }
+  // A careful condition, since the subscriber may be asked to terminate before processing the entries.
+  EXPECT_TRUE(CompareValuesMixedWithTerminate(d.results_, expected_values, StreamTestProcessor::kTerminateStr))
+      << d.results_;
+  EXPECT_TRUE(
+      CompareValuesMixedWithTerminate(d_unchecked.results_, expected_values, StreamTestProcessor::kTerminateStr))
+      << d_unchecked.results_;
+}
+
 TEST(Stream, ParsesFromFile) {
   current::time::ResetToZero();
 
@@ -1096,6 +1335,67 @@ TEST(Stream, ParsesFromFile) {
       << joined_expected_values << " != " << d_unchecked.results_;
 }
 
+TEST(Stream, PersistsToBinaryFile) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_stream_test_tmpdir, "data.bin");
+  const auto persistence_file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+  const std::string text_file_name = current::FileSystem::JoinPath(FLAGS_stream_test_tmpdir, "data");
+  const auto text_file_remover = current::FileSystem::ScopedRmFile(text_file_name);
+
+  const auto namespace_name = current::ss::StreamNamespaceName(current::stream::constants::kDefaultNamespaceName,
+                                                               current::stream::constants::kDefaultTopLevelName);
+
+  {
+    auto persisted =
+        current::stream::Stream<Record, current::persistence::Binary>::CreateStream(persistence_file_name);
+
+    current::time::SetNow(std::chrono::microseconds(100));
+    persisted->Publisher()->Publish(Record(1));
+    current::time::SetNow(std::chrono::microseconds(200));
+    persisted->Publisher()->Publish(Record(2));
+    current::time::SetNow(std::chrono::microseconds(300));
+    persisted->Publisher()->UpdateHead();
+    current::time::SetNow(std::chrono::microseconds(400));
+    persisted->Publisher()->Publish(Record(3));
+    current::time::SetNow(std::chrono::microseconds(450));
+    persisted->Publisher()->UpdateHead();
+    current::time::SetNow(std::chrono::microseconds(500));
+    persisted->Publisher()->UpdateHead();
+  }
+
+  // The intermediate head, `300`, is not carried over by the conversion, as it is not the most recent one.
+  EXPECT_EQ(3u,
+            current::persistence::ConvertBinaryToFile<Record>(persistence_file_name, text_file_name, namespace_name));
+  EXPECT_EQ(stream_golden_data_single_head, current::FileSystem::ReadFileAsString(text_file_name));
+
+  auto parsed = current::stream::Stream<Record, current::persistence::Binary>::CreateStream(persistence_file_name);
+
+  Data d;
+  Data d_unchecked;
+  {
+    StreamTestProcessor p(d, false, true);
+    StreamTestProcessor p_unchecked(d_unchecked, false, true);
+    p.SetMax(4u);
+    p_unchecked.SetMax(4u);
+    parsed->Subscribe(p);  // A blocking call until the subscriber processes three entries and one head update.
+    parsed->SubscribeUnchecked(p_unchecked);
+    EXPECT_EQ(4u, d.seen_);
+    EXPECT_EQ(500, d.head_.count());
+    EXPECT_EQ(4u, d_unchecked.seen_);
+    EXPECT_EQ(500, d_unchecked.head_.count());
+  }
+
+  const std::vector<std::string> expected_values{"[0:100,2:400] 1", "[1:200,2:400] 2", "[2:400,2:400] 3"};
+  EXPECT_TRUE(CompareValuesMixedWithTerminate(d.results_, expected_values, StreamTestProcessor::kTerminateStr))
+      << d.results_;
+  EXPECT_TRUE(
+      CompareValuesMixedWithTerminate(d_unchecked.results_, expected_values, StreamTestProcessor::kTerminateStr))
+      << d_unchecked.results_;
+}
+
 TEST(Stream, UncheckedVsCheckedSubscription) {
   using namespace stream_unittest;
 
@@ -1349,6 +1649,21 @@ TEST(Stream, ParseArbitrarilySplitChunks) {
   }
 
   EXPECT_EQ(stream_golden_data, current::FileSystem::ReadFileAsString(persistence_file_name));
+
+  // Same for the raw replication, which appends the received lines as they are, only scanning their indexes.
+  const std::string raw_persistence_file_name = current::FileSystem::JoinPath(FLAGS_stream_test_tmpdir, "raw_data");
+  const auto raw_persistence_file_remover = current::FileSystem::ScopedRmFile(raw_persistence_file_name);
+  auto raw_replicated_stream = stream_t::CreateStream(raw_persistence_file_name);
+  auto raw_replicator = RemoteStreamReplicator(raw_replicated_stream);
+
+  {
+    const auto subscriber_scope = remote_stream.SubscribeUnchecked(raw_replicator);
+    while (raw_replicated_stream->Data()->Size() < 3u) {
+      std::this_thread::yield();
+    }
+  }
+
+  EXPECT_EQ(stream_golden_data, current::FileSystem::ReadFileAsString(raw_persistence_file_name));
 }
 
 TEST(Stream, MasterFollowerFlip) {
@@ -1885,6 +2200,190 @@ TEST(Stream, SubscribeWithFilterByType) {
   }
 }
 
+namespace stream_unittest {
+
+// Collects the batches, for the `BatchSubscribers` test.
+struct BatchCollectorImpl {
+  BatchCollectorImpl() = delete;
+  explicit BatchCollectorImpl(size_t expected_count) : expected_count_(expected_count) {}
+
+  template <typename T>
+  EntryResponse operator()(const std::vector<current::ss::BatchedEntry<T>>& batch, idxts_t last) {
+    std::vector<std::string> entries;
+    for (const auto& e : batch) {
+      EXPECT_LE(e.current.index, last.index);
+      entries.push_back(current::ToString(e.current.index) + ':' + JSON<JSONFormat::Minimalistic>(e.entry));
+    }
+    count_ += batch.size();
+    results_.push_back('[' + Join(entries, ',') + ']');
+    return count_ == expected_count_ ? EntryResponse::Done : EntryResponse::More;
+  }
+
+  EntryResponse operator()(const std::vector<current::ss::BatchedRawLogLine>& batch, idxts_t) {
+    std::vector<std::string> entries;
+    for (const auto& e : batch) {
+      const std::string line = e.raw_log_line;
+      const auto tab_pos = line.find('\t');
+      CURRENT_ASSERT(tab_pos != std::string::npos);
+      EXPECT_EQ(e.current_index, ParseJSON<idxts_t>(line.substr(0, tab_pos)).index);
+      entries.push_back(current::ToString(e.current_index));
+    }
+    count_ += batch.size();
+    results_.push_back('[' + Join(entries, ',') + ']');
+    return count_ == expected_count_ ? EntryResponse::Done : EntryResponse::More;
+  }
+
+  // Never called, as the batch callbacks take precedence.
+  template <typename E>
+  EntryResponse operator()(const E&, idxts_t, idxts_t) {
+    ADD_FAILURE();
+    return EntryResponse::Done;
+  }
+  EntryResponse operator()(const std::string&, uint64_t, idxts_t) {
+    ADD_FAILURE();
+    return EntryResponse::Done;
+  }
+
+  EntryResponse operator()(std::chrono::microseconds) const { return EntryResponse::More; }
+  TerminationResponse Terminate() const { return TerminationResponse::Wait; }
+  static EntryResponse EntryResponseIfNoMorePassTypeFilter() { return EntryResponse::More; }
+  static size_t MaxBatchSize() { return 2u; }
+
+  std::vector<std::string> results_;
+  size_t count_ = 0u;
+  const size_t expected_count_;
+};
+
+}  // namespace stream_unittest
+
+TEST(Stream, BatchSubscribers) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+
+  auto stream = current::stream::Stream<Variant<Record, AnotherRecord>>::CreateStream();
+  for (int i = 1; i <= 5; ++i) {
+    current::time::SetNow(std::chrono::microseconds(i));
+    if (i & 1) {
+      stream->Publisher()->Publish(Record(i));
+    } else {
+      stream->Publisher()->Publish(AnotherRecord(i));
+    }
+  }
+
+  {
+    using Collector = current::ss::StreamSubscriber<BatchCollectorImpl, Variant<Record, AnotherRecord>>;
+    static_assert(current::ss::IsBatchSubscriber<Collector, Variant<Record, AnotherRecord>>::value, "");
+    static_assert(current::ss::IsRawBatchSubscriber<Collector>::value, "");
+    static_assert(!current::ss::IsBatchSubscriber<RecordsCollector, Record>::value, "");
+    static_assert(!current::ss::IsRawBatchSubscriber<RecordsUncheckedCollector>::value, "");
+
+    Collector c(5);
+    Collector c_unchecked(5);
+    stream->Subscribe(c);
+    stream->SubscribeUnchecked(c_unchecked);
+    EXPECT_EQ(
+        "[0:{\"Record\":{\"x\":1}},1:{\"AnotherRecord\":{\"y\":2}}] "
+        "[2:{\"Record\":{\"x\":3}},3:{\"AnotherRecord\":{\"y\":4}}] "
+        "[4:{\"Record\":{\"x\":5}}]",
+        Join(c.results_, ' '));
+    EXPECT_EQ("[0,1] [2,3] [4]", Join(c_unchecked.results_, ' '));
+  }
+
+  {
+    // The batches are made of the entries passing the type filter.
+    using Collector = current::ss::StreamSubscriber<BatchCollectorImpl, Record>;
+    static_assert(current::ss::IsBatchSubscriber<Collector, Record>::value, "");
+
+    Collector c(3);
+    stream->Subscribe<Record>(c);
+    EXPECT_EQ("[0:{\"x\":1},2:{\"x\":3}] [4:{\"x\":5}]", Join(c.results_, ' '));
+  }
+}
+
+namespace stream_unittest {
+
+// Checks the raw log lines of each batch in full, for the `RawBatchesOutliveTheRemapOfTheFile` test.
+struct RawBatchCheckerImpl {
+  RawBatchCheckerImpl() = delete;
+  explicit RawBatchCheckerImpl(size_t expected_count) : expected_count_(expected_count) {}
+
+  EntryResponse operator()(const std::vector<current::ss::BatchedRawLogLine>& batch, idxts_t) {
+    for (const auto& e : batch) {
+      const std::string line = e.raw_log_line;
+      const auto tab_pos = line.find('\t');
+      CURRENT_ASSERT(tab_pos != std::string::npos);
+      EXPECT_EQ(e.current_index, ParseJSON<idxts_t>(line.substr(0, tab_pos)).index);
+      EXPECT_EQ(std::string(100000u, static_cast<char>('a' + e.current_index)),
+                ParseJSON<RecordWithTimestamp>(line.substr(tab_pos + 1)).s);
+    }
+    count_ += batch.size();
+    batch_sizes_.push_back(current::ToString(batch.size()));
+    return count_ == expected_count_ ? EntryResponse::Done : EntryResponse::More;
+  }
+
+  // Never called, as the batch callback takes precedence.
+  template <typename E>
+  EntryResponse operator()(const E&, idxts_t, idxts_t) {
+    ADD_FAILURE();
+    return EntryResponse::Done;
+  }
+  EntryResponse operator()(const std::string&, uint64_t, idxts_t) {
+    ADD_FAILURE();
+    return EntryResponse::Done;
+  }
+
+  EntryResponse operator()(std::chrono::microseconds) const { return EntryResponse::More; }
+  TerminationResponse Terminate() const { return TerminationResponse::Wait; }
+  static EntryResponse EntryResponseIfNoMorePassTypeFilter() { return EntryResponse::More; }
+  static size_t MaxBatchSize() { return 100u; }
+
+  std::vector<std::string> batch_sizes_;
+  size_t count_ = 0u;
+  const size_t expected_count_;
+};
+
+}  // namespace stream_unittest
+
+// The memory-mapped chunks of one batch may span the remap of the file, which grows past the capacity of the
+// mapping the iteration has started with.
+TEST(Stream, RawBatchesOutliveTheRemapOfTheFile) {
+  current::time::ResetToZero();
+
+  using namespace stream_unittest;
+  using Checker = current::ss::StreamSubscriber<RawBatchCheckerImpl, RecordWithTimestamp>;
+
+  const std::string persistence_file_name = current::FileSystem::JoinPath(FLAGS_stream_test_tmpdir, "data");
+  const auto persistence_file_remover = current::FileSystem::ScopedRmFile(persistence_file_name);
+
+  auto stream =
+      current::stream::Stream<RecordWithTimestamp, current::persistence::File>::CreateStream(persistence_file_name);
+  const auto publish = [&stream](uint64_t index) {
+    current::time::SetNow(std::chrono::microseconds(index + 1u));
+    stream->Publisher()->Publish(RecordWithTimestamp(std::string(100000u, static_cast<char>('a' + index))));
+  };
+
+  // Some 900KB, mapped with the minimum capacity of 1MB.
+  for (uint64_t i = 0u; i < 9u; ++i) {
+    publish(i);
+  }
+  {
+    Checker c(9u);
+    stream->SubscribeUnchecked(c);
+    EXPECT_EQ("9", Join(c.batch_sizes_, ' '));
+  }
+
+  // Some 1.2MB, the iteration over which starts with the 1MB mapping, and remaps the file halfway through the batch.
+  for (uint64_t i = 9u; i < 12u; ++i) {
+    publish(i);
+  }
+  {
+    Checker c(12u);
+    stream->SubscribeUnchecked(c);
+    EXPECT_EQ("12", Join(c.batch_sizes_, ' '));
+  }
+}
+
 TEST(Stream, ReleaseAndAcquirePublisher) {
   current::time::ResetToZero();
 
@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "schema.h"
 
+#include "../serialization/binary.h"
 #include "../serialization/json.h"
 #include "../evolution/type_evolution.h"
 
@@ -316,6 +317,55 @@ TEST(Schema, SmokeTestFullStruct) {
             restored_schema.Describe<Language::TypeScript>());
 }
 
+TEST(Schema, SmokeTestFullStructBinaryRoundTrip) {
+  using namespace smoke_test_struct_namespace;
+
+  // Same as `serialized/smoke_test_struct.json`, with more fields populated, and with no uninitialized `Variant`-s.
+  FullTest full_test{B2()};
+  C full_test_c{A()};
+  full_test_c.d = Variant<A, X, Y>(Y());
+  full_test.q = full_test_c;
+  full_test.w2.bar = X();
+  full_test.w5.meh = Y();
+  full_test.v1.push_back("foo");
+  full_test.v1.push_back(std::string("bar\0baz", 7));
+  full_test.v2.push_back(full_test.primitives);
+  full_test.v2.back().h = -1;
+  full_test.v2.back().n = std::chrono::microseconds(-1);
+  full_test.o = full_test.primitives;
+  full_test.tsc.o2 = 42;
+  full_test.tsc.o5 = std::vector<A>(2u);
+  full_test.tsc.o7["null"] = nullptr;
+  full_test.tsc.o7["value"] = A();
+
+  const std::string json = JSON(full_test);
+  const std::string binary = SaveIntoBinary(full_test);
+  EXPECT_LT(binary.length() * 2u, json.length());
+  FullTest restored{Empty()};
+  LoadFromBinary(binary, restored);
+  EXPECT_EQ(json, JSON(restored));
+}
+
+TEST(Schema, SmokeTestFullStructWriterMatchesDocument) {
+  using namespace smoke_test_struct_namespace;
+
+  // Leaves `w2.bar` and `w5.meh` uninitialized, to cover the omitted fields of the `Minimalistic` format.
+  FullTest full_test{B2()};
+  full_test.q = C{A()};
+  full_test.v1.push_back("foo");
+  full_test.v2.push_back(full_test.primitives);
+  full_test.o = full_test.primitives;
+  full_test.tsc.o2 = 42;
+  full_test.tsc.o7["null"] = nullptr;
+  full_test.tsc.o7["value"] = A();
+
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::Current>(full_test), JSON<JSONFormat::Current>(full_test));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::Minimalistic>(full_test), JSON<JSONFormat::Minimalistic>(full_test));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::JavaScript>(full_test), JSON<JSONFormat::JavaScript>(full_test));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::NewtonsoftFSharp>(full_test),
+            JSON<JSONFormat::NewtonsoftFSharp>(full_test));
+}
+
 namespace schema_test {
 
 CURRENT_STRUCT(FS) {
@@ -22,9 +22,831 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 *******************************************************************************/
 
+// The binary format for `CURRENT_STRUCT`-s, a compact counterpart of the JSON one.
+//
+// * `bool`, `char`, `int8_t` and `uint8_t` take one byte each.
+// * Wider unsigned integers are LEB128 varints, wider signed integers and `std::chrono::*` are zigzag varints.
+// * `float` and `double` are their IEEE 754 representations, four and eight bytes, little endian.
+// * `std::string`-s and containers are prefixed by the varint number of bytes or elements respectively.
+// * `enum`-s are serialized as their underlying types.
+// * `Optional<T>` is a byte, `0` or `1`, followed by the value if it is present.
+// * `Variant<...>` is a varint case tag, the one-based index of the type in its type list, followed by the value.
+//   An uninitialized `Variant` is serialized as the tag of `0`, and is an error when loaded.
+// * `CURRENT_STRUCT`-s are the fields of the base struct, followed by their own fields, in the order of declaration.
+//
+// No field names and no type IDs are written, so the schema is implied. The binary format is meant to be used
+// where the schema is known to both ends, such as within a persisted stream, which carries its signature.
+
 #ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_BINARY_H
 #define CURRENT_TYPE_SYSTEM_SERIALIZATION_BINARY_H
 
-// TBD.
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "exceptions.h"
+#include "serialization.h"
+
+#include "../helpers.h"
+#include "../optional.h"
+#include "../struct.h"
+#include "../variant.h"
+#include "../reflection/reflection.h"
+
+#include "../../bricks/template/enable_if.h"
+#include "../../bricks/template/pod.h"  // `current::copy_free`.
+
+namespace current {
+namespace serialization {
+namespace binary {
+
+class BinarySerializer final {
+ public:
+  explicit BinarySerializer(std::string& output) : output_(output) {}
+
+  void WriteByte(uint8_t byte) { output_.push_back(static_cast<char>(byte)); }
+
+  void WriteVarUInt(uint64_t value) {
+    char buffer[10];
+    size_t size = 0u;
+    while (value >= 0x80u) {
+      buffer[size++] = static_cast<char>(value | 0x80u);
+      value >>= 7;
+    }
+    buffer[size++] = static_cast<char>(value);
+    output_.append(buffer, size);
+  }
+
+  void WriteVarInt(int64_t value) {
+    WriteVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+  }
+
+  template <typename T>
+  void WriteLittleEndian(T value) {
+    static_assert(std::is_unsigned<T>::value, "");
+    char buffer[sizeof(T)];
+    for (size_t i = 0u; i < sizeof(T); ++i) {
+      buffer[i] = static_cast<char>(value >> (i * 8u));
+    }
+    output_.append(buffer, sizeof(T));
+  }
+
+  void WriteBytes(const char* data, size_t size) {
+    WriteVarUInt(size);
+    output_.append(data, size);
+  }
+
+ private:
+  std::string& output_;
+};
+
+// Reads from a contiguous block of memory, which is the fast path.
+class BinaryMemoryReader final {
+ public:
+  BinaryMemoryReader(const char* begin, const char* end) : begin_(begin), p_(begin), end_(end) {}
+
+  uint8_t ReadByte() {
+    if (p_ == end_) {
+      CURRENT_THROW(BinaryLoadFromStreamException("Unexpected end of binary data at offset " +
+                                                  current::ToString(p_ - begin_) + '.'));
+    }
+    return static_cast<uint8_t>(*p_++);
+  }
+
+  void ReadBytes(std::string& destination, uint64_t size) {
+    if (size > static_cast<uint64_t>(end_ - p_)) {
+      CURRENT_THROW(BinaryLoadFromStreamException("Unexpected end of binary data at offset " +
+                                                  current::ToString(p_ - begin_) + ", " + current::ToString(size) +
+                                                  " bytes expected."));
+    }
+    destination.assign(p_, static_cast<size_t>(size));
+    p_ += size;
+  }
+
+  // The upper bound for `reserve()`-ing containers, so that malformed input can not exhaust memory.
+  uint64_t ReserveHint() const { return static_cast<uint64_t>(end_ - p_); }
+
+  size_t Offset() const { return static_cast<size_t>(p_ - begin_); }
+  bool AtEnd() const { return p_ == end_; }
+
+ private:
+  const char* const begin_;
+  const char* p_;
+  const char* const end_;
+};
+
+// Reads from an `std::istream`, to load multiple objects saved into the same stream one after another.
+class BinaryStreamReader final {
+ public:
+  explicit BinaryStreamReader(std::istream& is) : buffer_(*is.rdbuf()) {}
+
+  uint8_t ReadByte() {
+    const auto c = buffer_.sbumpc();
+    if (c == std::char_traits<char>::eof()) {
+      CURRENT_THROW(BinaryLoadFromStreamException("Unexpected end of binary stream."));
+    }
+    return static_cast<uint8_t>(c);
+  }
+
+  void ReadBytes(std::string& destination, uint64_t size) {
+    // Read in blocks, so that a malformed size results in an exception, not in an attempt to allocate it all.
+    constexpr static uint64_t kBlockSize = 1024u * 1024u;
+    destination.clear();
+    while (destination.length() < size) {
+      const size_t offset = destination.length();
+      const size_t block = static_cast<size_t>(std::min(kBlockSize, size - offset));
+      destination.resize(offset + block);
+      if (buffer_.sgetn(&destination[offset], static_cast<std::streamsize>(block)) !=
+          static_cast<std::streamsize>(block)) {
+        CURRENT_THROW(BinaryLoadFromStreamException("Unexpected end of binary stream, " + current::ToString(size) +
+                                                    " bytes expected."));
+      }
+    }
+  }
+
+  uint64_t ReserveHint() const { return 1024u; }
+
+ private:
+  std::streambuf& buffer_;
+};
+
+template <class READER>
+class BinaryDeserializer final {
+ public:
+  template <typename... ARGS>
+  explicit BinaryDeserializer(ARGS&&... args) : reader_(std::forward<ARGS>(args)...) {}
+
+  READER& Reader() { return reader_; }
+
+  uint8_t ReadByte() { return reader_.ReadByte(); }
+
+  uint64_t ReadVarUInt() {
+    uint64_t result = 0u;
+    for (uint32_t shift = 0u; shift < 64u; shift += 7u) {
+      const uint8_t byte = reader_.ReadByte();
+      result |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+      if (!(byte & 0x80u)) {
+        return result;
+      }
+    }
+    CURRENT_THROW(BinaryLoadFromStreamException("Malformed varint in binary data."));
+  }
+
+  int64_t ReadVarInt() {
+    const uint64_t zigzag = ReadVarUInt();
+    return static_cast<int64_t>((zigzag >> 1) ^ (~(zigzag & 1u) + 1u));
+  }
+
+  template <typename T>
+  T ReadLittleEndian() {
+    static_assert(std::is_unsigned<T>::value, "");
+    T result = 0u;
+    for (size_t i = 0u; i < sizeof(T); ++i) {
+      result |= static_cast<T>(static_cast<T>(reader_.ReadByte()) << (i * 8u));
+    }
+    return result;
+  }
+
+  void ReadBytes(std::string& destination) { reader_.ReadBytes(destination, ReadVarUInt()); }
+
+  uint64_t ReadSize() { return ReadVarUInt(); }
+  size_t ReserveHint(uint64_t size) const { return static_cast<size_t>(std::min(size, reader_.ReserveHint())); }
+
+ private:
+  READER reader_;
+};
+
+// The one-based case tag of `T` in the type list of a `Variant`.
+template <typename TYPELIST, typename T>
+struct BinaryVariantCaseTag;
+
+template <typename T, typename... TS>
+struct BinaryVariantCaseTag<TypeListImpl<T, TS...>, T> {
+  constexpr static uint64_t value = 1u;
+};
+
+template <typename T, typename U, typename... TS>
+struct BinaryVariantCaseTag<TypeListImpl<U, TS...>, T> {
+  constexpr static uint64_t value = 1u + BinaryVariantCaseTag<TypeListImpl<TS...>, T>::value;
+};
+
+template <class READER, typename VARIANT, typename TYPELIST>
+struct BinaryVariantLoader;
+
+template <class READER, typename VARIANT, typename... TS>
+struct BinaryVariantLoader<READER, VARIANT, TypeListImpl<TS...>> {
+  template <typename X>
+  static void LoadCase(BinaryDeserializer<READER>& deserializer, VARIANT& destination) {
+    auto result = std::make_unique<X>();
+    Deserialize(deserializer, *result);
+    destination.UncheckedMoveFromUniquePtr(std::move(result));
+  }
+
+  static void Load(BinaryDeserializer<READER>& deserializer, VARIANT& destination, uint64_t tag) {
+    using loader_t = void (*)(BinaryDeserializer<READER>&, VARIANT&);
+    static const loader_t loaders[] = {&LoadCase<TS>...};
+    if (tag >= 1u && tag <= sizeof...(TS)) {
+      loaders[tag - 1u](deserializer, destination);
+    } else {
+      CURRENT_THROW(BinaryLoadFromStreamException("Invalid variant case tag " + current::ToString(tag) + '.'));
+    }
+  }
+};
+
+template <typename T>
+struct IsBinarySingleByteInteger {
+  constexpr static bool value = std::numeric_limits<T>::is_integer && sizeof(T) == 1u && !std::is_same<T, bool>::value;
+};
+
+template <typename T>
+struct IsBinaryVarUInt {
+  constexpr static bool value =
+      std::numeric_limits<T>::is_integer && !std::numeric_limits<T>::is_signed && sizeof(T) > 1u;
+};
+
+template <typename T>
+struct IsBinaryVarInt {
+  constexpr static bool value =
+      std::numeric_limits<T>::is_integer && std::numeric_limits<T>::is_signed && sizeof(T) > 1u;
+};
+
+}  // namespace current::serialization::binary
+
+// `bool`.
+template <>
+struct SerializeImpl<binary::BinarySerializer, bool> {
+  static void DoSerialize(binary::BinarySerializer& serializer, bool value) { serializer.WriteByte(value ? 1u : 0u); }
+};
+
+template <class READER>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, bool> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, bool& destination) {
+    const uint8_t byte = deserializer.ReadByte();
+    if (byte > 1u) {
+      CURRENT_THROW(BinaryLoadFromStreamException("Invalid boolean value " + current::ToString(byte) + '.'));
+    }
+    destination = (byte != 0u);
+  }
+};
+
+// `char`, `int8_t`, `uint8_t`.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, T, std::enable_if_t<binary::IsBinarySingleByteInteger<T>::value>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, T value) {
+    serializer.WriteByte(static_cast<uint8_t>(value));
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>,
+                       T,
+                       std::enable_if_t<binary::IsBinarySingleByteInteger<T>::value>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    destination = static_cast<T>(deserializer.ReadByte());
+  }
+};
+
+// `uint16_t`, `uint32_t`, `uint64_t`.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, T, std::enable_if_t<binary::IsBinaryVarUInt<T>::value>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, T value) {
+    serializer.WriteVarUInt(static_cast<uint64_t>(value));
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, T, std::enable_if_t<binary::IsBinaryVarUInt<T>::value>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    destination = static_cast<T>(deserializer.ReadVarUInt());
+  }
+};
+
+// `int16_t`, `int32_t`, `int64_t`.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, T, std::enable_if_t<binary::IsBinaryVarInt<T>::value>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, T value) {
+    serializer.WriteVarInt(static_cast<int64_t>(value));
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, T, std::enable_if_t<binary::IsBinaryVarInt<T>::value>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    destination = static_cast<T>(deserializer.ReadVarInt());
+  }
+};
+
+// `float`.
+template <>
+struct SerializeImpl<binary::BinarySerializer, float> {
+  static void DoSerialize(binary::BinarySerializer& serializer, float value) {
+    static_assert(sizeof(float) == sizeof(uint32_t), "");
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    serializer.WriteLittleEndian(bits);
+  }
+};
+
+template <class READER>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, float> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, float& destination) {
+    const uint32_t bits = deserializer.template ReadLittleEndian<uint32_t>();
+    std::memcpy(&destination, &bits, sizeof(bits));
+  }
+};
+
+// `double`.
+template <>
+struct SerializeImpl<binary::BinarySerializer, double> {
+  static void DoSerialize(binary::BinarySerializer& serializer, double value) {
+    static_assert(sizeof(double) == sizeof(uint64_t), "");
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    serializer.WriteLittleEndian(bits);
+  }
+};
+
+template <class READER>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, double> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, double& destination) {
+    const uint64_t bits = deserializer.template ReadLittleEndian<uint64_t>();
+    std::memcpy(&destination, &bits, sizeof(bits));
+  }
+};
+
+// `std::string`.
+template <>
+struct SerializeImpl<binary::BinarySerializer, std::string> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::string& value) {
+    serializer.WriteBytes(value.data(), value.length());
+  }
+};
+
+template <class READER>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::string> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::string& destination) {
+    deserializer.ReadBytes(destination);
+  }
+};
+
+// `std::chrono::microseconds`, `std::chrono::milliseconds`.
+template <typename R, typename P>
+struct SerializeImpl<binary::BinarySerializer, std::chrono::duration<R, P>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, std::chrono::duration<R, P> value) {
+    serializer.WriteVarInt(static_cast<int64_t>(value.count()));
+  }
+};
+
+template <class READER, typename R, typename P>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::chrono::duration<R, P>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer,
+                            std::chrono::duration<R, P>& destination) {
+    destination = std::chrono::duration<R, P>(static_cast<R>(deserializer.ReadVarInt()));
+  }
+};
+
+// `enum`-s and `enum class`-es.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, T, std::enable_if_t<std::is_enum<T>::value>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, T value) {
+    Serialize(serializer, static_cast<typename std::underlying_type<T>::type>(value));
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, T, std::enable_if_t<std::is_enum<T>::value>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    typename std::underlying_type<T>::type value;
+    Deserialize(deserializer, value);
+    destination = static_cast<T>(value);
+  }
+};
+
+// `std::vector<T>`.
+template <typename T, typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::vector<T, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::vector<T, TA>& value) {
+    serializer.WriteVarUInt(value.size());
+    for (const auto& element : value) {
+      Serialize(serializer, element);
+    }
+  }
+};
+
+template <typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::vector<bool, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::vector<bool, TA>& value) {
+    serializer.WriteVarUInt(value.size());
+    for (const bool element : value) {
+      serializer.WriteByte(element ? 1u : 0u);
+    }
+  }
+};
+
+template <class READER, typename T, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::vector<T, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::vector<T, TA>& destination) {
+    const uint64_t size = deserializer.ReadSize();
+    destination.clear();
+    destination.reserve(deserializer.ReserveHint(size));
+    for (uint64_t i = 0u; i < size; ++i) {
+      destination.emplace_back();
+      Deserialize(deserializer, destination.back());
+    }
+  }
+};
+
+template <class READER, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::vector<bool, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::vector<bool, TA>& destination) {
+    const uint64_t size = deserializer.ReadSize();
+    destination.clear();
+    destination.reserve(deserializer.ReserveHint(size));
+    for (uint64_t i = 0u; i < size; ++i) {
+      bool element;
+      Deserialize(deserializer, element);
+      destination.push_back(element);
+    }
+  }
+};
+
+// `std::pair<TF, TS>`.
+template <typename TF, typename TS>
+struct SerializeImpl<binary::BinarySerializer, std::pair<TF, TS>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::pair<TF, TS>& value) {
+    Serialize(serializer, value.first);
+    Serialize(serializer, value.second);
+  }
+};
+
+template <class READER, typename TF, typename TS>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::pair<TF, TS>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::pair<TF, TS>& destination) {
+    Deserialize(deserializer, destination.first);
+    Deserialize(deserializer, destination.second);
+  }
+};
+
+// `std::tuple<TS...>`.
+template <typename... TS>
+struct SerializeImpl<binary::BinarySerializer, std::tuple<TS...>> {
+  template <size_t... IS>
+  static void DoSerializeElements(binary::BinarySerializer& serializer,
+                                  const std::tuple<TS...>& value,
+                                  std::index_sequence<IS...>) {
+    const int dummy[] = {0, (Serialize(serializer, std::get<IS>(value)), 0)...};
+    static_cast<void>(dummy);
+  }
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::tuple<TS...>& value) {
+    DoSerializeElements(serializer, value, std::index_sequence_for<TS...>());
+  }
+};
+
+template <class READER, typename... TS>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::tuple<TS...>> {
+  template <size_t... IS>
+  static void DoDeserializeElements(binary::BinaryDeserializer<READER>& deserializer,
+                                    std::tuple<TS...>& destination,
+                                    std::index_sequence<IS...>) {
+    const int dummy[] = {0, (Deserialize(deserializer, std::get<IS>(destination)), 0)...};
+    static_cast<void>(dummy);
+  }
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::tuple<TS...>& destination) {
+    DoDeserializeElements(deserializer, destination, std::index_sequence_for<TS...>());
+  }
+};
+
+namespace binary {
+
+template <typename CONTAINER>
+inline void SerializeBinaryMapOrSet(BinarySerializer& serializer, const CONTAINER& value) {
+  serializer.WriteVarUInt(value.size());
+  for (const auto& element : value) {
+    Serialize(serializer, element);
+  }
+}
+
+template <class READER, typename CONTAINER>
+inline void DeserializeBinaryMap(BinaryDeserializer<READER>& deserializer, CONTAINER& destination) {
+  const uint64_t size = deserializer.ReadSize();
+  destination.clear();
+  for (uint64_t i = 0u; i < size; ++i) {
+    typename CONTAINER::key_type k;
+    typename CONTAINER::mapped_type v;
+    Deserialize(deserializer, k);
+    Deserialize(deserializer, v);
+    destination.emplace(std::move(k), std::move(v));
+  }
+}
+
+template <class READER, typename CONTAINER>
+inline void DeserializeBinarySet(BinaryDeserializer<READER>& deserializer, CONTAINER& destination) {
+  const uint64_t size = deserializer.ReadSize();
+  destination.clear();
+  for (uint64_t i = 0u; i < size; ++i) {
+    typename CONTAINER::value_type element;
+    Deserialize(deserializer, element);
+    destination.insert(std::move(element));
+  }
+}
+
+}  // namespace current::serialization::binary
+
+// `std::map<TK, TV>`, `std::unordered_map<TK, TV>`.
+template <typename TK, typename TV, typename TC, typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::map<TK, TV, TC, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::map<TK, TV, TC, TA>& value) {
+    binary::SerializeBinaryMapOrSet(serializer, value);
+  }
+};
+
+template <class READER, typename TK, typename TV, typename TC, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::map<TK, TV, TC, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::map<TK, TV, TC, TA>& destination) {
+    binary::DeserializeBinaryMap(deserializer, destination);
+  }
+};
+
+template <typename TK, typename TV, typename HASH, typename EQ, typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::unordered_map<TK, TV, HASH, EQ, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::unordered_map<TK, TV, HASH, EQ, TA>& value) {
+    binary::SerializeBinaryMapOrSet(serializer, value);
+  }
+};
+
+template <class READER, typename TK, typename TV, typename HASH, typename EQ, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::unordered_map<TK, TV, HASH, EQ, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer,
+                            std::unordered_map<TK, TV, HASH, EQ, TA>& destination) {
+    binary::DeserializeBinaryMap(deserializer, destination);
+  }
+};
+
+// `std::set<T>`, `std::unordered_set<T>`.
+template <typename T, typename TC, typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::set<T, TC, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::set<T, TC, TA>& value) {
+    binary::SerializeBinaryMapOrSet(serializer, value);
+  }
+};
+
+template <class READER, typename T, typename TC, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::set<T, TC, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, std::set<T, TC, TA>& destination) {
+    binary::DeserializeBinarySet(deserializer, destination);
+  }
+};
+
+template <typename T, typename HASH, typename EQ, typename TA>
+struct SerializeImpl<binary::BinarySerializer, std::unordered_set<T, HASH, EQ, TA>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const std::unordered_set<T, HASH, EQ, TA>& value) {
+    binary::SerializeBinaryMapOrSet(serializer, value);
+  }
+};
+
+template <class READER, typename T, typename HASH, typename EQ, typename TA>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, std::unordered_set<T, HASH, EQ, TA>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer,
+                            std::unordered_set<T, HASH, EQ, TA>& destination) {
+    binary::DeserializeBinarySet(deserializer, destination);
+  }
+};
+
+// `Optional<T>`, `ImmutableOptional<T>`.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, Optional<T>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const Optional<T>& value) {
+    if (Exists(value)) {
+      serializer.WriteByte(1u);
+      Serialize(serializer, Value(value));
+    } else {
+      serializer.WriteByte(0u);
+    }
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, Optional<T>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, Optional<T>& destination) {
+    bool exists;
+    Deserialize(deserializer, exists);
+    if (exists) {
+      destination = T();
+      Deserialize(deserializer, Value(destination));
+    } else {
+      destination = nullptr;
+    }
+  }
+};
+
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, ImmutableOptional<T>> {
+  static void DoSerialize(binary::BinarySerializer& serializer, const ImmutableOptional<T>& value) {
+    if (Exists(value)) {
+      serializer.WriteByte(1u);
+      Serialize(serializer, Value(value));
+    } else {
+      serializer.WriteByte(0u);
+    }
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, ImmutableOptional<T>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, ImmutableOptional<T>& destination) {
+    bool exists;
+    Deserialize(deserializer, exists);
+    if (exists) {
+      T value;
+      Deserialize(deserializer, value);
+      destination = std::move(value);
+    } else {
+      destination = nullptr;
+    }
+  }
+};
+
+// `CURRENT_STRUCT`-s.
+template <>
+struct SerializeImpl<binary::BinarySerializer, CurrentStruct> {
+  static void DoSerialize(binary::BinarySerializer&, const CurrentStruct&) {}
+};
+
+template <class READER>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, CurrentStruct> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>&, CurrentStruct&) {}
+};
+
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer,
+                     T,
+                     std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
+  class SerializeSingleField {
+   public:
+    explicit SerializeSingleField(binary::BinarySerializer& serializer) : serializer_(serializer) {}
+
+    template <typename U>
+    void operator()(const char*, const U& value) const {
+      Serialize(serializer_, value);
+    }
+
+   private:
+    binary::BinarySerializer& serializer_;
+  };
+
+  static void DoSerialize(binary::BinarySerializer& serializer, const T& value) {
+    using super_t = current::reflection::SuperType<T>;
+    Serialize(serializer, static_cast<const super_t&>(value));
+    current::reflection::VisitAllFields<T, current::reflection::FieldNameAndImmutableValue>::WithObject(
+        value, SerializeSingleField(serializer));
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>,
+                       T,
+                       std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
+  class DeserializeSingleField {
+   public:
+    explicit DeserializeSingleField(binary::BinaryDeserializer<READER>& deserializer) : deserializer_(deserializer) {}
+
+    template <typename U>
+    void operator()(const char*, U& value) const {
+      Deserialize(deserializer_, value);
+    }
+
+   private:
+    binary::BinaryDeserializer<READER>& deserializer_;
+  };
+
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    using super_t = current::reflection::SuperType<T>;
+    Deserialize(deserializer, static_cast<super_t&>(destination));
+    current::reflection::VisitAllFields<T, current::reflection::FieldNameAndMutableValue>::WithObject(
+        destination, DeserializeSingleField(deserializer));
+  }
+};
+
+// `Variant<...>`-s.
+template <typename T>
+struct SerializeImpl<binary::BinarySerializer, T, std::enable_if_t<IS_CURRENT_VARIANT(T)>> {
+  class SerializeCase {
+   public:
+    explicit SerializeCase(binary::BinarySerializer& serializer) : serializer_(serializer) {}
+
+    template <typename X>
+    void operator()(const X& value) const {
+      serializer_.WriteVarUInt(binary::BinaryVariantCaseTag<typename T::typelist_t, X>::value);
+      Serialize(serializer_, value);
+    }
+
+   private:
+    binary::BinarySerializer& serializer_;
+  };
+
+  static void DoSerialize(binary::BinarySerializer& serializer, const T& value) {
+    if (Exists(value)) {
+      value.Call(SerializeCase(serializer));
+    } else {
+      serializer.WriteVarUInt(0u);
+    }
+  }
+};
+
+template <class READER, typename T>
+struct DeserializeImpl<binary::BinaryDeserializer<READER>, T, std::enable_if_t<IS_CURRENT_VARIANT(T)>> {
+  static void DoDeserialize(binary::BinaryDeserializer<READER>& deserializer, T& destination) {
+    const uint64_t tag = deserializer.ReadVarUInt();
+    if (tag) {
+      binary::BinaryVariantLoader<READER, T, typename T::typelist_t>::Load(deserializer, destination, tag);
+    } else {
+      CURRENT_THROW(BinaryUninitializedVariantObjectException());
+    }
+  }
+};
+
+namespace binary {
+
+template <typename T>
+inline void SaveIntoBinary(std::string& output, const T& source) {
+  BinarySerializer serializer(output);
+  Serialize(serializer, source);
+}
+
+template <typename T>
+inline std::string SaveIntoBinary(const T& source) {
+  std::string output;
+  SaveIntoBinary(output, source);
+  return output;
+}
+
+template <typename T>
+inline void SaveIntoBinary(std::ostream& os, const T& source) {
+  const std::string output = SaveIntoBinary(source);
+  os.write(output.data(), static_cast<std::streamsize>(output.length()));
+}
+
+template <typename T>
+inline void LoadFromBinary(const char* data, size_t size, T& destination) {
+  BinaryDeserializer<BinaryMemoryReader> deserializer(data, data + size);
+  try {
+    Deserialize(deserializer, destination);
+    CheckIntegrity(destination);
+  } catch (UninitializedVariant) {
+    CURRENT_THROW(BinaryUninitializedVariantObjectException());
+  }
+  if (!deserializer.Reader().AtEnd()) {
+    CURRENT_THROW(BinaryLoadFromStreamException("Unexpected trailing binary data at offset " +
+                                                current::ToString(deserializer.Reader().Offset()) + '.'));
+  }
+}
+
+template <typename T>
+inline void LoadFromBinary(const std::string& binary, T& destination) {
+  LoadFromBinary(binary.data(), binary.length(), destination);
+}
+
+template <typename T>
+inline T LoadFromBinary(const std::string& binary) {
+  T result;
+  LoadFromBinary(binary, result);
+  return result;
+}
+
+// Loads one object from the stream, leaving the stream positioned right after it.
+template <typename T>
+inline void LoadFromBinary(std::istream& is, T& destination) {
+  BinaryDeserializer<BinaryStreamReader> deserializer(is);
+  try {
+    Deserialize(deserializer, destination);
+    CheckIntegrity(destination);
+  } catch (UninitializedVariant) {
+    CURRENT_THROW(BinaryUninitializedVariantObjectException());
+  }
+}
+
+template <typename T>
+inline T LoadFromBinary(std::istream& is) {
+  T result;
+  LoadFromBinary(is, result);
+  return result;
+}
+
+}  // namespace current::serialization::binary
+}  // namespace current::serialization
+}  // namespace current
+
+using current::serialization::binary::SaveIntoBinary;
+using current::serialization::binary::LoadFromBinary;
 
 #endif  // CURRENT_TYPE_SYSTEM_SERIALIZATION_BINARY_H
@@ -49,6 +49,19 @@ struct JSONUninitializedVariantObjectException : TypeSystemParseJSONException {}
 
 }  // namepsace current::serialization::json
 
+namespace binary {
+
+struct BinaryLoadFromStreamException : Exception {
+  using Exception::Exception;
+};
+
+struct BinaryUninitializedVariantObjectException : BinaryLoadFromStreamException {
+  BinaryUninitializedVariantObjectException()
+      : BinaryLoadFromStreamException("Uninitialized `Variant` in binary data.") {}
+};
+
+}  // namespace current::serialization::binary
+
 }  // namespace current::serialization
 }  // namespace current
 
@@ -56,5 +69,7 @@ using current::serialization::json::InvalidJSONException;
 using current::serialization::json::TypeSystemParseJSONException;
 using current::serialization::json::RapidJSONAssertionFailedException;
 using current::serialization::json::JSONUninitializedVariantObjectException;
+using current::serialization::binary::BinaryLoadFromStreamException;
+using current::serialization::binary::BinaryUninitializedVariantObjectException;
 
 #endif  // TYPE_SYSTEM_SERIALIZATION_EXCEPTIONS_BASE_H
@@ -42,6 +42,14 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, T, std::enable_if_t<std
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename T>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, T, std::enable_if_t<std::is_enum<T>::value>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const T enum_value) {
+    using underlying_t = typename std::underlying_type<T>::type;
+    json::JSONValueWriterImpl<underlying_t>::WriteValue(json_writer.Writer(), static_cast<underlying_t>(enum_value));
+  }
+};
+
 template <class JSON_FORMAT, typename T>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, T, std::enable_if_t<std::is_enum<T>::value>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, T& destination) {
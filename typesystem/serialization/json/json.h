@@ -36,6 +36,7 @@ SOFTWARE.
 #include "../../helpers.h"
 
 #include "../../../bricks/strings/chunk.h"
+#include "../../../bricks/util/singleton.h"
 #include "../../../bricks/template/pod.h"  // `current::copy_free`.
 
 namespace current {
@@ -223,6 +224,49 @@ struct JSONVariantTypeNameInDollarKey<JSONFormat::JavaScript> {
   constexpr static bool value = true;
 };
 
+// Serializes straight into a RapidJSON SAX `Writer`, without building an intermediate `rapidjson::Document`.
+// The output is byte-identical to that of `JSONStringifier`, which is kept as the reference implementation.
+template <class JSON_FORMAT, class WRITER = rapidjson::Writer<rapidjson::StringBuffer>>
+class JSONWriter final {
+ public:
+  explicit JSONWriter(WRITER& writer) : writer_(writer) {}
+
+  WRITER& Writer() { return writer_; }
+
+ private:
+  WRITER& writer_;
+};
+
+// For RapidJSON SAX writes, the counterpart of `JSONValueAssignerImpl`.
+template <typename T, typename ENABLE = void>
+struct JSONValueWriterImpl;
+
+template <typename T>
+struct JSONValueWriterImpl<T,
+                           std::enable_if_t<std::numeric_limits<T>::is_integer && std::numeric_limits<T>::is_signed>> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, T value) {
+    writer.Int64(static_cast<int64_t>(value));
+  }
+};
+
+template <typename T>
+struct JSONValueWriterImpl<T,
+                           std::enable_if_t<std::numeric_limits<T>::is_integer && !std::numeric_limits<T>::is_signed &&
+                                            !std::is_same<T, bool>::value>> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, T value) {
+    writer.Uint64(static_cast<uint64_t>(value));
+  }
+};
+
+// Whether the value, when it is a field of an object, should be omitted altogether.
+// Mirrors `JSONStringifier::MarkAsAbsentValue()`, which the SAX path can not use, as it never goes back.
+template <class JSON_FORMAT, typename T, typename ENABLE = void>
+struct JSONValueIsAbsent {
+  static bool IsAbsent(const T&) { return false; }
+};
+
 template <class J>
 struct JSONPatcher {
   constexpr static JSONVariantStyle variant_style = J::variant_style;
@@ -238,10 +282,103 @@ struct JSONPatchMode<JSONPatcher<J>> {
   constexpr static bool value = true;
 };
 
+// The `P1, P2, P3` and `CharPtrOrInt` magic are optimizations for fast JSON path construction. -- D.K.
+struct CharPtrOrInt {
+  const char* p;
+  int i;
+  CharPtrOrInt(const char* p) : p(p) {}
+  CharPtrOrInt(int i) : p(nullptr), i(i) {}
+  void AppendToString(std::string& s) const {
+    if (p) {
+      s.append(p);
+    } else {
+      s.append(current::ToString(i));
+    }
+  }
+};
+
+// The memory `JSONParser` reuses across the `ParseJSON()` calls made from the same thread: the pool for
+// the values of the `rapidjson::Document`, the pool for its parse stack, and the JSON path vector.
+// Replaying a stream parses millions of small entries, and allocating all of these from scratch for each
+// of them used to dominate the cost of `ParseJSON()`. The pools grow to fit the largest document seen,
+// up to `kMaxRetainedPoolSize` each; anything above is allocated from the heap and freed after each parse.
+// The cap is kept low, as every thread that has ever parsed JSON holds on to its arena until it exits.
+class JSONParserArena final {
+ public:
+  using pool_t = rapidjson::MemoryPoolAllocator<>;
+  using document_t = rapidjson::GenericDocument<rapidjson::UTF8<>, pool_t, pool_t>;
+
+  constexpr static size_t kInitialValuesPoolSize = 64 * 1024;
+  constexpr static size_t kInitialStackPoolSize = 16 * 1024;
+  constexpr static size_t kInitialStackCapacity = 1024;
+  constexpr static size_t kMaxRetainedPoolSize = 1024 * 1024;
+
+  // Holds the arena of this thread for the lifetime of a `JSONParser`. A nested `ParseJSON()` call,
+  // for instance, from within a custom `DeserializeImpl`, finds it taken, and allocates from the heap.
+  class Scope final {
+   public:
+    Scope() : arena_(current::ThreadLocalSingleton<JSONParserArena>()), acquired_(!arena_.in_use_) {
+      if (acquired_) {
+        arena_.in_use_ = true;
+      }
+    }
+
+    ~Scope() {
+      if (acquired_) {
+        arena_.Recycle();
+        arena_.in_use_ = false;
+      }
+    }
+
+    pool_t* ValuesPool() { return acquired_ ? arena_.values_pool_.get() : nullptr; }
+    pool_t* StackPool() { return acquired_ ? arena_.stack_pool_.get() : nullptr; }
+    std::vector<CharPtrOrInt>& Path() { return acquired_ ? arena_.path_ : own_path_; }
+
+   private:
+    JSONParserArena& arena_;
+    const bool acquired_;
+    std::vector<CharPtrOrInt> own_path_;
+  };
+
+  JSONParserArena()
+      : values_buffer_(kInitialValuesPoolSize),
+        stack_buffer_(kInitialStackPoolSize),
+        values_pool_(std::make_unique<pool_t>(&values_buffer_[0], values_buffer_.size())),
+        stack_pool_(std::make_unique<pool_t>(&stack_buffer_[0], stack_buffer_.size())) {}
+
+ private:
+  void Recycle() {
+    RecyclePool(values_buffer_, values_pool_);
+    RecyclePool(stack_buffer_, stack_pool_);
+    path_.clear();  // Would only be non-empty if the parsing has thrown.
+  }
+
+  // Releases the memory allocated past the buffer, and grows the buffer so that next time it is not needed.
+  static void RecyclePool(std::vector<char>& buffer, std::unique_ptr<pool_t>& pool) {
+    const size_t capacity = pool->Capacity();
+    if (capacity > buffer.size() && buffer.size() < kMaxRetainedPoolSize) {
+      pool = nullptr;
+      buffer.resize(std::min(capacity * 2, kMaxRetainedPoolSize));
+      pool = std::make_unique<pool_t>(&buffer[0], buffer.size());
+    } else {
+      pool->Clear();
+    }
+  }
+
+  bool in_use_ = false;
+  std::vector<char> values_buffer_;
+  std::vector<char> stack_buffer_;
+  std::unique_ptr<pool_t> values_pool_;
+  std::unique_ptr<pool_t> stack_pool_;
+  std::vector<CharPtrOrInt> path_;
+};
+
 template <class JSON_FORMAT>
 class JSONParser final {
  public:
-  explicit JSONParser(const char* json) {
+  explicit JSONParser(const char* json)
+      : path_(arena_.Path()),
+        document_(arena_.ValuesPool(), JSONParserArena::kInitialStackCapacity, arena_.StackPool()) {
     if (document_.Parse(json).HasParseError()) {
       CURRENT_THROW(InvalidJSONException(json));
     }
@@ -268,7 +405,6 @@ class JSONParser final {
     path_.pop_back();
   }
 
-  // The `P1, P2, P3` and `CharPtrOrInt` magic are optimizations for fast JSON path construction. -- D.K.
   template <typename T, typename P1, typename P2>
   void Inner(rapidjson::Value* inner_value, T&& x, P1 p1, P2 p2) {
     path_.emplace_back(p1);
@@ -293,20 +429,6 @@ class JSONParser final {
     path_.pop_back();
   }
 
-  struct CharPtrOrInt {
-    const char* p;
-    int i;
-    CharPtrOrInt(const char* p) : p(p) {}
-    CharPtrOrInt(int i) : p(nullptr), i(i) {}
-    void AppendToString(std::string& s) const {
-      if (p) {
-        s.append(p);
-      } else {
-        s.append(current::ToString(i));
-      }
-    }
-  };
-
   bool PathIsEmpty() const { return path_.empty(); }
 
   std::string Path() const {
@@ -319,8 +441,9 @@ class JSONParser final {
 
  private:
   rapidjson::Value* current_;
-  std::vector<CharPtrOrInt> path_;
-  rapidjson::Document document_;
+  JSONParserArena::Scope arena_;  // Must precede `path_` and `document_`, which use its memory.
+  std::vector<CharPtrOrInt>& path_;
+  JSONParserArena::document_t document_;
 };
 
 template <class J, typename T>
@@ -329,8 +452,33 @@ void ParseJSONViaRapidJSON(const char* json, T& destination) {
   Deserialize(json_parser, destination);
 }
 
+template <class J = JSONFormat::Current, typename T, class OUTPUT_STREAM>
+inline void WriteJSON(rapidjson::Writer<OUTPUT_STREAM>& writer, const T& source) {
+  JSONWriter<J, rapidjson::Writer<OUTPUT_STREAM>> json_writer(writer);
+  Serialize(json_writer, source);
+}
+
+// Appends to a caller-provided buffer. Staged via `rapidjson::StringBuffer`, as appending to an `std::string`
+// character by character is measurably slower.
+template <class J = JSONFormat::Current, typename T>
+inline void AppendJSON(std::string& output, const T& source) {
+  rapidjson::StringBuffer string_buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
+  WriteJSON<J>(writer, source);
+  output.append(string_buffer.GetString(), string_buffer.GetSize());
+}
+
 template <class J = JSONFormat::Current, typename T>
 inline std::string JSON(const T& source) {
+  rapidjson::StringBuffer string_buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
+  WriteJSON<J>(writer, source);
+  return std::string(string_buffer.GetString(), string_buffer.GetSize());
+}
+
+// The original, `rapidjson::Document`-based, implementation of `JSON()`. Kept for testing and benchmarking.
+template <class J = JSONFormat::Current, typename T>
+inline std::string JSONViaRapidJSONDocument(const T& source) {
   JSONStringifier<J> json_stringifier;
   Serialize(json_stringifier, source);
   return json_stringifier.ResultingJSON();
@@ -425,6 +573,9 @@ inline Optional<T> TryParseJSON(const strings::Chunk& source) {
 
 // Keep top-level symbols both in `current::` and in global namespace.
 using serialization::json::JSON;
+using serialization::json::AppendJSON;
+using serialization::json::WriteJSON;
+using serialization::json::JSONViaRapidJSONDocument;
 using serialization::json::ParseJSON;
 using serialization::json::TryParseJSON;
 using serialization::json::PatchObjectWithJSON;
@@ -436,6 +587,9 @@ using serialization::json::JSONUninitializedVariantObjectException;
 }  // namespace current
 
 using current::JSON;
+using current::AppendJSON;
+using current::WriteJSON;
+using current::JSONViaRapidJSONDocument;
 using current::ParseJSON;
 using current::TryParseJSON;
 using current::PatchObjectWithJSON;
@@ -68,6 +68,34 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::map<std::string, T
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename TK, typename TV, typename TC, typename TA>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::map<TK, TV, TC, TA>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer,
+                          const std::map<TK, TV, TC, TA>& value) {
+    json_writer.Writer().StartArray();
+    for (const auto& element : value) {
+      json_writer.Writer().StartArray();
+      Serialize(json_writer, element.first);
+      Serialize(json_writer, element.second);
+      json_writer.Writer().EndArray(2u);
+    }
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
+template <class JSON_FORMAT, class WRITER, typename TV, typename TC, typename TA>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::map<std::string, TV, TC, TA>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer,
+                          const std::map<std::string, TV, TC, TA>& value) {
+    json_writer.Writer().StartObject();
+    for (const auto& element : value) {
+      json_writer.Writer().Key(element.first.data(), static_cast<rapidjson::SizeType>(element.first.length()));
+      Serialize(json_writer, element.second);
+    }
+    json_writer.Writer().EndObject(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
 template <class JSON_FORMAT, typename TK, typename TV, typename TC, typename TA, class J>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::map<TK, TV, TC, TA>, J> {
   template <typename K = TK>
@@ -84,6 +84,52 @@ struct SerializeImpl<json::JSONStringifier<json::JSONFormat::NewtonsoftFSharp>,
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename T>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, Optional<T>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const Optional<T>& value) {
+    if (Exists(value)) {
+      Serialize(json_writer, Value(value));
+    } else {
+      // Object fields holding no value are skipped altogether in some formats, see `JSONValueIsAbsent`.
+      json_writer.Writer().Null();
+    }
+  }
+};
+
+template <class WRITER, typename T>
+struct SerializeImpl<json::JSONWriter<json::JSONFormat::NewtonsoftFSharp, WRITER>, Optional<T>> {
+  static void DoSerialize(json::JSONWriter<json::JSONFormat::NewtonsoftFSharp, WRITER>& json_writer,
+                          const Optional<T>& value) {
+    if (Exists(value)) {
+      WRITER& writer = json_writer.Writer();
+      writer.StartObject();
+      writer.Key("Case");
+      writer.String("Some");
+      writer.Key("Fields");
+      writer.StartArray();
+      Serialize(json_writer, Value(value));
+      writer.EndArray(1u);
+      writer.EndObject(2u);
+    } else {
+      json_writer.Writer().Null();
+    }
+  }
+};
+
+namespace json {
+template <class JSON_FORMAT, typename T>
+struct JSONValueIsAbsent<JSON_FORMAT, Optional<T>> {
+  static bool IsAbsent(const Optional<T>& value) {
+    constexpr bool fsharp = std::is_same<JSON_FORMAT, JSONFormat::NewtonsoftFSharp>::value;
+    if (Exists(value)) {
+      return !fsharp && JSONValueIsAbsent<JSON_FORMAT, T>::IsAbsent(Value(value));
+    } else {
+      return fsharp || std::is_same<JSON_FORMAT, JSONFormat::Minimalistic>::value;
+    }
+  }
+};
+}  // namespace current::serialization::json
+
 template <class JSON_FORMAT, typename T>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, Optional<T>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, Optional<T>& destination) {
@@ -60,6 +60,29 @@ struct SerializeImpl<json::JSONStringifier<json::JSONFormat::NewtonsoftFSharp>,
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename TF, typename TS>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::pair<TF, TS>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const std::pair<TF, TS>& value) {
+    json_writer.Writer().StartArray();
+    Serialize(json_writer, value.first);
+    Serialize(json_writer, value.second);
+    json_writer.Writer().EndArray(2u);
+  }
+};
+
+template <class WRITER, typename TF, typename TS>
+struct SerializeImpl<json::JSONWriter<json::JSONFormat::NewtonsoftFSharp, WRITER>, std::pair<TF, TS>> {
+  static void DoSerialize(json::JSONWriter<json::JSONFormat::NewtonsoftFSharp, WRITER>& json_writer,
+                          const std::pair<TF, TS>& value) {
+    json_writer.Writer().StartObject();
+    json_writer.Writer().Key("Item1");
+    Serialize(json_writer, value.first);
+    json_writer.Writer().Key("Item2");
+    Serialize(json_writer, value.second);
+    json_writer.Writer().EndObject(2u);
+  }
+};
+
 template <class JSON_FORMAT, typename TF, typename TS>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::pair<TF, TS>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, std::pair<TF, TS>& destination) {
@@ -55,6 +55,38 @@ struct JSONValueAssignerImpl<std::chrono::milliseconds> {
     destination.SetInt64(value.count());
   }
 };
+
+template <>
+struct JSONValueWriterImpl<bool> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, bool value) {
+    writer.Bool(value);
+  }
+};
+
+template <typename T>
+struct JSONValueWriterImpl<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, T value) {
+    writer.Double(static_cast<double>(value));
+  }
+};
+
+template <>
+struct JSONValueWriterImpl<std::string> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, const std::string& value) {
+    writer.String(value.data(), static_cast<rapidjson::SizeType>(value.length()));
+  }
+};
+
+template <typename REP, typename PERIOD>
+struct JSONValueWriterImpl<std::chrono::duration<REP, PERIOD>> {
+  template <class WRITER>
+  static void WriteValue(WRITER& writer, std::chrono::duration<REP, PERIOD> value) {
+    writer.Int64(static_cast<int64_t>(value.count()));
+  }
+};
 }  // namespace curent::serialization::json
 
 #define CURRENT_DECLARE_PRIMITIVE_TYPE(typeid_index, cpp_type, current_type, fs_type, md_type, typescript_type) \
@@ -64,6 +96,12 @@ struct JSONValueAssignerImpl<std::chrono::milliseconds> {
       json_stringifier = value;                                                                                 \
     }                                                                                                           \
   };                                                                                                            \
+  template <class JSON_FORMAT, class WRITER>                                                                    \
+  struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, cpp_type> {                                       \
+    static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, copy_free<cpp_type> value) {    \
+      json::JSONValueWriterImpl<cpp_type>::WriteValue(json_writer.Writer(), value);                             \
+    }                                                                                                           \
+  };                                                                                                            \
   namespace json {                                                                                              \
   template <>                                                                                                   \
   struct IsJSONSerializable<cpp_type> {                                                                         \
@@ -47,6 +47,18 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::set<T, EQ, ALLOCAT
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename T, class EQ, class ALLOCATOR>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::set<T, EQ, ALLOCATOR>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer,
+                          const std::set<T, EQ, ALLOCATOR>& value) {
+    json_writer.Writer().StartArray();
+    for (const auto& element : value) {
+      Serialize(json_writer, element);
+    }
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
 template <class JSON_FORMAT, typename T, class EQ, class ALLOCATOR>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::set<T, EQ, ALLOCATOR>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, std::set<T, EQ, ALLOCATOR>& destination) {
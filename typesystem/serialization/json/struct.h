@@ -77,8 +77,56 @@ struct SerializeStructImpl<JSON_FORMAT, CurrentStruct> {
   static void SerializeStruct(JSONStructFieldsSerializer<JSON_FORMAT>&, const CurrentStruct&) {}
 };
 
+template <class JSON_FORMAT, class WRITER>
+class JSONWriterStructFieldsSerializer {
+ public:
+  explicit JSONWriterStructFieldsSerializer(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer)
+      : json_writer_(json_writer) {}
+
+  template <typename U>
+  void operator()(const char* name, const U& source) const {
+    if (!JSONValueIsAbsent<JSON_FORMAT, U>::IsAbsent(source)) {
+      json_writer_.Writer().Key(name);
+      Serialize(json_writer_, source);
+    }
+  }
+
+ private:
+  json::JSONWriter<JSON_FORMAT, WRITER>& json_writer_;
+};
+
+template <class JSON_FORMAT, class WRITER, typename T>
+struct WriteStructImpl {
+  static void WriteStruct(JSONWriterStructFieldsSerializer<JSON_FORMAT, WRITER>& visitor, const T& source) {
+    using decayed_t = current::decay<T>;
+    using super_t = current::reflection::SuperType<decayed_t>;
+
+    WriteStructImpl<JSON_FORMAT, WRITER, super_t>::WriteStruct(visitor, source);
+
+    current::reflection::VisitAllFields<decayed_t, current::reflection::FieldNameAndImmutableValue>::WithObject(
+        source, visitor);
+  }
+};
+
+template <class JSON_FORMAT, class WRITER>
+struct WriteStructImpl<JSON_FORMAT, WRITER, CurrentStruct> {
+  static void WriteStruct(JSONWriterStructFieldsSerializer<JSON_FORMAT, WRITER>&, const CurrentStruct&) {}
+};
+
 }  // namespace current::serialization::json
 
+template <class JSON_FORMAT, class WRITER, typename T>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>,
+                     T,
+                     std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const T& value) {
+    json_writer.Writer().StartObject();
+    json::JSONWriterStructFieldsSerializer<JSON_FORMAT, WRITER> visitor(json_writer);
+    json::WriteStructImpl<JSON_FORMAT, WRITER, T>::WriteStruct(visitor, value);
+    json_writer.Writer().EndObject();
+  }
+};
+
 template <class JSON_FORMAT, typename T>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>,
                      T,
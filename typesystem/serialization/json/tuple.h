@@ -57,6 +57,28 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::tuple<TS...>> {
   }
 };
 
+template <class JSON_FORMAT, class WRITER, class TUPLE, int I, int N>
+struct WriteTupleImpl {
+  static void DoIt(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const TUPLE& value) {
+    Serialize(json_writer, std::get<I>(value));
+    WriteTupleImpl<JSON_FORMAT, WRITER, TUPLE, I + 1, N>::DoIt(json_writer, value);
+  }
+};
+
+template <class JSON_FORMAT, class WRITER, class TUPLE, int N>
+struct WriteTupleImpl<JSON_FORMAT, WRITER, TUPLE, N, N> {
+  static void DoIt(json::JSONWriter<JSON_FORMAT, WRITER>&, const TUPLE&) {}
+};
+
+template <class JSON_FORMAT, class WRITER, typename... TS>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::tuple<TS...>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const std::tuple<TS...>& value) {
+    json_writer.Writer().StartArray();
+    WriteTupleImpl<JSON_FORMAT, WRITER, std::tuple<TS...>, 0, sizeof...(TS)>::DoIt(json_writer, value);
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(sizeof...(TS)));
+  }
+};
+
 template <class JSON_FORMAT, class TUPLE, int I, int N>
 struct DeserializeTupleImpl {
   static void DoIt(json::JSONParser<JSON_FORMAT>& json_parser, TUPLE& destination) {
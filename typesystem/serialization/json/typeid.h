@@ -42,6 +42,14 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, reflection::TypeID> {
   }
 };
 
+template <class JSON_FORMAT, class WRITER>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, reflection::TypeID> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, reflection::TypeID value) {
+    const std::string type_id = "T" + current::ToString(value);
+    json_writer.Writer().String(type_id.data(), static_cast<rapidjson::SizeType>(type_id.length()));
+  }
+};
+
 template <class JSON_FORMAT>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, reflection::TypeID> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, reflection::TypeID& destination) {
@@ -70,6 +70,34 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::unordered_map<std:
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename TK, typename TV, class HASH, class EQ, class ALLOCATOR>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::unordered_map<TK, TV, HASH, EQ, ALLOCATOR>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer,
+                          const std::unordered_map<TK, TV, HASH, EQ, ALLOCATOR>& value) {
+    json_writer.Writer().StartArray();
+    for (const auto& element : value) {
+      json_writer.Writer().StartArray();
+      Serialize(json_writer, element.first);
+      Serialize(json_writer, element.second);
+      json_writer.Writer().EndArray(2u);
+    }
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
+template <class JSON_FORMAT, class WRITER, typename TV, class HASH, class EQ, class ALLOCATOR>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::unordered_map<std::string, TV, HASH, EQ, ALLOCATOR>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer,
+                          const std::unordered_map<std::string, TV, HASH, EQ, ALLOCATOR>& value) {
+    json_writer.Writer().StartObject();
+    for (const auto& element : value) {
+      json_writer.Writer().Key(element.first.data(), static_cast<rapidjson::SizeType>(element.first.length()));
+      Serialize(json_writer, element.second);
+    }
+    json_writer.Writer().EndObject(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
 template <class JSON_FORMAT, typename TK, typename TV, class HASH, class EQ, class ALLOCATOR, class J>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::unordered_map<TK, TV, HASH, EQ, ALLOCATOR>, J> {
   template <typename K = TK>
@@ -128,6 +128,74 @@ class JSONVariantSerializer<json::JSONVariantStyle::NewtonsoftFSharp, JSON_FORMA
   json::JSONStringifier<JSON_FORMAT>& json_stringifier_;
 };
 
+template <json::JSONVariantStyle, class JSON_FORMAT, class WRITER>
+class JSONVariantWriter;
+
+template <class JSON_FORMAT, class WRITER>
+class JSONVariantWriter<json::JSONVariantStyle::Current, JSON_FORMAT, WRITER> {
+ public:
+  explicit JSONVariantWriter(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer) : json_writer_(json_writer) {}
+
+  template <typename X>
+  std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(X)> operator()(const X& object) {
+    WRITER& writer = json_writer_.Writer();
+    writer.StartObject();
+    writer.Key(reflection::CurrentTypeName<X, reflection::NameFormat::Z>());
+    Serialize(json_writer_, object);
+    if (json::JSONVariantTypeIDInEmptyKey<JSON_FORMAT>::value) {
+      using namespace ::current::reflection;
+      writer.Key("");
+      Serialize(json_writer_, Value<ReflectedTypeBase>(Reflector().ReflectType<X>()).type_id);
+    }
+    if (json::JSONVariantTypeNameInDollarKey<JSON_FORMAT>::value) {
+      writer.Key("$");
+      writer.String(reflection::CurrentTypeName<X, reflection::NameFormat::Z>());
+    }
+    writer.EndObject();
+  }
+
+ private:
+  json::JSONWriter<JSON_FORMAT, WRITER>& json_writer_;
+};
+
+template <class JSON_FORMAT, class WRITER>
+class JSONVariantWriter<json::JSONVariantStyle::Simple, JSON_FORMAT, WRITER>
+    : public JSONVariantWriter<json::JSONVariantStyle::Current, JSON_FORMAT, WRITER> {
+  using JSONVariantWriter<json::JSONVariantStyle::Current, JSON_FORMAT, WRITER>::JSONVariantWriter;
+};
+
+template <class JSON_FORMAT, class WRITER>
+class JSONVariantWriter<json::JSONVariantStyle::NewtonsoftFSharp, JSON_FORMAT, WRITER> {
+ public:
+  explicit JSONVariantWriter(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer) : json_writer_(json_writer) {}
+
+  template <typename X>
+  std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(X)> operator()(const X& object) {
+    WRITER& writer = json_writer_.Writer();
+    writer.StartObject();
+    writer.Key("Case");
+    writer.String(reflection::CurrentTypeName<X, reflection::NameFormat::Z>());
+    if (IS_CURRENT_VARIANT(X) || !IS_EMPTY_CURRENT_STRUCT(X)) {
+      writer.Key("Fields");
+      writer.StartArray();
+      Serialize(json_writer_, object);
+      writer.EndArray(1u);
+    }
+    writer.EndObject();
+  }
+
+ private:
+  json::JSONWriter<JSON_FORMAT, WRITER>& json_writer_;
+};
+
+// An uninitialized `Variant` is omitted from its enclosing object in the formats that don't use nulls for it.
+template <class JSON_FORMAT, typename T>
+struct JSONValueIsAbsent<JSON_FORMAT, T, std::enable_if_t<IS_CURRENT_VARIANT(T)>> {
+  static bool IsAbsent(const T& value) {
+    return !json::JSONVariantStyleUseNulls<JSON_FORMAT::variant_style>::value && !Exists(value);
+  }
+};
+
 template <class JSON_FORMAT>
 class JSONVariantCaseAbstractBase {
  public:
@@ -418,6 +486,19 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, T, std::enable_if_t<IS_
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename T>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, T, std::enable_if_t<IS_CURRENT_VARIANT(T)>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const T& value) {
+    if (Exists(value)) {
+      json::JSONVariantWriter<JSON_FORMAT::variant_style, JSON_FORMAT, WRITER> impl(json_writer);
+      value.Call(impl);
+    } else {
+      // When not a field of an object, an absent `Variant` is `null` regardless of the format.
+      json_writer.Writer().Null();
+    }
+  }
+};
+
 template <class JSON_FORMAT, typename T>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, T, std::enable_if_t<IS_CURRENT_VARIANT(T)>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, T& value) {
@@ -58,6 +58,28 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::vector<bool, TA>>
   }
 };
 
+template <class JSON_FORMAT, class WRITER, typename T, typename TA>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::vector<T, TA>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const std::vector<T, TA>& value) {
+    json_writer.Writer().StartArray();
+    for (const auto& element : value) {
+      Serialize(json_writer, element);
+    }
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
+template <class JSON_FORMAT, class WRITER, typename TA>
+struct SerializeImpl<json::JSONWriter<JSON_FORMAT, WRITER>, std::vector<bool, TA>> {
+  static void DoSerialize(json::JSONWriter<JSON_FORMAT, WRITER>& json_writer, const std::vector<bool, TA>& value) {
+    json_writer.Writer().StartArray();
+    for (const bool element : value) {
+      json_writer.Writer().Bool(element);
+    }
+    json_writer.Writer().EndArray(static_cast<rapidjson::SizeType>(value.size()));
+  }
+};
+
 template <class JSON_FORMAT, typename T, typename TA>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::vector<T, TA>> {
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, std::vector<T, TA>& destination) {
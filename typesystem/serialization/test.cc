@@ -181,8 +181,6 @@ CURRENT_STRUCT(WithInnerVariant) { CURRENT_FIELD(v, InnerVariant); };
 }  // namespace serialization_test::named_variant
 }  // namespace serialization_test
 
-#if 0
-// TODO(dkorolev): DIMA FIXME binary format.
 TEST(Serialization, Binary) {
   using namespace serialization_test;
 
@@ -253,7 +251,88 @@ TEST(Serialization, Binary) {
     ASSERT_THROW(LoadFromBinary<ComplexSerializable>(is), BinaryLoadFromStreamException);
   }
 }
-#endif
+
+TEST(Serialization, BinaryRoundTrip) {
+  using namespace serialization_test;
+
+  {
+    // Varints and zigzag varints.
+    EXPECT_EQ(1u, SaveIntoBinary(static_cast<uint64_t>(127u)).length());
+    EXPECT_EQ(2u, SaveIntoBinary(static_cast<uint64_t>(128u)).length());
+    EXPECT_EQ(10u, SaveIntoBinary(std::numeric_limits<uint64_t>::max()).length());
+    EXPECT_EQ(1u, SaveIntoBinary(static_cast<int32_t>(-64)).length());
+    EXPECT_EQ(2u, SaveIntoBinary(static_cast<int32_t>(64)).length());
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(),
+              LoadFromBinary<uint64_t>(SaveIntoBinary(std::numeric_limits<uint64_t>::max())));
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(),
+              LoadFromBinary<int64_t>(SaveIntoBinary(std::numeric_limits<int64_t>::min())));
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(),
+              LoadFromBinary<int64_t>(SaveIntoBinary(std::numeric_limits<int64_t>::max())));
+    EXPECT_EQ(-1, LoadFromBinary<int8_t>(SaveIntoBinary(static_cast<int8_t>(-1))));
+    EXPECT_EQ(0.1f, LoadFromBinary<float>(SaveIntoBinary(0.1f)));
+    EXPECT_EQ(-1e-300, LoadFromBinary<double>(SaveIntoBinary(-1e-300)));
+    EXPECT_EQ(std::string("a\0b", 3), LoadFromBinary<std::string>(SaveIntoBinary(std::string("a\0b", 3))));
+    EXPECT_EQ(-42ll, LoadFromBinary<std::chrono::microseconds>(SaveIntoBinary(std::chrono::microseconds(-42))).count());
+  }
+
+  {
+    // Containers.
+    WithVectorOfPairs with_vector_of_pairs;
+    with_vector_of_pairs.v.emplace_back(-1, "minus one");
+    with_vector_of_pairs.v.emplace_back(100500, "");
+    EXPECT_EQ(JSON(with_vector_of_pairs),
+              JSON(LoadFromBinary<WithVectorOfPairs>(SaveIntoBinary(with_vector_of_pairs))));
+
+    WithTrivialSet with_set;
+    with_set.s.insert("foo");
+    with_set.s.insert("bar");
+    EXPECT_EQ(JSON(with_set), JSON(LoadFromBinary<WithTrivialSet>(SaveIntoBinary(with_set))));
+
+    WithNontrivialUnorderedMap with_unordered_map;
+    with_unordered_map.q[Serializable(1, "one", false, Enum::DEFAULT)] = "yes";
+    with_unordered_map.q[Serializable(2, "two", true, Enum::SET)] = "no";
+    const auto parsed = LoadFromBinary<WithNontrivialUnorderedMap>(SaveIntoBinary(with_unordered_map));
+    ASSERT_EQ(2u, parsed.q.size());
+    EXPECT_EQ("yes", parsed.q.at(Serializable(1)));
+    EXPECT_EQ("no", parsed.q.at(Serializable(2)));
+
+    const std::vector<bool> bits{true, false, true};
+    EXPECT_EQ(4u, SaveIntoBinary(bits).length());
+    EXPECT_EQ(bits, LoadFromBinary<std::vector<bool>>(SaveIntoBinary(bits)));
+
+    const auto tuple = std::make_tuple(1, std::string("two"), 3.0);
+    EXPECT_EQ(tuple, (LoadFromBinary<std::tuple<int, std::string, double>>(SaveIntoBinary(tuple))));
+  }
+
+  {
+    // Variants, including the nested ones.
+    using namespace serialization_test::named_variant;
+    ContainsVariant contains_variant;
+    contains_variant.variant = ComplexSerializable('a', 'c');
+    EXPECT_EQ(JSON(contains_variant), JSON(LoadFromBinary<ContainsVariant>(SaveIntoBinary(contains_variant))));
+
+    WrappedQ wrapped;
+    OuterB outer_b;
+    outer_b.b = T();
+    wrapped = outer_b;
+    EXPECT_EQ(JSON(wrapped), JSON(LoadFromBinary<WrappedQ>(SaveIntoBinary(wrapped))));
+
+    // The case tag is the one-based index of the type in the type list.
+    EXPECT_EQ(2, SaveIntoBinary(wrapped)[0]);
+    EXPECT_EQ(2, SaveIntoBinary(wrapped)[1]);
+  }
+
+  {
+    // Malformed input.
+    ASSERT_THROW(LoadFromBinary<ContainsVariant>(SaveIntoBinary(ContainsVariant())),
+                 BinaryUninitializedVariantObjectException);
+    ASSERT_THROW(LoadFromBinary<ContainsVariant>(std::string("\x7f")), BinaryLoadFromStreamException);
+    ASSERT_THROW(LoadFromBinary<bool>(std::string("\x02")), BinaryLoadFromStreamException);
+    ASSERT_THROW(LoadFromBinary<uint32_t>(std::string("\x80")), BinaryLoadFromStreamException);
+    ASSERT_THROW(LoadFromBinary<uint32_t>(std::string("\x01\x01")), BinaryLoadFromStreamException);
+    ASSERT_THROW(LoadFromBinary<std::string>(std::string("\xff\xff\xff\xff\x0f")), BinaryLoadFromStreamException);
+  }
+}
 
 TEST(JSONSerialization, CPPTypes) {
   using namespace serialization_test;
@@ -363,8 +442,6 @@ TEST(JSONSerialization, Tuple) {
   }
 }
 
-#if 0
-// TODO(dkorolev): DIMA FIXME binary format.
 TEST(Serialization, OptionalAsBinary) {
   using namespace serialization_test;
 
@@ -407,7 +484,6 @@ TEST(Serialization, OptionalAsBinary) {
     EXPECT_TRUE(Value(parsed_with_b.b));
   }
 }
-#endif
 
 TEST(JSONSerialization, CurrentStructs) {
   using namespace serialization_test;
@@ -876,8 +952,6 @@ TEST(JSONSerialization, Time) {
   }
 }
 
-#if 0
-// TODO(dkorolev): DIMA FIXME binary format.
 TEST(Serialization, TimeAsBinary) {
   using namespace serialization_test;
 
@@ -885,7 +959,7 @@ TEST(Serialization, TimeAsBinary) {
     WithTime zero;
     std::ostringstream oss;
     SaveIntoBinary(oss, zero);
-    EXPECT_EQ(16u, oss.str().length());
+    EXPECT_EQ(2u, oss.str().length());  // Both zeroes are single-byte varints.
   }
 
   {
@@ -900,7 +974,6 @@ TEST(Serialization, TimeAsBinary) {
     EXPECT_EQ(6ll, parsed.micros.count());
   }
 }
-#endif
 
 TEST(JSONSerialization, Optional) {
   using namespace serialization_test;
@@ -1249,6 +1322,77 @@ TEST(JSONSerialization, VariantNullOmittedInMinimalisticFormat) {
 
 namespace serialization_test {
 
+CURRENT_STRUCT(WithEveryJSONShape, DerivedSerializable) {
+  CURRENT_FIELD(c, char, 'c');
+  CURRENT_FIELD(i8, int8_t, -8);
+  CURRENT_FIELD(u16, uint16_t, 16);
+  CURRENT_FIELD(i64, int64_t, -(1ll << 40));
+  CURRENT_FIELD(u64, uint64_t, static_cast<uint64_t>(-1));
+  CURRENT_FIELD(f, float, 0.1f);
+  CURRENT_FIELD(ms, std::chrono::milliseconds, std::chrono::milliseconds(-1));
+  CURRENT_FIELD(escaped, std::string, "\"quoted\"\n\ttab\\ and a \x01");
+  CURRENT_FIELD(flags, std::vector<bool>);
+  CURRENT_FIELD(tuple, (std::tuple<int32_t, std::string, Optional<bool>>));
+  CURRENT_FIELD(pairs, (std::vector<std::pair<int32_t, std::string>>));
+  CURRENT_FIELD(trivial_map, (std::map<std::string, Optional<int32_t>>));
+  CURRENT_FIELD(nontrivial_map, (std::map<int32_t, simple_variant_t>));
+  CURRENT_FIELD(trivial_unordered_map, (std::unordered_map<std::string, std::set<std::string>>));
+  CURRENT_FIELD(variants, std::vector<simple_variant_t>);
+  CURRENT_FIELD(absent_variant, simple_variant_t);
+  CURRENT_FIELD(wrapped, named_variant::WrappedQ);
+  CURRENT_FIELD(optional_absent_variant, Optional<named_variant::InnerA>);
+  CURRENT_FIELD(optional_present, Optional<Serializable>);
+  CURRENT_FIELD(optional_absent, Optional<std::string>);
+  CURRENT_FIELD(immutable_optional, ImmutableOptional<std::string>, std::string("immutable"));
+  CURRENT_FIELD(type_id, current::reflection::TypeID, static_cast<current::reflection::TypeID>(42));
+};
+
+}  // namespace serialization_test
+
+TEST(JSONSerialization, WriterMatchesDocumentInAllFormats) {
+  using namespace serialization_test;
+
+  WithEveryJSONShape object;
+  object.i = 1;
+  object.s = "derived";
+  object.b = true;
+  object.e = Enum::SET;
+  object.d = 0.5;
+  object.flags = {true, false, true};
+  object.tuple = std::make_tuple(1, "one", nullptr);
+  object.pairs = {{1, "a"}, {2, "b"}};
+  object.trivial_map["present"] = 42;
+  object.trivial_map["absent"] = nullptr;
+  object.nontrivial_map[1] = Empty();
+  object.nontrivial_map[2] = simple_variant_t();
+  object.trivial_unordered_map["set"] = {"x", "y"};
+  object.variants.push_back(Empty());
+  object.variants.push_back(simple_variant_t());
+  object.variants.push_back(Serializable(2, "two", false, Enum::DEFAULT));
+  object.wrapped = named_variant::OuterA();
+  object.optional_absent_variant = named_variant::InnerA();
+  object.optional_present = Serializable(3, "three", true, Enum::SET);
+
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::Current>(object), JSON<JSONFormat::Current>(object));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::Minimalistic>(object), JSON<JSONFormat::Minimalistic>(object));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::JavaScript>(object), JSON<JSONFormat::JavaScript>(object));
+  EXPECT_EQ(JSONViaRapidJSONDocument<JSONFormat::NewtonsoftFSharp>(object),
+            JSON<JSONFormat::NewtonsoftFSharp>(object));
+
+  // Top-level values that would be omitted as object fields are `null`-s, in both implementations.
+  EXPECT_EQ("null", JSONViaRapidJSONDocument<JSONFormat::Minimalistic>(Optional<int>()));
+  EXPECT_EQ("null", JSON<JSONFormat::Minimalistic>(Optional<int>()));
+  EXPECT_EQ("null", JSONViaRapidJSONDocument<JSONFormat::NewtonsoftFSharp>(Optional<int>()));
+  EXPECT_EQ("null", JSON<JSONFormat::NewtonsoftFSharp>(Optional<int>()));
+
+  // `AppendJSON()` writes into the caller-provided buffer, preserving its contents.
+  std::string buffer = "prefix:";
+  AppendJSON(buffer, object);
+  EXPECT_EQ("prefix:" + JSON(object), buffer);
+}
+
+namespace serialization_test {
+
 CURRENT_STRUCT_T(TemplatedValue) {
   CURRENT_FIELD(value, T);
   CURRENT_DEFAULT_CONSTRUCTOR_T(TemplatedValue) : value() {}
@@ -1420,6 +1564,39 @@ CURRENT_STRUCT(CrashingStruct) {
 
 }  // namespace serialization_test
 
+TEST(JSONSerialization, ParserArenaIsReusedAndReentrant) {
+  using namespace serialization_test;
+  using current::serialization::json::JSONParserArena;
+
+  // Larger than the initial pools, to have the arena grow, and then reuse the grown pools.
+  std::vector<std::string> large(10000u, "Some string long enough to not fit the initial memory pool.");
+  const std::string large_json = JSON(large);
+  EXPECT_EQ(large, ParseJSON<std::vector<std::string>>(large_json));
+  EXPECT_EQ(large, ParseJSON<std::vector<std::string>>(large_json));
+  EXPECT_EQ(42, Value(ParseJSON<WithOptional>("{\"i\":42}").i));
+
+  // The schema errors report the path correctly after a previous parse has thrown midway.
+  ASSERT_THROW(ParseJSON<ComplexSerializable>("{\"j\":1,\"q\":\"\",\"v\":[1],\"z\":{}}"), JSONSchemaException);
+  try {
+    ParseJSON<ComplexSerializable>("{\"j\":\"bad\"}");
+    ASSERT_TRUE(false);
+  } catch (const JSONSchemaException& e) {
+    EXPECT_EQ("Expected unsigned integer for `j`, got: \"bad\"", e.OriginalDescription());
+  }
+
+  {
+    // A `ParseJSON()` while the arena of this thread is taken, as it would be from a nested call, uses the heap.
+    JSONParserArena::Scope outer;
+    EXPECT_TRUE(outer.ValuesPool() != nullptr);
+    JSONParserArena::Scope inner;
+    EXPECT_TRUE(inner.ValuesPool() == nullptr);
+    EXPECT_TRUE(inner.StackPool() == nullptr);
+    EXPECT_EQ(large, ParseJSON<std::vector<std::string>>(large_json));
+  }
+  JSONParserArena::Scope released;
+  EXPECT_TRUE(released.ValuesPool() != nullptr);
+}
+
 TEST(JSONSerialization, JSONCrashTests) {
   EXPECT_EQ("{\"i\":0,\"o\":null,\"e\":0}", JSON(serialization_test::CrashingStruct()));
 